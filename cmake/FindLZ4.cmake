@@ -0,0 +1,39 @@
+# - Try to find the LZ4 library and include dirs
+#
+# This script will set the following variables:
+#  LZ4_FOUND - System has lz4
+#  LZ4_INCLUDE_DIR - The lz4 include directories
+#  LZ4_LIBRARY - The library needed to use lz4
+
+
+include(FindPackageHandleStandardArgs)
+
+# find includes
+find_path(LZ4_INCLUDE_DIR
+  NAMES lz4.h
+  HINTS ${LZ4_ROOT}
+  PATH_SUFFIXES "include"
+)
+
+find_library(LZ4_LIBRARY
+    NAMES lz4 liblz4
+    HINTS ${LZ4_ROOT}/lib ${LZ4_ROOT}/lib64
+    ENV LD_LIBRARY_PATH
+)
+
+find_package_handle_standard_args(LZ4
+    REQUIRED_VARS
+      LZ4_INCLUDE_DIR
+      LZ4_LIBRARY
+)
+
+if (LZ4_FOUND)
+  message(STATUS "Found LZ4  (include: ${LZ4_INCLUDE_DIR}, library: ${LZ4_LIBRARY})")
+  mark_as_advanced(LZ4_INCLUDE_DIR LZ4_LIBRARY)
+endif ()
+
+if (LZ4_FOUND AND NOT TARGET LZ4::lz4)
+  add_library(LZ4::lz4 SHARED IMPORTED)
+  set_property(TARGET LZ4::lz4 PROPERTY IMPORTED_LOCATION ${LZ4_LIBRARY})
+  target_include_directories(LZ4::lz4 INTERFACE ${LZ4_INCLUDE_DIR})
+endif()
@@ -0,0 +1,39 @@
+# - Try to find the zstd library and include dirs
+#
+# This script will set the following variables:
+#  Zstd_FOUND - System has zstd
+#  Zstd_INCLUDE_DIR - The zstd include directories
+#  Zstd_LIBRARY - The library needed to use zstd
+
+
+include(FindPackageHandleStandardArgs)
+
+# find includes
+find_path(Zstd_INCLUDE_DIR
+  NAMES zstd.h
+  HINTS ${Zstd_ROOT}
+  PATH_SUFFIXES "include"
+)
+
+find_library(Zstd_LIBRARY
+    NAMES zstd libzstd
+    HINTS ${Zstd_ROOT}/lib ${Zstd_ROOT}/lib64
+    ENV LD_LIBRARY_PATH
+)
+
+find_package_handle_standard_args(Zstd
+    REQUIRED_VARS
+      Zstd_INCLUDE_DIR
+      Zstd_LIBRARY
+)
+
+if (Zstd_FOUND)
+  message(STATUS "Found zstd  (include: ${Zstd_INCLUDE_DIR}, library: ${Zstd_LIBRARY})")
+  mark_as_advanced(Zstd_INCLUDE_DIR Zstd_LIBRARY)
+endif ()
+
+if (Zstd_FOUND AND NOT TARGET Zstd::zstd)
+  add_library(Zstd::zstd SHARED IMPORTED)
+  set_property(TARGET Zstd::zstd PROPERTY IMPORTED_LOCATION ${Zstd_LIBRARY})
+  target_include_directories(Zstd::zstd INTERFACE ${Zstd_INCLUDE_DIR})
+endif()
@@ -18,8 +18,6 @@
 #include <chrono>
 #include <thread>
 
-#include <unistd.h>
-
 #include <Headers/DAQID.h>
 
 namespace o2
@@ -32,39 +30,32 @@ void CruLinkEmulator::linkReadoutThread()
   static const std::uint64_t cHBFrameFreq = 11223;
 
   const auto cSuperpageSize = mMemHandler->getSuperpageSize();
-  const auto cHBFrameSize = (mLinkBitsPerS / cHBFrameFreq) >> 3;
-  const auto cStfLinkSize = cHBFrameSize * cHBFrameFreq * 256 / cHBFrameFreq;
-  const auto cNumDmaChunkPerSuperpage = std::min(size_t(256), size_t(cSuperpageSize / mDmaChunkSize));
-  constexpr int64_t cStfTimeUs = std::chrono::microseconds(std::uint64_t(1000000) * 256 / cHBFrameFreq).count();
+  const std::uint64_t cHbfPerTf = mWorkloadConfig.mHbfPerTf;
+  const auto cStfLinkSize = (mLinkBitsPerS >> 3) * cHbfPerTf / cHBFrameFreq;
+
+  CruLinkWorkloadGenerator lWorkload(mWorkloadConfig, mLinkID, cSuperpageSize);
 
   DDDLOG("Superpage size: {}", cSuperpageSize);
-  DDDLOG("mDmaChunkSize size: {}", mDmaChunkSize);
-  DDDLOG("HBFrameSize size: {}", cHBFrameSize);
+  DDDLOG("HBFrame mean size: {}", mWorkloadConfig.mHbfSizeMean);
   DDDLOG("StfLinkSize size: {}", cStfLinkSize);
-  DDDLOG("cNumDmaChunkPerSuperpage: {}", cNumDmaChunkPerSuperpage);
-  DDDLOG("Sleep time us: {}", cStfTimeUs);
+  DDDLOG("STF rate: {:.3f} Hz, profile: {}", mRateConfig.mStfRate, to_string(mRateConfig.mProfile));
 
-  // os might sleep much longer than requested
-  // keep count of transmitted pages and adjust when needed
+  // STF deadlines are absolute: oversleeping is compensated, and the backlog is bounded by the bucket depth
+  CruLinkRateControl lRateControl(mRateConfig);
   int64_t lSentStf = 0;
-  using hres_clock = std::chrono::high_resolution_clock;
-  const auto lOpStart = hres_clock::now();
 
   std::vector<CRUSuperpage> lSuperpages;
 
   while (mRunning) {
 
-    const int64_t lUsSinceStart = std::chrono::duration_cast<std::chrono::microseconds>(hres_clock::now() - lOpStart).count();
-    const int64_t lStfToSend = lUsSinceStart / cStfTimeUs - lSentStf;
-
-    if (lStfToSend <= 0) {
-      usleep(500);
+    const int64_t lStfToSend = lRateControl.waitForStfs();
+    if (lStfToSend == 0) {
       continue;
     }
 
-    if (lStfToSend > 1 || lStfToSend < 0) {
-      WDDLOG("Data producer is running slow. StfBacklog: {}", lStfToSend);
-    }
+    IDDLOG_RL(10000, "CruLinkEmulator: link_id={} issued_stfs={} dropped_stfs={} lateness_mean_us={:.1f} lateness_max_us={:.1f}",
+      mLinkID, lRateControl.numIssued(), lRateControl.numDropped(), lRateControl.meanLatenessUs(),
+      lRateControl.maxLatenessUs());
 
     const std::int64_t lPagesToSend = std::max(lStfToSend, int64_t(lStfToSend * (cStfLinkSize + cSuperpageSize - 1) / cSuperpageSize));
 
@@ -74,72 +65,82 @@ void CruLinkEmulator::linkReadoutThread()
       lPagesAvail += mMemHandler->getSuperpages(std::max(lPagesToSend, std::int64_t(32)), std::back_inserter(lSuperpages));
       assert(std::size_t(lPagesAvail) == lSuperpages.size());
     }
-    lPagesAvail = lSuperpages.size();
 
     for (int64_t stf = 0; stf < lStfToSend; stf++, lSentStf++) {
-      auto lHbfToSend = 256;
-
-      while (lHbfToSend > 0) {
-        if (!lSuperpages.empty()) {
-          CRUSuperpage sp = lSuperpages.back();
-          lSuperpages.pop_back();
-
-          // Enumerate valid data and create work-item for STFBuilder
-          // Each channel is reported separately to the O2
-          ReadoutLinkO2Data linkO2Data;
-
-          linkO2Data.mLinkHeader.mSystemId = (rand() % 100 < 70) ? o2::header::DAQID::TPC : o2::header::DAQID::ITS;
-          linkO2Data.mLinkHeader.mFeeId = 0xFEE0;
-          linkO2Data.mLinkHeader.mEquipmentId = 0xE1D0; // ?
-          linkO2Data.mLinkHeader.mLinkId = mLinkID;
-          linkO2Data.mLinkHeader.mFlags.mIsRdhFormat = 1;
-
-          for (unsigned d = 0; d < cNumDmaChunkPerSuperpage; d++, lHbfToSend--) {
-
-            if (lHbfToSend == 0)
-              break; // start a new superpage
-
-            // make set few bits for the RDHv4 packet to keep SubTimeFrame builder happy
-            {
-              char *lRdh = reinterpret_cast<char*>(sp.mDataVirtualAddress + (d * mDmaChunkSize));
-              // version
-              std::uint32_t lVer = 0x00000004;
-              std::memcpy(lRdh, &lVer, sizeof(std::uint32_t));
-
-              // cru, linkid, ep
-              std::uint32_t lEquipment = 0;
-              lEquipment = (
-                (std::uint32_t(0xEEE) << 16) |  /* CRU, 12bit */
-                (std::uint32_t(0x0) << 28) |    /* endpoint id */
-                (std::uint32_t(mLinkID) & 0xFF) /* linkID, 8 bit */
-              );
-
-              std::memcpy(lRdh+12, &lEquipment, sizeof(std::uint32_t));
-            }
-
-            linkO2Data.mLinkRawData.push_back(CruDmaPacket{
-              mMemHandler->getDataRegion(),
-              sp.mDataVirtualAddress + (d * mDmaChunkSize),        // Valid data DMA Chunk <superpage offset + length>
-              mDmaChunkSize /* - (rand() % (mDmaChunkSize / 10))*/ // This should be taken from desc->mRawDataSize (filled by the CRU)
-            });
-          }
-
-          // Put the link info data into the send queue
-          mMemHandler->putLinkData(std::move(linkO2Data));
+      const std::uint32_t lTfOrbit = mWorkloadConfig.mFirstOrbit + std::uint32_t(lSentStf * cHbfPerTf);
+
+      // Each channel is reported separately to the O2
+      ReadoutSubTimeframeHeader lTfHeader;
+      lTfHeader.mTimeFrameId = lSentStf + 1;
+      lTfHeader.mTimeframeOrbitFirst = lTfOrbit;
+      lTfHeader.mTimeframeOrbitLast = lTfOrbit + cHbfPerTf - 1;
+      lTfHeader.mSystemId = mWorkloadConfig.mSystemId;
+      lTfHeader.mFeeId = lWorkload.feeId();
+      lTfHeader.mEquipmentId = 0xE1D0; // ?
+      lTfHeader.mLinkId = mLinkID;
+      lTfHeader.mFlags.mIsRdhFormat = 1;
+      lTfHeader.mFlags.mLastTFMessage = 0;
+
+      std::uint64_t lHbf = 0;
+      std::size_t lHbfSize = lWorkload.prepareHbf(lTfOrbit, true);
+
+      while (lHbf < cHbfPerTf) {
+        if (lSuperpages.empty()) {
+          mMemHandler->getSuperpages(32, std::back_inserter(lSuperpages));
+        }
 
-        } else {
-          // signal lost data (no free superpages)
+        if (lSuperpages.empty()) {
+          // signal lost data (no free superpages), and close the TF for this link
           ReadoutLinkO2Data linkO2Data;
+          linkO2Data.mLinkHeader = lTfHeader;
           linkO2Data.mLinkHeader.mFlags.mIsRdhFormat = 0;
+          linkO2Data.mLinkHeader.mFlags.mLastTFMessage = 1;
 
           mMemHandler->putLinkData(std::move(linkO2Data));
           break;
         }
+
+        CRUSuperpage sp = lSuperpages.back();
+        lSuperpages.pop_back();
+
+        // Enumerate valid data and create work-item for STFBuilder
+        ReadoutLinkO2Data linkO2Data;
+        linkO2Data.mLinkHeader = lTfHeader;
+
+        // fill the superpage with HBFs of the current TF
+        std::size_t lSpOffset = 0;
+        while (lHbf < cHbfPerTf && (lSpOffset + lHbfSize) <= cSuperpageSize) {
+          char *lHbfPtr = sp.mDataVirtualAddress + lSpOffset;
+          lWorkload.writeHbf(lHbfPtr);
+
+          linkO2Data.mLinkRawData.push_back(CruDmaPacket{
+            mMemHandler->getDataRegion(),
+            lHbfPtr,  // Valid data DMA Chunk <superpage offset + length>
+            lHbfSize
+          });
+
+          // keep HBFs 64 B aligned
+          lSpOffset += (lHbfSize + 63) & ~std::size_t(63);
+          lHbf++;
+
+          if (lHbf < cHbfPerTf) {
+            lHbfSize = lWorkload.prepareHbf(lTfOrbit + lHbf, false);
+          }
+        }
+
+        if (lHbf == cHbfPerTf) {
+          linkO2Data.mLinkHeader.mFlags.mLastTFMessage = 1;
+        }
+
+        // Put the link info data into the send queue
+        mMemHandler->putLinkData(std::move(linkO2Data));
       }
     }
   }
 
-  DDDLOG("Exiting ReadoutEmulator thread.");
+  DDDLOG("Exiting ReadoutEmulator thread. link_id={} empty_hbfs={} injected_faults={} issued_stfs={} dropped_stfs={}"
+    " lateness_mean_us={:.1f} lateness_max_us={:.1f}", mLinkID, lWorkload.numEmptyHbfs(), lWorkload.numFaults(),
+    lRateControl.numIssued(), lRateControl.numDropped(), lRateControl.meanLatenessUs(), lRateControl.maxLatenessUs());
 }
 
 /// Start "data taking" thread
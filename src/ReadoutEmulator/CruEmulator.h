@@ -12,6 +12,8 @@
 #define ALICEO2_CRU_EMULATOR_H_
 
 #include "CruMemoryHandler.h"
+#include "CruWorkloadGenerator.h"
+#include "CruRateControl.h"
 
 #include <ConcurrentQueue.h>
 #include <ReadoutDataModel.h>
@@ -40,11 +42,13 @@ struct RawDmaChunkDesc {
 class CruLinkEmulator
 {
  public:
-  CruLinkEmulator(std::shared_ptr<CruMemoryHandler> pMemHandler, uint64_t pLinkId, uint64_t pLinkBitsPerS, uint64_t pDmaChunkSize)
+  CruLinkEmulator(std::shared_ptr<CruMemoryHandler> pMemHandler, uint64_t pLinkId, uint64_t pLinkBitsPerS,
+                  const CruWorkloadConfig &pWorkloadConfig, const CruRateConfig &pRateConfig)
     : mMemHandler{ pMemHandler },
       mLinkID{ pLinkId },
       mLinkBitsPerS{ pLinkBitsPerS },
-      mDmaChunkSize{ pDmaChunkSize },
+      mWorkloadConfig{ pWorkloadConfig },
+      mRateConfig{ pRateConfig },
       mRunning{ false }
   {
   }
@@ -66,7 +70,8 @@ class CruLinkEmulator
 
   std::uint64_t mLinkID;
   std::uint64_t mLinkBitsPerS;
-  std::uint64_t mDmaChunkSize;
+  CruWorkloadConfig mWorkloadConfig;
+  CruRateConfig mRateConfig;
 
   std::thread mCRULinkThread;
   bool mRunning;
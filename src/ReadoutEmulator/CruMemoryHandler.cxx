@@ -26,17 +26,14 @@ namespace o2
 namespace DataDistribution
 {
 
-constexpr unsigned long CruMemoryHandler::cBufferBucketSize;
-
 void CruMemoryHandler::teardown()
 {
   mO2LinkDataQueue.stop(); // get will not block, return false
   mSuperpages.stop();
 
-  for (unsigned b = 0; b < cBufferBucketSize; b++) {
-    std::lock_guard<std::mutex> lock(mBufferMap[b].mLock);
-    mBufferMap[b].mVirtToSuperpage.clear();
-    mBufferMap[b].mUsedSuperPages.clear();
+  for (std::size_t i = 0; mSuperpageBuffers && i < mNumSuperpages; i++) {
+    std::lock_guard<std::mutex> lock(mSuperpageBuffers[i].mLock);
+    mSuperpageBuffers[i].mUsedBuffers.clear();
   }
 }
 
@@ -50,29 +47,17 @@ void CruMemoryHandler::init(FairMQUnmanagedRegion* pDataRegion, std::size_t pSup
   // lock and initialize the empty page queue
   mSuperpages.flush();
 
-  for (unsigned b = 0; b < cBufferBucketSize; b++) {
-    std::lock_guard<std::mutex> lock(mBufferMap[b].mLock);
-    mBufferMap[b].mVirtToSuperpage.clear();
-    mBufferMap[b].mUsedSuperPages.clear();
-  }
+  // reset used buffer tracking
+  mNumSuperpages = lCntSuperpages;
+  mSuperpageBuffers = std::make_unique<SuperpageBuffers[]>(lCntSuperpages);
 
   for (size_t i = 0; i < lCntSuperpages; i++) {
-    const CRUSuperpage sp{ getDataRegionPtr() + (i * mSuperpageSize), reinterpret_cast<char*>(~0x0) };
+    const CRUSuperpage sp = getSuperpageFromIndex(i);
     // stack of free superpages to feed the CRU
     if (!sp.mDataVirtualAddress) {
       EDDLOG("init_superpage: Data region pointer null region_ptr={:p}", getDataRegionPtr());
     }
     mSuperpages.push(sp);
-
-    // Virtual address to superpage mapping to help with returning of the used pages
-    if (!sp.mDataVirtualAddress) {
-      EDDLOG("init_superpage: Data region pointer null region_ptr={:p}", getDataRegionPtr());
-    }
-
-    auto& lBucket = getBufferBucket(sp.mDataVirtualAddress);
-    std::lock_guard<std::mutex> lock(lBucket.mLock);
-
-    lBucket.mVirtToSuperpage[sp.mDataVirtualAddress] = sp;
   }
 
   IDDLOG("CRU Memory Handler initialization finished. Using {} superpages.", lCntSuperpages);
@@ -85,15 +70,14 @@ bool CruMemoryHandler::getSuperpage(CRUSuperpage& sp)
 
 void CruMemoryHandler::put_superpage(const char* spVirtAddr)
 {
-  auto& lBucket = getBufferBucket(spVirtAddr);
-
-  std::lock_guard<std::mutex> lock(lBucket.mLock); // needed for the mVirtToSuperpage[] lookup
-  const auto lSp = lBucket.mVirtToSuperpage[spVirtAddr];
-  if (!lSp.mDataVirtualAddress) {
-    EDDLOG("put_superpage: Data region pointer null region_ptr={:p} num_spaages={}",
-      getDataRegionPtr(), lBucket.mVirtToSuperpage.size());
+  const auto lSpIdx = getSuperpageIndex(spVirtAddr);
+  if (spVirtAddr < getDataRegionPtr() || lSpIdx >= mNumSuperpages) {
+    EDDLOG("put_superpage: Superpage outside of the data segment! sp_addr={:p} region_ptr={:p} num_spages={}",
+      spVirtAddr, getDataRegionPtr(), mNumSuperpages);
+    return;
   }
-  mSuperpages.push(lSp);
+
+  mSuperpages.push(getSuperpageFromIndex(lSpIdx));
 }
 
 size_t CruMemoryHandler::free_superpages()
@@ -103,73 +87,67 @@ size_t CruMemoryHandler::free_superpages()
 
 void CruMemoryHandler::get_data_buffer(const char* dataBufferAddr, const std::size_t dataBuffSize)
 {
-  const char* lSpStartAddr = reinterpret_cast<char*>((uintptr_t)dataBufferAddr & ~(mSuperpageSize - 1));
+  const auto lSpIdx = getSuperpageIndex(dataBufferAddr);
+  if (dataBufferAddr < getDataRegionPtr() || lSpIdx >= mNumSuperpages) {
+    EDDLOG("Used data buffer outside of the data segment! b_addr={:p} reg_addr={:p}",
+      dataBufferAddr, getDataRegionPtr());
+    return;
+  }
 
-  auto& lBucket = getBufferBucket(lSpStartAddr);
-  std::lock_guard<std::mutex> lock(lBucket.mLock);
+  auto& lSpBuffers = mSuperpageBuffers[lSpIdx];
+  std::lock_guard<std::mutex> lock(lSpBuffers.mLock);
 
   // make sure the data buffer is not already in use
-  if (lBucket.mUsedSuperPages[lSpStartAddr].count(dataBufferAddr) != 0) {
-    EDDLOG("Data buffer is already in the used list! addr={:#010X}", dataBufferAddr);
+  if (lSpBuffers.mUsedBuffers.count(dataBufferAddr) != 0) {
+    EDDLOG("Data buffer is already in the used list! addr={:#010X}", reinterpret_cast<uintptr_t>(dataBufferAddr));
     return;
   }
 
-  lBucket.mUsedSuperPages[lSpStartAddr][dataBufferAddr] = dataBuffSize;
+  lSpBuffers.mUsedBuffers[dataBufferAddr] = dataBuffSize;
 }
 
 void CruMemoryHandler::put_data_buffer(const char* dataBufferAddr, const std::size_t dataBuffSize)
 {
-  const char* lSpStartAddr = reinterpret_cast<char*>((uintptr_t)dataBufferAddr & ~(mSuperpageSize - 1));
+  const auto lSpIdx = getSuperpageIndex(dataBufferAddr);
 
-  if (lSpStartAddr < getDataRegionPtr() || lSpStartAddr > getDataRegionPtr() + getDataRegionSize()) {
+  if (dataBufferAddr < getDataRegionPtr() || lSpIdx >= mNumSuperpages) {
     EDDLOG("Returned data buffer outside of the data segment!"
-      " sp_start={:#010X} b_addr={:#010X} reg_addr={:#010X} reg_end={:#010X}",
-      reinterpret_cast<uintptr_t>(lSpStartAddr),
+      " b_addr={:#010X} reg_addr={:#010X} reg_end={:#010X}",
       reinterpret_cast<uintptr_t>(dataBufferAddr),
       reinterpret_cast<uintptr_t>(getDataRegionPtr()),
       reinterpret_cast<uintptr_t>(getDataRegionPtr() + getDataRegionSize()));
     return;
   }
 
-  const auto lDataBufferAddr = dataBufferAddr;
-  const auto lDataBuffSize = dataBuffSize;
-
-  auto& lBucket = getBufferBucket(lSpStartAddr);
-  std::lock_guard<std::mutex> lock(lBucket.mLock);
+  auto& lSpBuffers = mSuperpageBuffers[lSpIdx];
+  {
+    std::lock_guard<std::mutex> lock(lSpBuffers.mLock);
 
-  if (lBucket.mUsedSuperPages.count(lSpStartAddr) == 0) {
-    EDDLOG_RL(200, "Returned data buffer is not in the list of used superpages!");
-    return;
-  }
-
-  auto& lSpBuffMap = lBucket.mUsedSuperPages[lSpStartAddr];
-
-  if (lSpBuffMap.count(lDataBufferAddr) == 0) {
-    EDDLOG("Returned data buffer is not marked as used within the superpage!");
-    return;
-  }
-
-  if (lSpBuffMap[lDataBufferAddr] != lDataBuffSize) {
-    EDDLOG("Returned data buffer size does not match the records! recorded={} returned={}",
-      lSpBuffMap[lDataBufferAddr], lDataBuffSize);
-    return;
-  }
+    if (lSpBuffers.mUsedBuffers.empty()) {
+      EDDLOG_RL(200, "Returned data buffer is not in the list of used superpages!");
+      return;
+    }
 
-  if (lSpBuffMap.size() > 1) {
-    lSpBuffMap.erase(lDataBufferAddr);
-  } else if (lSpBuffMap.size() == 1) {
-    lBucket.mUsedSuperPages.erase(lSpStartAddr);
+    const auto lBuffIt = lSpBuffers.mUsedBuffers.find(dataBufferAddr);
+    if (lBuffIt == lSpBuffers.mUsedBuffers.end()) {
+      EDDLOG("Returned data buffer is not marked as used within the superpage!");
+      return;
+    }
 
-    const auto lSp = lBucket.mVirtToSuperpage[lSpStartAddr];
-    if (!lSp.mDataVirtualAddress) {
-      EDDLOG("put_data_buffer: Data region pointer null region_ptr={:p} sp_addr={:p} num_spaages={}",
-        getDataRegionPtr(), lSpStartAddr, lBucket.mVirtToSuperpage.size());
+    if (lBuffIt->second != dataBuffSize) {
+      EDDLOG("Returned data buffer size does not match the records! recorded={} returned={}",
+        lBuffIt->second, dataBuffSize);
+      return;
     }
 
-    mSuperpages.push(lSp);
-  } else {
-    EDDLOG("Superpage chunk lost.");
+    lSpBuffers.mUsedBuffers.erase(lBuffIt);
+    if (!lSpBuffers.mUsedBuffers.empty()) {
+      return;
+    }
   }
+
+  // last buffer of the superpage returned
+  mSuperpages.push(getSuperpageFromIndex(lSpIdx));
 }
 }
 } /* namespace o2::DataDistribution */
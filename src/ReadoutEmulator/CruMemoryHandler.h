@@ -23,6 +23,8 @@
 #include <vector>
 #include <queue>
 #include <iterator>
+#include <memory>
+#include <unordered_map>
 
 #include <mutex>
 #include <condition_variable>
@@ -84,6 +86,7 @@ class CruMemoryHandler
   void put_superpage(const char* spVirtAddr);
 
   // address must match shm fairmq messages sent out
+  // NOTE: all buffers of a superpage must be taken before any of them is returned
   void get_data_buffer(const char* dataBufferAddr, const std::size_t dataBuffSize);
   void put_data_buffer(const char* dataBufferAddr, const std::size_t dataBuffSize);
   size_t free_superpages();
@@ -125,21 +128,24 @@ class CruMemoryHandler
   ConcurrentLifo<CRUSuperpage> mSuperpages;
 
   /// used buffers
-  /// split tracking for scalability into several buckets based on sp address
-  static constexpr unsigned long cBufferBucketSize = 127;
-
-  struct BufferBucket {
+  /// tracked for each superpage, indexed by (addr - region_base) / superpage_size
+  struct SuperpageBuffers {
     std::mutex mLock;
-    std::unordered_map<const char*, CRUSuperpage> mVirtToSuperpage;
-    // map<sp_address, map<buff_addr, buf_len>>
-    std::unordered_map<const char*, std::unordered_map<const char*, std::size_t>> mUsedSuperPages;
+    // map<buff_addr, buf_len>: the superpage is free when the last buffer is returned
+    std::unordered_map<const char*, std::size_t> mUsedBuffers;
   };
 
-  BufferBucket mBufferMap[cBufferBucketSize];
+  std::size_t mNumSuperpages = 0;
+  std::unique_ptr<SuperpageBuffers[]> mSuperpageBuffers;
+
+  inline std::size_t getSuperpageIndex(const char* pAddr) const
+  {
+    return std::size_t(pAddr - getDataRegionPtr()) / mSuperpageSize;
+  }
 
-  BufferBucket& getBufferBucket(const char* pAddr)
+  inline CRUSuperpage getSuperpageFromIndex(const std::size_t pIdx) const
   {
-    return mBufferMap[std::hash<const char*>{}(pAddr) % cBufferBucketSize];
+    return CRUSuperpage{ getDataRegionPtr() + (pIdx * mSuperpageSize), reinterpret_cast<char*>(~0x0) };
   }
 
   /// output data queue
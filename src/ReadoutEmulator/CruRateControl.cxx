@@ -0,0 +1,246 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "CruRateControl.h"
+#include "DataDistLogger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+namespace o2::DataDistribution
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// CruRateConfig
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<double> CruRateConfig::parseStepFactors(const std::string &pFactors)
+{
+  std::vector<double> lFactors;
+  std::istringstream lStream(pFactors);
+  std::string lToken;
+
+  while (std::getline(lStream, lToken, ',')) {
+    if (lToken.find_first_not_of(" \t") == std::string::npos) {
+      continue;
+    }
+
+    const auto lFactor = std::stod(lToken); // throws on invalid input
+    if (lFactor < 0.0) {
+      throw std::out_of_range("Rate factor must not be negative: " + lToken);
+    }
+    lFactors.push_back(lFactor);
+  }
+
+  if (lFactors.empty() || std::accumulate(lFactors.begin(), lFactors.end(), 0.0) <= 0.0) {
+    throw std::invalid_argument("At least one rate factor must be positive: " + pFactors);
+  }
+
+  return lFactors;
+}
+
+std::istream& operator>>(std::istream& in, CruRateConfig::RateProfile& pRetVal)
+{
+  std::string token;
+  in >> token;
+
+  if (token == "stable") {
+    pRetVal = CruRateConfig::eStable;
+  } else if (token == "bursty") {
+    pRetVal = CruRateConfig::eBursty;
+  } else if (token == "stepped") {
+    pRetVal = CruRateConfig::eStepped;
+  } else {
+    in.setstate(std::ios_base::failbit);
+  }
+  return in;
+}
+
+std::string to_string(const CruRateConfig::RateProfile pProfile)
+{
+  switch (pProfile)
+  {
+    case CruRateConfig::eStable:
+      return "stable";
+    case CruRateConfig::eBursty:
+      return "bursty";
+    case CruRateConfig::eStepped:
+      return "stepped";
+    default:
+      return "invalid";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// CruLinkRateControl
+////////////////////////////////////////////////////////////////////////////////
+
+// bound the wait, so the caller can check if it should still be running
+static constexpr auto cMaxWait = std::chrono::milliseconds(100);
+
+CruLinkRateControl::CruLinkRateControl(const CruRateConfig &pConfig)
+  : mConfig(pConfig),
+    mPeriodS(std::max(std::chrono::duration<double>(pConfig.mPeriod).count(), 1e-3)),
+    mStepFactorSum(std::accumulate(pConfig.mStepFactors.begin(), pConfig.mStepFactors.end(), 0.0)),
+    mStart(clock::now())
+{
+  if (mConfig.mStfRate <= 0.0) {
+    throw std::invalid_argument("STF rate must be positive");
+  }
+
+  if (mConfig.mProfile == CruRateConfig::eBursty && (mConfig.mBurstDuty <= 0.0 || mConfig.mBurstDuty > 1.0)) {
+    throw std::invalid_argument("Burst duty cycle must be in the (0, 1] range");
+  }
+
+  if (mConfig.mProfile == CruRateConfig::eStepped && !(mStepFactorSum > 0.0)) {
+    throw std::invalid_argument("At least one rate step factor must be positive");
+  }
+}
+
+double CruLinkRateControl::stfsDue(const double pTime) const
+{
+  const double lRate = mConfig.mStfRate;
+
+  switch (mConfig.mProfile) {
+    case CruRateConfig::eBursty:
+    {
+      const double lPeriods = std::floor(pTime / mPeriodS);
+      const double lRem = pTime - lPeriods * mPeriodS;
+      const double lOnTime = mConfig.mBurstDuty * mPeriodS;
+      return lRate * (lPeriods * mPeriodS + std::min(lRem, lOnTime) / mConfig.mBurstDuty);
+    }
+    case CruRateConfig::eStepped:
+    {
+      const auto &lFactors = mConfig.mStepFactors;
+      const double lPeriods = std::floor(pTime / mPeriodS);
+      const double lCycles = std::floor(lPeriods / lFactors.size());
+      const std::size_t lStepIdx = std::size_t(lPeriods - lCycles * lFactors.size());
+
+      double lDue = lCycles * mStepFactorSum * mPeriodS;
+      for (std::size_t i = 0; i < lStepIdx; i++) {
+        lDue += lFactors[i] * mPeriodS;
+      }
+      lDue += lFactors[lStepIdx] * (pTime - lPeriods * mPeriodS);
+      return lRate * lDue;
+    }
+    case CruRateConfig::eStable:
+    default:
+      return lRate * pTime;
+  }
+}
+
+double CruLinkRateControl::timeOfStfs(const double pStfs) const
+{
+  // normalized to the nominal rate
+  const double lDue = pStfs / mConfig.mStfRate;
+
+  switch (mConfig.mProfile) {
+    case CruRateConfig::eBursty:
+    {
+      const double lPeriods = std::floor(lDue / mPeriodS);
+      const double lRem = lDue - lPeriods * mPeriodS;
+      return lPeriods * mPeriodS + lRem * mConfig.mBurstDuty;
+    }
+    case CruRateConfig::eStepped:
+    {
+      const auto &lFactors = mConfig.mStepFactors;
+      const double lCycles = std::floor(lDue / (mStepFactorSum * mPeriodS));
+      double lRem = lDue - lCycles * mStepFactorSum * mPeriodS;
+      double lTime = lCycles * lFactors.size() * mPeriodS;
+
+      for (const auto lFactor : lFactors) {
+        const double lStepDue = lFactor * mPeriodS;
+        if (lRem <= lStepDue && lFactor > 0.0) {
+          return lTime + lRem / lFactor;
+        }
+        lRem -= lStepDue;
+        lTime += mPeriodS;
+      }
+      return lTime; // rounding: start of the next cycle
+    }
+    case CruRateConfig::eStable:
+    default:
+      return lDue;
+  }
+}
+
+void CruLinkRateControl::sleepUntil(const clock::time_point &pDeadline) const
+{
+  const auto lSleepUntil = pDeadline - mConfig.mSpinTime;
+
+  if (lSleepUntil > clock::now()) {
+#if defined(__linux__)
+    // steady_clock is CLOCK_MONOTONIC
+    const auto lNs = std::chrono::duration_cast<std::chrono::nanoseconds>(lSleepUntil.time_since_epoch()).count();
+    struct timespec lTs;
+    lTs.tv_sec = lNs / 1000000000;
+    lTs.tv_nsec = lNs % 1000000000;
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &lTs, nullptr) == EINTR) { }
+#else
+    std::this_thread::sleep_until(lSleepUntil);
+#endif
+  }
+
+  // spin for the rest
+  while (clock::now() < pDeadline) { }
+}
+
+std::uint64_t CruLinkRateControl::waitForStfs()
+{
+  using dsec = std::chrono::duration<double>;
+
+  auto lNow = clock::now();
+  double lAvail = stfsDue(dsec(lNow - mStart).count()) - double(mNumIssued);
+
+  // token bucket: drop the backlog exceeding the bucket depth
+  if (lAvail > mConfig.mBucketDepth) {
+    const auto lDrop = std::uint64_t(lAvail - mConfig.mBucketDepth);
+    mNumIssued += lDrop;
+    mNumDropped += lDrop;
+    lAvail -= double(lDrop);
+
+    WDDLOG_RL(1000, "Data producer is running slow. dropped_stfs={} total_dropped={}", lDrop, mNumDropped);
+  }
+
+  if (lAvail >= 1.0) {
+    const auto lStfs = std::uint64_t(lAvail);
+    mNumIssued += lStfs;
+    return lStfs;
+  }
+
+  // deadline of the next STF
+  const auto lDeadline = mStart + std::chrono::duration_cast<clock::duration>(dsec(timeOfStfs(double(mNumIssued + 1))));
+  if (lDeadline - lNow > cMaxWait) {
+    sleepUntil(lNow + cMaxWait);
+    return 0;
+  }
+
+  sleepUntil(lDeadline);
+
+  // record lateness
+  const double lLatenessUs = std::chrono::duration<double, std::micro>(clock::now() - lDeadline).count();
+  mLatenessUsMean = mLatenessUsMean * 0.99 + lLatenessUs * 0.01;
+  mLatenessUsMax = std::max(mLatenessUsMax, lLatenessUs);
+
+  mNumIssued += 1;
+  return 1;
+}
+
+} /* namespace o2::DataDistribution */
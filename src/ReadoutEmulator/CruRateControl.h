@@ -0,0 +1,100 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef ALICEO2_CRU_RATE_CONTROL_H_
+#define ALICEO2_CRU_RATE_CONTROL_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <istream>
+
+namespace o2::DataDistribution
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// CruRateConfig
+////////////////////////////////////////////////////////////////////////////////
+
+struct CruRateConfig {
+  enum RateProfile {
+    eStable,  // constant rate
+    eBursty,  // full period average rate, produced in the first mBurstDuty fraction of each period
+    eStepped  // rate multiplied by mStepFactors[i], changing every period
+  };
+
+  RateProfile mProfile = eStable;
+  double mStfRate = 11223.0 / 256.0;  // nominal STFs per second
+
+  // token bucket: max number of STFs produced back-to-back after a stall. Older STFs are dropped.
+  double mBucketDepth = 4.0;
+
+  // sleep until (deadline - spin), and busy wait for the rest
+  std::chrono::microseconds mSpinTime = std::chrono::microseconds(50);
+
+  std::chrono::milliseconds mPeriod = std::chrono::milliseconds(1000);
+  double mBurstDuty = 0.5;
+  std::vector<double> mStepFactors = { 1.0 };
+
+  // parse comma separated list of rate factors
+  static std::vector<double> parseStepFactors(const std::string &pFactors);
+};
+
+std::istream& operator>>(std::istream& in, CruRateConfig::RateProfile& pRetVal);
+std::string to_string(const CruRateConfig::RateProfile pProfile);
+
+////////////////////////////////////////////////////////////////////////////////
+/// CruLinkRateControl
+////////////////////////////////////////////////////////////////////////////////
+
+/// Paces STF production of a link using absolute deadlines. The number of STFs due at any time
+/// is given by the integral of the rate profile, so oversleeping is compensated without drift.
+class CruLinkRateControl
+{
+ public:
+  using clock = std::chrono::steady_clock;
+
+  CruLinkRateControl() = delete;
+  CruLinkRateControl(const CruRateConfig &pConfig);
+
+  /// Wait for the next STF deadline. Returns the number of STFs to produce now.
+  /// Returns 0 after a bounded wait (e.g. in the idle phase of the bursty profile).
+  std::uint64_t waitForStfs();
+
+  std::uint64_t numIssued() const { return mNumIssued; }
+  std::uint64_t numDropped() const { return mNumDropped; }
+  double meanLatenessUs() const { return mLatenessUsMean; }
+  double maxLatenessUs() const { return mLatenessUsMax; }
+
+ private:
+  // number of STFs due between the start and pTime (seconds since start)
+  double stfsDue(const double pTime) const;
+  // time when pStfs STFs are due (seconds since start)
+  double timeOfStfs(const double pStfs) const;
+
+  void sleepUntil(const clock::time_point &pDeadline) const;
+
+  const CruRateConfig mConfig;
+  const double mPeriodS;
+  const double mStepFactorSum;
+
+  clock::time_point mStart;
+
+  std::uint64_t mNumIssued = 0;  // produced + dropped
+  std::uint64_t mNumDropped = 0;
+
+  double mLatenessUsMean = 0.0;
+  double mLatenessUsMax = 0.0;
+};
+
+} /* namespace o2::DataDistribution */
+
+#endif /* ALICEO2_CRU_RATE_CONTROL_H_ */
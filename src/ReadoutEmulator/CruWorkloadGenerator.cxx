@@ -0,0 +1,242 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "CruWorkloadGenerator.h"
+#include "DataDistLogger.h"
+
+#include <Headers/RAWDataHeader.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace o2::DataDistribution
+{
+
+// RDH trigger type bits
+static constexpr std::uint32_t cTriggerHB = 0x00000002;
+static constexpr std::uint32_t cTriggerTF = 0x00000800;
+
+////////////////////////////////////////////////////////////////////////////////
+/// CruWorkloadConfig
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::uint16_t> CruWorkloadConfig::parseFeeIds(const std::string &pFeeIds)
+{
+  std::vector<std::uint16_t> lFeeIds;
+  std::istringstream lStream(pFeeIds);
+  std::string lToken;
+
+  while (std::getline(lStream, lToken, ',')) {
+    lToken.erase(std::remove_if(lToken.begin(), lToken.end(), ::isspace), lToken.end());
+    if (lToken.empty()) {
+      continue;
+    }
+
+    const auto lFeeId = std::stoul(lToken, nullptr, 0); // throws on invalid input
+    if (lFeeId > 0xFFFF) {
+      throw std::out_of_range("FEE ID must fit into 16 bits: " + lToken);
+    }
+    lFeeIds.push_back(std::uint16_t(lFeeId));
+  }
+
+  return lFeeIds;
+}
+
+std::istream& operator>>(std::istream& in, CruWorkloadConfig::SizeDistribution& pRetVal)
+{
+  std::string token;
+  in >> token;
+
+  if (token == "fixed") {
+    pRetVal = CruWorkloadConfig::eFixed;
+  } else if (token == "uniform") {
+    pRetVal = CruWorkloadConfig::eUniform;
+  } else if (token == "normal") {
+    pRetVal = CruWorkloadConfig::eNormal;
+  } else {
+    in.setstate(std::ios_base::failbit);
+  }
+  return in;
+}
+
+std::string to_string(const CruWorkloadConfig::SizeDistribution pSizeDist)
+{
+  switch (pSizeDist)
+  {
+    case CruWorkloadConfig::eFixed:
+      return "fixed";
+    case CruWorkloadConfig::eUniform:
+      return "uniform";
+    case CruWorkloadConfig::eNormal:
+      return "normal";
+    default:
+      return "invalid";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// CruLinkWorkloadGenerator
+////////////////////////////////////////////////////////////////////////////////
+
+CruLinkWorkloadGenerator::CruLinkWorkloadGenerator(const CruWorkloadConfig &pConfig, const std::uint64_t pLinkId,
+  const std::size_t pMaxHbfSize)
+  : mConfig(pConfig),
+    mLinkId(pLinkId),
+    mFeeId(pConfig.mFeeIds.empty() ? std::uint16_t(0xFEE0 + pLinkId) : pConfig.mFeeIds[pLinkId % pConfig.mFeeIds.size()]),
+    // leave space for the stop page and RDHs of all data pages
+    mMaxPayloadSize(pMaxHbfSize > 2 * cRdhSize ?
+      ((pMaxHbfSize - 2 * cRdhSize) * (cPageSize - cRdhSize) / cPageSize) & ~std::size_t(0xF) : 0),
+    mRng(0x5EED0000 + pLinkId) // deterministic per link
+{
+  if (mConfig.mRdhVersion < 4 || mConfig.mRdhVersion > 6) {
+    EDDLOG("CruLinkWorkloadGenerator: unsupported RDH version={}. Supported versions are 4, 5, and 6.",
+      mConfig.mRdhVersion);
+    throw std::logic_error("Unsupported RDH version for the workload generator.");
+  }
+
+  DDDLOG("CruLinkWorkloadGenerator: link_id={} fee_id={:#06x} rdh_version={} size_dist={} mean={} spread={}"
+    " empty_fraction={} fault_rate={}", mLinkId, mFeeId, mConfig.mRdhVersion, to_string(mConfig.mSizeDist),
+    mConfig.mHbfSizeMean, mConfig.mHbfSizeSpread, mConfig.mEmptyHbfFraction, mConfig.mFaultRate);
+}
+
+std::size_t CruLinkWorkloadGenerator::nextPayloadSize()
+{
+  double lSize = double(mConfig.mHbfSizeMean);
+
+  switch (mConfig.mSizeDist) {
+    case CruWorkloadConfig::eUniform:
+    {
+      const double lMin = std::max(0.0, double(mConfig.mHbfSizeMean) - double(mConfig.mHbfSizeSpread));
+      lSize = std::uniform_real_distribution<double>(lMin, double(mConfig.mHbfSizeMean + mConfig.mHbfSizeSpread))(mRng);
+      break;
+    }
+    case CruWorkloadConfig::eNormal:
+      lSize = std::normal_distribution<double>(double(mConfig.mHbfSizeMean), double(mConfig.mHbfSizeSpread))(mRng);
+      break;
+    case CruWorkloadConfig::eFixed:
+    default:
+      break;
+  }
+
+  lSize = std::clamp(lSize, 0.0, double(mMaxPayloadSize));
+
+  // payload is made of 16 B GBT words
+  return std::size_t(lSize) & ~std::size_t(0xF);
+}
+
+std::size_t CruLinkWorkloadGenerator::prepareHbf(const std::uint32_t pOrbit, const bool pFirstInTf)
+{
+  mOrbit = pOrbit;
+  mFirstInTf = pFirstInTf;
+
+  // empty HBF: only the start and the stop page
+  if (mConfig.mEmptyHbfFraction > 0.0 && mUniform01(mRng) < mConfig.mEmptyHbfFraction) {
+    mPayloadSize = 0;
+    mNumEmptyHbfs++;
+  } else {
+    mPayloadSize = nextPayloadSize();
+  }
+
+  mFault = eNoFault;
+  if (mConfig.mFaultRate > 0.0 && mUniform01(mRng) < mConfig.mFaultRate) {
+    mFault = FaultType(1 + (mRng() % (eFaultCount - 1)));
+    mNumFaults++;
+  }
+
+  const std::size_t lMaxPagePayload = cPageSize - cRdhSize;
+  const std::size_t lNumDataPages = std::max(std::size_t(1), (mPayloadSize + lMaxPagePayload - 1) / lMaxPagePayload);
+  const std::size_t lNumPages = lNumDataPages + ((mFault == eFaultNoStopPage) ? 0 : 1);
+
+  return lNumPages * cRdhSize + mPayloadSize;
+}
+
+void CruLinkWorkloadGenerator::writeHbf(char *pDst)
+{
+  switch (mConfig.mRdhVersion) {
+    case 4:
+      writeHbfImpl<o2::header::RAWDataHeaderV4>(pDst);
+      break;
+    case 5:
+      writeHbfImpl<o2::header::RAWDataHeaderV5>(pDst);
+      break;
+    case 6:
+    default:
+      writeHbfImpl<o2::header::RAWDataHeaderV6>(pDst);
+      break;
+  }
+}
+
+template <typename RDH>
+void CruLinkWorkloadGenerator::writeHbfImpl(char *pDst)
+{
+  static_assert(sizeof(RDH) == cRdhSize, "Unexpected RDH size");
+
+  const std::size_t lMaxPagePayload = cPageSize - cRdhSize;
+  const std::size_t lNumDataPages = std::max(std::size_t(1), (mPayloadSize + lMaxPagePayload - 1) / lMaxPagePayload);
+  const std::size_t lNumPages = lNumDataPages + ((mFault == eFaultNoStopPage) ? 0 : 1);
+
+  const std::uint32_t lOrbit = (mFault == eFaultOrbitJump) ? 0 : mOrbit;
+  const std::uint32_t lTrigger = cTriggerHB | (mFirstInTf ? cTriggerTF : 0);
+
+  std::size_t lPayloadLeft = mPayloadSize;
+  char *lPage = pDst;
+
+  for (std::size_t lPageIdx = 0; lPageIdx < lNumPages; lPageIdx++) {
+    const bool lStopPage = (lPageIdx == lNumDataPages);
+    const std::size_t lPagePayload = lStopPage ? 0 : std::min(lPayloadLeft, lMaxPagePayload);
+    const std::size_t lMemSize = cRdhSize + lPagePayload;
+    lPayloadLeft -= lPagePayload;
+
+    RDH lRdh; // version and header size are set by the constructor
+
+    // equipment
+    lRdh.feeId = mFeeId;
+    lRdh.linkID = mLinkId;
+    lRdh.cruID = mConfig.mCruId;
+    lRdh.endPointID = mConfig.mEndPointId;
+    if constexpr (std::is_same_v<RDH, o2::header::RAWDataHeaderV6>) {
+      lRdh.sourceID = mConfig.mSystemId;
+    }
+
+    // memory layout
+    lRdh.memorySize = lMemSize;
+    lRdh.offsetToNext = lMemSize;
+    lRdh.packetCounter = mPacketCounter++;
+    lRdh.pageCnt = lPageIdx;
+    lRdh.stop = lStopPage ? 1 : 0;
+
+    // trigger
+    lRdh.triggerType = lTrigger;
+    if constexpr (std::is_same_v<RDH, o2::header::RAWDataHeaderV4>) {
+      lRdh.triggerOrbit = lOrbit;
+      lRdh.heartbeatOrbit = lOrbit;
+      lRdh.triggerBC = 0;
+      lRdh.heartbeatBC = 0;
+    } else {
+      lRdh.orbit = lOrbit;
+      lRdh.bunchCrossing = 0;
+    }
+
+    // injected faults in the first page
+    if (lPageIdx == 0 && mFault == eFaultZeroOffset) {
+      lRdh.offsetToNext = 0;
+    } else if (lPageIdx == 0 && mFault == eFaultMemorySize) {
+      lRdh.memorySize = 0xFFFF;
+    }
+
+    std::memcpy(lPage, &lRdh, sizeof(RDH));
+    lPage += lMemSize;
+  }
+}
+
+} /* namespace o2::DataDistribution */
@@ -0,0 +1,128 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef ALICEO2_CRU_WORKLOAD_GENERATOR_H_
+#define ALICEO2_CRU_WORKLOAD_GENERATOR_H_
+
+#include <Headers/DAQID.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <istream>
+
+namespace o2::DataDistribution
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// CruWorkloadConfig
+////////////////////////////////////////////////////////////////////////////////
+
+struct CruWorkloadConfig {
+  enum SizeDistribution {
+    eFixed,
+    eUniform,
+    eNormal
+  };
+
+  unsigned mRdhVersion = 6;
+  std::uint32_t mHbfPerTf = 256;
+  std::uint32_t mFirstOrbit = 1;
+
+  // per link HBF payload size
+  SizeDistribution mSizeDist = eFixed;
+  std::size_t mHbfSizeMean = 8192;
+  std::size_t mHbfSizeSpread = 0;
+
+  // fraction of HBFs without payload (RDH start + stop pages only)
+  double mEmptyHbfFraction = 0.0;
+
+  // equipment
+  std::uint8_t mSystemId = o2::header::DAQID::TPC;
+  std::uint16_t mCruId = 0xEEE;
+  std::uint8_t mEndPointId = 0;
+  std::vector<std::uint16_t> mFeeIds; // assigned round-robin to links. Empty: 0xFEE0 + link id
+
+  // fraction of HBFs with an injected RDH fault
+  double mFaultRate = 0.0;
+
+  // parse comma separated list of FEE IDs (decimal or 0x prefixed hex)
+  static std::vector<std::uint16_t> parseFeeIds(const std::string &pFeeIds);
+};
+
+std::istream& operator>>(std::istream& in, CruWorkloadConfig::SizeDistribution& pRetVal);
+std::string to_string(const CruWorkloadConfig::SizeDistribution pSizeDist);
+
+////////////////////////////////////////////////////////////////////////////////
+/// CruLinkWorkloadGenerator
+////////////////////////////////////////////////////////////////////////////////
+
+/// Produces RDH v4, v5, or v6 formatted HBFs of a single link. Each HBF is made of
+/// 8 kiB (or smaller) pages with consecutive page counters, and is closed with a stop page.
+class CruLinkWorkloadGenerator
+{
+ public:
+  static constexpr std::size_t cRdhSize = 64;
+  static constexpr std::size_t cPageSize = 8192;
+
+  enum FaultType {
+    eNoFault = 0,
+    eFaultZeroOffset,     // offsetToNext of the first page is 0
+    eFaultNoStopPage,     // HBF is not terminated with the stop page
+    eFaultOrbitJump,      // orbit counter resets to 0
+    eFaultMemorySize,     // memorySize points beyond the HBF buffer
+    eFaultCount
+  };
+
+  CruLinkWorkloadGenerator() = delete;
+  CruLinkWorkloadGenerator(const CruWorkloadConfig &pConfig, const std::uint64_t pLinkId, const std::size_t pMaxHbfSize);
+
+  /// Prepare the next HBF of the link. Returns the buffer size required to write it.
+  std::size_t prepareHbf(const std::uint32_t pOrbit, const bool pFirstInTf);
+
+  /// Write the prepared HBF into the buffer
+  void writeHbf(char *pDst);
+
+  std::uint16_t feeId() const { return mFeeId; }
+  std::uint64_t numFaults() const { return mNumFaults; }
+  std::uint64_t numEmptyHbfs() const { return mNumEmptyHbfs; }
+
+ private:
+  template <typename RDH>
+  void writeHbfImpl(char *pDst);
+
+  std::size_t nextPayloadSize();
+
+  const CruWorkloadConfig mConfig;
+  const std::uint64_t mLinkId;
+  const std::uint16_t mFeeId;
+  const std::size_t mMaxPayloadSize;
+
+  std::mt19937_64 mRng;
+  std::uniform_real_distribution<double> mUniform01{0.0, 1.0};
+
+  // prepared HBF
+  std::uint32_t mOrbit = 0;
+  bool mFirstInTf = false;
+  std::size_t mPayloadSize = 0;
+  FaultType mFault = eNoFault;
+
+  // RDH counters
+  std::uint8_t mPacketCounter = 0;
+
+  // stats
+  std::uint64_t mNumFaults = 0;
+  std::uint64_t mNumEmptyHbfs = 0;
+};
+
+} /* namespace o2::DataDistribution */
+
+#endif /* ALICEO2_CRU_WORKLOAD_GENERATOR_H_ */
@@ -18,6 +18,8 @@
 #include <chrono>
 #include <thread>
 #include <functional>
+#include <algorithm>
+#include <map>
 
 
 namespace o2::DataDistribution
@@ -51,8 +53,48 @@ void ReadoutDevice::InitTask()
     mSuperpageSize = (1ULL << 20);
   }
 
-  mDmaChunkSize = (mCruLinkBitsPerS / 11223ULL) >> 3;
-  IDDLOG("Using HBFrame size of {} B.", mDmaChunkSize);
+  // workload
+  mWorkloadConfig.mRdhVersion = GetConfig()->GetValue<unsigned>(OptionKeyRdhVersion);
+  mWorkloadConfig.mFirstOrbit = GetConfig()->GetValue<std::uint32_t>(OptionKeyFirstOrbit);
+  mWorkloadConfig.mSizeDist = GetConfig()->GetValue<CruWorkloadConfig::SizeDistribution>(OptionKeyHbfSizeDist);
+  mWorkloadConfig.mHbfSizeMean = (mCruLinkBitsPerS / 11223ULL) >> 3;
+  mWorkloadConfig.mHbfSizeSpread = GetConfig()->GetValue<std::size_t>(OptionKeyHbfSizeSpread);
+  mWorkloadConfig.mEmptyHbfFraction = std::clamp(GetConfig()->GetValue<double>(OptionKeyEmptyHbfFraction), 0.0, 1.0);
+  mWorkloadConfig.mSystemId = GetConfig()->GetValue<unsigned>(OptionKeySystemId);
+  mWorkloadConfig.mFaultRate = std::clamp(GetConfig()->GetValue<double>(OptionKeyFaultRate), 0.0, 1.0);
+  try {
+    mWorkloadConfig.mFeeIds = CruWorkloadConfig::parseFeeIds(GetConfig()->GetValue<std::string>(OptionKeyFeeIds));
+  } catch (std::logic_error &e) {
+    EDDLOG("Invalid FEE ID list. what={}", e.what());
+    throw;
+  }
+
+  if (mWorkloadConfig.mRdhVersion < 4 || mWorkloadConfig.mRdhVersion > 6) {
+    EDDLOG("Unsupported RDH version={}. Supported versions are 4, 5, and 6.", mWorkloadConfig.mRdhVersion);
+    throw std::logic_error("Unsupported RDH version.");
+  }
+
+  IDDLOG("Using HBFrame size of {} B. distribution={} spread={} empty_fraction={} fault_rate={} rdh_version={}",
+    mWorkloadConfig.mHbfSizeMean, to_string(mWorkloadConfig.mSizeDist), mWorkloadConfig.mHbfSizeSpread,
+    mWorkloadConfig.mEmptyHbfFraction, mWorkloadConfig.mFaultRate, mWorkloadConfig.mRdhVersion);
+
+  // rate
+  mRateConfig.mStfRate = 11223.0 / mWorkloadConfig.mHbfPerTf;
+  mRateConfig.mProfile = GetConfig()->GetValue<CruRateConfig::RateProfile>(OptionKeyRateProfile);
+  mRateConfig.mPeriod = std::chrono::milliseconds(std::max(GetConfig()->GetValue<std::uint64_t>(OptionKeyRatePeriodMs), std::uint64_t(1)));
+  mRateConfig.mBurstDuty = std::clamp(GetConfig()->GetValue<double>(OptionKeyRateBurstDuty), 0.01, 1.0);
+  mRateConfig.mBucketDepth = std::max(GetConfig()->GetValue<double>(OptionKeyRateBucketDepth), 1.0);
+  mRateConfig.mSpinTime = std::chrono::microseconds(GetConfig()->GetValue<std::uint64_t>(OptionKeyRateSpinUs));
+  try {
+    mRateConfig.mStepFactors = CruRateConfig::parseStepFactors(GetConfig()->GetValue<std::string>(OptionKeyRateStepFactors));
+  } catch (std::logic_error &e) {
+    EDDLOG("Invalid rate step factor list. what={}", e.what());
+    throw;
+  }
+
+  IDDLOG("Using STF rate of {:.3f} Hz. profile={} period_ms={} burst_duty={} bucket_depth={} spin_us={}",
+    mRateConfig.mStfRate, to_string(mRateConfig.mProfile), mRateConfig.mPeriod.count(), mRateConfig.mBurstDuty,
+    mRateConfig.mBucketDepth, mRateConfig.mSpinTime.count());
 
   mDataRegion.reset();
 
@@ -73,7 +115,7 @@ void ReadoutDevice::InitTask()
   mCruLinks.clear();
   for (unsigned e = 0; e < mCruLinkCount; e++) {
     mCruLinks.push_back(std::make_unique<CruLinkEmulator>(mCruMemoryHandler, mLinkIdOffset + e,
-      mCruLinkBitsPerS, mDmaChunkSize));
+      mCruLinkBitsPerS, mWorkloadConfig, mRateConfig));
   }
 }
 
@@ -123,68 +165,40 @@ void ReadoutDevice::SendingThread()
 
   auto& lOutputChan = GetChannel(mOutChannelName, 0);
 
-  // finish an STF every ~1/45 seconds
-  static const auto cDataTakingStart = std::chrono::high_resolution_clock::now();
-  static constexpr auto cStfInterval = std::chrono::microseconds(22810);
-  uint64_t lNumberSentStfs = 0;
-  uint64_t lCurrentTfId = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()).count() / cStfInterval.count() - 71394000000;
+  // Links produce data independently. Data of the current TF is forwarded immediately, and
+  // data of following TFs is kept back until all links have finished the current TF.
+  std::map<std::uint64_t, std::vector<ReadoutLinkO2Data>> lPendingTfs;
+  std::uint64_t lCurrentTfId = 0;
+  std::uint64_t lNumLinksFinished = 0;
 
   uint64_t lTfIdToSkip = ~uint64_t(0);
 
+  // returns true if the TF is finished (all links reported the last update)
+  const auto lSendLinkData = [&](ReadoutLinkO2Data &pCruLinkData) -> bool {
+    ReadoutSubTimeframeHeader lHBFHeader = pCruLinkData.mLinkHeader;
+    lHBFHeader.mVersion = 2;
 
-  while (IsRunningState()) {
-
-    ReadoutLinkO2Data lCruLinkData;
-    if (!mCruMemoryHandler->getLinkData(lCruLinkData)) {
-      IDDLOG("GetLinkData failed. Stopping interface thread.");
-      return;
+    if (lHBFHeader.mFlags.mLastTFMessage) {
+      lNumLinksFinished += 1;
     }
+    const bool lTfFinished = (lNumLinksFinished == mCruLinkCount);
+    lHBFHeader.mFlags.mLastTFMessage = lTfFinished ? 1 : 0;
 
     // check no data signal
-    if (lCruLinkData.mLinkHeader.mFlags.mIsRdhFormat == 0) {
+    if (pCruLinkData.mLinkRawData.empty() && !lTfFinished) {
       // WDDLOG("No Superpages left! Losing data...");
-    }
-
-    // debug: skip some of the STFs
-    if (lTfIdToSkip == ~uint64_t(0)) {
-      if ((std::hash<unsigned long long>{}((unsigned long long)lCurrentTfId) % 67) == 0 ) {
-        lTfIdToSkip = lCurrentTfId + 1;
-        IDDLOG("Skipping sending data for tf_id={}", lTfIdToSkip);
-      }
-    } else if (lTfIdToSkip != ~uint64_t(0)) {
-      if (lTfIdToSkip < lCurrentTfId) {
-        lTfIdToSkip = ~uint64_t(0);
-      }
-    }
-
-    ReadoutSubTimeframeHeader lHBFHeader = lCruLinkData.mLinkHeader;
-    lHBFHeader.mVersion = 2;
-    lHBFHeader.mTimeFrameId = lCurrentTfId;
-    lHBFHeader.mTimeframeOrbitFirst = lCurrentTfId * 256;
-    lHBFHeader.mTimeframeOrbitLast = (lCurrentTfId + 1) * 256 - 1;
-    lHBFHeader.mFlags.mLastTFMessage = 0;
-
-    // last one?
-    auto isStfFinished =
-      (std::chrono::high_resolution_clock::now() - cDataTakingStart) - (lNumberSentStfs * cStfInterval) > cStfInterval;
-
-    if (isStfFinished) {
-      lNumberSentStfs += 1;
-      lCurrentTfId = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()).count() / cStfInterval.count() - 71394000000;
-      lHBFHeader.mFlags.mLastTFMessage = 1;
+      return false;
     }
 
     assert(mDataBlockMsgs.empty());
-    mDataBlockMsgs.reserve(lCruLinkData.mLinkRawData.size());
+    mDataBlockMsgs.reserve(pCruLinkData.mLinkRawData.size() + 1);
 
     // create messages for the header
     mDataBlockMsgs.push_back(lOutputChan.NewMessage(sizeof(ReadoutSubTimeframeHeader)));
     std::memcpy(mDataBlockMsgs.front()->GetData(), &lHBFHeader, sizeof(ReadoutSubTimeframeHeader));
 
     // create messages for the data
-    for (const auto& lDmaChunk : lCruLinkData.mLinkRawData) {
+    for (const auto& lDmaChunk : pCruLinkData.mLinkRawData) {
       // mark this as used in the memory handler
       mCruMemoryHandler->get_data_buffer(lDmaChunk.mDataPtr, lDmaChunk.mDataSize);
 
@@ -192,13 +206,59 @@ void ReadoutDevice::SendingThread()
       mDataBlockMsgs.push_back(lOutputChan.NewMessage(mDataRegion, lDmaChunk.mDataPtr, lDmaChunk.mDataSize));
     }
 
-    if (lTfIdToSkip == lHBFHeader.mTimeFrameId) {
-      mDataBlockMsgs.clear();
+    if (lTfIdToSkip != lHBFHeader.mTimeFrameId) {
+      lOutputChan.Send(mDataBlockMsgs);
+    }
+    mDataBlockMsgs.clear();
+
+    return lTfFinished;
+  };
+
+  while (IsRunningState()) {
+
+    ReadoutLinkO2Data lCruLinkData;
+    if (!mCruMemoryHandler->getLinkData(lCruLinkData)) {
+      IDDLOG("GetLinkData failed. Stopping interface thread.");
+      return;
+    }
+
+    const std::uint64_t lTfId = lCruLinkData.mLinkHeader.mTimeFrameId;
+    if (lCurrentTfId == 0) {
+      lCurrentTfId = lTfId;
+    }
+
+    if (lTfId != lCurrentTfId) {
+      lPendingTfs[lTfId].push_back(std::move(lCruLinkData));
       continue;
     }
 
-    lOutputChan.Send(mDataBlockMsgs);
-    mDataBlockMsgs.clear();
+    if (!lSendLinkData(lCruLinkData)) {
+      continue;
+    }
+
+    // current TF is finished. Send the data of the next TF kept back while waiting for slower links
+    bool lTfFinished = true;
+    while (lTfFinished) {
+      lCurrentTfId += 1;
+      lNumLinksFinished = 0;
+      lTfFinished = false;
+
+      // debug: skip some of the STFs
+      if ((std::hash<unsigned long long>{}((unsigned long long)lCurrentTfId) % 67) == 0 ) {
+        lTfIdToSkip = lCurrentTfId;
+        IDDLOG("Skipping sending data for tf_id={}", lTfIdToSkip);
+      }
+
+      auto lPendingIt = lPendingTfs.find(lCurrentTfId);
+      if (lPendingIt == lPendingTfs.end()) {
+        break;
+      }
+
+      for (auto &lPendingData : lPendingIt->second) {
+        lTfFinished = lSendLinkData(lPendingData);
+      }
+      lPendingTfs.erase(lPendingIt);
+    }
   }
 }
 
@@ -38,6 +38,22 @@ class ReadoutDevice : public DataDistDevice
   static constexpr const char* OptionKeyCruLinkCount = "cru-link-count";
   static constexpr const char* OptionKeyCruLinkBitsPerS = "cru-link-bits-per-s";
 
+  static constexpr const char* OptionKeyRdhVersion = "rdh-version";
+  static constexpr const char* OptionKeyFirstOrbit = "first-orbit";
+  static constexpr const char* OptionKeyHbfSizeDist = "hbf-size-distribution";
+  static constexpr const char* OptionKeyHbfSizeSpread = "hbf-size-spread";
+  static constexpr const char* OptionKeyEmptyHbfFraction = "empty-hbf-fraction";
+  static constexpr const char* OptionKeySystemId = "system-id";
+  static constexpr const char* OptionKeyFeeIds = "fee-ids";
+  static constexpr const char* OptionKeyFaultRate = "fault-rate";
+
+  static constexpr const char* OptionKeyRateProfile = "rate-profile";
+  static constexpr const char* OptionKeyRatePeriodMs = "rate-profile-period-ms";
+  static constexpr const char* OptionKeyRateBurstDuty = "rate-burst-duty";
+  static constexpr const char* OptionKeyRateStepFactors = "rate-step-factors";
+  static constexpr const char* OptionKeyRateBucketDepth = "rate-bucket-depth";
+  static constexpr const char* OptionKeyRateSpinUs = "rate-spin-us";
+
   /// Default constructor
   ReadoutDevice();
 
@@ -66,10 +82,12 @@ class ReadoutDevice : public DataDistDevice
   std::size_t mLinkIdOffset;
 
   std::size_t mSuperpageSize;
-  std::size_t mDmaChunkSize;
   unsigned mCruLinkCount;
   std::uint64_t mCruLinkBitsPerS;
 
+  CruWorkloadConfig mWorkloadConfig;
+  CruRateConfig mRateConfig;
+
   std::shared_ptr<CruMemoryHandler> mCruMemoryHandler;
 
   std::vector<std::unique_ptr<CruLinkEmulator>> mCruLinks;
@@ -37,7 +37,51 @@ void addCustomOptions(bpo::options_description& options)
     "Number of CRU equipments to emulate (links, user logics, ...).")(
     o2::DataDistribution::ReadoutDevice::OptionKeyCruLinkBitsPerS,
     bpo::value<double>()->default_value(1000000000),
-    "Input throughput per link (bits per second).");
+    "Input throughput per link (bits per second).")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyRdhVersion,
+    bpo::value<unsigned>()->default_value(6),
+    "RDH version of generated data. Supported versions are 4, 5, and 6.")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyFirstOrbit,
+    bpo::value<std::uint32_t>()->default_value(1),
+    "Orbit counter of the first generated HBF.")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyHbfSizeDist,
+    bpo::value<o2::DataDistribution::CruWorkloadConfig::SizeDistribution>()->default_value(
+      o2::DataDistribution::CruWorkloadConfig::eFixed, "fixed"),
+    "Distribution of HBF sizes per link (fixed|uniform|normal). Mean is given by the link throughput.")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyHbfSizeSpread,
+    bpo::value<std::size_t>()->default_value(0),
+    "Spread of HBF sizes: half-width of the uniform, or sigma of the normal distribution (bytes).")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyEmptyHbfFraction,
+    bpo::value<double>()->default_value(0.0),
+    "Fraction of empty HBFs (only RDH start and stop pages).")(
+    o2::DataDistribution::ReadoutDevice::OptionKeySystemId,
+    bpo::value<unsigned>()->default_value(o2::header::DAQID::TPC),
+    "DAQ System ID of generated data (RDHv6 only).")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyFeeIds,
+    bpo::value<std::string>()->default_value(""),
+    "Comma separated list of FEE IDs assigned to links round-robin. Default: 0xFEE0 + link id.")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyFaultRate,
+    bpo::value<double>()->default_value(0.0),
+    "Fraction of HBFs with injected RDH faults (zero offset, missing stop, orbit reset, bad memory size).")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyRateProfile,
+    bpo::value<o2::DataDistribution::CruRateConfig::RateProfile>()->default_value(
+      o2::DataDistribution::CruRateConfig::eStable, "stable"),
+    "STF rate profile (stable|bursty|stepped). Nominal rate is given by the HBF rate and the TF length.")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyRatePeriodMs,
+    bpo::value<std::uint64_t>()->default_value(1000),
+    "Period of the bursty profile, or duration of each step of the stepped profile (ms).")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyRateBurstDuty,
+    bpo::value<double>()->default_value(0.5),
+    "Fraction of the period producing data in the bursty profile. Average rate is kept nominal.")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyRateStepFactors,
+    bpo::value<std::string>()->default_value("1.0"),
+    "Comma separated list of rate multipliers for the stepped profile, applied cyclically.")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyRateBucketDepth,
+    bpo::value<double>()->default_value(4.0),
+    "Maximum number of STFs produced back-to-back after a stall. Older STFs are dropped.")(
+    o2::DataDistribution::ReadoutDevice::OptionKeyRateSpinUs,
+    bpo::value<std::uint64_t>()->default_value(50),
+    "Busy-wait time before each STF deadline, to absorb the scheduler wake-up latency (us).");
 }
 
 FairMQDevicePtr getDevice(const FairMQProgOptions& /*config*/)
@@ -105,6 +105,10 @@ void StfBuilderDevice::InitTask()
   DataDistMonitor::set_interval(GetConfig()->GetValue<float>("monitoring-interval"));
   DataDistMonitor::set_log(GetConfig()->GetValue<bool>("monitoring-log"));
 
+  // start STF tracing
+  DataDistTracer::start("StfBuilder", GetConfig()->GetValue<std::uint64_t>("trace-sample-interval"),
+    GetConfig()->GetValue<std::string>("trace-dump-dir"));
+
   // input data handling
   ReadoutDataUtils::sSpecifiedDataOrigin = getDataOriginFromOption(
     GetConfig()->GetValue<std::string>(OptionKeyStfDetector));
@@ -312,6 +316,9 @@ void StfBuilderDevice::ResetTask()
   // stop the memory resources very last
   MemI().stop();
 
+  // stop STF tracing
+  DataDistTracer::stop();
+
   DDDLOG("StfBuilderDevice::ResetTask() done... ");
 }
 
@@ -381,6 +388,9 @@ void StfBuilderDevice::StfOutputThread()
       DDMON("stfbuilder", "data_output.rate", (lRate * lStf->getDataSize()));
     }
 
+    lStf->traceStamp(eStfTraceStfBuilderOut);
+    DataDistTracer::record(lStf->id(), lStf->trace());
+
     if (!isStandalone()) {
       try {
         assert (lStfDplAdapter);
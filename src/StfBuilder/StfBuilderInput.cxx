@@ -251,6 +251,7 @@ void StfInputInterface::StfBuilderThread()
         }
 
         (*lStf)->setOrigin(SubTimeFrame::Header::Origin::eReadout);
+        (*lStf)->traceStamp(eStfTraceBuilt);
         mSeqStfQueue.push(std::move(*lStf));
         {
           auto lNow = hres_clock::now();
@@ -472,6 +473,7 @@ void StfInputInterface::TopologicalStfBuilderThread()
       sStfId += 1;
       pStf->updateId(sStfId);
       pStf->setOrigin(SubTimeFrame::Header::Origin::eReadoutTopology);
+      pStf->traceStamp(eStfTraceBuilt);
 
       mDevice.I().queue(eStfBuilderOut, std::move(pStf));
       {
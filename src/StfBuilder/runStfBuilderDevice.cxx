@@ -43,6 +43,8 @@ int main(int argc, char* argv[])
       r.fConfig.AddToCmdLineOptions(impl::DataDistLoggerCtx::getProgramOptions());
       // Add Monitoring Options
       r.fConfig.AddToCmdLineOptions(DataDistMonitor::getProgramOptions());
+      // Add Tracing Options
+      r.fConfig.AddToCmdLineOptions(DataDistTracer::getProgramOptions());
 
       bpo::options_description lStfBuilderOptions("StfBuilder options", 120);
 
@@ -0,0 +1,273 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <SubTimeFrameFile.h>
+#include <SubTimeFrameFileChecksum.h>
+
+#include <boost/program_options.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __linux__
+#include <sys/mman.h>
+#endif
+
+using namespace o2::DataDistribution;
+using namespace o2::header;
+
+namespace {
+
+using DataIndexElem = SubTimeFrameFileDataIndex::DataIndexElem;
+
+struct StfFile {
+  std::string mFileName;
+  boost::iostreams::mapped_file_source mFileMap;
+
+  std::uint64_t mNumStfs = 0;
+  std::uint64_t mNumNoChecksum = 0; // STFs written without checksums
+  std::atomic_uint64_t mNumErrors = 0;
+  bool mValid = true;
+};
+
+struct VerifyTask {
+  StfFile *mFile;
+  std::uint64_t mStfId;
+  const char *mDataStart;
+  DataIndexElem mElem;
+};
+
+/// Walk the STFs of the file using the meta and index headers, and collect the index elements
+static void collectTasks(StfFile &pFile, std::vector<VerifyTask> &pTasks)
+{
+  const char *lData = pFile.mFileMap.data();
+  std::uint64_t lFileSize = pFile.mFileMap.size();
+  std::uint64_t lPos = 0;
+
+  // STF data ends at the directory footer, if present
+  if (lFileSize >= sizeof(SubTimeFrameFileFooter)) {
+    SubTimeFrameFileFooter lFooter;
+    std::memcpy(&lFooter, lData + lFileSize - sizeof(SubTimeFrameFileFooter), sizeof(SubTimeFrameFileFooter));
+    if (lFooter.valid() && (lFooter.mDirectoryOffset + lFooter.getSizeInFile()) == lFileSize) {
+      lFileSize = lFooter.mDirectoryOffset;
+    }
+  }
+
+  while (lPos < lFileSize) {
+    // DataHeader + SubTimeFrameFileMeta
+    DataHeader lMetaHdr;
+    if ((lFileSize - lPos) < sizeof(BaseHeader)) {
+      break;
+    }
+    std::memcpy(&lMetaHdr, lData + lPos, std::min(std::uint64_t(sizeof(DataHeader)), lFileSize - lPos));
+
+    // the meta header stack contains the SubTimeFrameFileStfOrder header since version 3
+    std::uint64_t lMetaHdrStackSize = 0;
+    std::uint64_t lStfId = pFile.mNumStfs;
+    for (bool lNextHdr = true; lNextHdr; ) {
+      DataHeader lHdr;
+      if ((lPos + lMetaHdrStackSize + sizeof(BaseHeader)) > lFileSize) {
+        lMetaHdrStackSize = 0;
+        break;
+      }
+      std::memcpy(&lHdr, lData + lPos + lMetaHdrStackSize, sizeof(BaseHeader));
+      if (lHdr.headerSize < sizeof(BaseHeader) || (lPos + lMetaHdrStackSize + lHdr.headerSize) > lFileSize) {
+        lMetaHdrStackSize = 0;
+        break;
+      }
+
+      if (lHdr.description == SubTimeFrameFileStfOrder::sHeaderType && lHdr.headerSize >= sizeof(SubTimeFrameFileStfOrder)) {
+        SubTimeFrameFileStfOrder lOrderHdr(0, {});
+        std::memcpy(&lOrderHdr, lData + lPos + lMetaHdrStackSize, sizeof(SubTimeFrameFileStfOrder));
+        lStfId = lOrderHdr.mStfId;
+      }
+
+      lMetaHdrStackSize += lHdr.headerSize;
+      lNextHdr = lHdr.flagsNextHeader;
+    }
+
+    if (!(lMetaHdr.dataDescription == SubTimeFrameFileMeta::sDataDescFileSubTimeFrame) || lMetaHdrStackSize == 0 ||
+        (lPos + lMetaHdrStackSize + lMetaHdr.payloadSize) > lFileSize) {
+      std::cerr << fmt::format("{}: invalid STF meta header at offset {}", pFile.mFileName, lPos) << std::endl;
+      pFile.mValid = false;
+      return;
+    }
+
+    SubTimeFrameFileMeta lMeta;
+    std::memcpy(&lMeta, lData + lPos + lMetaHdrStackSize,
+      std::min(lMetaHdr.payloadSize, std::uint64_t(sizeof(SubTimeFrameFileMeta))));
+
+    if (lMeta.mStfSizeInFile == 0 || (lPos + lMeta.mStfSizeInFile) > lFileSize) {
+      std::cerr << fmt::format("{}: truncated STF at offset {}. stf_size={} file_size={}",
+        pFile.mFileName, lPos, lMeta.mStfSizeInFile, lFileSize) << std::endl;
+      pFile.mValid = false;
+      return;
+    }
+
+    // DataHeader + index
+    const std::uint64_t lIndexPos = lPos + lMetaHdrStackSize + lMetaHdr.payloadSize;
+    DataHeader lIndexHdr;
+    std::memcpy(&lIndexHdr, lData + lIndexPos, sizeof(DataHeader));
+
+    const std::uint64_t lDataPos = lIndexPos + lIndexHdr.headerSize + lIndexHdr.payloadSize;
+    if (!(lIndexHdr.dataDescription == SubTimeFrameFileDataIndex::sDataDescFileStfDataIndex) ||
+        lDataPos > (lPos + lMeta.mStfSizeInFile)) {
+      std::cerr << fmt::format("{}: invalid STF index header at offset {}", pFile.mFileName, lIndexPos) << std::endl;
+      pFile.mValid = false;
+      return;
+    }
+
+    pFile.mNumStfs++;
+
+    if (lMeta.mStfFileVersion < 4) {
+      pFile.mNumNoChecksum++;
+    } else {
+      const std::uint64_t lStfDataSize = lPos + lMeta.mStfSizeInFile - lDataPos;
+      const auto *lElems = reinterpret_cast<const DataIndexElem*>(lData + lIndexPos + lIndexHdr.headerSize);
+
+      for (std::size_t i = 0; i < lIndexHdr.payloadSize / sizeof(DataIndexElem); i++) {
+        if ((lElems[i].mOffset + lElems[i].mSize) > lStfDataSize) {
+          std::cerr << fmt::format("{}: index element beyond the STF data. stf_id={} offset={} size={}",
+            pFile.mFileName, lStfId, lElems[i].mOffset, lElems[i].mSize) << std::endl;
+          pFile.mNumErrors++;
+          continue;
+        }
+        pTasks.push_back(VerifyTask{ &pFile, lStfId, lData + lDataPos, lElems[i] });
+      }
+    }
+
+    lPos += lMeta.mStfSizeInFile;
+  }
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+  namespace bpo = boost::program_options;
+
+  bpo::options_description lOptions("StfFileVerify options", 120);
+  lOptions.add_options()
+    ("help,h", "Print help.")
+    ("file", bpo::value<std::vector<std::string>>()->composing(), "(Sub)TimeFrame file(s) to verify.")
+    ("threads,t", bpo::value<unsigned>()->default_value(std::max(1U, std::thread::hardware_concurrency())),
+      "Number of verification threads.");
+
+  bpo::positional_options_description lPositional;
+  lPositional.add("file", -1);
+
+  bpo::variables_map lVm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(lOptions).positional(lPositional).run(), lVm);
+    bpo::notify(lVm);
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n" << lOptions << std::endl;
+    return 1;
+  }
+
+  if (lVm.count("help") || !lVm.count("file")) {
+    std::cout << "Usage: StfFileVerify [options] <file.tf>...\n" << lOptions << std::endl;
+    return lVm.count("help") ? 0 : 1;
+  }
+
+  const auto lNumThreads = std::max(1U, lVm["threads"].as<unsigned>());
+  const auto lStart = std::chrono::steady_clock::now();
+
+  // map all files and collect index elements
+  const auto &lFileNames = lVm["file"].as<std::vector<std::string>>();
+  std::vector<std::unique_ptr<StfFile>> lFiles;
+  std::vector<VerifyTask> lTasks;
+
+  for (const auto &lFileName : lFileNames) {
+    auto &lFile = lFiles.emplace_back(std::make_unique<StfFile>());
+    lFile->mFileName = lFileName;
+
+    try {
+      lFile->mFileMap.open(lFileName);
+    } catch (std::exception &e) {
+      std::cerr << fmt::format("{}: cannot open the file. error={}", lFileName, e.what()) << std::endl;
+      lFile->mValid = false;
+      continue;
+    }
+#if __linux__
+    madvise((void*)lFile->mFileMap.data(), lFile->mFileMap.size(), MADV_WILLNEED);
+#endif
+    collectTasks(*lFile, lTasks);
+  }
+
+  // verify in parallel: larger elements first for better balancing
+  std::sort(lTasks.begin(), lTasks.end(), [](const VerifyTask &a, const VerifyTask &b) {
+    return a.mElem.mSize > b.mElem.mSize;
+  });
+
+  std::atomic_size_t lNextTask = 0;
+  std::atomic_uint64_t lBytesVerified = 0;
+  std::mutex lOutLock;
+
+  auto lVerifyFn = [&]() {
+    std::uint64_t lBytes = 0;
+    for (auto i = lNextTask++; i < lTasks.size(); i = lNextTask++) {
+      const auto &lTask = lTasks[i];
+
+      if (!verifyChecksum(lTask.mElem, lTask.mDataStart)) {
+        lTask.mFile->mNumErrors++;
+
+        std::scoped_lock lLock(lOutLock);
+        std::cerr << fmt::format("{}: checksum mismatch. stf_id={} origin={} description={} subspec={:#010x} "
+          "blocks={} offset={} size={} checksum_type={}", lTask.mFile->mFileName, lTask.mStfId,
+          lTask.mElem.mDataOrigin.as<std::string>(), lTask.mElem.mDataDescription.as<std::string>(),
+          lTask.mElem.mSubSpecification, lTask.mElem.mDataBlockCnt, lTask.mElem.mOffset, lTask.mElem.mSize,
+          to_string(StfFileChecksum(lTask.mElem.mChecksumType))) << std::endl;
+      }
+      lBytes += lTask.mElem.mSize;
+    }
+    lBytesVerified += lBytes;
+  };
+
+  std::vector<std::thread> lThreads;
+  for (unsigned i = 0; i < lNumThreads; i++) {
+    lThreads.emplace_back(lVerifyFn);
+  }
+  for (auto &lThread : lThreads) {
+    lThread.join();
+  }
+
+  const double lElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStart).count();
+
+  // report
+  int lRet = 0;
+  for (const auto &lFile : lFiles) {
+    const bool lOk = lFile->mValid && (lFile->mNumErrors == 0);
+    lRet |= lOk ? 0 : 2;
+
+    std::cout << fmt::format("{}: {} stfs={} without_checksum={} errors={}", lFile->mFileName,
+      (lOk ? "OK" : "FAILED"), lFile->mNumStfs, lFile->mNumNoChecksum, lFile->mNumErrors.load()) << std::endl;
+  }
+
+  std::cout << fmt::format("Verified {:.3f} MiB in {} blocks using {} threads in {:.3f} s ({:.3f} GiB/s, crc32c {})",
+    double(lBytesVerified) / double(1ULL << 20), lTasks.size(), lNumThreads, lElapsed,
+    double(lBytesVerified) / double(1ULL << 30) / std::max(lElapsed, 1e-9),
+    (crc32cHardware() ? "hardware" : "software")) << std::endl;
+
+  return lRet;
+}
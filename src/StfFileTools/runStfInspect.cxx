@@ -0,0 +1,261 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <SubTimeFrameFile.h>
+#include <SubTimeFrameFileReader.h>
+
+#include <boost/program_options.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace o2::DataDistribution;
+using namespace o2::header;
+
+namespace {
+
+struct OriginSummary {
+  std::uint64_t mNumBlocks = 0;
+  std::uint64_t mNumEquipments = 0;   // <origin, description, subspec> in all STFs
+  std::uint64_t mSizeInFile = 0;
+  std::uint64_t mUncompressedSize = 0;
+  std::uint64_t mCompressedBlocks = 0;
+
+  void merge(const OriginSummary &pOther)
+  {
+    mNumBlocks += pOther.mNumBlocks;
+    mNumEquipments += pOther.mNumEquipments;
+    mSizeInFile += pOther.mSizeInFile;
+    mUncompressedSize += pOther.mUncompressedSize;
+    mCompressedBlocks += pOther.mCompressedBlocks;
+  }
+};
+
+using SummaryKey = std::tuple<std::string, std::string>; // origin, description
+
+struct FileSummary {
+  std::string mFileName;
+  bool mValid = true;
+  bool mHasFooter = false;
+
+  std::uint64_t mFileSize = 0;
+  std::uint64_t mNumStfs = 0;
+  std::uint64_t mHeaderBytes = 0;     // meta, index, and header stacks of data blocks
+  std::uint64_t mMinStfId = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t mMaxStfId = 0;
+  std::uint32_t mMinOrbit = std::numeric_limits<std::uint32_t>::max();
+  std::uint32_t mMaxOrbit = 0;
+  std::uint64_t mMinVersion = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t mMaxVersion = 0;
+
+  std::map<SummaryKey, OriginSummary> mOrigins;
+};
+
+static void inspectFile(FileSummary &pSummary, const bool pPerStf, std::mutex &pOutLock)
+{
+  boost::filesystem::path lPath(pSummary.mFileName);
+
+  try {
+    pSummary.mFileSize = boost::filesystem::file_size(lPath);
+  } catch (std::exception &e) {
+    std::cerr << fmt::format("{}: cannot open the file. error={}", pSummary.mFileName, e.what()) << std::endl;
+    pSummary.mValid = false;
+    return;
+  }
+
+  SubTimeFrameFileReader lReader(lPath);
+  pSummary.mHasFooter = lReader.hasFooter();
+
+  SubTimeFrameFileReader::StfHeaders lStfHdrs;
+
+  while (!lReader.eof()) {
+    if (!lReader.readHeaders(lStfHdrs)) {
+      pSummary.mValid = false;
+      break;
+    }
+
+    const auto &lMeta = lStfHdrs.mMeta;
+    const std::uint64_t lStfId = lStfHdrs.mOrder.mValid ? lStfHdrs.mOrder.mStfId : pSummary.mNumStfs;
+
+    pSummary.mNumStfs++;
+    pSummary.mMinStfId = std::min(pSummary.mMinStfId, lStfId);
+    pSummary.mMaxStfId = std::max(pSummary.mMaxStfId, lStfId);
+    pSummary.mMinVersion = std::min(pSummary.mMinVersion, lMeta.mStfFileVersion);
+    pSummary.mMaxVersion = std::max(pSummary.mMaxVersion, lMeta.mStfFileVersion);
+
+    // meta and index are everything before the first block
+    std::uint64_t lStfDataSize = 0;
+    pSummary.mHeaderBytes += (lStfHdrs.mBlocks.empty() ? lMeta.mStfSizeInFile :
+      (lStfHdrs.mBlocks.front().mHdrOffset - lStfHdrs.mOffset));
+
+    const DataHeader *lPrevDh = nullptr;
+    for (const auto &lBlock : lStfHdrs.mBlocks) {
+      const auto &lDh = lBlock.mDataHeader;
+      auto &lOrigin = pSummary.mOrigins[{ lDh.dataOrigin.as<std::string>(), lDh.dataDescription.as<std::string>() }];
+
+      lOrigin.mNumBlocks++;
+      lOrigin.mSizeInFile += lBlock.dataSize();
+      lOrigin.mUncompressedSize += lBlock.mUncompressedSize;
+      lOrigin.mCompressedBlocks += (lBlock.mCodec != eStfFileCodecNone) ? 1 : 0;
+
+      // blocks of an equipment are contiguous in the file
+      if (!lPrevDh || !(lPrevDh->dataOrigin == lDh.dataOrigin) ||
+          !(lPrevDh->dataDescription == lDh.dataDescription) || lPrevDh->subSpecification != lDh.subSpecification) {
+        lOrigin.mNumEquipments++;
+      }
+      lPrevDh = &lDh;
+
+      if (lDh.firstTForbit != 0) {
+        pSummary.mMinOrbit = std::min(pSummary.mMinOrbit, lDh.firstTForbit);
+        pSummary.mMaxOrbit = std::max(pSummary.mMaxOrbit, lDh.firstTForbit);
+      }
+
+      pSummary.mHeaderBytes += lBlock.mHdrStackSize;
+      lStfDataSize += lBlock.dataSize();
+    }
+
+    if (pPerStf) {
+      std::scoped_lock lLock(pOutLock);
+      std::cout << fmt::format("{}: stf_id={} offset={} size={} data_size={} blocks={} version={} write_time={}",
+        pSummary.mFileName, lStfId, lStfHdrs.mOffset, lMeta.mStfSizeInFile, lStfDataSize, lStfHdrs.mBlocks.size(),
+        lMeta.mStfFileVersion, SubTimeFrameFileMeta(lMeta).getTimeString()) << std::endl;
+    }
+  }
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+  namespace bpo = boost::program_options;
+
+  bpo::options_description lOptions("StfInspect options", 120);
+  lOptions.add_options()
+    ("help,h", "Print help.")
+    ("file", bpo::value<std::vector<std::string>>()->composing(), "(Sub)TimeFrame file(s) to inspect.")
+    ("per-stf", bpo::bool_switch()->default_value(false), "Print a line for each (Sub)TimeFrame.")
+    ("per-file", bpo::bool_switch()->default_value(false), "Print the origin summary of each file.")
+    ("threads,t", bpo::value<unsigned>()->default_value(std::max(1U, std::thread::hardware_concurrency())),
+      "Number of files inspected in parallel.");
+
+  bpo::positional_options_description lPositional;
+  lPositional.add("file", -1);
+
+  bpo::variables_map lVm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(lOptions).positional(lPositional).run(), lVm);
+    bpo::notify(lVm);
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n" << lOptions << std::endl;
+    return 1;
+  }
+
+  if (lVm.count("help") || !lVm.count("file")) {
+    std::cout << "Usage: StfInspect [options] <file.tf>...\n" << lOptions << std::endl;
+    return lVm.count("help") ? 0 : 1;
+  }
+
+  const bool lPerStf = lVm["per-stf"].as<bool>();
+  const bool lPerFile = lVm["per-file"].as<bool>();
+  const auto &lFileNames = lVm["file"].as<std::vector<std::string>>();
+  const auto lNumThreads = std::clamp(lVm["threads"].as<unsigned>(), 1U, unsigned(lFileNames.size()));
+
+  std::vector<FileSummary> lFiles(lFileNames.size());
+  for (std::size_t i = 0; i < lFileNames.size(); i++) {
+    lFiles[i].mFileName = lFileNames[i];
+  }
+
+  const auto lStart = std::chrono::steady_clock::now();
+
+  std::atomic_size_t lNextFile = 0;
+  std::mutex lOutLock;
+
+  auto lInspectFn = [&]() {
+    for (auto i = lNextFile++; i < lFiles.size(); i = lNextFile++) {
+      inspectFile(lFiles[i], lPerStf, lOutLock);
+    }
+  };
+
+  std::vector<std::thread> lThreads;
+  for (unsigned i = 0; i < lNumThreads; i++) {
+    lThreads.emplace_back(lInspectFn);
+  }
+  for (auto &lThread : lThreads) {
+    lThread.join();
+  }
+
+  const double lElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStart).count();
+
+  auto lPrintOrigins = [](const std::map<SummaryKey, OriginSummary> &pOrigins) {
+    std::cout << fmt::format("  {:<6} {:<16} {:>10} {:>12} {:>14} {:>14} {:>7}", "origin", "description",
+      "equipments", "blocks", "size_mib", "uncompr_mib", "ratio") << std::endl;
+    for (const auto &[lKey, lSum] : pOrigins) {
+      std::cout << fmt::format("  {:<6} {:<16} {:>10} {:>12} {:>14.3f} {:>14.3f} {:>7.3f}",
+        std::get<0>(lKey), std::get<1>(lKey), lSum.mNumEquipments, lSum.mNumBlocks,
+        double(lSum.mSizeInFile) / double(1ULL << 20), double(lSum.mUncompressedSize) / double(1ULL << 20),
+        (lSum.mSizeInFile > 0 ? double(lSum.mUncompressedSize) / double(lSum.mSizeInFile) : 1.0)) << std::endl;
+    }
+  };
+
+  // report
+  int lRet = 0;
+  FileSummary lTotal;
+  std::uint64_t lNumFooters = 0;
+
+  for (const auto &lFile : lFiles) {
+    lRet |= lFile.mValid ? 0 : 2;
+    lNumFooters += lFile.mHasFooter ? 1 : 0;
+
+    std::cout << fmt::format("{}: {} stfs={} stf_ids=[{}, {}] orbits=[{}, {}] version=[{}, {}] footer={} "
+      "size_mib={:.3f}", lFile.mFileName, (lFile.mValid ? "OK" : "FAILED"), lFile.mNumStfs,
+      (lFile.mNumStfs ? lFile.mMinStfId : 0), lFile.mMaxStfId,
+      (lFile.mMaxOrbit ? lFile.mMinOrbit : 0), lFile.mMaxOrbit,
+      (lFile.mNumStfs ? lFile.mMinVersion : 0), lFile.mMaxVersion,
+      lFile.mHasFooter, double(lFile.mFileSize) / double(1ULL << 20)) << std::endl;
+
+    if (lPerFile) {
+      lPrintOrigins(lFile.mOrigins);
+    }
+
+    lTotal.mFileSize += lFile.mFileSize;
+    lTotal.mNumStfs += lFile.mNumStfs;
+    lTotal.mHeaderBytes += lFile.mHeaderBytes;
+    for (const auto &[lKey, lSum] : lFile.mOrigins) {
+      lTotal.mOrigins[lKey].merge(lSum);
+    }
+  }
+
+  std::cout << fmt::format("Total: files={} with_footer={} stfs={}", lFiles.size(), lNumFooters, lTotal.mNumStfs)
+            << std::endl;
+  lPrintOrigins(lTotal.mOrigins);
+
+  // headers are read, payloads are only skipped
+  std::cout << fmt::format("Inspected {:.3f} MiB ({:.3f} MiB of headers) in {:.3f} s using {} threads "
+    "({:.3f} GiB/s, {:.0f} stfs/s)", double(lTotal.mFileSize) / double(1ULL << 20),
+    double(lTotal.mHeaderBytes) / double(1ULL << 20), lElapsed, lNumThreads,
+    double(lTotal.mFileSize) / double(1ULL << 30) / std::max(lElapsed, 1e-9),
+    double(lTotal.mNumStfs) / std::max(lElapsed, 1e-9)) << std::endl;
+
+  return lRet;
+}
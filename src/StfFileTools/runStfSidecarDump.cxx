@@ -0,0 +1,203 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <SubTimeFrameFile.h>
+#include <SubTimeFrameFileCodec.h>
+#include <SubTimeFrameFileSidecar.h>
+
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <fmt/format.h>
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace o2::DataDistribution;
+
+namespace {
+
+struct SidecarColumn {
+  const char *mHdrFmt;  // not including sep
+  const char *mHdr;
+  const char *mValFmt;
+};
+
+enum SidecarColumnType {
+  TF_ID = 0,
+  TF_OFFSET,
+  TF_SIZE,
+  ORIGIN,
+  DESC,
+  SUBSPEC,
+  DATA_IDX,
+  DATA_PARTS,
+  HDR_OFF,
+  HDR_SIZE,
+  DATA_OFF,
+  DATA_SIZE,
+  RAW_SIZE,
+  CODEC,
+  TF_ORBIT,
+  RUN,
+  RDH_FEE_ID,
+  RDH_ORBIT,
+  RDH_BC,
+  RDH_TRG,
+};
+
+static const SidecarColumn sColumns[] = {
+  { "{:<10}", "TF_ID",          "{:<10d}"   },
+  { "{:<10}", "TF_OFFSET",      "{:<10d}"   },
+  { "{:<9}",  "TF_SIZE",        "{:<9d}"    },
+  { "{:<6}",  "ORIGIN",         "{:<6}"     },
+  { "{:<9}",  "DESC",           "{:<9}"     },
+  { "{:<10}", "SUBSPEC",        "{:<#010x}" },
+  { "{:<8}",  "DATA_IDX",       "{:<8}"     },
+  { "{:<10}", "DATA_PARTS",     "{:<10}"    },
+  { "{:<10}", "HDR_OFF",        "{:<10}"    },
+  { "{:<8}",  "HDR_SIZE",       "{:<8}"     },
+  { "{:<10}", "DATA_OFF",       "{:<10}"    },
+  { "{:<9}",  "DATA_SIZE",      "{:<9}"     },
+  { "{:<9}",  "RAW_SIZE",       "{:<9}"     },
+  { "{:<5}",  "CODEC",          "{:<5}"     },
+  { "{:<12}", "TF_ORBIT",       "{:<#12d}"  },
+  { "{:<9}",  "RUN",            "{:<9d}"    },
+  { "{:<10}", "RDH_FEE_ID",     "{:<10}"    },
+  { "{:<12}", "RDH_ORBIT",      "{:<#12d}"  },
+  { "{:<10}", "RDH_BC",         "{:<#10d}"  },
+  { "{:<10}", "RDH_TRG",        "{:<#010x}" },
+};
+
+static constexpr std::size_t sNumColumns = sizeof(sColumns) / sizeof(SidecarColumn);
+
+static std::string headerString()
+{
+  fmt::memory_buffer lHeader;
+
+  for (std::size_t i = 0; i < sNumColumns; i++) {
+    fmt::format_to(fmt::appender(lHeader), sColumns[i].mHdrFmt, sColumns[i].mHdr);
+    fmt::format_to(fmt::appender(lHeader), "{}", (i < sNumColumns - 1) ? " " : "");
+  }
+
+  return std::string(lHeader.begin(), lHeader.end());
+}
+
+template<class T>
+static void columnVal(fmt::memory_buffer &pBuf, const SidecarColumnType pType, const T& pVal)
+{
+  fmt::format_to(fmt::appender(pBuf), sColumns[pType].mValFmt, pVal);
+  fmt::format_to(fmt::appender(pBuf), "{}", (pType < sNumColumns - 1) ? " " : "");
+}
+
+static std::string recordString(const SubTimeFrameFileSidecarRecord &pRec)
+{
+  fmt::memory_buffer lRow;
+
+  columnVal(lRow, TF_ID, pRec.mStfId);
+  columnVal(lRow, TF_OFFSET, pRec.mStfOffset);
+  columnVal(lRow, TF_SIZE, pRec.mStfSize);
+  columnVal(lRow, ORIGIN, pRec.mDataOrigin.as<std::string>());
+  columnVal(lRow, DESC, pRec.mDataDescription.as<std::string>());
+  columnVal(lRow, SUBSPEC, pRec.mSubSpecification);
+  columnVal(lRow, DATA_IDX, pRec.mSplitPayloadIndex);
+  columnVal(lRow, DATA_PARTS, pRec.mSplitPayloadParts);
+  columnVal(lRow, HDR_OFF, pRec.mHdrOffset);
+  columnVal(lRow, HDR_SIZE, pRec.mHdrSize);
+  columnVal(lRow, DATA_OFF, pRec.dataOffset());
+  columnVal(lRow, DATA_SIZE, pRec.mDataSize);
+  columnVal(lRow, RAW_SIZE, pRec.mUncompressedSize);
+  columnVal(lRow, CODEC, to_string(StfFileCodec(pRec.mCodec)));
+  columnVal(lRow, TF_ORBIT, pRec.mTfFirstOrbit);
+  columnVal(lRow, RUN, pRec.mRunNumber);
+
+  if (pRec.rdhValid()) {
+    columnVal(lRow, RDH_FEE_ID, pRec.mFeeId);
+    columnVal(lRow, RDH_ORBIT, pRec.mFirstOrbit);
+    columnVal(lRow, RDH_BC, pRec.mBc);
+    columnVal(lRow, RDH_TRG, pRec.mTriggerType);
+  }
+
+  return std::string(lRow.begin(), lRow.end());
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+  namespace bpo = boost::program_options;
+
+  bpo::options_description lOptions("StfSidecarDump options", 120);
+  lOptions.add_options()
+    ("help,h", "Print help.")
+    ("file", bpo::value<std::vector<std::string>>()->composing(), "Sidecar file(s) of (Sub)TimeFrame files.")
+    ("stf-id", bpo::value<std::uint64_t>(), "Only print records of the (Sub)TimeFrame.")
+    ("origin", bpo::value<std::string>(), "Only print records of the data origin (e.g. TPC).")
+    ("no-header", bpo::bool_switch()->default_value(false), "Do not print the column header.");
+
+  bpo::positional_options_description lPositional;
+  lPositional.add("file", -1);
+
+  bpo::variables_map lVm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(lOptions).positional(lPositional).run(), lVm);
+    bpo::notify(lVm);
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n" << lOptions << std::endl;
+    return 1;
+  }
+
+  if (lVm.count("help") || !lVm.count("file")) {
+    std::cout << "Usage: StfSidecarDump [options] <file.sidecar>...\n" << lOptions << std::endl;
+    return lVm.count("help") ? 0 : 1;
+  }
+
+  std::optional<std::uint64_t> lStfId;
+  if (lVm.count("stf-id")) {
+    lStfId = lVm["stf-id"].as<std::uint64_t>();
+  }
+
+  std::optional<o2::header::DataOrigin> lOrigin;
+  if (lVm.count("origin")) {
+    const auto lOriginStr = boost::to_upper_copy(lVm["origin"].as<std::string>());
+    lOrigin.emplace();
+    lOrigin->runtimeInit(lOriginStr.c_str());
+  }
+
+  if (!lVm["no-header"].as<bool>()) {
+    std::cout << headerString() << '\n';
+  }
+
+  int lRet = 0;
+  for (const auto &lFileName : lVm["file"].as<std::vector<std::string>>()) {
+    SubTimeFrameFileSidecarReader lReader(lFileName);
+    if (!lReader.good()) {
+      std::cerr << "Cannot read the sidecar file " << lFileName << std::endl;
+      lRet = 1;
+      continue;
+    }
+
+    auto [lBegin, lEnd] = lStfId ? lReader.findStf(*lStfId) : std::make_pair(lReader.begin(), lReader.end());
+
+    for (auto lRec = lBegin; lRec != lEnd; ++lRec) {
+      if (lOrigin && !(lRec->mDataOrigin == *lOrigin)) {
+        continue;
+      }
+      std::cout << recordString(*lRec) << '\n';
+    }
+  }
+
+  return lRet;
+}
@@ -76,6 +76,9 @@ void StfSenderDevice::InitTask()
   DataDistMonitor::set_interval(GetConfig()->GetValue<float>("monitoring-interval"));
   DataDistMonitor::set_log(GetConfig()->GetValue<bool>("monitoring-log"));
 
+  // start STF tracing
+  DataDistTracer::start("StfSender", GetConfig()->GetValue<std::uint64_t>("trace-sample-interval"),
+    GetConfig()->GetValue<std::string>("trace-dump-dir"));
 
   I().mPartitionId = Config::getPartitionOption(*GetConfig()).value_or("-");
 
@@ -249,6 +252,7 @@ void StfSenderDevice::ResetTask()
 
   // stop monitoring
   DataDistMonitor::stop_datadist();
+  DataDistTracer::stop();
 
   DDDLOG("ResetTask() done.");
 }
@@ -288,6 +292,8 @@ void StfSenderDevice::StfReceiverThread()
       continue;
     }
 
+    lStf->traceProcessStart(eStfTraceStfSenderIn);
+
     { // Input STF frequency
       const auto lNow = hres_clock::now();
       const std::chrono::duration<double> lStfDur = lNow - lStfStartTime;
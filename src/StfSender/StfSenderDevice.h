@@ -24,6 +24,7 @@
 #include <Utilities.h>
 #include <FmqUtilities.h>
 #include <DataDistMonitoring.h>
+#include <DataDistTracing.h>
 
 #include <thread>
 #include <vector>
@@ -54,7 +54,13 @@ void StfSenderOutput::start(std::shared_ptr<ConsulStfSender> pDiscoveryConfig)
   if (lTransportOpt == "fmq" || lTransportOpt == "FMQ" || lTransportOpt == "fairmq" || lTransportOpt == "FAIRMQ") {
     // create a socket and connect
     mDevice.GetConfig()->SetProperty<int>("io-threads", (int) std::min(std::thread::hardware_concurrency(), 20u));
-    mZMQTransportFactory = FairMQTransportFactory::CreateTransportFactory("zeromq", "", mDevice.GetConfig());
+    if (pDiscoveryConfig->getBoolParam(DataDistFmqShmTransportKey, DataDistFmqShmTransportDefault)) {
+      // co-located TfBuilders: send the shm messages of the STF by reference (no copy to zeromq messages)
+      mZMQTransportFactory = mDevice.AddTransport(fair::mq::Transport::SHM);
+      IDDLOG("StfSenderOutput: Using the FairMQ shared memory transport for TfBuilder channels.");
+    } else {
+      mZMQTransportFactory = FairMQTransportFactory::CreateTransportFactory("zeromq", "", mDevice.GetConfig());
+    }
 
     // create FairMQ output
     mOutputFairMQ = std::make_unique<StfSenderOutputFairMQ>(pDiscoveryConfig, mCounters);
@@ -143,12 +149,13 @@ bool StfSenderOutput::disconnectTfBuilder(const std::string &pTfBuilderId, const
   return mOutputFairMQ->disconnectTfBuilder(pTfBuilderId, lEndpoint);
 }
 
-ConnectStatus StfSenderOutput::connectTfBuilderUCX(const std::string &pTfBuilderId, const std::string &pIp, unsigned pPort)
+ConnectStatus StfSenderOutput::connectTfBuilderUCX(const std::string &pTfBuilderId, const std::string &pIp, unsigned pPort,
+  const std::vector<std::pair<std::string, unsigned>> &pRailEps)
 {
   if (!mOutputUCX) {
     return ConnectStatus::eCONNERR;
   }
-  return mOutputUCX->connectTfBuilder(pTfBuilderId, pIp, pPort);
+  return mOutputUCX->connectTfBuilder(pTfBuilderId, pIp, pPort, pRailEps);
 }
 bool StfSenderOutput::disconnectTfBuilderUCX(const std::string &pTfBuilderId)
 {
@@ -285,7 +292,8 @@ void StfSenderOutput::StfSchedulerThread()
   DDDLOG("StfSchedulerThread: Exiting.");
 }
 
-void StfSenderOutput::sendStfToTfBuilder(const std::uint64_t pStfId, const std::string &pTfBuilderId, StfDataResponse &pRes)
+void StfSenderOutput::sendStfToTfBuilder(const std::uint64_t pStfId, const std::string &pTfBuilderId,
+  const std::uint64_t pCreditBytes, StfDataResponse &pRes)
 {
   assert(!pTfBuilderId.empty());
   std::scoped_lock lLock(mScheduledStfMapLock);
@@ -313,6 +321,14 @@ void StfSenderOutput::sendStfToTfBuilder(const std::uint64_t pStfId, const std::
     const auto lStfSize = lStf->getDataSize();
     mScheduledStfMap.erase(lStfIter);
 
+    lStf->traceStamp(eStfTraceStfSenderSched);
+
+    // TfBuilder grants the credit with the announced size, it is corrected with the size in the response
+    if ((pCreditBytes > 0) && (lStfSize > pCreditBytes)) {
+      WDDLOG_GRL(5000, "sendStfToTfBuilder: STF is larger than the granted credit. stf_id={} stf_size={} credit={}",
+        pStfId, lStfSize, pCreditBytes);
+    }
+
     // send to output backend
     bool lOk = false;
     if (mOutputUCX) {
@@ -329,6 +345,7 @@ void StfSenderOutput::sendStfToTfBuilder(const std::uint64_t pStfId, const std::
 
     // update status and counters
     pRes.set_status(StfDataResponse::OK);
+    pRes.set_stf_size(lStfSize);
     {
       std::scoped_lock lCntLock(mCounters.mCountersLock);
       mCounters.mValues.mInSending.mSize += lStfSize;
@@ -60,10 +60,12 @@ public:
   ConnectStatus connectTfBuilder(const std::string &pTfBuilderId, const std::string &lEndpoint);
   bool disconnectTfBuilder(const std::string &pTfBuilderId, const std::string &lEndpoint);
   // UCX
-  ConnectStatus connectTfBuilderUCX(const std::string &pTfBuilderId, const std::string &pIp, unsigned pPort);
+  ConnectStatus connectTfBuilderUCX(const std::string &pTfBuilderId, const std::string &pIp, unsigned pPort,
+    const std::vector<std::pair<std::string, unsigned>> &pRailEps = {});
   bool disconnectTfBuilderUCX(const std::string &pTfBuilderId);
   // Data
-  void sendStfToTfBuilder(const std::uint64_t pStfId, const std::string &pTfBuilderId, StfDataResponse &pRes);
+  void sendStfToTfBuilder(const std::uint64_t pStfId, const std::string &pTfBuilderId, const std::uint64_t pCreditBytes,
+    StfDataResponse &pRes);
 
   /// Counters
   StdSenderOutputCounters::Values getCounters() {
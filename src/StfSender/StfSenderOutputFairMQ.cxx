@@ -15,6 +15,7 @@
 
 #include <DataDistLogger.h>
 #include <DataDistMonitoring.h>
+#include <DataDistTracing.h>
 
 namespace o2::DataDistribution
 {
@@ -216,6 +217,9 @@ void StfSenderOutputFairMQ::DataHandlerThread(const std::string pTfBuilderId)
     DDDLOG_GRL(5000, "Sending an STF to TfBuilder. stf_id={} tfb_id={} stf_size={} total_sent_stf={}",
       lStfId, pTfBuilderId, lStfSize, lNumSentStfs);
 
+    lStf->traceStamp(eStfTraceStfSenderOut);
+    DataDistTracer::record(lStfId, lStf->trace());
+
     try {
       lStfSerializer->serialize(std::move(lStf));
     } catch (std::exception &e) {
@@ -16,6 +16,8 @@
 #include <DataDistributionOptions.h>
 #include <DataDistLogger.h>
 #include <DataDistMonitoring.h>
+#include <DataDistTracing.h>
+#include <ProtobufPool.h>
 
 #include <UCXSendRecv.h>
 
@@ -44,7 +46,21 @@ bool StfSenderOutputUCX::start()
   mThreadPoolSize = std::clamp(mDiscoveryConfig->getUInt64Param(UcxSenderThreadPoolSizeKey, UcxStfSenderThreadPoolSizeDefault), std::size_t(0), std::size_t(128));
   mThreadPoolSize = std::max(std::size_t(8), (mThreadPoolSize == 0) ? std::thread::hardware_concurrency() : mThreadPoolSize);
 
-  IDDLOG("StfSenderOutputUCX: Configuration loaded. rma_gap={} thread_pool={}", mRmaGap, mThreadPoolSize);
+  // txg coalescing: cost model decides on each gap, up to the largest allowed gap
+  const auto lRmaCostModel = mDiscoveryConfig->getStringParam(UcxRmaCostModelKey, UcxRmaCostModelDefault);
+  mRmaCostModelEnabled = !lRmaCostModel.empty() && mRmaCostModel.parse(lRmaCostModel);
+  if (mRmaCostModelEnabled) {
+    mRmaGap = std::size_t(16 << 20);
+    IDDLOG("StfSenderOutputUCX: RMA cost model enabled. model={} max_gap_4k={} max_gap_1m={}", mRmaCostModel.to_string(),
+      mRmaCostModel.maxMergeGap(4096, 4096), mRmaCostModel.maxMergeGap(1ULL << 20, 1ULL << 20));
+  } else if (!lRmaCostModel.empty()) {
+    WDDLOG("StfSenderOutputUCX: Invalid RMA cost model, using the fixed gap. model={} rma_gap={}", lRmaCostModel, mRmaGap);
+  }
+
+  mAmControl = mDiscoveryConfig->getBoolParam(UcxControlActiveMessagesKey, UcxControlActiveMessagesDefault);
+
+  IDDLOG("StfSenderOutputUCX: Configuration loaded. rma_gap={} rma_cost_model={} thread_pool={} control={}",
+    mRmaGap, mRmaCostModelEnabled, mThreadPoolSize, (mAmControl ? "am" : "tag"));
 
   // Create the UCX context
   if (!ucx::util::create_ucp_context(&ucp_context)) {
@@ -91,6 +107,7 @@ void StfSenderOutputUCX::stop()
   // Revoke all rkeys and mappings
   {
     std::scoped_lock lLock(mRegionListLock);
+    std::atomic_store(&mRegionIndex, std::make_shared<const UCXRegionIndex>());
     for (auto &lMapping : mRegions) {
       ucx::util::destroy_rkey_for_region(ucp_context, lMapping.ucp_mem, lMapping.ucp_rkey_buf);
     }
@@ -108,7 +125,8 @@ void StfSenderOutputUCX::stop()
   DDDLOG("StfSenderOutputUCX::stop: closed all connections.");
 }
 
-ConnectStatus StfSenderOutputUCX::connectTfBuilder(const std::string &pTfBuilderId, const std::string &lTfBuilderIp, const unsigned lTfBuilderPort)
+ConnectStatus StfSenderOutputUCX::connectTfBuilder(const std::string &pTfBuilderId, const std::string &lTfBuilderIp, const unsigned lTfBuilderPort,
+  const std::vector<std::pair<std::string, unsigned>> &pRailEps)
 {
   if (!mRunning.load()) {
     EDDLOG_ONCE("StfSenderOutputUCX::connectTfBuilder: backend is not started.");
@@ -132,6 +150,12 @@ ConnectStatus StfSenderOutputUCX::connectTfBuilder(const std::string &pTfBuilder
     return eCONNERR;
   }
 
+  // receive handler of the control channel, registered before the TfBuilder learns about it
+  lConnInfo->mAmControl = mAmControl;
+  if (!ucx::io::am_register_handler(lConnInfo->worker, lConnInfo->mAmQueue)) {
+    return eCONNERR;
+  }
+
   // create endpoint for TfBuilder connection
   DDDLOG("Connect to TfBuilder ip={} port={}", lTfBuilderIp, lTfBuilderPort);
   if (!ucx::util::create_ucp_client_ep(lConnInfo->worker.ucp_worker, lTfBuilderIp, lTfBuilderPort,
@@ -146,6 +170,48 @@ ConnectStatus StfSenderOutputUCX::connectTfBuilder(const std::string &pTfBuilder
     return eCONNERR;
   }
 
+  // send the region registry: STF metadata only refers to region ids
+  {
+    UCXIovStfHeader lRegistry;
+    addRegionRegistry(*lConnInfo, lRegistry);
+
+    if (!ucx::io::ucx_send_string(lConnInfo->worker, lConnInfo->ucp_ep, lRegistry.SerializeAsString())) {
+      EDDLOG("connectTfBuilder: Sending of the region registry failed.");
+      return eCONNERR;
+    }
+    DDDLOG("StfSenderOutputUCX::connectTfBuilder: region registry sent. tfbuilder_id={} num_regions={}",
+      pTfBuilderId, lConnInfo->mNumRegionsSent);
+  }
+
+  // select the control channel of the connection
+  if (!ucx::io::ucx_send_string(lConnInfo->worker, lConnInfo->ucp_ep, (lConnInfo->mAmControl ? "am" : "tag"))) {
+    EDDLOG("connectTfBuilder: Sending of the control channel type failed.");
+    return eCONNERR;
+  }
+
+  // connect the additional rails of the TfBuilder. TfBuilder uses them for striping of RMA gets
+  for (const auto &lRailEp : pRailEps) {
+    ucp_ep_h lEp = nullptr;
+    if (!ucx::util::create_ucp_client_ep(lConnInfo->worker.ucp_worker, lRailEp.first, lRailEp.second,
+      &lEp, client_ep_err_cb, lConnInfo.get(), pTfBuilderId)) {
+      WDDLOG("connectTfBuilder: Connecting to the TfBuilder rail failed. tfbuilder_id={} ip={} port={}",
+        pTfBuilderId, lRailEp.first, lRailEp.second);
+      continue;
+    }
+
+    if (!ucx::io::ucx_send_string(lConnInfo->worker, lEp, lStfSenderId)) {
+      WDDLOG("connectTfBuilder: Sending of local id on the TfBuilder rail failed. tfbuilder_id={} ip={} port={}",
+        pTfBuilderId, lRailEp.first, lRailEp.second);
+      ucx::util::close_ep(lConnInfo->worker, lEp);
+      continue;
+    }
+    lConnInfo->mRailEps.push_back(lEp);
+  }
+  if (!pRailEps.empty()) {
+    IDDLOG("connectTfBuilder: TfBuilder rails connected. tfbuilder_id={} rails={} of {}",
+      pTfBuilderId, lConnInfo->mRailEps.size(), pRailEps.size());
+  }
+
   // Add the connection to connection map
   {
     std::scoped_lock lLock(mOutputMapLock);
@@ -180,6 +246,9 @@ bool StfSenderOutputUCX::disconnectTfBuilder(const std::string &pTfBuilderId)
     DDDLOG("StfSenderOutputUCX::disconnectTfBuilder: closing transport for tf_builder={}", pTfBuilderId);
     // acquire the lock and close the connection
     std::unique_lock lTfSenderLock(pConnInfo->mTfBuilderLock);
+    for (auto lRailEp : pConnInfo->mRailEps) {
+      ucx::util::close_ep(pConnInfo->worker, lRailEp);
+    }
     ucx::util::close_connection(pConnInfo->worker, pConnInfo->ucp_ep);
     DDDLOG("StfSenderOutputUCX::disconnectTfBuilder: transport stopped for tf_builder={}", pTfBuilderId);
   }).detach();
@@ -197,7 +266,6 @@ void StfSenderOutputUCX::visit(const SubTimeFrame &pStf, void *pData)
 {
   using UCXData = UCXIovStfHeader::UCXData;
   using UCXIovTxg = UCXIovStfHeader::UCXIovTxg;
-  using UCXRegion = UCXIovStfHeader::UCXRegion;
 
   const auto lStfSize = pStf.getDataSize();
 
@@ -209,9 +277,8 @@ void StfSenderOutputUCX::visit(const SubTimeFrame &pStf, void *pData)
   // Pack the Stf header
   lStfUCXMeta->mutable_stf_hdr_meta()->set_stf_dd_header(&pStf.header(), sizeof(SubTimeFrame::Header));
 
-  // pack all headers and collect data
-  std::vector<UCXData> lStfDataPtrs;
-  lStfDataPtrs.reserve(32768);
+  // pack all headers and collect data (directly into the message, allocated in the arena of the thread)
+  auto &lStfDataPtrs = *lStfUCXMeta->mutable_stf_data_iov();
 
   std::uint64_t lDataIovIdx = 0;
 
@@ -227,11 +294,11 @@ void StfSenderOutputUCX::visit(const SubTimeFrame &pStf, void *pData)
 
           // add the data part info
           for (auto &lDataMsg : lStfDataIter.mDataParts) {
-            lStfDataPtrs.emplace_back(UCXData());
-            lStfDataPtrs.back().set_idx(lDataIovIdx++);
-            lStfDataPtrs.back().set_len(lDataMsg->GetSize());
+            auto lDataPart = lStfDataPtrs.Add();
+            lDataPart->set_idx(lDataIovIdx++);
+            lDataPart->set_len(lDataMsg->GetSize());
             // add pointer for start, then reset to region offset later
-            lStfDataPtrs.back().set_start(reinterpret_cast<std::uint64_t>(lDataMsg->GetData()));
+            lDataPart->set_start(reinterpret_cast<std::uint64_t>(lDataMsg->GetData()));
           }
         }
       }
@@ -241,23 +308,22 @@ void StfSenderOutputUCX::visit(const SubTimeFrame &pStf, void *pData)
   std::size_t lTotalGap = 0;
 
   if (!lStfDataPtrs.empty()) {
-    // sort all data parts by pointer value in order to make txgs
-    std::sort(lStfDataPtrs.begin(), lStfDataPtrs.end(), [](const UCXData &a, const UCXData &b) { return a.start() < b.start(); } );
+    // sort all data parts by pointer value in order to make txgs (only the element pointers are moved)
+    std::sort(lStfDataPtrs.pointer_begin(), lStfDataPtrs.pointer_end(),
+      [](const UCXData *a, const UCXData *b) { return a->start() < b->start(); } );
 
     // create transactions
     std::uint32_t lTxgIdx = 0;
-    std::uint32_t lRegionIdx = 0;
 
     UCXIovTxg *lStfTxg = lStfUCXMeta->add_stf_txg_iov();
 
-    UCXData *lData = &lStfDataPtrs.front();
+    UCXData *lData = lStfDataPtrs.Mutable(0);
+
+    // snapshot of registered regions, used for all data buffers of the STF
+    const auto lRegionIndex = regionIndex();
 
-    const UCXMemoryRegionInfo* lRunningRegion = regionLookup(lData->start(), lData->len());
-    // create the first region
-    UCXRegion *lStfRegion = lStfUCXMeta->add_data_regions();
-    lStfRegion->set_region(lRegionIdx++);
-    lStfRegion->set_size(lRunningRegion->mSize);
-    lStfRegion->set_region_rkey(lRunningRegion->ucp_rkey_buf, lRunningRegion->ucp_rkey_buf_size);
+    // regions are referenced by the registry id (rkeys are sent once for each connection)
+    const UCXMemoryRegionInfo* lRunningRegion = regionLookup(*lRegionIndex, lData->start(), lData->len());
 
     // Update the start to region offset
     lData->set_txg(lTxgIdx);
@@ -267,17 +333,21 @@ void StfSenderOutputUCX::visit(const SubTimeFrame &pStf, void *pData)
     lStfTxg->set_start(lData->start());
     lStfTxg->set_len(lData->len());
     lStfTxg->set_data_parts(1);
-    lStfTxg->set_region(lStfRegion->region());
+    lStfTxg->set_region(lRunningRegion->mRegionId);
 
-    for (std::size_t i = 1; i < lStfDataPtrs.size(); i++) {
-      lData = &lStfDataPtrs[i];
+    for (int i = 1; i < lStfDataPtrs.size(); i++) {
+      lData = lStfDataPtrs.Mutable(i);
 
-      const auto lReg = regionLookup(lData->start(), lData->len());
+      // buffers are sorted: check the running region before searching the index
+      const auto lRunningStart = reinterpret_cast<std::uint64_t>(lRunningRegion->mPtr);
+      const bool lInRunning = (lData->start() >= lRunningStart) &&
+        ((lData->start() + lData->len()) <= (lRunningStart + lRunningRegion->mSize));
+      const auto lReg = lInRunning ? lRunningRegion : regionLookup(*lRegionIndex, lData->start(), lData->len());
 
-      if (*lReg == *lRunningRegion) {
+      if (lReg == lRunningRegion) {
         // check if we extend the current txg
         const auto lGap = lData->start() - (lStfTxg->start() + lStfTxg->len());
-        if (lGap <= mRmaGap) {
+        if ((lGap <= mRmaGap) && (!mRmaCostModelEnabled || mRmaCostModel.merge(lStfTxg->len(), lGap, lData->len()))) {
           // extend the existing txg
           lStfTxg->set_len(lStfTxg->len() + lGap + lData->len());
           lStfTxg->set_data_parts(lStfTxg->data_parts() + 1);
@@ -291,14 +361,8 @@ void StfSenderOutputUCX::visit(const SubTimeFrame &pStf, void *pData)
           continue;
         }
       } else {
-        // this is a different region. That means we need to add it into the region vector and
-        // start a new txg for the current data buffer
+        // this is a different region. Start a new txg for the current data buffer
         lRunningRegion = lReg;
-        // add new region
-        lStfRegion = lStfUCXMeta->add_data_regions();
-        lStfRegion->set_region(lRegionIdx++);
-        lStfRegion->set_size(lRunningRegion->mSize);
-        lStfRegion->set_region_rkey(lRunningRegion->ucp_rkey_buf, lRunningRegion->ucp_rkey_buf_size);
       }
 
       // start a new txg
@@ -307,24 +371,29 @@ void StfSenderOutputUCX::visit(const SubTimeFrame &pStf, void *pData)
       lStfTxg->set_start(lData->start());
       lStfTxg->set_len(lData->len());
       lStfTxg->set_data_parts(1);
-      lStfTxg->set_region(lStfRegion->region());
+      lStfTxg->set_region(lRunningRegion->mRegionId);
       // set the data part txg
       lData->set_txg(lStfTxg->txg());
     }
 
-    // prepare the message
-    for (const auto & lDataPart: lStfDataPtrs) {
-      auto lNewDataPtr = lStfUCXMeta->add_stf_data_iov();
-      *lNewDataPtr = lDataPart;
-    }
-
+    // rma ops and wasted bytes of the STF
+    DDMON("stfsender", "ucx.rma_ops", lStfUCXMeta->stf_txg_iov_size());
     DDMON("stfsender", "ucx.rma_gap_total", lTotalGap);
     if (lStfSize > 0) {
       DDMON("stfsender", "ucx.rma_gap_overhead", (double(lTotalGap) / double(lStfSize) * 100.));
     }
 
-    DDDLOG_GRL(10000, "UCX pack total data_size={} data_cnt={} txg_size={} txg_cnt={} gap_size={}",
-      pStf.getDataSize(), lStfUCXMeta->stf_data_iov_size(), pStf.getDataSize()+lTotalGap, lStfUCXMeta->stf_txg_iov_size(), lTotalGap);
+    double lRmaCostUs = 0.0;
+    if (mRmaCostModelEnabled) {
+      for (const auto &lTxg : lStfUCXMeta->stf_txg_iov()) {
+        lRmaCostUs += mRmaCostModel.cost(lTxg.len());
+      }
+      DDMON("stfsender", "ucx.rma_cost_us", lRmaCostUs);
+    }
+
+    DDDLOG_GRL(10000, "UCX pack total data_size={} data_cnt={} txg_size={} txg_cnt={} gap_size={} rma_cost_us={:.1f}",
+      pStf.getDataSize(), lStfUCXMeta->stf_data_iov_size(), pStf.getDataSize()+lTotalGap, lStfUCXMeta->stf_txg_iov_size(),
+      lTotalGap, lRmaCostUs);
   }
 
 }
@@ -334,6 +403,40 @@ void StfSenderOutputUCX::prepareStfMetaHeader(const SubTimeFrame &pStf, UCXIovSt
   pStf.accept(*this, pStfUCXMeta);
 }
 
+bool StfSenderOutputUCX::sendStfMetaAm(StfSenderUCXConnInfo &pConn, const std::uint64_t pStfId, const std::string &pStfMetaData)
+{
+  using clock = std::chrono::steady_clock;
+  const auto lStart = clock::now();
+
+  ucx::io::dd_am_hdr lHdr;
+  lHdr.mType = ucx::io::DD_AM_STF_META;
+  lHdr.mStfId = pStfId;
+
+  if (!ucx::io::am_send_blocking(pConn.worker, pConn.ucp_ep, lHdr, pStfMetaData.data(), pStfMetaData.size())) {
+    EDDLOG("StfSender could not transfer stf metadata to tf_builder={} tf_id={}", pConn.mTfBuilderId, pStfId);
+    return false;
+  }
+  DDMON("stfsender", "ucx.meta_send_us", since<std::chrono::microseconds>(lStart));
+
+  // wait here until we get completed notification
+  const auto lDoneMsg = ucx::io::am_receive_blocking(pConn.worker, pConn.mAmQueue);
+  if (!lDoneMsg) {
+    EDDLOG("StfSender was NOT notified about transfer finish tf_builder={} tf_id={}", pConn.mTfBuilderId, pStfId);
+    return false;
+  }
+
+  const auto lDoneHdr = lDoneMsg->mHdr;
+  pConn.mAmQueue.pop();
+
+  if (lDoneHdr.mType != ucx::io::DD_AM_STF_DONE || lDoneHdr.mStfId != pStfId || lDoneHdr.mStatus != 0) {
+    EDDLOG("StfSender received an invalid transfer finish notification. tf_builder={} tf_id={} type={} ack_tf_id={} status={}",
+      pConn.mTfBuilderId, pStfId, lDoneHdr.mType, lDoneHdr.mStfId, lDoneHdr.mStatus);
+    return false;
+  }
+  DDMON("stfsender", "ucx.meta_done_ms", since<std::chrono::milliseconds>(lStart));
+  return true;
+}
+
 /// Sending thread
 void StfSenderOutputUCX::DataHandlerThread(unsigned pThreadIdx)
 {
@@ -345,6 +448,9 @@ void StfSenderOutputUCX::DataHandlerThread(unsigned pThreadIdx)
 
   std::uint64_t lNumSentStfs = 0;
 
+  // metadata messages and the serialization buffer of the thread
+  ProtobufArenaPool<UCXIovStfHeader> lMetaPool;
+
   std::optional<SendStfInfo> lSendReqOpt;
 
   while ((lSendReqOpt = mSendRequestQueue.pop()) != std::nullopt) {
@@ -373,10 +479,14 @@ void StfSenderOutputUCX::DataHandlerThread(unsigned pThreadIdx)
     const auto lStfId = lStf->id();
     const auto lStfSize = lStf->getDataSize();
 
-    UCXIovStfHeader lMeta;
+    lStf->traceStamp(eStfTraceStfSenderOut);
+    DataDistTracer::record(lStfId, lStf->trace());
+
+    auto &lMeta = lMetaPool.acquire();
     prepareStfMetaHeader(*lStf, &lMeta);
 
-    std::string lStfMetaData = lMeta.SerializeAsString();
+    lMetaPool.serialize(lMeta);
+    std::string &lStfMetaData = lMetaPool.buffer();
 
     DDDLOG_GRL(5000, "Sending an STF to TfBuilder. stf_id={} tfb_id={} stf_size={} total_sent_stf={} meta_size={}",
       lStfId, lTfBuilderId, lStfSize, lNumSentStfs, lStfMetaData.size());
@@ -385,11 +495,23 @@ void StfSenderOutputUCX::DataHandlerThread(unsigned pThreadIdx)
     { // lock the TfBuilder for sending
       std::scoped_lock lTfBuilderLock(lConnInfo->mTfBuilderLock);
 
-      if (ucx::io::ucx_send_string(lConnInfo->worker, lConnInfo->ucp_ep, lStfMetaData)) {
+      // regions registered after the connection was made: append the registry update to the metadata.
+      // Concatenated protobuf messages are parsed as one (repeated fields are merged).
+      if (lConnInfo->mNumRegionsSent < mRegionCount) {
+        UCXIovStfHeader lRegistry;
+        addRegionRegistry(*lConnInfo, lRegistry);
+        lRegistry.AppendToString(&lStfMetaData);
+      }
+
+      if (lConnInfo->mAmControl) {
+        sendStfMetaAm(*lConnInfo, lStfId, lStfMetaData);
+      } else if (ucx::io::ucx_send_string(lConnInfo->worker, lConnInfo->ucp_ep, lStfMetaData)) {
         // wait here until we get cometed notification
         auto lOkStrOpt = ucx::io::ucx_receive_string(lConnInfo->worker);
-        if (!(lOkStrOpt.has_value() && (lOkStrOpt.value() == "OK"))) {
+        if (!lOkStrOpt.has_value()) {
           EDDLOG("StfSender was NOT notified about transfer finish tf_builder={} tf_id={}", lTfBuilderId, lStfId);
+        } else if (lOkStrOpt.value() != "OK") {
+          EDDLOG("TfBuilder failed the stf transfer. tf_builder={} tf_id={} status={}", lTfBuilderId, lStfId, lOkStrOpt.value());
         }
       } else {
         EDDLOG("StfSender could not transfer stf metadata to tf_builder={} tf_id={}", lTfBuilderId, lStfId);
@@ -23,12 +23,14 @@
 
 #include <UCXUtilities.h>
 #include <UCXSendRecv.h>
+#include <UCXRmaCostModel.h>
 #include <ucp/api/ucp.h>
 
 #include <vector>
 #include <map>
 #include <thread>
-#include <boost/container/small_vector.hpp>
+#include <algorithm>
+#include <memory>
 
 namespace o2::DataDistribution
 {
@@ -54,8 +56,18 @@ struct StfSenderUCXConnInfo {
   ucx::dd_ucp_worker worker;
   ucp_ep_h      ucp_ep;
 
+  // additional endpoints to the rails (interfaces) of the TfBuilder. Progressed by the connection worker
+  std::vector<ucp_ep_h> mRailEps;
+
   std::atomic_bool mConnError = false;
 
+  // number of regions sent to the TfBuilder (region registry ids are [0, mNumRegionsSent) ). Use with mTfBuilderLock
+  std::uint32_t mNumRegionsSent = 0;
+
+  // control channel: active messages (STF metadata and DONE acks) or tagged strings
+  bool mAmControl = false;
+  ucx::io::dd_ucp_am_queue mAmQueue;
+
   StfSenderUCXConnInfo() = delete;
   StfSenderUCXConnInfo(StfSenderOutputUCX *pOutputUCX, const std::string &pTfBuilderId)
   : mOutputUCX(pOutputUCX),
@@ -72,7 +84,8 @@ public:
   void stop();
 
   /// RPC requests
-  ConnectStatus connectTfBuilder(const std::string &pTfBuilderId, const std::string &lTfBuilderIp, const unsigned lTfBuilderPort);
+  ConnectStatus connectTfBuilder(const std::string &pTfBuilderId, const std::string &lTfBuilderIp, const unsigned lTfBuilderPort,
+    const std::vector<std::pair<std::string, unsigned>> &pRailEps = {});
   bool disconnectTfBuilder(const std::string &pTfBuilderId);
 
   bool sendStfToTfBuilder(const std::string &pTfBuilderId, std::unique_ptr<SubTimeFrame> &&pStf);
@@ -80,6 +93,9 @@ public:
   void DataHandlerThread(unsigned pThreadIdx);
   void StfDeallocThread();
 
+  /// Send STF metadata and wait for the DONE ack over the active message channel (use with mTfBuilderLock)
+  bool sendStfMetaAm(StfSenderUCXConnInfo &pConn, const std::uint64_t pStfId, const std::string &pStfMetaData);
+
   void handle_client_ep_error(StfSenderUCXConnInfo *pUCXConnInfo, ucs_status_t status)
   {
     // TfBuilder gets disconnected?
@@ -94,6 +110,8 @@ public:
   struct UCXMemoryRegionInfo {
     void *mPtr = nullptr;
     std::size_t mSize = 0;
+    // id in the region registry of each connection (index in mRegions)
+    std::uint32_t mRegionId = 0;
 
     ucp_mem_h ucp_mem = nullptr;
     void      *ucp_rkey_buf = nullptr;
@@ -102,8 +120,32 @@ public:
     bool operator==(const UCXMemoryRegionInfo &a) const { return (mPtr == a.mPtr); }
   };
 
+  /// Immutable index of registered regions, sorted by the address. A new index is published when regions are
+  /// added, so the threads packing STF metadata do not need locks (RCU-style snapshot).
+  struct UCXRegionIndex {
+    std::vector<UCXMemoryRegionInfo> mRegions; // sorted by mPtr
+
+    const UCXMemoryRegionInfo* lookup(const std::uint64_t pPtr, const std::size_t pSize) const {
+      // last region starting at or below the pointer
+      auto lIt = std::upper_bound(mRegions.cbegin(), mRegions.cend(), pPtr,
+        [](const std::uint64_t pAddr, const UCXMemoryRegionInfo &pReg) {
+          return pAddr < reinterpret_cast<std::uint64_t>(pReg.mPtr);
+        });
+
+      if (lIt == mRegions.cbegin()) {
+        return nullptr;
+      }
+      --lIt;
+
+      const auto lRegStart = reinterpret_cast<std::uint64_t>(lIt->mPtr);
+      return ((pPtr + pSize) <= (lRegStart + lIt->mSize)) ? &(*lIt) : nullptr;
+    }
+  };
+
   mutable std::mutex mRegionListLock;
     std::vector<UCXMemoryRegionInfo> mRegions;
+  std::atomic_uint32_t mRegionCount = 0;
+  std::shared_ptr<const UCXRegionIndex> mRegionIndex = std::make_shared<const UCXRegionIndex>();
 
   void registerSHMRegion(void *pPtr, const std::size_t pSize, const bool pManaged, const std::uint64_t pFlags) {
     if (!mRunning) {
@@ -128,40 +170,43 @@ public:
 
     {
       std::scoped_lock lLock(mRegionListLock);
+      lMemInfo.mRegionId = mRegions.size();
       mRegions.push_back(lMemInfo);
+
+      // publish a new region index
+      auto lIndex = std::make_shared<UCXRegionIndex>();
+      lIndex->mRegions = mRegions;
+      std::sort(lIndex->mRegions.begin(), lIndex->mRegions.end(),
+        [](const UCXMemoryRegionInfo &a, const UCXMemoryRegionInfo &b) { return a.mPtr < b.mPtr; });
+      std::atomic_store(&mRegionIndex, std::shared_ptr<const UCXRegionIndex>(std::move(lIndex)));
+
+      mRegionCount = mRegions.size();
     }
   }
 
-  const UCXMemoryRegionInfo* regionLookup(std::uint64_t pPtr, const std::size_t pSize) const {
-    static thread_local boost::container::small_vector<UCXMemoryRegionInfo, 16> sRegions;
-    bool lReloadCache = true;
-
-    do {
-      for (const auto &lRegion : sRegions) {
-        // DDDLOG_RL(1000, "mesg={} len={} region={} len={}", pPtr, pSize, reinterpret_cast<std::uint64_t>(lRegion.mPtr), lRegion.mSize);
+  /// Add regions not yet sent to the TfBuilder into the region registry message
+  void addRegionRegistry(StfSenderUCXConnInfo &pConnInfo, UCXIovStfHeader &pRegistry) const {
+    std::scoped_lock lLock(mRegionListLock);
 
-        if ((reinterpret_cast<char*>(pPtr) >= lRegion.mPtr) &&
-          (reinterpret_cast<char*>(pPtr)+pSize) <= (reinterpret_cast<char*>(lRegion.mPtr)+lRegion.mSize)) {
-          return &lRegion;
-        }
-      }
-      if (!lReloadCache) {
-        throw std::runtime_error("no region matched");
-      }
+    for (auto i = pConnInfo.mNumRegionsSent; i < mRegions.size(); i++) {
+      auto lRegion = pRegistry.add_data_regions();
+      lRegion->set_region(mRegions[i].mRegionId);
+      lRegion->set_size(mRegions[i].mSize);
+      lRegion->set_region_rkey(mRegions[i].ucp_rkey_buf, mRegions[i].ucp_rkey_buf_size);
+    }
+    pConnInfo.mNumRegionsSent = std::uint32_t(mRegions.size());
+  }
 
-      sRegions.clear();
-      {
-        std::scoped_lock lLock(mRegionListLock);
-        std::copy(mRegions.begin(), mRegions.end(), std::back_inserter(sRegions));
-      }
-      std::sort(sRegions.begin(), sRegions.end(), [](auto &a, auto &b) { return a.mSize > b.mSize; } );
-      lReloadCache = false;
-    } while (true);
+  std::shared_ptr<const UCXRegionIndex> regionIndex() const { return std::atomic_load(&mRegionIndex); }
 
-    throw std::runtime_error("no region matched");
+  const UCXMemoryRegionInfo* regionLookup(const UCXRegionIndex &pIndex, std::uint64_t pPtr, const std::size_t pSize) const {
+    const auto lRegion = pIndex.lookup(pPtr, pSize);
+    if (!lRegion) {
+      throw std::runtime_error("no region matched");
+    }
+    return lRegion;
   }
 
-
 protected:
   virtual void visit(const SubTimeFrame&, void*) final override;
 
@@ -174,6 +219,9 @@ private:
 
   /// Runtime options
   std::size_t mRmaGap;
+  bool mRmaCostModelEnabled = false;
+  ucx::UCXRmaCostModel mRmaCostModel;
+  bool mAmControl = false; // STF metadata and acks as active messages
   std::size_t mThreadPoolSize;
 
   // Global stf counters
@@ -102,7 +102,7 @@ void StfSenderRpcImpl::stop()
                                 const StfDataRequestMessage* request,
                                 StfDataResponse* response)
 {
-  mOutput->sendStfToTfBuilder(request->stf_id(), request->tf_builder_id(), *response/*out*/);
+  mOutput->sendStfToTfBuilder(request->stf_id(), request->tf_builder_id(), request->credit_bytes(), *response/*out*/);
   return Status::OK;
 }
 
@@ -119,11 +119,16 @@ void StfSenderRpcImpl::stop()
   }
 
   // handle the request
-  DDDLOG("Requested to connect to UCX TfBuilder. tfb_id={} tfb_ip={} tfb_port={}",
-    lTfBuilderId, lTfBuilderEp.listen_ep().ip(), lTfBuilderEp.listen_ep().port());
+  DDDLOG("Requested to connect to UCX TfBuilder. tfb_id={} tfb_ip={} tfb_port={} tfb_rails={}",
+    lTfBuilderId, lTfBuilderEp.listen_ep().ip(), lTfBuilderEp.listen_ep().port(), lTfBuilderEp.rail_eps_size());
   response->set_status(OK);
 
-  const auto lStatus = mOutput->connectTfBuilderUCX(lTfBuilderId, lTfBuilderEp.listen_ep().ip(), lTfBuilderEp.listen_ep().port());
+  std::vector<std::pair<std::string, unsigned>> lRailEps;
+  for (const auto &lRailEp : lTfBuilderEp.rail_eps()) {
+    lRailEps.emplace_back(lRailEp.ip(), lRailEp.port());
+  }
+
+  const auto lStatus = mOutput->connectTfBuilderUCX(lTfBuilderId, lTfBuilderEp.listen_ep().ip(), lTfBuilderEp.listen_ep().port(), lRailEps);
   switch (lStatus) {
     case ConnectStatus::eOK:
       response->set_status(OK);
@@ -0,0 +1,328 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Per-STF cost of the STF metadata: building and serializing the metadata in StfSender, and parsing it
+// in TfBuilder, for the UCX (UCXIovStfHeader) and FairMQ (IovStfHeader) transports.
+// "fresh": new messages and output strings for every STF, and copies of the header metadata on receive.
+// "pooled": messages in the per-thread arena (ProtobufArenaPool), reusable output buffers, and the header
+// metadata parsed directly into the object forwarded to the deserializer.
+
+#include <ProtobufPool.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <discovery.pb.h>
+#pragma GCC diagnostic pop
+
+#include <boost/program_options.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace o2::DataDistribution;
+
+namespace {
+
+using UCXData = UCXIovStfHeader::UCXData;
+using UCXIovTxg = UCXIovStfHeader::UCXIovTxg;
+
+/// Messages of one STF: o2 headers and data buffers (shuffled buffer addresses)
+struct StfInput {
+  std::vector<std::string> mHeaders;
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> mData; // <start, len>
+};
+
+static StfInput make_stf(const std::uint64_t pNumMsgs)
+{
+  StfInput lStf;
+  std::mt19937_64 lGen(pNumMsgs);
+
+  std::uint64_t lPtr = (1ULL << 40);
+  for (std::uint64_t i = 0; i < pNumMsgs; i++) {
+    lStf.mHeaders.emplace_back(96 /* DataHeader */, char('a' + i % 26));
+    const std::uint64_t lLen = 256 + (lGen() % (64 << 10));
+    lStf.mData.emplace_back(lPtr, lLen);
+    lPtr += lLen + ((lGen() % 4 == 0) ? 4096 : 0);
+  }
+  std::shuffle(lStf.mData.begin(), lStf.mData.end(), lGen);
+  return lStf;
+}
+
+static void add_headers(const StfInput &pStf, IovStfHdrMeta &pHdrMeta, const std::uint64_t pStfId)
+{
+  pHdrMeta.set_stf_id(pStfId);
+  pHdrMeta.set_stf_size(pStf.mData.size());
+  pHdrMeta.set_stf_dd_header(std::string(64, 'h'));
+
+  for (const auto &lHdr : pStf.mHeaders) {
+    auto lHdrMeta = pHdrMeta.add_stf_hdr_iov();
+    lHdrMeta->set_hdr_data(lHdr.data(), lHdr.size());
+    lHdrMeta->set_num_data_parts(1);
+  }
+}
+
+/// txgs of sorted data parts: merge adjacent buffers
+template <typename DataIter>
+static void add_txgs(DataIter pBegin, DataIter pEnd, UCXIovStfHeader &pMeta)
+{
+  UCXIovTxg *lTxg = nullptr;
+  for (auto lIt = pBegin; lIt != pEnd; ++lIt) {
+    UCXData &lData = *lIt;
+    if (lTxg && (lTxg->start() + lTxg->len()) == lData.start()) {
+      lTxg->set_len(lTxg->len() + lData.len());
+      lTxg->set_data_parts(lTxg->data_parts() + 1);
+    } else {
+      lTxg = pMeta.add_stf_txg_iov();
+      lTxg->set_txg(pMeta.stf_txg_iov_size() - 1);
+      lTxg->set_start(lData.start());
+      lTxg->set_len(lData.len());
+      lTxg->set_data_parts(1);
+    }
+    lData.set_txg(lTxg->txg());
+  }
+}
+
+/// StfSenderOutputUCX, before: data parts in a vector, copied into a new message, new output string
+static std::string ucx_build_fresh(const StfInput &pStf, const std::uint64_t pStfId)
+{
+  UCXIovStfHeader lMeta;
+  add_headers(pStf, *lMeta.mutable_stf_hdr_meta(), pStfId);
+
+  std::vector<UCXData> lStfDataPtrs;
+  lStfDataPtrs.reserve(32768);
+  std::uint32_t lIdx = 0;
+  for (const auto &lData : pStf.mData) {
+    lStfDataPtrs.emplace_back(UCXData());
+    lStfDataPtrs.back().set_idx(lIdx++);
+    lStfDataPtrs.back().set_start(lData.first);
+    lStfDataPtrs.back().set_len(lData.second);
+  }
+  std::sort(lStfDataPtrs.begin(), lStfDataPtrs.end(), [](const UCXData &a, const UCXData &b) { return a.start() < b.start(); });
+  add_txgs(lStfDataPtrs.begin(), lStfDataPtrs.end(), lMeta);
+
+  for (const auto &lDataPart : lStfDataPtrs) {
+    *lMeta.add_stf_data_iov() = lDataPart;
+  }
+
+  return lMeta.SerializeAsString();
+}
+
+/// StfSenderOutputUCX: data parts added to the arena message, sorted by pointers, reusable output buffer
+static const std::string& ucx_build_pooled(const StfInput &pStf, const std::uint64_t pStfId,
+                                           ProtobufArenaPool<UCXIovStfHeader> &pPool)
+{
+  auto &lMeta = pPool.acquire();
+  add_headers(pStf, *lMeta.mutable_stf_hdr_meta(), pStfId);
+
+  auto &lStfDataPtrs = *lMeta.mutable_stf_data_iov();
+  std::uint32_t lIdx = 0;
+  for (const auto &lData : pStf.mData) {
+    auto lDataPart = lStfDataPtrs.Add();
+    lDataPart->set_idx(lIdx++);
+    lDataPart->set_start(lData.first);
+    lDataPart->set_len(lData.second);
+  }
+  std::sort(lStfDataPtrs.pointer_begin(), lStfDataPtrs.pointer_end(),
+    [](const UCXData *a, const UCXData *b) { return a->start() < b->start(); });
+  add_txgs(lStfDataPtrs.begin(), lStfDataPtrs.end(), lMeta);
+
+  return pPool.serialize(lMeta);
+}
+
+/// TfBuilderInputUCX, before: new message, header meta copied for the deserializer, and copied again there
+static std::uint64_t ucx_parse_fresh(const std::string &pData)
+{
+  UCXIovStfHeader lMeta;
+  lMeta.ParseFromString(pData);
+  auto lStfHdr = std::make_unique<IovStfHdrMeta>(lMeta.stf_hdr_meta());
+
+  IovStfHdrMeta lDeserializerHdr;
+  lDeserializerHdr.CopyFrom(*lStfHdr);
+  return lMeta.stf_data_iov_size() + lDeserializerHdr.stf_hdr_iov_size();
+}
+
+/// TfBuilderInputUCX: iov entries in the arena, header meta parsed into the forwarded object
+static std::uint64_t ucx_parse_pooled(const std::string &pData, ProtobufArenaPool<UCXIovStfHeader> &pPool)
+{
+  auto &lMeta = pPool.acquire();
+  auto lStfHdr = std::make_unique<IovStfHdrMeta>();
+  lMeta.unsafe_arena_set_allocated_stf_hdr_meta(lStfHdr.get());
+  proto_merge_from_array(lMeta, pData.data(), pData.size());
+  lMeta.unsafe_arena_release_stf_hdr_meta();
+
+  return lMeta.stf_data_iov_size() + lStfHdr->stf_hdr_iov_size();
+}
+
+/// IovSerializer, before: reused message, new output string copied into the message buffer
+static std::unique_ptr<char[]> fmq_build_fresh(const StfInput &pStf, const std::uint64_t pStfId, IovStfHeader &pIovHeader,
+                                               std::size_t &pSize)
+{
+  pIovHeader.Clear();
+  add_headers(pStf, *pIovHeader.mutable_stf_hdr_meta(), pStfId);
+
+  std::string lHeaderMessage;
+  pIovHeader.SerializeToString(&lHeaderMessage);
+
+  pSize = lHeaderMessage.size();
+  auto lMsg = std::make_unique<char[]>(pSize);
+  std::memcpy(lMsg.get(), lHeaderMessage.data(), pSize);
+  return lMsg;
+}
+
+/// IovSerializer: reused message serialized directly into the message buffer
+static std::unique_ptr<char[]> fmq_build_pooled(const StfInput &pStf, const std::uint64_t pStfId, IovStfHeader &pIovHeader,
+                                                std::size_t &pSize)
+{
+  pIovHeader.Clear();
+  add_headers(pStf, *pIovHeader.mutable_stf_hdr_meta(), pStfId);
+
+  pSize = pIovHeader.ByteSizeLong();
+  auto lMsg = std::make_unique<char[]>(pSize);
+  pIovHeader.SerializeWithCachedSizesToArray(reinterpret_cast<std::uint8_t*>(lMsg.get()));
+  return lMsg;
+}
+
+/// TfBuilderInputFairMQ, before
+static std::uint64_t fmq_parse_fresh(const char *pData, const std::size_t pSize)
+{
+  IovStfHeader lStfHeaderMeta;
+  lStfHeaderMeta.ParseFromArray(pData, int(pSize));
+  auto lStfHdr = std::make_unique<IovStfHdrMeta>(lStfHeaderMeta.stf_hdr_meta());
+
+  IovStfHdrMeta lDeserializerHdr;
+  lDeserializerHdr.CopyFrom(*lStfHdr);
+  return lDeserializerHdr.stf_hdr_iov_size();
+}
+
+/// TfBuilderInputFairMQ
+static std::uint64_t fmq_parse_pooled(const char *pData, const std::size_t pSize, ProtobufArenaPool<IovStfHeader> &pPool)
+{
+  auto &lStfHeaderMeta = pPool.acquire();
+  auto lStfHdr = std::make_unique<IovStfHdrMeta>();
+  lStfHeaderMeta.unsafe_arena_set_allocated_stf_hdr_meta(lStfHdr.get());
+  proto_merge_from_array(lStfHeaderMeta, pData, pSize);
+  lStfHeaderMeta.unsafe_arena_release_stf_hdr_meta();
+
+  return lStfHdr->stf_hdr_iov_size();
+}
+
+template <typename Fn>
+static double time_us(const std::uint64_t pIterations, Fn &&pFn)
+{
+  const auto lStart = std::chrono::steady_clock::now();
+  for (std::uint64_t i = 0; i < pIterations; i++) {
+    pFn(i);
+  }
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - lStart).count() / double(pIterations);
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+  namespace bpo = boost::program_options;
+
+  bpo::options_description lOptions("StfMetaBenchmark options", 120);
+  lOptions.add_options()
+    ("help,h", "Print help.")
+    ("msgs", bpo::value<std::vector<std::uint64_t>>()->multitoken()->default_value({ 100, 1000, 10000 }, "100 1000 10000"),
+      "Number of messages (header and data) in the STF.")
+    ("msgs-per-iteration", bpo::value<std::uint64_t>()->default_value(10000000),
+      "Number of messages processed for each measurement (at least 100 STFs).");
+
+  bpo::variables_map lVm;
+  try {
+    bpo::store(bpo::parse_command_line(argc, argv, lOptions), lVm);
+    bpo::notify(lVm);
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n" << lOptions << std::endl;
+    return 1;
+  }
+
+  if (lVm.count("help")) {
+    std::cout << "Usage: StfMetaBenchmark [options]\n" << lOptions << std::endl;
+    return 0;
+  }
+
+  std::cout << fmt::format("{:>6} {:>8} {:>10} {:>14} {:>14} {:>14} {:>14}", "tport", "msgs", "meta_kB",
+    "build_fresh_us", "build_pool_us", "parse_fresh_us", "parse_pool_us") << std::endl;
+
+  ProtobufArenaPool<UCXIovStfHeader> lUcxSendPool;
+  ProtobufArenaPool<UCXIovStfHeader> lUcxRecvPool;
+  ProtobufArenaPool<IovStfHeader> lFmqRecvPool(64 << 10);
+  IovStfHeader lIovHeader;
+
+  for (const auto lNumMsgs : lVm["msgs"].as<std::vector<std::uint64_t>>()) {
+    const auto lStf = make_stf(std::max(std::uint64_t(1), lNumMsgs));
+    const auto lIterations = std::max(std::uint64_t(100), lVm["msgs-per-iteration"].as<std::uint64_t>() / lStf.mData.size());
+
+    { // UCX
+      const std::string lMetaData = ucx_build_fresh(lStf, 1);
+      std::uint64_t lCheck = 0;
+
+      // warm up the pools
+      ucx_build_pooled(lStf, 0, lUcxSendPool);
+      ucx_parse_pooled(lMetaData, lUcxRecvPool);
+
+      const double lBuildFresh = time_us(lIterations, [&](std::uint64_t i) { lCheck += ucx_build_fresh(lStf, i).size(); });
+      const double lBuildPool = time_us(lIterations, [&](std::uint64_t i) { lCheck += ucx_build_pooled(lStf, i, lUcxSendPool).size(); });
+      const double lParseFresh = time_us(lIterations, [&](std::uint64_t) { lCheck += ucx_parse_fresh(lMetaData); });
+      const double lParsePool = time_us(lIterations, [&](std::uint64_t) { lCheck += ucx_parse_pooled(lMetaData, lUcxRecvPool); });
+
+      if (ucx_build_pooled(lStf, 1, lUcxSendPool) != lMetaData) {
+        std::cerr << "Error: UCX metadata of the pooled build is different." << std::endl;
+        return 1;
+      }
+
+      if (lCheck == 0) {
+        return 1; // keep the results used
+      }
+
+      std::cout << fmt::format("{:>6} {:>8} {:>10.1f} {:>14.2f} {:>14.2f} {:>14.2f} {:>14.2f}", "ucx", lNumMsgs,
+        double(lMetaData.size()) / 1024.0, lBuildFresh, lBuildPool, lParseFresh, lParsePool) << std::endl;
+    }
+
+    { // FairMQ
+      std::size_t lSize = 0;
+      const auto lMetaData = fmq_build_fresh(lStf, 1, lIovHeader, lSize);
+      std::uint64_t lCheck = 0;
+
+      fmq_parse_pooled(lMetaData.get(), lSize, lFmqRecvPool);
+
+      const double lBuildFresh = time_us(lIterations, [&](std::uint64_t i) {
+        std::size_t lMsgSize; lCheck += bool(fmq_build_fresh(lStf, i, lIovHeader, lMsgSize)); });
+      const double lBuildPool = time_us(lIterations, [&](std::uint64_t i) {
+        std::size_t lMsgSize; lCheck += bool(fmq_build_pooled(lStf, i, lIovHeader, lMsgSize)); });
+      const double lParseFresh = time_us(lIterations, [&](std::uint64_t) { lCheck += fmq_parse_fresh(lMetaData.get(), lSize); });
+      const double lParsePool = time_us(lIterations, [&](std::uint64_t) {
+        lCheck += fmq_parse_pooled(lMetaData.get(), lSize, lFmqRecvPool); });
+
+      if (lCheck == 0) {
+        return 1; // keep the results used
+      }
+
+      std::cout << fmt::format("{:>6} {:>8} {:>10.1f} {:>14.2f} {:>14.2f} {:>14.2f} {:>14.2f}", "fmq", lNumMsgs,
+        double(lSize) / 1024.0, lBuildFresh, lBuildPool, lParseFresh, lParsePool) << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -39,6 +39,8 @@ int main(int argc, char* argv[])
       r.fConfig.AddToCmdLineOptions(impl::DataDistLoggerCtx::getProgramOptions());
       // Add Monitoring Options
       r.fConfig.AddToCmdLineOptions(DataDistMonitor::getProgramOptions());
+      // Add Tracing Options
+      r.fConfig.AddToCmdLineOptions(DataDistTracer::getProgramOptions());
 
       // StfSender options
       bpo::options_description lStfSenderOptions("StfSender options", 120);
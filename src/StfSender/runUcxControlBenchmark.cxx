@@ -0,0 +1,200 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Per-STF control plane cost of the UCX transport: STF metadata from StfSender and the transfer ack
+// from TfBuilder, using tagged strings or active messages (UcxControlActiveMessages parameter).
+// Measured over a loopback UCX connection, with one thread for each side.
+// Select the transport with UCX_TLS (e.g. UCX_TLS=tcp, or UCX_TLS=shm).
+
+#include <UCXLoopback.h>
+
+#include <boost/program_options.hpp>
+
+#include <fmt/format.h>
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace o2::DataDistribution;
+
+namespace {
+
+struct Result {
+  std::vector<double> mLatencyUs;
+  double mSenderCpuUs = 0;    // per STF
+  double mReceiverCpuUs = 0;  // per STF
+};
+
+static double thread_cpu_us()
+{
+  timespec lTs;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &lTs);
+  return double(lTs.tv_sec) * 1e6 + double(lTs.tv_nsec) / 1e3;
+}
+
+/// TfBuilder side: receive the metadata, send the ack
+static void receiver(ucx::UcxLoopbackConn &pConn, ucx::io::dd_ucp_am_queue &pQueue, const bool pAm,
+                     const std::uint64_t pNumStfs, double &pCpuUs)
+{
+  const auto lCpuStart = thread_cpu_us();
+
+  for (std::uint64_t i = 0; i < pNumStfs; i++) {
+    if (pAm) {
+      auto lMsg = ucx::io::am_receive_blocking(pConn.server_worker, pQueue);
+      const auto lStfId = lMsg->mHdr.mStfId;
+      pQueue.pop();
+
+      ucx::io::dd_am_hdr lDone;
+      lDone.mType = ucx::io::DD_AM_STF_DONE;
+      lDone.mStfId = lStfId;
+      ucx::io::am_send_blocking(pConn.server_worker, pConn.server_ep, lDone);
+    } else {
+      auto lMeta = ucx::io::ucx_receive_string(pConn.server_worker);
+      ucx::io::ucx_send_string(pConn.server_worker, pConn.server_ep, std::string("OK"));
+    }
+  }
+
+  pCpuUs = (thread_cpu_us() - lCpuStart) / double(pNumStfs);
+}
+
+/// StfSender side: send the metadata, wait for the ack
+static Result measure(ucx::UcxLoopbackConn &pConn, ucx::io::dd_ucp_am_queue &pClientQueue,
+                      ucx::io::dd_ucp_am_queue &pServerQueue, const bool pAm, const std::uint64_t pMetaSize,
+                      const std::uint64_t pNumStfs)
+{
+  Result lResult;
+  lResult.mLatencyUs.reserve(pNumStfs);
+
+  std::thread lReceiver(receiver, std::ref(pConn), std::ref(pServerQueue), pAm, pNumStfs, std::ref(lResult.mReceiverCpuUs));
+
+  const std::string lMeta(pMetaSize, 'x');
+  const auto lCpuStart = thread_cpu_us();
+
+  for (std::uint64_t lStfId = 0; lStfId < pNumStfs; lStfId++) {
+    const auto lStart = std::chrono::steady_clock::now();
+
+    if (pAm) {
+      ucx::io::dd_am_hdr lHdr;
+      lHdr.mType = ucx::io::DD_AM_STF_META;
+      lHdr.mStfId = lStfId;
+      ucx::io::am_send_blocking(pConn.client_worker, pConn.client_ep, lHdr, lMeta.data(), lMeta.size());
+
+      auto lDone = ucx::io::am_receive_blocking(pConn.client_worker, pClientQueue);
+      if (lDone->mHdr.mStfId != lStfId) {
+        std::cerr << "Unexpected ack. stf_id=" << lStfId << " ack_stf_id=" << lDone->mHdr.mStfId << std::endl;
+      }
+      pClientQueue.pop();
+    } else {
+      ucx::io::ucx_send_string(pConn.client_worker, pConn.client_ep, lMeta);
+      auto lOk = ucx::io::ucx_receive_string(pConn.client_worker);
+    }
+
+    lResult.mLatencyUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - lStart).count());
+  }
+
+  lResult.mSenderCpuUs = (thread_cpu_us() - lCpuStart) / double(pNumStfs);
+  lReceiver.join();
+
+  return lResult;
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+  namespace bpo = boost::program_options;
+
+  bpo::options_description lOptions("UcxControlBenchmark options", 120);
+  lOptions.add_options()
+    ("help,h", "Print help.")
+    ("ip", bpo::value<std::string>()->default_value("127.0.0.1"), "IP address of the loopback connection.")
+    ("meta-size", bpo::value<std::vector<std::uint64_t>>()->multitoken()->default_value({ 256, 4096, 65536, 1ULL << 20 },
+      "256 4096 65536 1048576"), "Sizes of the STF metadata (bytes).")
+    ("stfs", bpo::value<std::uint64_t>()->default_value(20000), "Number of STFs for each size.")
+    ("mode", bpo::value<std::string>()->default_value("both"), "Control channel: tag, am, or both.");
+
+  bpo::variables_map lVm;
+  try {
+    bpo::store(bpo::parse_command_line(argc, argv, lOptions), lVm);
+    bpo::notify(lVm);
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n" << lOptions << std::endl;
+    return 1;
+  }
+
+  if (lVm.count("help")) {
+    std::cout << "Usage: [UCX_TLS=tcp] UcxControlBenchmark [options]\n" << lOptions << std::endl;
+    return 0;
+  }
+
+  const auto lMode = lVm["mode"].as<std::string>();
+  if (lMode != "tag" && lMode != "am" && lMode != "both") {
+    std::cerr << "Error: invalid mode: " << lMode << std::endl;
+    return 1;
+  }
+  const auto lNumStfs = std::max(std::uint64_t(1), lVm["stfs"].as<std::uint64_t>());
+
+  ucx::UcxLoopbackConn lConn;
+  if (!lConn.connect(lVm["ip"].as<std::string>())) {
+    std::cerr << "Failed to create the loopback UCX connection." << std::endl;
+    return 2;
+  }
+
+  ucx::io::dd_ucp_am_queue lClientQueue;
+  ucx::io::dd_ucp_am_queue lServerQueue;
+  if (!ucx::io::am_register_handler(lConn.client_worker, lClientQueue) ||
+      !ucx::io::am_register_handler(lConn.server_worker, lServerQueue)) {
+    return 2;
+  }
+
+  std::vector<bool> lModes;
+  if (lMode != "am") {
+    lModes.push_back(false);
+  }
+  if (lMode != "tag") {
+    lModes.push_back(true);
+  }
+
+  std::cout << fmt::format("{:>6} {:>10} {:>10} {:>10} {:>10} {:>10} {:>14} {:>14}", "mode", "meta_size",
+    "mean_us", "p50_us", "p99_us", "stfs/s", "snd_cpu_us", "rcv_cpu_us") << std::endl;
+
+  for (const auto lMetaSize : lVm["meta-size"].as<std::vector<std::uint64_t>>()) {
+    for (const bool lAm : lModes) {
+      // warm up
+      measure(lConn, lClientQueue, lServerQueue, lAm, lMetaSize, std::min(lNumStfs, std::uint64_t(1000)));
+
+      auto lResult = measure(lConn, lClientQueue, lServerQueue, lAm, lMetaSize, lNumStfs);
+
+      auto &lLat = lResult.mLatencyUs;
+      double lTotal = 0;
+      for (const auto lUs : lLat) {
+        lTotal += lUs;
+      }
+      std::sort(lLat.begin(), lLat.end());
+
+      std::cout << fmt::format("{:>6} {:>10} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.0f} {:>14.2f} {:>14.2f}",
+        (lAm ? "am" : "tag"), lMetaSize, lTotal / double(lLat.size()), lLat[lLat.size() / 2],
+        lLat[std::min(lLat.size() - 1, lLat.size() * 99 / 100)], double(lLat.size()) / std::max(lTotal / 1e6, 1e-9),
+        lResult.mSenderCpuUs, lResult.mReceiverCpuUs) << std::endl;
+    }
+  }
+
+  lConn.close();
+  return 0;
+}
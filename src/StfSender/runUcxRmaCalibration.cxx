@@ -0,0 +1,171 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Offline calibration of the UCX RMA cost model (UcxRmaCostModel parameter of StfSender).
+// RMA get operations of increasing size are measured over a loopback UCX connection.
+// Select the transport with UCX_TLS (e.g. UCX_TLS=tcp, or UCX_TLS=shm,tcp).
+
+#include <UCXLoopback.h>
+
+#include <UCXRmaCostModel.h>
+
+#include <boost/program_options.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace o2::DataDistribution;
+
+namespace {
+
+/// Average time of get operations of the size, with pConcurrency operations in flight (us)
+static double measure(ucx::UcxLoopbackConn &pConn, char *pLocal, std::uint64_t pRemote, ucp_rkey_h pRKey,
+                      const std::uint64_t pSize, const std::uint64_t pNumOps, const std::uint64_t pConcurrency)
+{
+  ucx::io::dd_ucp_multi_req lReq(pConcurrency);
+
+  const auto lStart = std::chrono::steady_clock::now();
+
+  for (std::uint64_t i = 0; i < pNumOps; i++) {
+    while (!lReq.done()) {
+      pConn.progress();
+    }
+    ucx::io::get(pConn.client_ep, pLocal, pSize, pRemote, pRKey, &lReq);
+  }
+
+  lReq.mark_finished();
+  while (!lReq.done()) {
+    pConn.progress();
+  }
+
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - lStart).count() / double(pNumOps);
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+  namespace bpo = boost::program_options;
+
+  bpo::options_description lOptions("UcxRmaCalibration options", 120);
+  lOptions.add_options()
+    ("help,h", "Print help.")
+    ("ip", bpo::value<std::string>()->default_value("127.0.0.1"), "IP address of the loopback connection.")
+    ("min-size", bpo::value<std::uint64_t>()->default_value(64), "Smallest get operation (bytes).")
+    ("max-size", bpo::value<std::uint64_t>()->default_value(16ULL << 20), "Largest get operation (bytes).")
+    ("concurrency", bpo::value<std::uint64_t>()->default_value(8),
+      "Number of get operations in flight (UcxNumConcurrentRmaGetOps of TfBuilder).")
+    ("bytes-per-point", bpo::value<std::uint64_t>()->default_value(1ULL << 30),
+      "Amount of data transferred for each measured size.")
+    ("min-ops", bpo::value<std::uint64_t>()->default_value(10000), "Minimum number of operations for each size.");
+
+  bpo::variables_map lVm;
+  try {
+    bpo::store(bpo::parse_command_line(argc, argv, lOptions), lVm);
+    bpo::notify(lVm);
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n" << lOptions << std::endl;
+    return 1;
+  }
+
+  if (lVm.count("help")) {
+    std::cout << "Usage: [UCX_TLS=tcp] UcxRmaCalibration [options]\n" << lOptions << std::endl;
+    return 0;
+  }
+
+  const auto lMinSize = std::max(std::uint64_t(1), lVm["min-size"].as<std::uint64_t>());
+  const auto lMaxSize = std::max(lMinSize, lVm["max-size"].as<std::uint64_t>());
+  const auto lConcurrency = std::clamp(lVm["concurrency"].as<std::uint64_t>(), std::uint64_t(1), std::uint64_t(64));
+  const auto lBytesPerPoint = lVm["bytes-per-point"].as<std::uint64_t>();
+  const auto lMinOps = std::max(std::uint64_t(1), lVm["min-ops"].as<std::uint64_t>());
+
+  ucx::UcxLoopbackConn lConn;
+  if (!lConn.connect(lVm["ip"].as<std::string>())) {
+    std::cerr << "Failed to create the loopback UCX connection." << std::endl;
+    return 2;
+  }
+
+  // remote (source) and local (destination) buffers
+  auto lRemoteBuf = std::make_unique<char[]>(lMaxSize);
+  auto lLocalBuf = std::make_unique<char[]>(lMaxSize);
+
+  ucp_mem_h lRemoteMem;
+  void *lRKeyBuf = nullptr;
+  std::size_t lRKeySize = 0;
+  ucp_mem_h lLocalMem;
+  if (!ucx::util::create_rkey_for_region(lConn.ucp_context, lRemoteBuf.get(), lMaxSize, true, &lRemoteMem, &lRKeyBuf, &lRKeySize) ||
+      !ucx::util::create_rkey_for_region(lConn.ucp_context, lLocalBuf.get(), lMaxSize, false, &lLocalMem, nullptr, nullptr)) {
+    return 2;
+  }
+
+  ucp_rkey_h lRKey;
+  if (ucp_ep_rkey_unpack(lConn.client_ep, lRKeyBuf, &lRKey) != UCS_OK) {
+    std::cerr << "Failed to unpack the rkey." << std::endl;
+    return 2;
+  }
+
+  const auto lRemotePtr = reinterpret_cast<std::uint64_t>(lRemoteBuf.get());
+
+  // warm up
+  measure(lConn, lLocalBuf.get(), lRemotePtr, lRKey, lMinSize, 1000, lConcurrency);
+
+  std::cout << fmt::format("{:>12} {:>10} {:>12} {:>12}", "size", "ops", "time_us", "MB/s") << std::endl;
+
+  ucx::UCXRmaCostModel lModel;
+  std::vector<ucx::UCXRmaCostModel::Point> lPoints;
+
+  for (std::uint64_t lSize = lMinSize; lSize <= lMaxSize; lSize *= 2) {
+    const auto lNumOps = std::max(lMinOps, lBytesPerPoint / lSize);
+    const double lTimeUs = measure(lConn, lLocalBuf.get(), lRemotePtr, lRKey, lSize, lNumOps, lConcurrency);
+
+    lPoints.push_back({ lSize, lTimeUs });
+    std::cout << fmt::format("{:>12} {:>10} {:>12.3f} {:>12.1f}", lSize, lNumOps, lTimeUs,
+      double(lSize) / std::max(lTimeUs, 1e-9)) << std::endl;
+
+    if (lSize > (lMaxSize / 2)) {
+      break;
+    }
+  }
+
+  std::string lModelStr;
+  for (const auto &lPoint : lPoints) {
+    lModelStr += fmt::format("{}{}:{:.3f}", (lModelStr.empty() ? "" : ","), lPoint.mSize, lPoint.mTimeUs);
+  }
+
+  if (!lModel.parse(lModelStr)) {
+    std::cerr << "Not enough points for the cost model. Increase max-size." << std::endl;
+    return 1;
+  }
+
+  // largest merged gaps between two buffers of the same size
+  std::cout << "\nLargest gap merged into a txg:" << std::endl;
+  std::cout << fmt::format("{:>12} {:>12}", "buffer_size", "max_gap") << std::endl;
+  for (const std::uint64_t lBufSize : { 128ULL, 4096ULL, 65536ULL, 1ULL << 20, 8ULL << 20 }) {
+    std::cout << fmt::format("{:>12} {:>12}", lBufSize, lModel.maxMergeGap(lBufSize, lBufSize)) << std::endl;
+  }
+
+  std::cout << "\nStfSender parameter:\nUcxRmaCostModel=" << lModel.to_string() << std::endl;
+
+  ucp_rkey_destroy(lRKey);
+  ucp_mem_unmap(lConn.ucp_context, lLocalMem);
+  ucx::util::destroy_rkey_for_region(lConn.ucp_context, lRemoteMem, lRKeyBuf);
+  lConn.close();
+
+  return 0;
+}
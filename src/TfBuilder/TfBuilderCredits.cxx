@@ -0,0 +1,132 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TfBuilderCredits.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace o2::DataDistribution
+{
+
+bool TfBuilderCredits::try_acquire(const std::string &pStfSenderId, const std::uint64_t pStfId, const std::uint64_t pBytes)
+{
+  // outside of the lock, can take the region lock
+  const std::uint64_t lFreeMem = mFreeMemFn ? mFreeMemFn() : std::numeric_limits<std::uint64_t>::max();
+
+  std::scoped_lock lLock(mLock);
+
+  const auto lKey = std::make_pair(pStfSenderId, pStfId);
+  if (mGrants.count(lKey) > 0) {
+    return true; // already granted
+  }
+
+  if (!mGrants.empty()) {
+    if (mGrants.size() >= mConfig.mMaxTransfers) {
+      mNumDenied++;
+      return false;
+    }
+
+    // free region memory is not yet reduced by transfers in progress (conservative)
+    std::uint64_t lLimit = lFreeMem;
+    if (mConfig.mMaxBytes > 0) {
+      lLimit = std::min(lLimit, mConfig.mMaxBytes);
+    }
+    if ((mBytesInFlight + pBytes) > lLimit) {
+      mNumDenied++;
+      return false;
+    }
+
+    const auto lSenderBytes = mStfSenderBytes[pStfSenderId];
+    if ((mConfig.mMaxStfSenderBytes > 0) && (lSenderBytes > 0) && ((lSenderBytes + pBytes) > mConfig.mMaxStfSenderBytes)) {
+      mNumDenied++;
+      return false;
+    }
+  }
+
+  mGrants[lKey] = pBytes;
+  mBytesInFlight += pBytes;
+  mStfSenderBytes[pStfSenderId] += pBytes;
+  return true;
+}
+
+void TfBuilderCredits::update(const std::string &pStfSenderId, const std::uint64_t pStfId, const std::uint64_t pBytes)
+{
+  {
+    std::scoped_lock lLock(mLock);
+
+    auto lIt = mGrants.find(std::make_pair(pStfSenderId, pStfId));
+    if (lIt == mGrants.end() || lIt->second == pBytes) {
+      return;
+    }
+
+    mBytesInFlight = mBytesInFlight - lIt->second + pBytes;
+    auto &lSenderBytes = mStfSenderBytes[pStfSenderId];
+    lSenderBytes = lSenderBytes - lIt->second + pBytes;
+    lIt->second = pBytes;
+    mGeneration++;
+  }
+  mCond.notify_all();
+}
+
+void TfBuilderCredits::release(const std::string &pStfSenderId, const std::uint64_t pStfId)
+{
+  {
+    std::scoped_lock lLock(mLock);
+
+    auto lIt = mGrants.find(std::make_pair(pStfSenderId, pStfId));
+    if (lIt == mGrants.end()) {
+      return;
+    }
+
+    mBytesInFlight -= lIt->second;
+    auto lSenderIt = mStfSenderBytes.find(pStfSenderId);
+    lSenderIt->second -= lIt->second;
+    if (lSenderIt->second == 0) {
+      mStfSenderBytes.erase(lSenderIt);
+    }
+    mGrants.erase(lIt);
+    mGeneration++;
+  }
+  mCond.notify_all();
+}
+
+void TfBuilderCredits::wait_for(const std::uint64_t pGeneration, const std::chrono::milliseconds pTimeout)
+{
+  std::unique_lock lLock(mLock);
+  mCond.wait_for(lLock, pTimeout, [&]() { return mGeneration != pGeneration; });
+}
+
+void TfBuilderCredits::notify()
+{
+  {
+    std::scoped_lock lLock(mLock);
+    mGeneration++;
+  }
+  mCond.notify_all();
+}
+
+void TfBuilderCredits::reset()
+{
+  {
+    std::scoped_lock lLock(mLock);
+    mBytesInFlight = 0;
+    mStfSenderBytes.clear();
+    mGrants.clear();
+    mNumDenied = 0;
+    mGeneration++;
+  }
+  mCond.notify_all();
+}
+
+} /* namespace o2::DataDistribution */
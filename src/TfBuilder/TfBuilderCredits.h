@@ -0,0 +1,100 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TF_BUILDER_CREDITS_H_
+#define TF_BUILDER_CREDITS_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace o2::DataDistribution
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// TfBuilderCredits
+////////////////////////////////////////////////////////////////////////////////
+
+///
+/// Receiver driven flow control of STF transfers. Every StfDataRequest sent to an StfSender is a
+/// grant of byte credit for the STF. Credits are granted while the bytes in flight fit into the free
+/// data region and into the node limit, and while the StfSender is below its own limit. Credits are
+/// returned when the STF is received, or when the request fails.
+/// A transfer is always granted when nothing is in flight, so that STFs larger than the limits make progress.
+///
+class TfBuilderCredits
+{
+public:
+  struct Config {
+    std::uint64_t mMaxBytes = 0;          // bytes in flight of all StfSenders. 0: free data region only
+    std::uint64_t mMaxStfSenderBytes = 0; // bytes in flight per StfSender. 0: unlimited
+    std::uint64_t mMaxTransfers = 100;    // number of STF transfers in flight
+  };
+
+  explicit TfBuilderCredits(std::function<std::uint64_t()> pFreeMemFn)
+  : mFreeMemFn(std::move(pFreeMemFn))
+  { }
+
+  void configure(const Config &pConfig)
+  {
+    std::scoped_lock lLock(mLock);
+    mConfig = pConfig;
+  }
+
+  /// Grant credit for the STF transfer, without blocking
+  bool try_acquire(const std::string &pStfSenderId, const std::uint64_t pStfId, const std::uint64_t pBytes);
+
+  /// Correct the size of a granted transfer (e.g. with the size reported by the StfSender)
+  void update(const std::string &pStfSenderId, const std::uint64_t pStfId, const std::uint64_t pBytes);
+
+  /// Return the credit of a finished or failed transfer
+  void release(const std::string &pStfSenderId, const std::uint64_t pStfId);
+
+  /// Changes on every returned credit. Read before try_acquire(), to wait for later changes.
+  std::uint64_t generation() const { std::scoped_lock lLock(mLock); return mGeneration; }
+
+  /// Wait for credits returned after the generation, or for changes of the free memory (notify())
+  void wait_for(const std::uint64_t pGeneration, const std::chrono::milliseconds pTimeout);
+  void notify();
+
+  void reset();
+
+  std::uint64_t bytesInFlight() const { std::scoped_lock lLock(mLock); return mBytesInFlight; }
+  std::uint64_t transfersInFlight() const { std::scoped_lock lLock(mLock); return mGrants.size(); }
+  std::uint64_t numDenied() const { std::scoped_lock lLock(mLock); return mNumDenied; }
+
+private:
+  std::function<std::uint64_t()> mFreeMemFn;
+
+  mutable std::mutex mLock;
+  std::condition_variable mCond;
+
+  Config mConfig;
+
+  std::uint64_t mGeneration = 0;
+  std::uint64_t mBytesInFlight = 0;
+  std::unordered_map<std::string, std::uint64_t> mStfSenderBytes;
+  // <stfsender, stf id> -> granted bytes
+  std::map<std::pair<std::string, std::uint64_t>, std::uint64_t> mGrants;
+
+  std::uint64_t mNumDenied = 0;
+};
+
+} /* namespace o2::DataDistribution */
+
+#endif /* TF_BUILDER_CREDITS_H_ */
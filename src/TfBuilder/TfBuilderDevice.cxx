@@ -78,6 +78,10 @@ void TfBuilderDevice::InitTask()
   DataDistMonitor::set_interval(GetConfig()->GetValue<float>("monitoring-interval"));
   DataDistMonitor::set_log(GetConfig()->GetValue<bool>("monitoring-log"));
 
+  // start STF tracing
+  DataDistTracer::start("TfBuilder", GetConfig()->GetValue<std::uint64_t>("trace-sample-interval"),
+    GetConfig()->GetValue<std::string>("trace-dump-dir"));
+
   // Using DPL?
   if (mDplChannelName != "") {
     mStandalone = false;
@@ -259,6 +263,7 @@ void TfBuilderDevice::stop()
 
   // stop monitoring
   DataDistMonitor::stop_datadist();
+  DataDistTracer::stop();
 
   DDDLOG("TfBuilderDevice() stopped... ");
 }
@@ -393,6 +398,9 @@ void TfBuilderDevice::TfForwardThread()
       DDMON("tfbuilder", "tf_output.sent_count", mTfFwdTotalTfCount);
     }
 
+    lTf->traceStamp(eStfTraceTfBuilderOut);
+    DataDistTracer::record(lTfId, lTf->trace());
+
     if (!mStandalone) {
       try {
         IDDLOG_RL(5000, "Forwarding a new TF to DPL. tf_id={} stf_size={:d} unique_equipments={:d} total={:d}",
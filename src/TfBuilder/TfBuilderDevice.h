@@ -26,6 +26,7 @@
 #include <Utilities.h>
 #include <FmqUtilities.h>
 #include <DataDistMonitoring.h>
+#include <DataDistTracing.h>
 
 #include <deque>
 #include <mutex>
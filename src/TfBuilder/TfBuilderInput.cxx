@@ -55,7 +55,14 @@ bool TfBuilderInput::start()
 {
   // make max number of listening channels for the partition
   mDevice.GetConfig()->SetProperty<int>("io-threads", (int) std::min(std::thread::hardware_concurrency(), 32u));
-  auto lTransportFactory = FairMQTransportFactory::CreateTransportFactory("zeromq", "", mDevice.GetConfig());
+  std::shared_ptr<FairMQTransportFactory> lTransportFactory;
+  if (mConfig->getBoolParam(DataDistFmqShmTransportKey, DataDistFmqShmTransportDefault)) {
+    // co-located StfSenders: STF data is received in shared memory and only the ownership is transferred
+    lTransportFactory = mDevice.AddTransport(fair::mq::Transport::SHM);
+    IDDLOG("TfBuilderInput: Using the FairMQ shared memory transport for StfSender channels.");
+  } else {
+    lTransportFactory = FairMQTransportFactory::CreateTransportFactory("zeromq", "", mDevice.GetConfig());
+  }
 
   // start the input stage
   if (mInputFairMQ) {
@@ -179,6 +186,7 @@ void TfBuilderInput::StfPacingThread()
       // deserialize here to be able to rename the stf
       lStfInfo.mStf = std::move(lStfReceiver.deserialize(*lStfInfo.mRecvStfHeaderMeta.get(), *lStfInfo.mRecvStfdata));
       lStfInfo.mRecvStfdata = nullptr;
+      lStfInfo.mStf->traceProcessStart(eStfTraceTfBuilderIn, StfTrace::toNs(lStfInfo.mTimeReceived));
 
       const std::uint64_t lNewTfId = mRpc->getIdForTopoTf(lStfInfo.mStfSenderId, lStfInfo.mStfId);
 
@@ -224,6 +232,7 @@ void TfBuilderInput::deserialize_headers(std::vector<ReceivedStfMeta> &pStfs)
     // deserialize the data
     lStfInfo.mStf = std::move(lStfReceiver.deserialize(*lStfInfo.mRecvStfHeaderMeta.get(), *lStfInfo.mRecvStfdata));
     lStfInfo.mRecvStfdata = nullptr;
+    lStfInfo.mStf->traceProcessStart(eStfTraceTfBuilderIn, StfTrace::toNs(lStfInfo.mTimeReceived));
   }
 }
 
@@ -308,6 +317,7 @@ void TfBuilderInput::StfMergerThread()
     for (auto lStfIter = std::next(lStfVector.begin()); lStfIter != lStfVector.end(); ++lStfIter) {
       lTf->mergeStf(std::move(lStfIter->mStf), lStfIter->mStfSenderId);
     }
+    lTf->traceStamp(eStfTraceTfBuilderMerged);
     lNumBuiltTfs++;
 
     const auto lTfId = lTf->id();
@@ -19,6 +19,7 @@
 
 #include <SubTimeFrameDataModel.h>
 #include <SubTimeFrameVisitors.h>
+#include <ProtobufPool.h>
 
 #include <DataDistMonitoring.h>
 
@@ -242,6 +243,9 @@ void TfBuilderInputFairMQ::DataHandlerThread(const std::uint32_t pFlpIndex, cons
   // Deserialization object (stf ID)
   IovDeserializer lStfReceiver(mTimeFrameBuilder);
 
+  // metadata messages of the thread
+  ProtobufArenaPool<IovStfHeader> lMetaPool(64 << 10);
+
   while (mState == RUNNING) {
 
     std::unique_ptr<std::vector<FairMQMessagePtr>> lStfData;
@@ -271,15 +275,20 @@ void TfBuilderInputFairMQ::DataHandlerThread(const std::uint32_t pFlpIndex, cons
     // get Stf ID
     FairMQMessagePtr lHdrMessage = std::move(lStfData->back()); lStfData->pop_back();
 
-    IovStfHeader lStfHeaderMeta;
-    lStfHeaderMeta.ParseFromArray(lHdrMessage->GetData(), lHdrMessage->GetSize());
-    auto lStfHdr = std::make_unique<IovStfHdrMeta>(lStfHeaderMeta.stf_hdr_meta());
+    // parse the header meta directly into the object forwarded to the deserializer (no copy)
+    auto &lStfHeaderMeta = lMetaPool.acquire();
+    auto lStfHdr = std::make_unique<IovStfHdrMeta>();
+    lStfHeaderMeta.unsafe_arena_set_allocated_stf_hdr_meta(lStfHdr.get());
+    proto_merge_from_array(lStfHeaderMeta, lHdrMessage->GetData(), lHdrMessage->GetSize());
+    lStfHeaderMeta.unsafe_arena_release_stf_hdr_meta();
 
     const SubTimeFrame::Header lStfHeader = lStfReceiver.peek_tf_header(*lStfHdr.get());
     const std::uint64_t lTfId = lStfHeader.mId;
 
     // move data to the dedicated region if required
-    lStfReceiver.copy_to_region(*lStfData);
+    if (!lStfReceiver.copy_to_region(*lStfData)) {
+      WDDLOG_RL(1000, "Data region allocation failed. Keeping STF data in receive buffers. stf_id={}", lTfId);
+    }
 
     // signal in flight STF is finished (or error)
     mRpc->recordStfReceived(pStfSenderId, lTfId);
@@ -19,11 +19,13 @@
 
 #include <SubTimeFrameDataModel.h>
 #include <SubTimeFrameVisitors.h>
+#include <ProtobufPool.h>
 
 #include <DataDistMonitoring.h>
 
 #include <UCXSendRecv.h>
 
+#include <algorithm>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
@@ -42,14 +44,22 @@ static void client_ep_err_cb(void *arg, ucp_ep_h, ucs_status_t status)
   }
 }
 
+static void rail_ep_err_cb(void *arg, ucp_ep_h, ucs_status_t status)
+{
+  dd_ucx_rail *lRail = reinterpret_cast<dd_ucx_rail*>(arg);
+  if (lRail) {
+    lRail->mInputUCX->handle_rail_ep_error(lRail, status);
+  }
+}
+
 static void listen_conn_handle_cb(ucp_conn_request_h conn_request, void *arg)
 {
   dd_ucp_listener_context_t *lCtx = reinterpret_cast<dd_ucp_listener_context_t*>(arg);
-  lCtx->mInputUcx->new_conn_handle(conn_request);
+  lCtx->mInputUcx->new_conn_handle(conn_request, lCtx->mRailIdx);
 }
 
 // callback on new connection
-void TfBuilderInputUCX::new_conn_handle(ucp_conn_request_h conn_request)
+void TfBuilderInputUCX::new_conn_handle(ucp_conn_request_h conn_request, const unsigned pRailIdx)
 {
   ucp_conn_request_attr_t attr;
 
@@ -63,7 +73,7 @@ void TfBuilderInputUCX::new_conn_handle(ucp_conn_request_h conn_request)
   const auto lStfSenderAddr = ucx::util::sockaddr_to_string(&attr.client_address);
   const auto lStfSenderPort = ucx::util::sockaddr_to_port(&attr.client_address);
 
-  DDDLOG("Received a connection request! addr={} port={}", lStfSenderAddr, lStfSenderPort);
+  DDDLOG("Received a connection request! addr={} port={} rail={}", lStfSenderAddr, lStfSenderPort, pRailIdx);
 
   if (mState.load() != CONFIGURING) {
     EDDLOG("Received a connection request but not in CONFIGURING state. state={}", mState.load());
@@ -71,7 +81,7 @@ void TfBuilderInputUCX::new_conn_handle(ucp_conn_request_h conn_request)
   }
 
   // forward to Listener thread
-  mConnRequestQueue.push(lStfSenderAddr, lStfSenderPort, conn_request);
+  mConnRequestQueue.push(lStfSenderAddr, lStfSenderPort, conn_request, pRailIdx);
 }
 
 
@@ -91,9 +101,17 @@ void TfBuilderInputUCX::ListenerThread()
     // we have a connection request
     const auto lStfSenderAddr = std::get<0>(lConnInfoOpt.value());
     ucp_conn_request_h conn_request = std::get<2>(lConnInfoOpt.value());
+    const auto lRailIdx = std::get<3>(lConnInfoOpt.value());
+
+    // endpoints of additional rails join an existing connection
+    if (lRailIdx > 0) {
+      acceptRail(lRailIdx, conn_request, lStfSenderAddr);
+      continue;
+    }
 
     // Create stfsender (data) worker + endpoint
     auto lConnStruct = std::make_unique<dd_ucx_conn_info>(this);
+    lConnStruct->mRmaWindow.configure(mConnRmaWindowConfig);
 
     if (!ucx::util::create_ucp_worker(ucp_context, &lConnStruct->worker, lStfSenderAddr)) {
       continue;
@@ -103,6 +121,10 @@ void TfBuilderInputUCX::ListenerThread()
       client_ep_err_cb, lConnStruct.get(), lStfSenderAddr)) {
       continue;
     }
+    // receive handler of the control channel
+    if (!ucx::io::am_register_handler(lConnStruct->worker, lConnStruct->mAmQueue)) {
+      continue;
+    }
 
     // receive the StfSenderId
     auto lStfSenderIdOpt = ucx::io::ucx_receive_string(lConnStruct->worker);
@@ -117,6 +139,32 @@ void TfBuilderInputUCX::ListenerThread()
     DDDLOG("UCXListenerThread::Connection request. stf_sender_id={}", lStfSenderId);
     lConnStruct->mStfSenderId = lStfSenderId;
 
+    // receive the region registry
+    auto lRegistryOpt = ucx::io::ucx_receive_string(lConnStruct->worker);
+    UCXIovStfHeader lRegistry;
+
+    if (!lRegistryOpt || !lRegistry.ParseFromString(lRegistryOpt.value()) || !updateRemoteKeys(*lConnStruct, lRegistry)) {
+      EDDLOG("ListenerThread: Connection request: Failed to receive the region registry. stf_sender_id={}", lStfSenderId);
+      continue;
+    }
+    DDDLOG("UCXListenerThread::Region registry received. stf_sender_id={} num_regions={}",
+      lStfSenderId, lConnStruct->mRemoteKeys.size());
+
+    // control channel type
+    auto lControlOpt = ucx::io::ucx_receive_string(lConnStruct->worker);
+    if (!lControlOpt || (lControlOpt.value() != "am" && lControlOpt.value() != "tag")) {
+      EDDLOG("ListenerThread: Connection request: Failed to receive the control channel type. stf_sender_id={}", lStfSenderId);
+      continue;
+    }
+    lConnStruct->mAmControl = (lControlOpt.value() == "am");
+    DDDLOG("UCXListenerThread::Control channel selected. stf_sender_id={} control={}", lStfSenderId, lControlOpt.value());
+
+    // handshake is done: the worker is progressed by the progress engine from now on
+    if (mProgressEngine.running() && !mProgressEngine.add(lConnStruct->worker)) {
+      EDDLOG("ListenerThread: Connection request: Failed to add the worker to the progress engine. stf_sender_id={}", lStfSenderId);
+      continue;
+    }
+
     // add the connection info map
     std::scoped_lock lLock(mConnectionMapLock);
     assert (mConnMap.count(lStfSenderId) == 0);
@@ -126,14 +174,225 @@ void TfBuilderInputUCX::ListenerThread()
   IDDLOG("TfBuilderInputUCX:stop: Listener thread stopped.");
 }
 
+void TfBuilderInputUCX::acceptRail(const unsigned pRailIdx, ucp_conn_request_h pConnRequest, const std::string &pStfSenderAddr)
+{
+  auto lRail = std::make_unique<dd_ucx_rail>(this, pRailIdx);
+
+  // the request must be rejected when the endpoint is not created
+  if (!ucx::util::create_ucp_worker(ucp_context, &lRail->worker, pStfSenderAddr)) {
+    ucp_listener_reject(mRailListeners[pRailIdx - 1], pConnRequest);
+    return;
+  }
+  if (!ucx::util::create_ucp_ep(lRail->worker.ucp_worker, pConnRequest, &lRail->ucp_ep,
+    rail_ep_err_cb, lRail.get(), pStfSenderAddr)) {
+    ucp_listener_reject(mRailListeners[pRailIdx - 1], pConnRequest);
+    ucp_worker_destroy(lRail->worker.ucp_worker);
+    return;
+  }
+
+  // the StfSender id selects the connection of the rail
+  auto lStfSenderIdOpt = ucx::io::ucx_receive_string(lRail->worker);
+  if (!lStfSenderIdOpt) {
+    EDDLOG("ListenerThread: Rail connection request: Failed to receive StfSenderId. rail={} addr={}", pRailIdx, pStfSenderAddr);
+    ucx::util::close_connection(lRail->worker, lRail->ucp_ep);
+    return;
+  }
+  const auto &lStfSenderId = lStfSenderIdOpt.value();
+
+  std::scoped_lock lLock(mConnectionMapLock);
+  auto lConnIt = mConnMap.find(lStfSenderId);
+  if (lConnIt == mConnMap.end()) {
+    EDDLOG("ListenerThread: Rail connection request of an unknown StfSender. stf_sender_id={} rail={}", lStfSenderId, pRailIdx);
+    ucx::util::close_connection(lRail->worker, lRail->ucp_ep);
+    return;
+  }
+  auto &lConn = *lConnIt->second;
+
+  std::scoped_lock lIoLock(lConn.mStfSenderIoLock);
+  if (!unpackRemoteKeys(lRail->ucp_ep, lConn.mPackedRemoteKeys, lRail->mRemoteKeys, lStfSenderId) ||
+      !mProgressEngine.add(lRail->worker)) {
+    EDDLOG("ListenerThread: Failed to attach the rail. stf_sender_id={} rail={}", lStfSenderId, pRailIdx);
+    for (auto lRKey : lRail->mRemoteKeys) {
+      if (lRKey) {
+        ucp_rkey_destroy(lRKey);
+      }
+    }
+    ucx::util::close_connection(lRail->worker, lRail->ucp_ep);
+    return;
+  }
+
+  lRail->mConn = &lConn;
+  lConn.mRails.push_back(std::move(lRail));
+
+  IDDLOG("StfSender rail connected. stf_sender_id={} rail={} local_ip={} stf_sender_addr={} num_rails={}",
+    lStfSenderId, pRailIdx, mRailIps[pRailIdx], pStfSenderAddr, lConn.mRails.size() + 1);
+}
+
+void TfBuilderInputUCX::detachFailedRails(dd_ucx_conn_info &pConn)
+{
+  auto lFailedIt = std::stable_partition(pConn.mRails.begin(), pConn.mRails.end(),
+    [](const auto &pRail) { return !pRail->mRailError.load(); });
+
+  for (auto lRailIt = lFailedIt; lRailIt != pConn.mRails.end(); ++lRailIt) {
+    auto &lRail = **lRailIt;
+    mProgressEngine.remove(lRail.worker);
+    for (auto lRKey : lRail.mRemoteKeys) {
+      if (lRKey) {
+        ucp_rkey_destroy(lRKey);
+      }
+    }
+    ucx::util::close_connection(lRail.worker, lRail.ucp_ep);
+
+    WDDLOG("StfSender rail closed. stf_sender_id={} rail={} num_rails={}", pConn.mStfSenderId, lRail.mRailIdx,
+      (lFailedIt - pConn.mRails.begin()) + 1);
+  }
+  pConn.mRails.erase(lFailedIt, pConn.mRails.end());
+}
+
+bool TfBuilderInputUCX::updateRemoteKeys(dd_ucx_conn_info &pConn, const UCXIovStfHeader &pMeta)
+{
+  for (const auto &lRegion : pMeta.data_regions()) {
+    if (lRegion.region() >= pConn.mPackedRemoteKeys.size()) {
+      pConn.mPackedRemoteKeys.resize(lRegion.region() + 1);
+    }
+
+    auto &lPackedKey = pConn.mPackedRemoteKeys[lRegion.region()];
+    if (lPackedKey.empty()) {
+      DDDLOG("Mapping the new region. stf_sender_id={} region={} size={}", pConn.mStfSenderId, lRegion.region(), lRegion.size());
+      lPackedKey = lRegion.region_rkey();
+    }
+  }
+
+  // rkeys are unpacked for each endpoint
+  bool lRet = unpackRemoteKeys(pConn.ucp_ep, pConn.mPackedRemoteKeys, pConn.mRemoteKeys, pConn.mStfSenderId);
+  for (auto &lRail : pConn.mRails) {
+    lRet = unpackRemoteKeys(lRail->ucp_ep, pConn.mPackedRemoteKeys, lRail->mRemoteKeys, pConn.mStfSenderId) && lRet;
+  }
+  return lRet;
+}
+
+bool TfBuilderInputUCX::unpackRemoteKeys(ucp_ep_h pEp, const std::vector<std::string> &pPackedKeys,
+                                         std::vector<ucp_rkey_h> &pRemoteKeys, const std::string &pStfSenderId)
+{
+  if (pRemoteKeys.size() < pPackedKeys.size()) {
+    pRemoteKeys.resize(pPackedKeys.size(), nullptr);
+  }
+
+  for (std::size_t lRegion = 0; lRegion < pPackedKeys.size(); lRegion++) {
+    auto &lRKey = pRemoteKeys[lRegion];
+    if (lRKey || pPackedKeys[lRegion].empty()) {
+      continue; // already unpacked
+    }
+
+    const auto lStatus = ucp_ep_rkey_unpack(pEp, pPackedKeys[lRegion].data(), &lRKey);
+    if (lStatus != UCS_OK) {
+      EDDLOG("Failed to unpack the region rkey. stf_sender_id={} region={} err={}",
+        pStfSenderId, lRegion, ucs_status_string(lStatus));
+      lRKey = nullptr;
+      return false;
+    }
+  }
+  return true;
+}
+
+void TfBuilderInputUCX::reportRailStats()
+{
+  static thread_local std::vector<double> sRatesMiBs;
+  if (!mRailStats.report(std::chrono::seconds(1), sRatesMiBs)) {
+    return;
+  }
+
+  std::string lRatesStr;
+  for (std::size_t lRail = 0; lRail < sRatesMiBs.size(); lRail++) {
+    DDMON("tfbuilder", fmt::format("recv.rail{}.rate_mibs", lRail), sRatesMiBs[lRail]);
+    lRatesStr += fmt::format(" {}:{:.1f}", mRailStats.name(lRail), sRatesMiBs[lRail]);
+  }
+  DDDLOG_GRL(10000, "Rail bandwidth (MiB/s).{}", lRatesStr);
+}
+
+void TfBuilderInputUCX::updateRmaWindows(dd_ucx_conn_info &pConn, ucx::io::dd_ucp_multi_req &pReq, const double pElapsedUs)
+{
+  ucx::UCXRmaWindow::Sample lSample;
+  {
+    std::scoped_lock lLock(pReq.mRequestLock);
+    if (pReq.mLatencyOps == 0) {
+      return; // all operations completed immediately
+    }
+    lSample.mBytes = pReq.mBytesDone;
+    lSample.mOps = pReq.mLatencyOps;
+    lSample.mElapsedUs = pElapsedUs;
+    lSample.mMeanLatencyUs = pReq.mLatencySumUs / double(pReq.mLatencyOps);
+    lSample.mMinLatencyUs = pReq.mLatencyMinUs;
+  }
+
+  const bool lCongested = pConn.mRmaWindow.update(lSample);
+  mNodeRmaWindow.update(lSample);
+  mNodeRmaBudget.mLimit = mNodeRmaWindow.window();
+
+  DDMON("tfbuilder", "recv.rma_op_latency_us", lSample.mMeanLatencyUs);
+  DDMON("tfbuilder", "recv.rma_conn_window_mb", double(pConn.mRmaWindow.window()) / double(1ULL << 20));
+  DDMON("tfbuilder", "recv.rma_node_window_mb", double(mNodeRmaWindow.window()) / double(1ULL << 20));
+
+  DDDLOG_GRL(5000, "RMA window update. stf_sender_id={} congested={} latency_us={:.1f} base_latency_us={:.1f} "
+    "conn_window={} node_window={} node_in_flight={}", pConn.mStfSenderId, lCongested, lSample.mMeanLatencyUs,
+    pConn.mRmaWindow.baseLatencyUs(), pConn.mRmaWindow.window(), mNodeRmaWindow.window(), mNodeRmaBudget.mBytes.load());
+}
+
 bool TfBuilderInputUCX::start()
 {
   // setting configuration options
   mThreadPoolSize = std::clamp(mConfig->getUInt64Param(UcxTfBuilderThreadPoolSizeKey, UcxTfBuilderThreadPoolSizeDefault), std::size_t(0), std::size_t(256));
   mThreadPoolSize = std::max(std::size_t(16), (mThreadPoolSize == 0) ? std::thread::hardware_concurrency() : mThreadPoolSize);
   mNumRmaOps = std::clamp(mConfig->getUInt64Param(UcxNumConcurrentRmaGetOpsKey, UcxNumConcurrentRmaGetOpsDefault), std::size_t(1), std::size_t(64));
+  auto lProgressThreads = std::clamp(mConfig->getUInt64Param(UcxTfBuilderProgressThreadsKey, UcxTfBuilderProgressThreadsDefault), std::size_t(0), std::size_t(16));
+  const auto lBusyPollUs = std::clamp(mConfig->getUInt64Param(UcxTfBuilderProgressBusyPollUsKey, UcxTfBuilderProgressBusyPollUsDefault), std::size_t(0), std::size_t(1000000));
+
+  // multi-rail: rail 0 is the ip of the TfBuilder (listen_ep), additional rails on other local interfaces
+  {
+    mRailIps = { mConfig->status().info().ip_address() };
+    for (const auto &lIp : ucx::parse_rail_ips(mConfig->getStringParam(UcxTfBuilderRailIpsKey, UcxTfBuilderRailIpsDefault))) {
+      if (lIp != mRailIps[0]) {
+        mRailIps.push_back(lIp);
+      }
+    }
+    mRailStripeSize = std::clamp(mConfig->getUInt64Param(UcxRailStripeSizeKBKey, UcxRailStripeSizeKBDefault), std::size_t(64), std::size_t(1 << 20)) << 10;
+    mRailStats.configure(mRailIps);
 
-  IDDLOG("TfBuilderInputUCX: Configuration loaded. thread_pool={} num_rma_ops={}", mThreadPoolSize, mNumRmaOps);
+    // workers of rails are only progressed by the progress engine
+    if (mRailIps.size() > 1 && lProgressThreads == 0) {
+      lProgressThreads = mRailIps.size();
+      WDDLOG("TfBuilderInputUCX: Multi-rail requires UCX progress threads. progress_threads={}", lProgressThreads);
+    }
+    IDDLOG("TfBuilderInputUCX: Rails configured. num_rails={} stripe_size={}", mRailIps.size(), mRailStripeSize);
+  }
+
+  IDDLOG("TfBuilderInputUCX: Configuration loaded. thread_pool={} num_rma_ops={} progress_threads={} busy_poll_us={}",
+    mThreadPoolSize, mNumRmaOps, lProgressThreads, lBusyPollUs);
+
+  // adaptive RMA concurrency
+  {
+    const auto lConnMaxMB = std::clamp(mConfig->getUInt64Param(UcxRmaConnWindowMaxMBKey, UcxRmaConnWindowMaxMBDefault), std::size_t(0), std::size_t(4096));
+    const auto lNodeMaxMB = std::clamp(mConfig->getUInt64Param(UcxRmaNodeWindowMaxMBKey, UcxRmaNodeWindowMaxMBDefault), std::size_t(1), std::size_t(65536));
+    const auto lTolerancePct = std::clamp(mConfig->getUInt64Param(UcxRmaLatencyTolerancePctKey, UcxRmaLatencyTolerancePctDefault), std::size_t(0), std::size_t(1000));
+
+    mRmaWindowEnabled = (lConnMaxMB > 0);
+    if (mRmaWindowEnabled) {
+      // the window limits the bytes in flight, UcxNumConcurrentRmaGetOps remains the limit of operations
+      mConnRmaWindowConfig.mMaxBytes = lConnMaxMB << 20;
+      mConnRmaWindowConfig.mLatencyTolerance = double(lTolerancePct) / 100.0;
+
+      ucx::UCXRmaWindow::Config lNodeConfig;
+      lNodeConfig.mMinBytes = (8ULL << 20);
+      lNodeConfig.mMaxBytes = lNodeMaxMB << 20;
+      lNodeConfig.mInitBytes = (64ULL << 20);
+      lNodeConfig.mIncreaseBytes = (1ULL << 20);
+      lNodeConfig.mLatencyTolerance = mConnRmaWindowConfig.mLatencyTolerance;
+      mNodeRmaWindow.configure(lNodeConfig);
+      mNodeRmaBudget.mLimit = mNodeRmaWindow.window();
+    }
+    IDDLOG("TfBuilderInputUCX: Adaptive RMA window. enabled={} conn_max_mb={} node_max_mb={} latency_tolerance_pct={}",
+      mRmaWindowEnabled, lConnMaxMB, lNodeMaxMB, lTolerancePct);
+  }
 
   auto &lConfStatus = mConfig->status();
 
@@ -145,6 +404,12 @@ bool TfBuilderInputUCX::start()
     return false;
   }
 
+  // shared progress threads for StfSender connections
+  if (lProgressThreads > 0 && !mProgressEngine.start(lProgressThreads, lBusyPollUs, "tfb_ucx")) {
+    EDDLOG("TfBuilderInputUCX::start: Failed to start the UCX progress engine.");
+    return false;
+  }
+
   // map the receive buffer for ucx rma
   {
     const auto lOrigAddress = mTimeFrameBuilder.mMemRes.mDataMemRes->address();
@@ -185,6 +450,22 @@ bool TfBuilderInputUCX::start()
     return false;
   }
 
+  // listeners of additional rails
+  for (unsigned lRailIdx = 1; lRailIdx < mRailIps.size(); lRailIdx++) {
+    auto lRailCtx = std::make_unique<dd_ucp_listener_context_t>();
+    lRailCtx->mInputUcx = this;
+    lRailCtx->mRailIdx = lRailIdx;
+
+    ucp_listener_h lRailListener;
+    if (!ucx::util::create_ucp_listener(listener_worker.ucp_worker, mRailIps[lRailIdx], &lRailListener,
+      listen_conn_handle_cb, lRailCtx.get())) {
+      EDDLOG("TfBuilderInputUCX::start: Failed to create the rail listener. rail={} ip={}", lRailIdx, mRailIps[lRailIdx]);
+      return false;
+    }
+    mRailListeners.push_back(lRailListener);
+    mRailListenContexts.push_back(std::move(lRailCtx));
+  }
+
   // Start the Listener thread
   mListenerThread = create_thread_member("ucx_listener", &TfBuilderInputUCX::ListenerThread, this);
 
@@ -203,6 +484,20 @@ bool TfBuilderInputUCX::start()
 
     lConfStatus.mutable_ucx_info()->mutable_listen_ep()->set_ip(lConfStatus.info().ip_address());
     lConfStatus.mutable_ucx_info()->mutable_listen_ep()->set_port(lListenPort);
+
+    // rail listeners
+    lConfStatus.mutable_ucx_info()->clear_rail_eps();
+    for (std::size_t lRail = 0; lRail < mRailListeners.size(); lRail++) {
+      attr.field_mask = UCP_LISTENER_ATTR_FIELD_SOCKADDR;
+      if (ucp_listener_query(mRailListeners[lRail], &attr) != UCS_OK) {
+        EDDLOG("Failed to query the UCX rail listener. ip={}", mRailIps[lRail + 1]);
+        return false;
+      }
+      auto lRailEp = lConfStatus.mutable_ucx_info()->add_rail_eps();
+      lRailEp->set_ip(mRailIps[lRail + 1]);
+      lRailEp->set_port(ucx::util::sockaddr_to_port(&attr.sockaddr));
+      IDDLOG("TfBuilder UCX rail listener rail={} ip={} port={}", lRail + 1, lRailEp->ip(), lRailEp->port());
+    }
     lConfStatus.mutable_ucx_info()->set_enabled(true);
 
     if (mConfig->write()) {
@@ -315,17 +610,53 @@ void TfBuilderInputUCX::stop()
 
     for (auto & lConn : mConnMap) {
       std::scoped_lock lIoLock(lConn.second->mStfSenderIoLock);
-      for (auto & lRKeyIt : lConn.second->mRemoteKeys) {
-        ucp_rkey_destroy(lRKeyIt.second);
+
+      for (auto &lRail : lConn.second->mRails) {
+        mProgressEngine.remove(lRail->worker);
+        for (auto lRKey : lRail->mRemoteKeys) {
+          if (lRKey) {
+            ucp_rkey_destroy(lRKey);
+          }
+        }
+        ucx::util::close_connection(lRail->worker, lRail->ucp_ep);
+      }
+      lConn.second->mRails.clear();
+
+      mProgressEngine.remove(lConn.second->worker);
+      for (auto lRKey : lConn.second->mRemoteKeys) {
+        if (lRKey) {
+          ucp_rkey_destroy(lRKey);
+        }
       }
       ucx::util::close_connection(lConn.second->worker, lConn.second->ucp_ep);
     }
     mConnMap.clear();
   }
+  mProgressEngine.stop();
 
   DDDLOG("TfBuilderInputUCX::stop: All input channels are closed.");
 }
 
+/// Notify StfSender the STF transfer is finished. Caller must hold mStfSenderIoLock
+bool TfBuilderInputUCX::sendStfDone(dd_ucx_conn_info &pConn, const std::uint64_t pTfId, const bool pOk)
+{
+  bool lDoneSent;
+  if (pConn.mAmControl) {
+    ucx::io::dd_am_hdr lDoneHdr;
+    lDoneHdr.mType = ucx::io::DD_AM_STF_DONE;
+    lDoneHdr.mStfId = pTfId;
+    lDoneHdr.mStatus = pOk ? 0 : 1;
+    lDoneSent = ucx::io::am_send_blocking(pConn.worker, pConn.ucp_ep, lDoneHdr);
+  } else {
+    std::string lOkStr = pOk ? "OK" : "ERROR";
+    lDoneSent = ucx::io::ucx_send_string(pConn.worker, pConn.ucp_ep, lOkStr);
+  }
+  if (!lDoneSent) {
+    EDDLOG_GRL(10000, "StfSender was NOT notified about transfer finish stf_sender={} tf_id={}", pConn.mStfSenderId, pTfId);
+  }
+  return lDoneSent;
+}
+
 /// Receiving thread
 void TfBuilderInputUCX::DataHandlerThread(const unsigned pThreadIdx)
 {
@@ -341,6 +672,19 @@ void TfBuilderInputUCX::DataHandlerThread(const unsigned pThreadIdx)
   std::vector<void*> lTxgPtrs;
   std::vector<std::pair<void*, std::size_t>> lDataMsgsBuffers;
 
+  // metadata messages of the thread
+  ProtobufArenaPool<UCXIovStfHeader> lMetaPool;
+
+  // rails of the connection (rail 0 is the control endpoint), and striping of txgs across the rails
+  struct RailRef {
+    ucp_ep_h mEp;
+    ucx::dd_ucp_worker *mWorker;
+    const std::vector<ucp_rkey_h> *mRemoteKeys;
+    unsigned mRailIdx;
+  };
+  std::vector<RailRef> lRails;
+  ucx::UCXRailStriper lStriper(mRailStripeSize);
+
   while ((lStfSenderIdOpt = mStfReqQueue.pop()) != std::nullopt) {
     using clock = std::chrono::steady_clock;
 
@@ -356,12 +700,21 @@ void TfBuilderInputUCX::DataHandlerThread(const unsigned pThreadIdx)
         if (lConn && lConn->mConnError) {
           continue; // we are stoping anyway
         }
+
+        // close failed rails, the transfer continues on the remaining rails
+        if (std::any_of(lConn->mRails.cbegin(), lConn->mRails.cend(), [](const auto &pRail) { return pRail->mRailError.load(); })) {
+          std::scoped_lock lIoLock(lConn->mStfSenderIoLock);
+          detachFailedRails(*lConn);
+        }
       } else {
         continue;
       }
     }
 
-    UCXIovStfHeader lMeta;
+    // iov entries are parsed into the arena, the header meta into a heap object forwarded to the deserializer
+    auto &lMeta = lMetaPool.acquire();
+    auto lStfHdr = std::make_unique<IovStfHdrMeta>();
+    lMeta.unsafe_arena_set_allocated_stf_hdr_meta(lStfHdr.get());
     lTxgPtrs.clear();
 
     clock::time_point lMetaDecodeStart;
@@ -371,34 +724,84 @@ void TfBuilderInputUCX::DataHandlerThread(const unsigned pThreadIdx)
       auto lStartLoop = clock::now();
 
       // Receive STF iov and metadata
-      const auto lStfMetaDataOtp = ucx::io::ucx_receive_string(lConn->worker);
+      if (lConn->mAmControl) {
+        const auto lMetaMsg = ucx::io::am_receive_blocking(lConn->worker, lConn->mAmQueue);
+        if (!lMetaMsg || lMetaMsg->mHdr.mType != ucx::io::DD_AM_STF_META || lMetaMsg->mHdr.mStatus != 0) {
+          EDDLOG("DataHandlerThread {}: Failed to receive stf meta structure.", lStfSenderId);
+          if (lMetaMsg) {
+            lConn->mAmQueue.pop();
+          }
+          lMeta.unsafe_arena_release_stf_hdr_meta();
+          continue;
+        }
 
-      if (!lStfMetaDataOtp.has_value()) {
-        EDDLOG("DataHandlerThread {}: Failed to receive stf meta structure.", lStfSenderId);
-        continue;
-      }
+        DDMON("tfbuilder", "recv.receive_meta_ms", since<std::chrono::milliseconds>(lStartLoop));
+        lMetaDecodeStart = clock::now();
 
-      DDMON("tfbuilder", "recv.receive_meta_ms", since<std::chrono::milliseconds>(lStartLoop));
-      lMetaDecodeStart = clock::now();
+        // parse from the preallocated receive buffer
+        const bool lParsed = proto_merge_from_array(lMeta, lMetaMsg->data(), lMetaMsg->size());
+        lConn->mAmQueue.pop();
 
-      const auto &lStfMetaData = lStfMetaDataOtp.value();
+        if (!lParsed) {
+          EDDLOG_GRL(1000, "DataHandlerThread {}: Failed to parse stf meta structure. size={}", lStfSenderId, lMetaMsg->size());
+          lMeta.unsafe_arena_release_stf_hdr_meta();
+          continue;
+        }
+      } else {
+        const auto lStfMetaDataOtp = ucx::io::ucx_receive_string(lConn->worker);
+
+        if (!lStfMetaDataOtp.has_value()) {
+          EDDLOG("DataHandlerThread {}: Failed to receive stf meta structure.", lStfSenderId);
+          lMeta.unsafe_arena_release_stf_hdr_meta();
+          continue;
+        }
 
-      lMeta.ParseFromString(lStfMetaData);
+        DDMON("tfbuilder", "recv.receive_meta_ms", since<std::chrono::milliseconds>(lStartLoop));
+        lMetaDecodeStart = clock::now();
+
+        if (!proto_merge_from_array(lMeta, lStfMetaDataOtp->data(), lStfMetaDataOtp->size())) {
+          EDDLOG_GRL(1000, "DataHandlerThread {}: Failed to parse stf meta structure. size={}", lStfSenderId,
+            lStfMetaDataOtp->size());
+          lMeta.unsafe_arena_release_stf_hdr_meta();
+          continue;
+        }
+      }
 
       lTfId = lMeta.stf_hdr_meta().stf_id();
 
       IDDLOG_GRL(1000, "Received StfMeta stf_id={} data_parts={}", lTfId, lMeta.stf_data_iov_size());
 
-      // make sure we have remote keys unpacked
-      for (const auto &lRegion : lMeta.data_regions() ) {
-        if (lConn->mRemoteKeys.count(lRegion.region_rkey()) == 0) {
-          DDDLOG("Mapping the new region size={}", lRegion.size());
-          auto lNewRkeyIter = lConn->mRemoteKeys.emplace(lRegion.region_rkey(), ucp_rkey_h());
-          ucp_ep_rkey_unpack(lConn->ucp_ep, lRegion.region_rkey().data(), &(lNewRkeyIter.first->second));
+      // regions registered after the connection was made
+      bool lRegionsOk = true;
+      if (lMeta.data_regions_size() > 0 && !updateRemoteKeys(*lConn, lMeta)) {
+        EDDLOG_GRL(1000, "DataHandlerThread: Failed to update the region keys. stf_sender_id={} stf_id={}",
+          lStfSenderId, lTfId);
+        lRegionsOk = false;
+      }
+
+      // all txgs must be in a known region, before any data is allocated
+      for (const auto &lStfTxg : lMeta.stf_txg_iov()) {
+        if (!lRegionsOk) {
+          break;
+        }
+        const auto lRegion = lStfTxg.region();
+        if (lRegion >= lConn->mRemoteKeys.size() || !lConn->mRemoteKeys[lRegion]) {
+          EDDLOG_GRL(1000, "DataHandlerThread: Unknown region in STF metadata. stf_sender_id={} region={} stf_id={}",
+            lStfSenderId, lRegion, lTfId);
+          lRegionsOk = false;
         }
       }
 
       DDMON("tfbuilder", "recv.meta_decode_ms", since<std::chrono::milliseconds>(lMetaDecodeStart));
+
+      // drop the STF: notify StfSender of the failed transfer
+      if (!lRegionsOk) {
+        sendStfDone(*lConn, lTfId, false);
+        lMeta.unsafe_arena_release_stf_hdr_meta();
+        mRpc->recordStfReceived(lStfSenderId, lTfId);
+        continue;
+      }
+
       auto lAllocStart = clock::now();
 
       // Allocate data memory
@@ -420,29 +823,84 @@ void TfBuilderInputUCX::DataHandlerThread(const unsigned pThreadIdx)
       // RMA get all the txgs
       auto lRmaGetStart = clock::now();
       ucx::io::dd_ucp_multi_req lRmaReqSem(mNumRmaOps);
+      if (mRmaWindowEnabled) {
+        lRmaReqSem.set_window(lConn->mRmaWindow.window(), &mNodeRmaBudget);
+      }
 
-      for (auto &lStfTxg : lMeta.stf_txg_iov()) {
-        auto lTxgUcxPtr = mTimeFrameBuilder.mMemRes.mDataMemRes->get_ucx_ptr(lTxgPtrs[lStfTxg.txg()]);
-        ucx::io::get(lConn->ucp_ep, lTxgUcxPtr, lStfTxg.len(), lStfTxg.start(), lConn->mRemoteKeys[lMeta.data_regions(lStfTxg.region()).region_rkey()], &lRmaReqSem);
+      lRails.clear();
+      lRails.push_back(RailRef{ lConn->ucp_ep, &lConn->worker, &lConn->mRemoteKeys, 0 });
+      for (const auto &lRail : lConn->mRails) {
+        if (!lRail->mRailError) {
+          lRails.push_back(RailRef{ lRail->ucp_ep, &lRail->worker, &lRail->mRemoteKeys, lRail->mRailIdx });
+        }
+      }
+      lStriper.reset(lRails.size());
 
-        if (!ucx::io::ucp_wait(lConn->worker, lRmaReqSem)) {
+      for (auto &lStfTxg : lMeta.stf_txg_iov()) {
+        const auto lRegion = lStfTxg.region();
+        auto lTxgUcxPtr = static_cast<char*>(mTimeFrameBuilder.mMemRes.mDataMemRes->get_ucx_ptr(lTxgPtrs[lStfTxg.txg()]));
+
+        // stripe the txg across the rails with the region mapped
+        const auto lRegionMapped = [&](const std::size_t pRail) {
+          const auto &lKeys = *lRails[pRail].mRemoteKeys;
+          return (lRegion < lKeys.size()) && lKeys[lRegion];
+        };
+
+        const bool lRmaOk = lStriper.stripe(lStfTxg.len(), lRegionMapped, [&](const std::size_t pRail, const std::uint64_t pOff, const std::uint64_t pLen) {
+          const RailRef &lRail = lRails[pRail];
+          ucx::io::get(lRail.mEp, lTxgUcxPtr + pOff, pLen, lStfTxg.start() + pOff, (*lRail.mRemoteKeys)[lRegion], &lRmaReqSem);
+          return ucx::io::ucp_wait(*lRail.mWorker, lRmaReqSem);
+        });
+
+        if (!lRmaOk) {
           EDDLOG("Error from ucp_wait");
           break;
         }
       }
-      // wait for final completion
+      // wait for final completion (workers of all rails are progressed by the progress engine)
       lRmaReqSem.mark_finished();
-      if (!ucx::io::ucp_wait(lConn->worker, lRmaReqSem)) {
+      for (std::size_t lRail = 1; lRail < lRails.size(); lRail++) {
+        mProgressEngine.kick(*lRails[lRail].mWorker);
+      }
+      const bool lRmaDone = ucx::io::ucp_wait(lConn->worker, lRmaReqSem);
+      if (!lRmaReqSem.done()) {
         EDDLOG("Error from ucp_wait");
+        lMeta.unsafe_arena_release_stf_hdr_meta();
         break;
       }
 
-      // notify StfSender we completed
-      std::string lOkStr = "OK";
-      if (!ucx::io::ucx_send_string(lConn->worker, lConn->ucp_ep, lOkStr) ) {
-        EDDLOG_GRL(10000, "StfSender was NOT notified about transfer finish stf_sender={} tf_id={}", lStfSenderId, lTfId);
+      // failed gets (e.g. on a failed rail): drop the STF, the buffers are released with the messages
+      if (!lRmaDone) {
+        EDDLOG_GRL(1000, "DataHandlerThread: RMA transfer failed. stf_sender_id={} stf_id={}", lStfSenderId, lTfId);
+        sendStfDone(*lConn, lTfId, false);
+
+        lDataMsgsBuffers.clear();
+        for (std::size_t lTxg = 0; lTxg < lTxgPtrs.size(); lTxg++) {
+          lDataMsgsBuffers.emplace_back(lTxgPtrs[lTxg], lTxgSizes[lTxg]);
+        }
+        std::vector<FairMQMessagePtr> lDropMsgs;
+        mTimeFrameBuilder.newDataFmqMessagesFromPtr(lDataMsgsBuffers, lDropMsgs);
+
+        lMeta.unsafe_arena_release_stf_hdr_meta();
+        mRpc->recordStfReceived(lStfSenderId, lTfId);
+        continue;
+      }
+
+      if (mRmaWindowEnabled) {
+        updateRmaWindows(*lConn, lRmaReqSem, since<std::chrono::microseconds>(lRmaGetStart));
       }
 
+      // bandwidth of rails
+      for (std::size_t lRail = 0; lRail < lRails.size(); lRail++) {
+        mRailStats.add(lRails[lRail].mRailIdx, lStriper.railBytes()[lRail]);
+      }
+      reportRailStats();
+
+      // notify StfSender we completed
+      const auto lDoneStart = clock::now();
+      sendStfDone(*lConn, lTfId, true);
+      DDMON("tfbuilder", "recv.done_send_us", since<std::chrono::microseconds>(lDoneStart));
+
       DDMON("tfbuilder", "recv.rma_get_total_ms", since<std::chrono::milliseconds>(lRmaGetStart));
     }
 
@@ -474,8 +932,8 @@ void TfBuilderInputUCX::DataHandlerThread(const unsigned pThreadIdx)
     // make data messages
     mTimeFrameBuilder.newDataFmqMessagesFromPtr(lDataMsgsBuffers, *lDataVec.get());
 
-    // copy header meta
-    auto lStfHdr = std::make_unique<IovStfHdrMeta>(std::move(lMeta.stf_hdr_meta()));
+    // header meta was parsed into lStfHdr
+    lMeta.unsafe_arena_release_stf_hdr_meta();
 
     DDMON("tfbuilder", "recv.fmq_msg_ms", since<std::chrono::milliseconds>(lFmqPrepareStart));
     DDMON("tfbuilder", "recv.total_ms", since<std::chrono::milliseconds>(lMetaDecodeStart));
@@ -23,6 +23,10 @@
 #include <ConcurrentQueue.h>
 
 #include <UCXUtilities.h>
+#include <UCXSendRecv.h>
+#include <UCXProgressEngine.h>
+#include <UCXRmaWindow.h>
+#include <UCXRails.h>
 #include <ucp/api/ucp.h>
 
 #include <vector>
@@ -40,6 +44,33 @@ class TfBuilderRpcImpl;
 struct dd_ucp_listener_context_t {
   /// Self reference to handle new connections
   TfBuilderInputUCX *mInputUcx;
+  /// Rail of the listener (0: the listener announced as listen_ep)
+  unsigned mRailIdx = 0;
+};
+
+struct dd_ucx_conn_info;
+
+/// Additional endpoint of a StfSender connection, on one local interface (multi-rail)
+struct dd_ucx_rail {
+  /// Self reference to perform cleanup on errors
+  TfBuilderInputUCX* mInputUCX;
+  /// Connection of the rail (set when the rail is attached)
+  dd_ucx_conn_info* mConn = nullptr;
+
+  /// Rail index of the node (local interface)
+  unsigned mRailIdx;
+
+  /// UCP worker and ep
+  ucx::dd_ucp_worker worker;
+  ucp_ep_h ucp_ep;
+
+  /// remote rma keys unpacked for the rail endpoint
+  std::vector<ucp_rkey_h> mRemoteKeys;
+
+  /// Signal that the rail endpoint has problems (the rail is detached, the connection continues on other rails)
+  std::atomic_bool mRailError = false;
+
+  dd_ucx_rail(TfBuilderInputUCX *pThis, const unsigned pRailIdx) : mInputUCX(pThis), mRailIdx(pRailIdx) { }
 };
 
 struct dd_ucx_conn_info {
@@ -56,8 +87,20 @@ struct dd_ucx_conn_info {
   /// Lock to ensure only one thread is using the endpoint at any time
   std::mutex mStfSenderIoLock;
 
-  /// cache of unpacked remote rma keys
-  std::map<std::string, ucp_rkey_h> mRemoteKeys;
+  /// unpacked remote rma keys, indexed by the region id of the StfSender region registry
+  std::vector<ucp_rkey_h> mRemoteKeys;
+  /// packed remote rma keys, to unpack for the endpoints of rails
+  std::vector<std::string> mPackedRemoteKeys;
+
+  /// Additional rails of the connection. Rail 0 is the endpoint above (also used for the control channel)
+  std::vector<std::unique_ptr<dd_ucx_rail>> mRails;
+
+  /// Control channel selected by StfSender: active messages (STF metadata and DONE acks) or tagged strings
+  bool mAmControl = false;
+  ucx::io::dd_ucp_am_queue mAmQueue;
+
+  /// Adaptive limit of rma_get bytes in flight
+  ucx::UCXRmaWindow mRmaWindow;
 
   /// Signal that peer connection has problems
   std::atomic_bool mConnError = false;
@@ -86,6 +129,34 @@ public:
   void reset() { }
 
   void DataHandlerThread(const unsigned pThreadIdx);
+  bool sendStfDone(dd_ucx_conn_info &pConn, const std::uint64_t pTfId, const bool pOk);
+
+  /// Unpack rkeys of the region registry sent by StfSender (on connect, or with STF metadata)
+  bool updateRemoteKeys(dd_ucx_conn_info &pConn, const UCXIovStfHeader &pMeta);
+  bool unpackRemoteKeys(ucp_ep_h pEp, const std::vector<std::string> &pPackedKeys, std::vector<ucp_rkey_h> &pRemoteKeys,
+                        const std::string &pStfSenderId);
+
+  /// Accept an endpoint of an additional rail, and attach it to the StfSender connection
+  void acceptRail(const unsigned pRailIdx, ucp_conn_request_h pConnRequest, const std::string &pStfSenderAddr);
+  /// Close rails with endpoint errors. Requires mConnectionMapLock and mStfSenderIoLock of the connection
+  void detachFailedRails(dd_ucx_conn_info &pConn);
+
+  /// Report the bandwidth of rails
+  void reportRailStats();
+
+  /// Adjust the connection and node RMA windows with completions of one STF
+  void updateRmaWindows(dd_ucx_conn_info &pConn, ucx::io::dd_ucp_multi_req &pReq, const double pElapsedUs);
+
+  void handle_rail_ep_error(dd_ucx_rail *pRail, ucs_status_t pStatus) {
+    // called from the progress thread: the rail is closed by the next transfer of the connection
+    if (pRail && pRail->mConn) {
+      pRail->mRailError = true;
+      EDDLOG("TfBuilderInputUCX: rail connection error. stfsender_id={} rail={} err={}",
+        pRail->mConn->mStfSenderId, pRail->mRailIdx, ucs_status_string(pStatus));
+    } else {
+      EDDLOG("TfBuilderInputUCX: rail connection error before the handshake. err={}", ucs_status_string(pStatus));
+    }
+  }
 
   void handle_client_ep_error(dd_ucx_conn_info *pConn, ucs_status_t pStatus) {
 
@@ -120,6 +191,20 @@ private:
   std::uint64_t mNumRmaOps;
   std::vector<std::thread> mThreadPool;
 
+  /// Progress threads of all StfSender connections (when enabled)
+  ucx::UCXProgressEngine mProgressEngine;
+
+  /// Adaptive RMA concurrency: windows of connections and of the node
+  bool mRmaWindowEnabled = false;
+  ucx::UCXRmaWindow::Config mConnRmaWindowConfig;
+  ucx::UCXRmaWindow mNodeRmaWindow;
+  ucx::io::dd_ucp_inflight_budget mNodeRmaBudget;
+
+  /// Multi-rail: ips of rails (rail 0 is the ip of the TfBuilder), striping and bandwidth of rails
+  std::vector<std::string> mRailIps;
+  std::uint64_t mRailStripeSize = (1ULL << 20);
+  ucx::UCXRailStats mRailStats;
+
   /// Queue for received STFs
   ConcurrentQueue<ReceivedStfMeta> &mReceivedDataQueue;
 
@@ -133,15 +218,20 @@ private:
   ucp_listener_h ucp_listener;
   dd_ucp_listener_context_t dd_ucp_listen_context;
 
+  /// listeners of additional rails (on the same worker)
+  std::vector<ucp_listener_h> mRailListeners;
+  std::vector<std::unique_ptr<dd_ucp_listener_context_t>> mRailListenContexts;
+
   void ListenerThread();
   std::thread mListenerThread;
-  ConcurrentQueue<std::tuple<std::string, unsigned, ucp_conn_request_h> > mConnRequestQueue;
+  // <stfsender addr, stfsender port, request, rail>
+  ConcurrentQueue<std::tuple<std::string, unsigned, ucp_conn_request_h, unsigned> > mConnRequestQueue;
   std::mutex mConnectionMapLock;
     std::map<std::string, std::unique_ptr<dd_ucx_conn_info>> mConnMap;
 
 public:
   // UCX callbacks
-  void new_conn_handle(ucp_conn_request_h conn_request);
+  void new_conn_handle(ucp_conn_request_h conn_request, const unsigned pRailIdx);
 };
 
 
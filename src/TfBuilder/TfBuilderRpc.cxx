@@ -119,6 +119,11 @@ void TfBuilderRpcImpl::stopAcceptingTfs() {
   sendTfBuilderUpdate();
 }
 
+std::uint64_t TfBuilderRpcImpl::freeDataMemory() const
+{
+  return mMemI.freeData();
+}
+
 void TfBuilderRpcImpl::UpdateSendingThread()
 {
   using namespace std::chrono_literals;
@@ -260,6 +265,8 @@ bool TfBuilderRpcImpl::recordTfForwarded(const std::uint64_t &pTfId)
   }
 
   mUpdateCondition.notify_one();
+  // free region memory for new STF transfers
+  mCredits.notify();
 
   return true;
 }
@@ -377,17 +384,18 @@ void TfBuilderRpcImpl::StfRequestThread()
         lStfSenderIdTopo = lReqVector.front().mStfSenderId;
       }
 
-      mMaxNumReqInFlight = std::clamp(mDiscoveryConfig->getUInt64Param(MaxNumStfTransfersKey, MaxNumStfTransferDefault),
-        std::uint64_t(10), std::uint64_t(200));
+      {
+        TfBuilderCredits::Config lCreditConfig;
+        lCreditConfig.mMaxTransfers = std::clamp(mDiscoveryConfig->getUInt64Param(MaxNumStfTransfersKey, MaxNumStfTransferDefault),
+          std::uint64_t(10), std::uint64_t(200));
+        lCreditConfig.mMaxBytes = mDiscoveryConfig->getUInt64Param(StfTransferCreditMBKey, StfTransferCreditMBDefault) << 20;
+        lCreditConfig.mMaxStfSenderBytes =
+          mDiscoveryConfig->getUInt64Param(StfTransferCreditPerStfSenderMBKey, StfTransferCreditPerStfSenderMBDefault) << 20;
+        mCredits.configure(lCreditConfig);
+      }
 
       std::uint64_t lNumExpectedStfs = 0;
       while (mRunning && !lReqVector.empty()) {
-        // wait for the stf slots to become free
-        if (mNumReqInFlight.load() >= mMaxNumReqInFlight) {
-          std::this_thread::sleep_for(5ms);
-          continue; // reevaluate the max TF conditions
-        }
-
         // select the stfsender to contact first based on the stf size
         std::size_t lIdx = 0;
 
@@ -419,8 +427,23 @@ void TfBuilderRpcImpl::StfRequestThread()
 
         DDMON("tfbuilder", "merge.request_idx", double(lIdx3_3) / double(lIdx + 1));
 
+        // requests are sent only with credit for the STF, to prevent incast bursts
+        // if the selected StfSender is above its credit, take any other with credit
+        const auto lCreditGeneration = mCredits.generation();
+        if (!mCredits.try_acquire(lReqVector[lIdx].mStfSenderId, lTfId, lReqVector[lIdx].mStfDataSize)) {
+          const auto lCreditIt = std::find_if(lReqVector.begin(), lReqVector.end(), [&](const StfRequests &pReq) {
+            return mCredits.try_acquire(pReq.mStfSenderId, lTfId, pReq.mStfDataSize);
+          });
+          if (lCreditIt == lReqVector.end()) {
+            mCredits.wait_for(lCreditGeneration, 100ms);
+            continue; // reevaluate the credits
+          }
+          lIdx = std::distance(lReqVector.begin(), lCreditIt);
+        }
+
         lStfRequest = std::move(lReqVector[lIdx]);
         lReqVector.erase(lReqVector.cbegin() + lIdx);
+        lStfRequest.mRequest.set_credit_bytes(lStfRequest.mStfDataSize);
 
         { // record the current TP
           std::unique_lock lLock(mStfDurationMapLock);
@@ -433,22 +456,29 @@ void TfBuilderRpcImpl::StfRequestThread()
           // gRPC problem... continue asking for other STFs
           EDDLOG("StfSender gRPC connection problem. stfs_id={} code={} error={} stf_size={}",
             lStfRequest.mStfSenderId, lStatus.error_code(), lStatus.error_message(), lStfRequest.mStfDataSize);
+          mCredits.release(lStfRequest.mStfSenderId, lTfId);
           continue;
         }
 
         if (lStfResponse.status() != StfDataResponse::OK) {
           EDDLOG("StfSender did not sent data. stfs_id={} reason={}",
             lStfRequest.mStfSenderId, StfDataResponse_StfDataStatus_Name(lStfResponse.status()));
+          mCredits.release(lStfRequest.mStfSenderId, lTfId);
           continue;
         }
 
+        // account the real size of the STF (no-op if already received)
+        if (lStfResponse.stf_size() > 0) {
+          mCredits.update(lStfRequest.mStfSenderId, lTfId, lStfResponse.stf_size());
+        }
+
         // Notify input about incoming STF
         mStfInputQueue->push(lStfRequest.mStfSenderId);
 
         lNumExpectedStfs += 1;
 
-        mNumReqInFlight += 1;
-        DDMON("tfbuilder", "merge.num_stf_in_flight", mNumReqInFlight);
+        DDMON("tfbuilder", "merge.num_stf_in_flight", mCredits.transfersInFlight());
+        DDMON("tfbuilder", "merge.stf_credit_in_flight_mb", double(mCredits.bytesInFlight()) / double(1ULL << 20));
       }
 
       // set the number of STFs for merging thread
@@ -485,8 +515,8 @@ void TfBuilderRpcImpl::StfRequestThread()
 bool TfBuilderRpcImpl::recordStfReceived(const std::string &pStfSenderId, const std::uint64_t pTfId)
 {
   using hres_clock = std::chrono::steady_clock;
-  // unblock the next request
-  mNumReqInFlight -= 1;
+  // return the credit, unblock the next request
+  mCredits.release(pStfSenderId, pTfId);
 
   // record completion time
   double lStfFetchDurationMs = 0.0;
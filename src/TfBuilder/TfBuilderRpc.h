@@ -15,6 +15,7 @@
 #define ALICEO2_TF_BUILDER_RPC_H_
 
 #include "TfBuilderInputDefs.h"
+#include "TfBuilderCredits.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -49,7 +50,8 @@ class TfBuilderRpcImpl final : public TfBuilderRpc::Service
 {
 public:
   TfBuilderRpcImpl(std::shared_ptr<ConsulTfBuilder> pDiscoveryConfig, SyncMemoryResources &pMemI)
-  : mMemI(pMemI),
+  : mCredits([this]() { return freeDataMemory(); }),
+    mMemI(pMemI),
     mDiscoveryConfig(pDiscoveryConfig),
     mStfSenderRpcClients(mDiscoveryConfig)
   { }
@@ -100,6 +102,7 @@ public:
     mNumBufferedTfs = 0;
     mNumTfsInBuilding = 0;
     mTfBuildRequests->flush();
+    mCredits.reset();
     // Reset Topo Tf Id renaming
     mTopoStfId = 1;
     mTopoTfIdRenameMap.clear();
@@ -135,6 +138,8 @@ public:
   }
 
 private:
+  std::uint64_t freeDataMemory() const;
+
   std::atomic_bool mRunning = false;
   std::atomic_bool mTerminateRequested = false;
 
@@ -160,8 +165,8 @@ private:
       : mStfSenderId(pStfSenderId), mStfDataSize(pStfDataSize), mRequest(pRequest) { }
     };
 
-  std::atomic_int64_t mMaxNumReqInFlight = 64;
-  std::atomic_int64_t mNumReqInFlight = 0;
+  /// Byte credits of STF transfers in flight
+  TfBuilderCredits mCredits;
 
   // <tfid, topo?, topo_id, stf_requests>
   ConcurrentFifo<std::tuple<std::uint64_t, bool, std::uint64_t, std::vector<StfRequests>> >  mStfRequestQueue;
@@ -0,0 +1,361 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Incast of STF transfers into one TfBuilder: many StfSenders, each over a loopback UCX connection,
+// send the STFs of every TF at the same time. The TfBuilder side requests STFs with the fixed number
+// of transfers in flight (MaxNumStfTransfers, "count" mode) or with byte credits (TfBuilderCredits, "credit" mode),
+// and fetches them with RMA get operations.
+// Select the transport with UCX_TLS (e.g. UCX_TLS=tcp, or UCX_TLS=shm,tcp).
+
+#include "TfBuilderCredits.h"
+
+#include <UCXLoopback.h>
+
+#include <boost/program_options.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace o2::DataDistribution;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+
+struct Config {
+  std::uint64_t mNumSenders;
+  std::uint64_t mStfSize;
+  std::uint64_t mTxgSize;
+  std::uint64_t mNumTfs;
+  std::uint64_t mRegionSize;
+  std::uint64_t mMaxTransfers;
+  std::uint64_t mCreditBytes;
+  std::uint64_t mStfSenderCreditBytes;
+};
+
+/// One StfSender, and the TfBuilder receiver thread of its connection
+struct StfSenderConn {
+  std::string mId;
+  ucx::UcxLoopbackConn mConn;
+
+  std::unique_ptr<char[]> mStfBuf;
+  std::unique_ptr<char[]> mRecvBuf;
+  ucp_mem_h mStfMem = nullptr;
+  void *mRKeyBuf = nullptr;
+  std::size_t mRKeySize = 0;
+  ucp_mem_h mRecvMem = nullptr;
+  ucp_rkey_h mRKey = nullptr;
+
+  // requested STFs: <tf id, request time>
+  std::mutex mLock;
+  std::condition_variable mCond;
+  std::deque<std::pair<std::uint64_t, clock_type::time_point>> mRequests;
+};
+
+/// TfBuilder state of one measurement
+struct Run {
+  const Config &mConfig;
+  const bool mCredit;
+
+  TfBuilderCredits mCredits;
+
+  // TF buffer of the scheduler (TFs in building), and the data region allocated for received STFs
+  std::atomic_uint64_t mTfBufferUsed = 0;
+  std::atomic_uint64_t mRegionUsed = 0;
+
+  std::atomic_uint64_t mBytesInFlight = 0;
+  std::atomic_uint64_t mMaxBytesInFlight = 0;
+  std::atomic_int64_t mNumInFlight = 0;
+
+  std::mutex mResultLock;
+  std::vector<double> mStfFetchUs;
+  std::vector<std::uint64_t> mTfStfsLeft;
+  std::vector<clock_type::time_point> mTfStart;
+  std::vector<double> mTfBuildUs;
+  std::condition_variable mTfDoneCond;
+  std::uint64_t mNumTfsDone = 0;
+
+  Run(const Config &pConfig, const bool pCredit)
+  : mConfig(pConfig),
+    mCredit(pCredit),
+    mCredits([this]() { return mConfig.mRegionSize - mRegionUsed.load(); }),
+    mTfStfsLeft(pConfig.mNumTfs, pConfig.mNumSenders),
+    mTfStart(pConfig.mNumTfs)
+  {
+    TfBuilderCredits::Config lCreditConfig;
+    lCreditConfig.mMaxTransfers = mConfig.mMaxTransfers;
+    lCreditConfig.mMaxBytes = mConfig.mCreditBytes;
+    lCreditConfig.mMaxStfSenderBytes = mConfig.mStfSenderCreditBytes;
+    mCredits.configure(lCreditConfig);
+  }
+
+  void stfReceived(StfSenderConn &pSender, const std::uint64_t pTfId, const clock_type::time_point pRequested)
+  {
+    const auto lNow = clock_type::now();
+
+    mBytesInFlight -= mConfig.mStfSize;
+    mNumInFlight -= 1;
+    if (mCredit) {
+      mCredits.release(pSender.mId, pTfId);
+    }
+
+    std::scoped_lock lLock(mResultLock);
+    mStfFetchUs.push_back(std::chrono::duration<double, std::micro>(lNow - pRequested).count());
+
+    if (--mTfStfsLeft[pTfId] == 0) {
+      mTfBuildUs.push_back(std::chrono::duration<double, std::micro>(lNow - mTfStart[pTfId]).count());
+      // the TF is forwarded immediately
+      mTfBufferUsed -= mConfig.mNumSenders * mConfig.mStfSize;
+      mRegionUsed -= mConfig.mNumSenders * mConfig.mStfSize;
+      mNumTfsDone++;
+      mTfDoneCond.notify_all();
+      mCredits.notify();
+    }
+  }
+};
+
+/// TfBuilder receiver of one connection: fetch the requested STFs with RMA get operations
+static void receiver(StfSenderConn &pSender, Run &pRun, const Config &pConfig)
+{
+  for (std::uint64_t i = 0; i < pConfig.mNumTfs; i++) {
+    std::pair<std::uint64_t, clock_type::time_point> lReq;
+    {
+      std::unique_lock lLock(pSender.mLock);
+      pSender.mCond.wait(lLock, [&]() { return !pSender.mRequests.empty(); });
+      lReq = pSender.mRequests.front();
+      pSender.mRequests.pop_front();
+    }
+
+    // allocate the STF in the region
+    pRun.mRegionUsed += pConfig.mStfSize;
+
+    ucx::io::dd_ucp_multi_req lReqSem(8);
+    const auto lRemote = reinterpret_cast<std::uint64_t>(pSender.mStfBuf.get());
+
+    for (std::uint64_t lOff = 0; lOff < pConfig.mStfSize; lOff += pConfig.mTxgSize) {
+      const auto lSize = std::min(pConfig.mTxgSize, pConfig.mStfSize - lOff);
+      while (!lReqSem.done()) {
+        pSender.mConn.progress();
+      }
+      ucx::io::get(pSender.mConn.client_ep, pSender.mRecvBuf.get() + lOff, lSize, lRemote + lOff, pSender.mRKey, &lReqSem);
+    }
+    lReqSem.mark_finished();
+    while (!lReqSem.done()) {
+      pSender.mConn.progress();
+    }
+
+    pRun.stfReceived(pSender, lReq.first, lReq.second);
+  }
+}
+
+/// TfBuilderRpc StfRequestThread: admit TFs into the region, and request all STFs
+static void requester(std::vector<std::unique_ptr<StfSenderConn>> &pSenders, Run &pRun, const Config &pConfig)
+{
+  using namespace std::chrono_literals;
+  const std::uint64_t lTfSize = pConfig.mNumSenders * pConfig.mStfSize;
+
+  for (std::uint64_t lTfId = 0; lTfId < pConfig.mNumTfs; lTfId++) {
+    // TfScheduler: assign the TF when the buffer has space for it
+    {
+      std::unique_lock lLock(pRun.mResultLock);
+      pRun.mTfDoneCond.wait(lLock, [&]() { return (pRun.mTfBufferUsed + lTfSize) <= pConfig.mRegionSize; });
+      pRun.mTfBufferUsed += lTfSize;
+      pRun.mTfStart[lTfId] = clock_type::now();
+    }
+
+    std::vector<StfSenderConn*> lReqVector;
+    for (auto &lSender : pSenders) {
+      lReqVector.push_back(lSender.get());
+    }
+
+    while (!lReqVector.empty()) {
+      std::size_t lIdx = 0;
+
+      if (pRun.mCredit) {
+        const auto lGeneration = pRun.mCredits.generation();
+        const auto lIt = std::find_if(lReqVector.begin(), lReqVector.end(), [&](StfSenderConn *pSender) {
+          return pRun.mCredits.try_acquire(pSender->mId, lTfId, pConfig.mStfSize);
+        });
+        if (lIt == lReqVector.end()) {
+          pRun.mCredits.wait_for(lGeneration, 100ms);
+          continue;
+        }
+        lIdx = std::distance(lReqVector.begin(), lIt);
+      } else if (pRun.mNumInFlight.load() >= std::int64_t(pConfig.mMaxTransfers)) {
+        std::this_thread::sleep_for(5ms);
+        continue;
+      }
+
+      auto &lSender = *lReqVector[lIdx];
+      lReqVector.erase(lReqVector.begin() + lIdx);
+
+      pRun.mNumInFlight += 1;
+      const auto lInFlight = (pRun.mBytesInFlight += pConfig.mStfSize);
+      auto lMax = pRun.mMaxBytesInFlight.load();
+      while (lInFlight > lMax && !pRun.mMaxBytesInFlight.compare_exchange_weak(lMax, lInFlight)) { }
+
+      {
+        std::scoped_lock lLock(lSender.mLock);
+        lSender.mRequests.emplace_back(lTfId, clock_type::now());
+      }
+      lSender.mCond.notify_one();
+    }
+  }
+}
+
+static double percentile(std::vector<double> &pValues, const double pPct)
+{
+  if (pValues.empty()) {
+    return 0.0;
+  }
+  std::sort(pValues.begin(), pValues.end());
+  return pValues[std::min(pValues.size() - 1, std::size_t(double(pValues.size()) * pPct / 100.0))];
+}
+
+static void measure(std::vector<std::unique_ptr<StfSenderConn>> &pSenders, const Config &pConfig, const bool pCredit)
+{
+  Run lRun(pConfig, pCredit);
+
+  const auto lStart = clock_type::now();
+
+  std::vector<std::thread> lReceivers;
+  for (auto &lSender : pSenders) {
+    lReceivers.emplace_back(receiver, std::ref(*lSender), std::ref(lRun), std::cref(pConfig));
+  }
+  requester(pSenders, lRun, pConfig);
+
+  for (auto &lThread : lReceivers) {
+    lThread.join();
+  }
+
+  const double lTotalS = std::chrono::duration<double>(clock_type::now() - lStart).count();
+  const double lTotalBytes = double(pConfig.mNumTfs * pConfig.mNumSenders * pConfig.mStfSize);
+
+  std::cout << fmt::format("{:>8} {:>10.2f} {:>12.1f} {:>12.1f} {:>12.1f} {:>12.1f} {:>14.1f}",
+    (pCredit ? "credit" : "count"), lTotalBytes / lTotalS / 1e9,
+    percentile(lRun.mStfFetchUs, 50) / 1e3, percentile(lRun.mStfFetchUs, 99) / 1e3,
+    percentile(lRun.mTfBuildUs, 50) / 1e3, percentile(lRun.mTfBuildUs, 99) / 1e3,
+    double(lRun.mMaxBytesInFlight.load()) / double(1ULL << 20)) << std::endl;
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+  namespace bpo = boost::program_options;
+
+  bpo::options_description lOptions("StfIncastBenchmark options", 120);
+  lOptions.add_options()
+    ("help,h", "Print help.")
+    ("ip", bpo::value<std::string>()->default_value("127.0.0.1"), "IP address of the loopback connections.")
+    ("senders", bpo::value<std::uint64_t>()->default_value(16), "Number of StfSenders.")
+    ("stf-size", bpo::value<std::uint64_t>()->default_value(8ULL << 20), "Size of one STF (bytes).")
+    ("txg-size", bpo::value<std::uint64_t>()->default_value(1ULL << 20), "Size of RMA get operations (bytes).")
+    ("tfs", bpo::value<std::uint64_t>()->default_value(200), "Number of TFs.")
+    ("region-mb", bpo::value<std::uint64_t>()->default_value(1024), "Size of the TfBuilder data region (MiB).")
+    ("max-transfers", bpo::value<std::uint64_t>()->default_value(100), "MaxNumStfTransfers parameter.")
+    ("credit-mb", bpo::value<std::uint64_t>()->default_value(64), "StfTransferCreditMB parameter.")
+    ("stfsender-credit-mb", bpo::value<std::uint64_t>()->default_value(16), "StfTransferCreditPerStfSenderMB parameter.")
+    ("mode", bpo::value<std::string>()->default_value("both"), "Flow control: count, credit, or both.");
+
+  bpo::variables_map lVm;
+  try {
+    bpo::store(bpo::parse_command_line(argc, argv, lOptions), lVm);
+    bpo::notify(lVm);
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n" << lOptions << std::endl;
+    return 1;
+  }
+
+  if (lVm.count("help")) {
+    std::cout << "Usage: [UCX_TLS=tcp] StfIncastBenchmark [options]\n" << lOptions << std::endl;
+    return 0;
+  }
+
+  const auto lMode = lVm["mode"].as<std::string>();
+  if (lMode != "count" && lMode != "credit" && lMode != "both") {
+    std::cerr << "Error: invalid mode: " << lMode << std::endl;
+    return 1;
+  }
+
+  Config lConfig;
+  lConfig.mNumSenders = std::clamp(lVm["senders"].as<std::uint64_t>(), std::uint64_t(1), std::uint64_t(256));
+  lConfig.mStfSize = std::max(std::uint64_t(1), lVm["stf-size"].as<std::uint64_t>());
+  lConfig.mTxgSize = std::max(std::uint64_t(1), lVm["txg-size"].as<std::uint64_t>());
+  lConfig.mNumTfs = std::max(std::uint64_t(1), lVm["tfs"].as<std::uint64_t>());
+  lConfig.mRegionSize = std::max(lVm["region-mb"].as<std::uint64_t>() << 20, lConfig.mNumSenders * lConfig.mStfSize);
+  lConfig.mMaxTransfers = std::max(std::uint64_t(1), lVm["max-transfers"].as<std::uint64_t>());
+  lConfig.mCreditBytes = lVm["credit-mb"].as<std::uint64_t>() << 20;
+  lConfig.mStfSenderCreditBytes = lVm["stfsender-credit-mb"].as<std::uint64_t>() << 20;
+
+  // StfSenders: STF data, and the receive buffer of TfBuilder
+  std::vector<std::unique_ptr<StfSenderConn>> lSenders;
+  for (std::uint64_t i = 0; i < lConfig.mNumSenders; i++) {
+    auto lSender = std::make_unique<StfSenderConn>();
+    lSender->mId = fmt::format("stfs-{}", i);
+
+    if (!lSender->mConn.connect(lVm["ip"].as<std::string>())) {
+      std::cerr << "Failed to create the loopback UCX connection." << std::endl;
+      return 2;
+    }
+
+    lSender->mStfBuf = std::make_unique<char[]>(lConfig.mStfSize);
+    lSender->mRecvBuf = std::make_unique<char[]>(lConfig.mStfSize);
+
+    auto &lCtx = lSender->mConn.ucp_context;
+    if (!ucx::util::create_rkey_for_region(lCtx, lSender->mStfBuf.get(), lConfig.mStfSize, true, &lSender->mStfMem,
+          &lSender->mRKeyBuf, &lSender->mRKeySize) ||
+        !ucx::util::create_rkey_for_region(lCtx, lSender->mRecvBuf.get(), lConfig.mStfSize, false, &lSender->mRecvMem,
+          nullptr, nullptr)) {
+      return 2;
+    }
+
+    if (ucp_ep_rkey_unpack(lSender->mConn.client_ep, lSender->mRKeyBuf, &lSender->mRKey) != UCS_OK) {
+      std::cerr << "Failed to unpack the rkey." << std::endl;
+      return 2;
+    }
+
+    lSenders.push_back(std::move(lSender));
+  }
+
+  std::cout << fmt::format("senders={} stf_size={} tf_size={} region_mb={}", lConfig.mNumSenders, lConfig.mStfSize,
+    lConfig.mNumSenders * lConfig.mStfSize, lConfig.mRegionSize >> 20) << std::endl;
+  std::cout << fmt::format("{:>8} {:>10} {:>12} {:>12} {:>12} {:>12} {:>14}", "mode", "GB/s",
+    "stf_p50_ms", "stf_p99_ms", "tf_p50_ms", "tf_p99_ms", "max_flight_mb") << std::endl;
+
+  if (lMode != "credit") {
+    measure(lSenders, lConfig, false);
+  }
+  if (lMode != "count") {
+    measure(lSenders, lConfig, true);
+  }
+
+  for (auto &lSender : lSenders) {
+    ucp_rkey_destroy(lSender->mRKey);
+    ucp_mem_unmap(lSender->mConn.ucp_context, lSender->mRecvMem);
+    ucx::util::destroy_rkey_for_region(lSender->mConn.ucp_context, lSender->mStfMem, lSender->mRKeyBuf);
+    lSender->mConn.close();
+  }
+
+  return 0;
+}
@@ -42,6 +42,8 @@ int main(int argc, char* argv[])
       r.fConfig.AddToCmdLineOptions(impl::DataDistLoggerCtx::getProgramOptions());
       // Add Monitoring Options
       r.fConfig.AddToCmdLineOptions(DataDistMonitor::getProgramOptions());
+      // Add Tracing Options
+      r.fConfig.AddToCmdLineOptions(DataDistTracer::getProgramOptions());
 
       // TfBuilder options
       bpo::options_description lTfBuilderOptions("TfBuilder options", 120);
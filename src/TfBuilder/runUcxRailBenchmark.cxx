@@ -0,0 +1,206 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Striping of RMA gets across multiple rails (UcxTfBuilderRailIps parameter of TfBuilder).
+// One loopback UCX connection is created for each rail address, and STF sized transfers are
+// striped across the connections as done by TfBuilder. The bandwidth of the first rail alone is
+// compared with the bandwidth of all rails.
+// Loopback addresses (e.g. --rails=127.0.0.1,127.0.0.2) verify the striping without multiple NICs.
+// Select the transport with UCX_TLS (e.g. UCX_TLS=tcp).
+
+#include <UCXLoopback.h>
+
+#include <UCXRails.h>
+
+#include <boost/program_options.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace o2::DataDistribution;
+
+namespace {
+
+struct RailBuffers {
+  ucx::UcxLoopbackConn mConn;
+  ucp_mem_h mRemoteMem = nullptr;
+  void *mRKeyBuf = nullptr;
+  ucp_mem_h mLocalMem = nullptr;
+  ucp_rkey_h mRKey = nullptr;
+};
+
+static void progress(std::vector<std::unique_ptr<RailBuffers>> &pRails)
+{
+  for (auto &lRail : pRails) {
+    lRail->mConn.progress();
+  }
+}
+
+/// Striped transfers of the buffer using the first pNumRails rails. Returns the elapsed time (s)
+static double measure(std::vector<std::unique_ptr<RailBuffers>> &pRails, const std::size_t pNumRails,
+                      char *pLocal, const std::uint64_t pRemote, const std::uint64_t pSize,
+                      const std::uint64_t pStripeSize, const std::uint64_t pIterations, const std::uint64_t pConcurrency,
+                      std::vector<std::uint64_t> &pRailBytes)
+{
+  ucx::UCXRailStriper lStriper(pStripeSize);
+  pRailBytes.assign(pNumRails, 0);
+
+  const auto lStart = std::chrono::steady_clock::now();
+
+  for (std::uint64_t i = 0; i < pIterations; i++) {
+    ucx::io::dd_ucp_multi_req lReq(pConcurrency);
+    lStriper.reset(pNumRails);
+
+    lStriper.stripe(pSize, [&](const std::size_t pRail, const std::uint64_t pOff, const std::uint64_t pLen) {
+      while (!lReq.done()) {
+        progress(pRails);
+      }
+      auto &lRail = *pRails[pRail];
+      ucx::io::get(lRail.mConn.client_ep, pLocal + pOff, pLen, pRemote + pOff, lRail.mRKey, &lReq);
+      return true;
+    });
+
+    lReq.mark_finished();
+    while (!lReq.done()) {
+      progress(pRails);
+    }
+
+    for (std::size_t lRail = 0; lRail < pNumRails; lRail++) {
+      pRailBytes[lRail] += lStriper.railBytes()[lRail];
+    }
+  }
+
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - lStart).count();
+}
+
+static void print(const std::string &pName, const std::vector<std::string> &pRailIps,
+                  const std::vector<std::uint64_t> &pRailBytes, const double pTimeS)
+{
+  std::uint64_t lTotal = 0;
+  for (std::size_t lRail = 0; lRail < pRailBytes.size(); lRail++) {
+    std::cout << fmt::format("{:>10} {:>4} {:>16} {:>12.1f}", pName, lRail, pRailIps[lRail],
+      double(pRailBytes[lRail]) / double(1ULL << 20) / pTimeS) << std::endl;
+    lTotal += pRailBytes[lRail];
+  }
+  std::cout << fmt::format("{:>10} {:>4} {:>16} {:>12.1f}", pName, "all", "",
+    double(lTotal) / double(1ULL << 20) / pTimeS) << std::endl;
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+  namespace bpo = boost::program_options;
+
+  bpo::options_description lOptions("UcxRailBenchmark options", 120);
+  lOptions.add_options()
+    ("help,h", "Print help.")
+    ("rails", bpo::value<std::string>()->default_value("127.0.0.1,127.0.0.2"),
+      "IP addresses of the rails. One loopback connection is created for each address.")
+    ("size", bpo::value<std::uint64_t>()->default_value(64ULL << 20), "Size of a transfer (STF, bytes).")
+    ("stripe-kb", bpo::value<std::uint64_t>()->default_value(1024), "Stripe size (UcxRailStripeSizeKB of TfBuilder).")
+    ("concurrency", bpo::value<std::uint64_t>()->default_value(8),
+      "Number of get operations in flight (UcxNumConcurrentRmaGetOps of TfBuilder).")
+    ("iterations", bpo::value<std::uint64_t>()->default_value(32), "Number of transfers for each measurement.");
+
+  bpo::variables_map lVm;
+  try {
+    bpo::store(bpo::parse_command_line(argc, argv, lOptions), lVm);
+    bpo::notify(lVm);
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n" << lOptions << std::endl;
+    return 1;
+  }
+
+  if (lVm.count("help")) {
+    std::cout << "Usage: [UCX_TLS=tcp] UcxRailBenchmark [options]\n" << lOptions << std::endl;
+    return 0;
+  }
+
+  const auto lRailIps = ucx::parse_rail_ips(lVm["rails"].as<std::string>());
+  const auto lSize = std::max(std::uint64_t(4096), lVm["size"].as<std::uint64_t>());
+  const auto lStripeSize = std::clamp(lVm["stripe-kb"].as<std::uint64_t>(), std::uint64_t(64), std::uint64_t(1) << 20) << 10;
+  const auto lConcurrency = std::clamp(lVm["concurrency"].as<std::uint64_t>(), std::uint64_t(1), std::uint64_t(64));
+  const auto lIterations = std::max(std::uint64_t(1), lVm["iterations"].as<std::uint64_t>());
+
+  if (lRailIps.empty()) {
+    std::cerr << "No rail addresses." << std::endl;
+    return 1;
+  }
+
+  // remote (source) and local (destination) buffers, registered with the context of each rail
+  auto lRemoteBuf = std::make_unique<char[]>(lSize);
+  auto lLocalBuf = std::make_unique<char[]>(lSize);
+  std::fill_n(lRemoteBuf.get(), lSize, 0x5a);
+
+  std::vector<std::unique_ptr<RailBuffers>> lRails;
+  for (const auto &lIp : lRailIps) {
+    auto &lRail = *lRails.emplace_back(std::make_unique<RailBuffers>());
+
+    if (!lRail.mConn.connect(lIp)) {
+      std::cerr << "Failed to create the loopback UCX connection. ip=" << lIp << std::endl;
+      return 2;
+    }
+
+    std::size_t lRKeySize = 0;
+    if (!ucx::util::create_rkey_for_region(lRail.mConn.ucp_context, lRemoteBuf.get(), lSize, true, &lRail.mRemoteMem, &lRail.mRKeyBuf, &lRKeySize) ||
+        !ucx::util::create_rkey_for_region(lRail.mConn.ucp_context, lLocalBuf.get(), lSize, false, &lRail.mLocalMem, nullptr, nullptr)) {
+      return 2;
+    }
+
+    if (ucp_ep_rkey_unpack(lRail.mConn.client_ep, lRail.mRKeyBuf, &lRail.mRKey) != UCS_OK) {
+      std::cerr << "Failed to unpack the rkey. ip=" << lIp << std::endl;
+      return 2;
+    }
+  }
+
+  const auto lRemotePtr = reinterpret_cast<std::uint64_t>(lRemoteBuf.get());
+  std::vector<std::uint64_t> lRailBytes;
+
+  // warm up
+  measure(lRails, lRails.size(), lLocalBuf.get(), lRemotePtr, lSize, lStripeSize, 1, lConcurrency, lRailBytes);
+
+  std::cout << fmt::format("rails={} size={} stripe_size={} concurrency={} iterations={}",
+    lRails.size(), lSize, lStripeSize, lConcurrency, lIterations) << std::endl;
+  std::cout << fmt::format("{:>10} {:>4} {:>16} {:>12}", "mode", "rail", "ip", "MiB/s") << std::endl;
+
+  const double lSingleS = measure(lRails, 1, lLocalBuf.get(), lRemotePtr, lSize, lStripeSize, lIterations, lConcurrency, lRailBytes);
+  print("single", lRailIps, lRailBytes, lSingleS);
+
+  // the data check covers the striped transfers only
+  std::fill_n(lLocalBuf.get(), lSize, 0);
+  const double lStripedS = measure(lRails, lRails.size(), lLocalBuf.get(), lRemotePtr, lSize, lStripeSize, lIterations, lConcurrency, lRailBytes);
+  print("striped", lRailIps, lRailBytes, lStripedS);
+
+  if (!std::all_of(lLocalBuf.get(), lLocalBuf.get() + lSize, [](const char c) { return c == 0x5a; })) {
+    std::cerr << "Data of the striped transfers is not correct." << std::endl;
+    return 3;
+  }
+
+  std::cout << fmt::format("\nspeedup={:.2f}", lSingleS / std::max(lStripedS, 1e-9)) << std::endl;
+
+  for (auto &lRail : lRails) {
+    ucp_rkey_destroy(lRail->mRKey);
+    ucp_mem_unmap(lRail->mConn.ucp_context, lRail->mLocalMem);
+    ucx::util::destroy_rkey_for_region(lRail->mConn.ucp_context, lRail->mRemoteMem, lRail->mRKeyBuf);
+    lRail->mConn.close();
+  }
+
+  return 0;
+}
@@ -366,6 +366,25 @@ public:
     return lMessage;
   }
 
+  // Allocate multiple messages. Refcounts of all allocations are updated under a single lock.
+  // Allocation stops on the first failure: the caller must check the number of returned messages.
+  template <typename OutIter>
+  inline std::size_t NewFairMQMessages(const std::vector<std::size_t> &pSizes, OutIter pInsertIt) {
+    static thread_local std::vector<std::pair<void*, std::size_t>> sAllocs;
+    sAllocs.clear();
+
+    for (const auto lSize : pSizes) {
+      auto* lMem = do_allocate(lSize);
+      if (!lMem) {
+        break;
+      }
+      sAllocs.emplace_back(lMem, lSize);
+    }
+
+    NewFairMQMessageFromPtr(sAllocs, pInsertIt);
+    return sAllocs.size();
+  }
+
   inline
   std::unique_ptr<FairMQMessage> NewFairMQMessageFromPtr(void *pPtr, const std::size_t pSize) {
     assert(pPtr >= static_cast<char*>(mRegion->GetData()));
@@ -791,26 +810,68 @@ public:
     return lMsg;
   }
 
+  // Allocate and copy multiple header messages, taking the header lock only once.
+  // New messages are appended to pDstMsgs. Returns false if not all messages could be allocated.
   inline
-  void newDataMessages(const std::vector<FairMQMessagePtr> &pSrcMsgs, std::vector<FairMQMessagePtr> &pDstMsgs) {
+  bool newHeaderMessages(const std::vector<std::pair<const void*, std::size_t>> &pSrcHdrs,
+                         std::vector<FairMQMessagePtr> &pDstMsgs) {
+    assert(mHeaderMemRes);
 
-    // create a new instance to support passing the same vect as in and out
-    std::vector<FairMQMessagePtr> lNewMsgs(pSrcMsgs.size());
-    lNewMsgs.clear();
+    static thread_local std::vector<std::size_t> sSizes;
+    sSizes.clear();
+    for (const auto &lSrcHdr : pSrcHdrs) {
+      sSizes.push_back(lSrcHdr.second);
+    }
 
+    const auto lFirstIdx = pDstMsgs.size();
+    std::size_t lNumAllocated = 0;
     { // allocate under one lock
-      std::scoped_lock lock(mDataLock);
-      for (const auto &lOrigMsg : pSrcMsgs) {
-        lNewMsgs.emplace_back( mDataMemRes->NewFairMQMessage(lOrigMsg->GetSize()) );
-      }
+      std::scoped_lock lock(mHdrLock);
+      lNumAllocated = mHeaderMemRes->NewFairMQMessages(sSizes, std::back_inserter(pDstMsgs));
     }
 
     // copy without holding allocator lock
-    for (std::size_t i = 0; i < pSrcMsgs.size(); i++) {
+    for (std::size_t i = 0; i < lNumAllocated; i++) {
+      memcpy(pDstMsgs[lFirstIdx + i]->GetData(), pSrcHdrs[i].first, pSrcHdrs[i].second);
+    }
+
+    return (lNumAllocated == pSrcHdrs.size());
+  }
+
+  // Allocate multiple data messages of given sizes, taking the data lock only once.
+  // New messages are appended to pDstMsgs. Returns false if not all messages could be allocated.
+  inline
+  bool newDataMessages(const std::vector<std::size_t> &pSizes, std::vector<FairMQMessagePtr> &pDstMsgs) {
+    assert(mDataMemRes);
+    std::scoped_lock lock(mDataLock);
+    return (mDataMemRes->NewFairMQMessages(pSizes, std::back_inserter(pDstMsgs)) == pSizes.size());
+  }
+
+  inline
+  bool newDataMessages(const std::vector<FairMQMessagePtr> &pSrcMsgs, std::vector<FairMQMessagePtr> &pDstMsgs) {
+
+    static thread_local std::vector<std::size_t> sSizes;
+    sSizes.clear();
+    for (const auto &lOrigMsg : pSrcMsgs) {
+      sSizes.push_back(lOrigMsg->GetSize());
+    }
+
+    // create a new instance to support passing the same vect as in and out
+    std::vector<FairMQMessagePtr> lNewMsgs;
+    lNewMsgs.reserve(pSrcMsgs.size());
+
+    // allocate under one lock
+    if (!newDataMessages(sSizes, lNewMsgs)) {
+      return false;
+    }
+
+    // copy without holding allocator lock
+    for (std::size_t i = 0; i < lNewMsgs.size(); i++) {
       memcpy(lNewMsgs[i]->GetData(), pSrcMsgs[i]->GetData(), pSrcMsgs[i]->GetSize());
     }
 
     pDstMsgs = std::move(lNewMsgs);
+    return true;
   }
 
   template <typename OutIter>
@@ -0,0 +1,114 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ALICEO2_PROTOBUF_POOL_H_
+#define ALICEO2_PROTOBUF_POOL_H_
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/message_lite.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace o2::DataDistribution
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// ProtobufArenaPool
+////////////////////////////////////////////////////////////////////////////////
+
+///
+/// Reusable protobuf message of one thread (STF metadata). Messages are created in an arena, so that
+/// thousands of repeated entries are bump allocated, and freed at once when the next message is acquired.
+/// The arena block grows to the largest message seen, and is kept between messages.
+/// Also keeps the serialization buffer of the thread.
+/// Not thread safe: use one pool for each thread.
+///
+template <typename T>
+class ProtobufArenaPool
+{
+public:
+  explicit ProtobufArenaPool(const std::size_t pBlockSize = (1ULL << 20))
+  {
+    resize(pBlockSize);
+  }
+
+  ProtobufArenaPool(const ProtobufArenaPool&) = delete;
+  ProtobufArenaPool& operator=(const ProtobufArenaPool&) = delete;
+
+  /// New empty message. Invalidates the previous message of the pool.
+  T& acquire()
+  {
+    mMsg = nullptr;
+
+    const auto lAllocated = mArena->SpaceAllocated();
+    if (lAllocated > mBlockSize) {
+      // keep one block large enough for the next message
+      resize(std::max(lAllocated, 2 * mBlockSize));
+    } else {
+      mArena->Reset();
+    }
+
+    mMsg = google::protobuf::Arena::CreateMessage<T>(mArena.get());
+    return *mMsg;
+  }
+
+  /// Serialize the message into the reusable buffer of the pool
+  const std::string& serialize(const T &pMsg)
+  {
+    mBuffer.clear();
+    pMsg.AppendToString(&mBuffer);
+    return mBuffer;
+  }
+
+  /// Reusable buffer (valid until the next serialize() call)
+  std::string& buffer() { return mBuffer; }
+
+  std::size_t blockSize() const { return mBlockSize; }
+
+private:
+  void resize(const std::size_t pBlockSize)
+  {
+    mArena.reset();
+
+    mBlockSize = pBlockSize;
+    mBlock = std::make_unique<char[]>(mBlockSize);
+
+    google::protobuf::ArenaOptions lOptions;
+    lOptions.initial_block = mBlock.get();
+    lOptions.initial_block_size = mBlockSize;
+    mArena = std::make_unique<google::protobuf::Arena>(lOptions);
+  }
+
+  std::size_t mBlockSize = 0;
+  std::unique_ptr<char[]> mBlock;
+  std::unique_ptr<google::protobuf::Arena> mArena;
+
+  T *mMsg = nullptr;
+  std::string mBuffer;
+};
+
+/// Parse into the message without clearing it first. Keeps the submessages set with
+/// unsafe_arena_set_allocated_*(), e.g. to parse a part of an arena message into a heap message.
+inline bool proto_merge_from_array(google::protobuf::MessageLite &pMsg, const void *pData, const std::size_t pSize)
+{
+  google::protobuf::io::CodedInputStream lStream(reinterpret_cast<const std::uint8_t*>(pData), int(pSize));
+  return pMsg.MergeFromCodedStream(&lStream) && lStream.ConsumedEntireMessage();
+}
+
+} /* namespace o2::DataDistribution */
+
+#endif /* ALICEO2_PROTOBUF_POOL_H_ */
@@ -70,6 +70,7 @@ bool SubTimeFrameReadoutBuilder::addHbFrames(
   if (!mStf) {
     mStf = std::make_unique<SubTimeFrame>(pHdr.mTimeFrameId);
     mStf->updateRunNumber(pHdr.mRunNumber);
+    mStf->traceProcessStart(eStfTraceReadoutRecv);
 
     mAcceptStfData = true;
     mFirstFiltered.clear();
@@ -250,6 +251,7 @@ std::optional<std::unique_ptr<SubTimeFrame>> SubTimeFrameReadoutBuilder::addTopo
 
   if (!lStf) {
     lStf = std::make_unique<SubTimeFrame>(sTfId);
+    lStf->traceProcessStart(eStfTraceReadoutRecv);
     lStfNumMessages = 0;
     sTfId++;
 
@@ -428,18 +430,18 @@ void TimeFrameBuilder::allocate_memory(const std::size_t pDataSegSize, const std
   mMemRes.start();
 }
 
-FairMQMessagePtr TimeFrameBuilder::newHeaderMessage(const char *pData, const std::size_t pSize)
+static bool checkTfHeader(const char *pData, const std::size_t pSize)
 {
     if (pSize < sizeof (DataHeader)) {
       EDDLOG_RL(1000, "TimeFrameBuilder: Header size less that DataHeader size={}", pSize);
-      return nullptr;
+      return false;
     }
 
     // Get the DH
-    DataHeader *lDataHdr = const_cast<DataHeader*>(reinterpret_cast<const DataHeader*>(pData));
+    const DataHeader *lDataHdr = reinterpret_cast<const DataHeader*>(pData);
     if (lDataHdr->description != DataHeader::sHeaderType) {
       EDDLOG_RL(1000, "TimeFrameBuilder: Unknown header type {}", lDataHdr->description.as<std::string>());
-      return nullptr;
+      return false;
     }
 
     // quick check for missing DPL header
@@ -447,9 +449,30 @@ FairMQMessagePtr TimeFrameBuilder::newHeaderMessage(const char *pData, const std
       EDDLOG("BUG: TimeFrameBuilder: missing DPL header");
     }
 
+    return true;
+}
+
+FairMQMessagePtr TimeFrameBuilder::newHeaderMessage(const char *pData, const std::size_t pSize)
+{
+    if (!checkTfHeader(pData, pSize)) {
+      return nullptr;
+    }
+
     return mMemRes.newHeaderMessage(pData, pSize);
 }
 
+bool TimeFrameBuilder::newHeaderMessages(const std::vector<std::pair<const void*, std::size_t>> &pSrcHdrs,
+                                         std::vector<FairMQMessagePtr> &pHdrVec)
+{
+    for (const auto &lSrcHdr : pSrcHdrs) {
+      if (!checkTfHeader(reinterpret_cast<const char*>(lSrcHdr.first), lSrcHdr.second)) {
+        return false;
+      }
+    }
+
+    return mMemRes.newHeaderMessages(pSrcHdrs, pHdrVec);
+}
+
 void TimeFrameBuilder::adaptHeaders(SubTimeFrame *pStf)
 {
   if (!pStf || !mMemRes.mHeaderMemRes || !mMemRes.mDataMemRes) {
@@ -173,6 +173,10 @@ class TimeFrameBuilder
 
   FairMQMessagePtr newHeaderMessage(const char *pData, const std::size_t pSize);
 
+  // allocate multiple header messages under a single header region lock
+  bool newHeaderMessages(const std::vector<std::pair<const void*, std::size_t>> &pSrcHdrs,
+                         std::vector<FairMQMessagePtr> &pHdrVec);
+
   inline
   FairMQMessagePtr newDataMessage(const std::size_t pSize) {
     return mMemRes.newDataMessage(pSize);
@@ -184,8 +188,8 @@ class TimeFrameBuilder
   }
 
   inline
-  void newDataMessages(const std::vector<FairMQMessagePtr> &pSrcMsgs, std::vector<FairMQMessagePtr> &pDstMsgs) {
-    mMemRes.newDataMessages(pSrcMsgs, pDstMsgs);
+  bool newDataMessages(const std::vector<FairMQMessagePtr> &pSrcMsgs, std::vector<FairMQMessagePtr> &pDstMsgs) {
+    return mMemRes.newDataMessages(pSrcMsgs, pDstMsgs);
   }
 
   inline void stop() {
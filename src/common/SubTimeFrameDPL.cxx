@@ -103,16 +103,22 @@ void StfToDplAdapter::visit(SubTimeFrame& pStf, void*)
           auto lDhPtr = lMssg.getDataHeaderMutable();
 
           // take all but last data message to reuse the existing hdr message
-          for (std::size_t iSp = 0; iSp < lMssg.mDataParts.size() - 1; iSp += 1) {
+          // allocate copies of the header for all split parts at once
+          const std::size_t lNumSpHdrs = lMssg.mDataParts.size() - 1;
+          mSpHdrSrcs.assign(lNumSpHdrs, { lMssg.mHeader->GetData(), lMssg.mHeader->GetSize() });
+          mSpHdrs.clear();
+          if (!mMemRes.newHeaderMessages(mSpHdrSrcs, mSpHdrs)) {
+            throw std::bad_alloc();
+          }
+
+          for (std::size_t iSp = 0; iSp < lNumSpHdrs; iSp += 1) {
             auto &lDataMsg = lMssg.mDataParts[iSp];
-            lDhPtr->splitPayloadIndex = iSp;
-            lDhPtr->splitPayloadParts = lMssg.mDataParts.size();
-            lDhPtr->payloadSize = lDataMsg->GetSize();
-
-            auto lSpHdr = mMemRes.newHeaderMessage(lMssg.mHeader->GetData(), lMssg.mHeader->GetSize());
-            if (!lSpHdr) {
-              throw std::bad_alloc();
-            }
+            auto &lSpHdr = mSpHdrs[iSp];
+            auto lSpDhPtr = reinterpret_cast<DataHeader*>(lSpHdr->GetData());
+            lSpDhPtr->splitPayloadIndex = iSp;
+            lSpDhPtr->splitPayloadParts = lMssg.mDataParts.size();
+            lSpDhPtr->payloadSize = lDataMsg->GetSize();
+
             mMessages.push_back(std::move(lSpHdr));
             mMessages.push_back(std::move(lDataMsg));
           }
@@ -357,8 +363,8 @@ void DplToStfAdapter::visit(SubTimeFrame& pStf, void*)
       auto& lHdrMsg = mMessages[i + 0];
       auto& lDataMsg = mMessages[i + 1];
 
-      // check for DD STF header
-      if (!lStfHeaderFound && (sizeof(SubTimeFrame::Header) == lDataMsg->GetSize())) {
+      // check for DD STF header (the size depends on the version of the peer, see Header::copyFromRaw())
+      if (!lStfHeaderFound && (gDataDescSubTimeFrame == lHdrPtr->dataDescription)) {
         if (lHdrMsg->GetSize() < sizeof(o2::header::DataHeader)) {
           EDDLOG("DPL interface: cannot find DataHeader in header stack");
           mMessages.clear();
@@ -370,7 +376,12 @@ void DplToStfAdapter::visit(SubTimeFrame& pStf, void*)
       // check if StfHeader
       if (gDataDescSubTimeFrame == lHdrPtr->dataDescription) {
         // copy the contents
-        std::memcpy(&pStf.mHeader, lDataMsg->GetData(), sizeof(SubTimeFrame::Header));
+        if (!pStf.mHeader.copyFromRaw(lDataMsg->GetData(), lDataMsg->GetSize())) {
+          EDDLOG("DPL interface: invalid SubTimeFrame::Header size={}", lDataMsg->GetSize());
+          mMessages.clear();
+          pStf.clear();
+          throw std::runtime_error("SubTimeFrame::Header size");
+        }
         lStfHeaderFound = true;
       } else {
         // Insert ordinary (single) message
@@ -68,6 +68,10 @@ class StfToDplAdapter : public ISubTimeFrameVisitor
   std::vector<FairMQMessagePtr> mMessages;
   FairMQChannel& mChan;
   SyncMemoryResources& mMemRes;
+
+  // split-payload header copies, allocated in batches
+  std::vector<std::pair<const void*, std::size_t>> mSpHdrSrcs;
+  std::vector<FairMQMessagePtr> mSpHdrs;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -126,6 +126,11 @@ void SubTimeFrame::mergeStf(std::unique_ptr<SubTimeFrame> pStf, const std::strin
     mHeader = pStf->header();
   }
 
+  // the TF is as late as its last STF
+  if (pStf->trace().lastTimeNs() > mHeader.mTrace.lastTimeNs()) {
+    mHeader.mTrace = pStf->trace();
+  }
+
   // make sure header values match
   if (mHeader.mOrigin != pStf->header().mOrigin) {
     EDDLOG_RL(5000, "Merging STFs error: STF origins do not match origin={} new_origin={} new_stfs_id={}",
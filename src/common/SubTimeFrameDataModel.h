@@ -17,6 +17,7 @@
 #include "Utilities.h"
 #include "DataModelUtils.h"
 #include "ReadoutDataModel.h"
+#include "StfTrace.h"
 
 #include <Headers/DataHeader.h>
 
@@ -24,6 +25,9 @@
 #include <map>
 #include <unordered_set>
 #include <stdexcept>
+#include <cstddef>
+#include <cstring>
+#include <memory>
 
 #include <functional>
 
@@ -313,10 +317,29 @@ class SubTimeFrame : public IDataModelObject
       eNull
     } mOrigin = eInvalid;
     std::uint64_t mCreationTimeMs = sInvalidTimeMs; // miliseconds since unix epoch
+    StfTrace mTrace;
+
+    // size of the header without the trace (peers built before the trace was added)
+    static constexpr std::size_t sSizeNoTrace = 32;
 
     Header() = default;
     explicit Header(TimeFrameIdType pId)
     : mId(pId) { }
+
+    /// Copy the raw header of a peer. The size identifies the header version: a header without the trace,
+    /// or with a different trace layout, only sets the fields before the trace. Returns false if too short.
+    bool copyFromRaw(const void *pData, const std::size_t pSize)
+    {
+      if (pSize == sizeof(Header)) {
+        std::memcpy(static_cast<void*>(this), pData, sizeof(Header));
+        return true;
+      } else if (pSize >= sSizeNoTrace) {
+        *this = Header();
+        std::memcpy(static_cast<void*>(this), pData, sSizeNoTrace);
+        return true;
+      }
+      return false;
+    }
   };
 
   const Header& header() const { return mHeader; }
@@ -385,6 +408,13 @@ public:
     mHeader.mCreationTimeMs = pTimeMs;
   }
 
+  const StfTrace& trace() const { return mHeader.mTrace; }
+  void traceStamp(const StfTraceStage pStage) { mHeader.mTrace.stamp(pStage); }
+  void traceHop(const StfTraceStage pStage) { mHeader.mTrace.stampHop(pStage); }
+  void traceProcessStart(const StfTraceStage pStage, const std::uint64_t pTimeNs = StfTrace::now()) {
+    mHeader.mTrace.stampProcessStart(pStage, pTimeNs);
+  }
+
 private:
   ///
   /// helper methods
@@ -458,6 +488,17 @@ private:
 
 };
 
+static_assert(offsetof(SubTimeFrame::Header, mTrace) == SubTimeFrame::Header::sSizeNoTrace,
+  "Fields of SubTimeFrame::Header before the trace must keep the layout of the header without the trace");
+
+/// Trace the pipeline hops of STFs (see IFifoPipeline)
+inline void pipeline_trace_hop(std::unique_ptr<SubTimeFrame> &pStf, const bool pDequeue)
+{
+  if (pStf) {
+    pStf->traceHop(pDequeue ? eStfTracePipeDequeue : eStfTracePipeQueue);
+  }
+}
+
 } /* o2::DataDistribution */
 
 namespace std
@@ -13,6 +13,8 @@
 
 #include "SubTimeFrameFile.h"
 
+#include <iterator>
+
 namespace o2
 {
 namespace DataDistribution
@@ -58,5 +60,51 @@ std::ostream& operator<<(std::ostream& pStream, const SubTimeFrameFileDataIndex&
   return pStream.write(reinterpret_cast<const char*>(pIndex.mDataIndex.data()),
                        pIndex.mDataIndex.size() * sizeof(SubTimeFrameFileDataIndex::DataIndexElem));
 }
+
+////////////////////////////////////////////////////////////////////////////////
+/// SubTimeFrameFileDirectory
+////////////////////////////////////////////////////////////////////////////////
+
+const o2::header::DataDescription SubTimeFrameFileDirectory::sDataDescFileStfDirectory{ "FILE_STF_DIR" };
+
+std::uint64_t SubTimeFrameFileDirectory::originBit(const o2::header::DataOrigin &pOrigin)
+{
+  // NOTE: append only, the bit positions are stored in files
+  static const o2::header::DataOrigin sOrigins[] = {
+    gDataOriginACO, gDataOriginCPV, gDataOriginCTP, gDataOriginEMC, gDataOriginFT0, gDataOriginFV0,
+    gDataOriginFDD, gDataOriginHMP, gDataOriginITS, gDataOriginMCH, gDataOriginMFT, gDataOriginMID,
+    gDataOriginPHS, gDataOriginTOF, gDataOriginTPC, gDataOriginTRD, gDataOriginZDC, gDataOriginTST
+  };
+
+  for (std::size_t i = 0; i < std::size(sOrigins); i++) {
+    if (sOrigins[i] == pOrigin) {
+      return std::uint64_t(1) << i;
+    }
+  }
+
+  return std::uint64_t(1) << 63;
+}
+
+std::ostream& operator<<(std::ostream& pStream, const SubTimeFrameFileDirectory& pDir)
+{
+  static_assert(std::is_standard_layout<SubTimeFrameFileDirectory::Entry>::value,
+                "SubTimeFrameFileDirectory::Entry must be a std layout type.");
+
+  // write DataHeader
+  const o2::header::DataHeader lDataHeader = pDir.getDataHeader();
+  pStream.write(reinterpret_cast<const char*>(&lDataHeader), sizeof(o2::header::DataHeader));
+
+  // write the directory
+  pStream.write(reinterpret_cast<const char*>(pDir.mEntries.data()),
+                pDir.mEntries.size() * sizeof(SubTimeFrameFileDirectory::Entry));
+
+  // write the footer
+  SubTimeFrameFileFooter lFooter;
+  lFooter.mNumStfs = pDir.mEntries.size();
+  lFooter.mDirectoryOffset = std::uint64_t(pStream.tellp()) - sizeof(o2::header::DataHeader) -
+    (pDir.mEntries.size() * sizeof(SubTimeFrameFileDirectory::Entry));
+
+  return pStream.write(reinterpret_cast<const char*>(&lFooter), sizeof(SubTimeFrameFileFooter));
+}
 }
 } /* o2::DataDistribution */
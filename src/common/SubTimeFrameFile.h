@@ -15,6 +15,7 @@
 #define ALICEO2_SUBTIMEFRAME_FILE_H_
 
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <ostream>
 #include <sstream>
@@ -48,15 +49,20 @@ struct SubTimeFrameFileMeta {
     return lHdr;
   }
 
-  static constexpr std::uint64_t getSizeInFile()
-  {
-    return sizeof(o2::header::DataHeader) + sizeof(SubTimeFrameFileMeta);
-  }
+  /// Size of the meta in file, including the DataHeader and the SubTimeFrameFileStfOrder header
+  static constexpr std::uint64_t getSizeInFile();
 
   ///
   /// Version of STF file format
+  ///  1: raw data blocks
+  ///  2: data blocks can be compressed (SubTimeFrameFileBlockCodec header follows the DataHeader),
+  ///     index records the uncompressed size
+  ///  3: STF id and order of the STF in the sink (multiple writer streams), recorded in the
+  ///     SubTimeFrameFileStfOrder header following the meta DataHeader
+  ///  4: index records the checksum of data blocks of each equipment
   ///
-  const std::uint64_t mStfFileVersion = 1;
+  static constexpr std::uint64_t sStfFileVersion = 4;
+  std::uint64_t mStfFileVersion = sStfFileVersion;
 
   ///
   /// Size of the Stf in file, including this header.
@@ -68,6 +74,15 @@ struct SubTimeFrameFileMeta {
   ///
   std::uint64_t mWriteTimeMs;
 
+  ///
+  /// Order of the Stf in the sink. Files of parallel writer streams can be merged by the sequence.
+  ///
+  struct StfOrder {
+    std::uint64_t mSequence = 0;
+    std::uint32_t mStreamIdx = 0;
+    std::uint32_t mNumStreams = 1;
+  };
+
   auto getTimePoint()
   {
     using namespace std::chrono;
@@ -102,6 +117,35 @@ struct SubTimeFrameFileMeta {
 
 std::ostream& operator<<(std::ostream& pStream, const SubTimeFrameFileMeta& pMeta);
 
+static_assert(sizeof(SubTimeFrameFileMeta) == 24,
+              "SubTimeFrameFileMeta changed -> Binary compatibility is lost!");
+
+///
+/// Id and order of the Stf in the sink (file version 3). Follows the DataHeader in the meta header stack,
+/// so readers of older versions skip it together with the header stack.
+///
+struct SubTimeFrameFileStfOrder : public o2::header::BaseHeader {
+  static constexpr o2::header::HeaderType sHeaderType = o2::header::String2<std::uint64_t>("StfOrder");
+  static constexpr std::uint32_t sVersion = 1;
+
+  std::uint64_t mStfId = 0;
+  SubTimeFrameFileMeta::StfOrder mOrder;
+
+  SubTimeFrameFileStfOrder(const std::uint64_t pStfId, const SubTimeFrameFileMeta::StfOrder &pOrder)
+    : BaseHeader(sizeof(SubTimeFrameFileStfOrder), sHeaderType, o2::header::gSerializationMethodNone, sVersion),
+      mStfId(pStfId),
+      mOrder(pOrder)
+  {
+    static_assert(sizeof(SubTimeFrameFileStfOrder) == 56,
+                  "SubTimeFrameFileStfOrder changed -> Binary compatibility is lost!");
+  }
+};
+
+constexpr std::uint64_t SubTimeFrameFileMeta::getSizeInFile()
+{
+  return sizeof(o2::header::DataHeader) + sizeof(SubTimeFrameFileStfOrder) + sizeof(SubTimeFrameFileMeta);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// SubTimeFrameFileDataIndex
 ////////////////////////////////////////////////////////////////////////////////
@@ -121,20 +165,28 @@ struct SubTimeFrameFileDataIndex {
     std::uint64_t mOffset = 0;
     /// Total size of data blocks including headers
     std::uint64_t mSize = 0;
+    /// Total size of data blocks including headers, with uncompressed payloads (version 2)
+    std::uint64_t mUncompressedSize = 0;
+    /// Checksum of data blocks including headers, as written in the file (version 4)
+    std::uint32_t mChecksumType = 0; // StfFileChecksum
+    std::uint32_t mChecksum = 0;
 
     DataIndexElem() = delete;
     DataIndexElem(const EquipmentIdentifier& pId,
                   const std::uint32_t pCnt,
                   const std::uint64_t pOff,
-                  const std::uint64_t pSize)
+                  const std::uint64_t pSize,
+                  const std::uint64_t pUncompressedSize)
       : mDataDescription(pId.mDataDescription),
         mDataOrigin(pId.mDataOrigin),
         mDataBlockCnt(pCnt),
         mSubSpecification(pId.mSubSpecification),
         mOffset(pOff),
-        mSize(pSize)
+        mSize(pSize),
+        mUncompressedSize(pUncompressedSize)
     {
-      static_assert(sizeof(DataIndexElem) == 48,
+      // NOTE: version 1 elements are 48B (without mUncompressedSize), versions 2-3 are 56B (without checksum)
+      static_assert(sizeof(DataIndexElem) == 64,
                     "DataIndexElem changed -> Binary compatibility is lost!");
     }
   };
@@ -147,9 +199,10 @@ struct SubTimeFrameFileDataIndex {
   void AddStfElement(const EquipmentIdentifier& pEqDataId,
                      const std::uint32_t pCnt,
                      const std::uint64_t pOffset,
-                     const std::uint64_t pSize)
+                     const std::uint64_t pSize,
+                     const std::uint64_t pUncompressedSize)
   {
-    mDataIndex.emplace_back(pEqDataId, pCnt, pOffset, pSize);
+    mDataIndex.emplace_back(pEqDataId, pCnt, pOffset, pSize, pUncompressedSize);
   }
 
   std::uint64_t getSizeInFile() const
@@ -157,9 +210,9 @@ struct SubTimeFrameFileDataIndex {
     return sizeof(o2::header::DataHeader) + (sizeof(DataIndexElem) * mDataIndex.size());
   }
 
-  friend std::ostream& operator<<(std::ostream& pStream, const SubTimeFrameFileDataIndex& pIndex);
+  std::vector<DataIndexElem>& elements() noexcept { return mDataIndex; }
+  const std::vector<DataIndexElem>& elements() const noexcept { return mDataIndex; }
 
- private:
   const o2::header::DataHeader getDataHeader() const
   {
     auto lHdr = o2::header::DataHeader(
@@ -173,10 +226,138 @@ struct SubTimeFrameFileDataIndex {
     return lHdr;
   }
 
+  friend std::ostream& operator<<(std::ostream& pStream, const SubTimeFrameFileDataIndex& pIndex);
+
+ private:
   std::vector<DataIndexElem> mDataIndex;
 };
 
 std::ostream& operator<<(std::ostream& pStream, const SubTimeFrameFileDataIndex& pIndex);
+
+/// Checksum of data blocks of an equipment, recorded in the index (version 4)
+enum StfFileChecksum : std::uint32_t {
+  eStfFileChecksumNone = 0,
+  eStfFileChecksumCrc32c = 1
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// SubTimeFrameFileDirectory
+////////////////////////////////////////////////////////////////////////////////
+
+///
+/// Directory of all Stfs in the file, written in the file footer when the file is closed:
+///   <DataHeader, Entry[]> SubTimeFrameFileFooter
+/// The fixed size SubTimeFrameFileFooter is at the end of the file. Files without the footer are scanned.
+///
+struct SubTimeFrameFileDirectory {
+  static const o2::header::DataDescription sDataDescFileStfDirectory;
+
+  struct Entry {
+    std::uint64_t mStfId = 0;
+    /// Offset of the Stf (meta DataHeader) in the file
+    std::uint64_t mOffset = 0;
+    /// Size of the Stf in the file
+    std::uint64_t mSize = 0;
+    /// Data origins present in the Stf (see originBit())
+    std::uint64_t mOriginMask = 0;
+    std::uint32_t mFirstOrbit = 0;
+    std::uint32_t mReserved = 0;
+
+    bool hasOrigin(const o2::header::DataOrigin &pOrigin) const { return mOriginMask & originBit(pOrigin); }
+  };
+
+  /// Bit of the detector origin in the mask. All other origins share the highest bit.
+  static std::uint64_t originBit(const o2::header::DataOrigin &pOrigin);
+
+  SubTimeFrameFileDirectory() = default;
+
+  void clear() noexcept { mEntries.clear(); }
+  bool empty() const noexcept { return mEntries.empty(); }
+
+  void addStf(const Entry &pEntry) { mEntries.push_back(pEntry); }
+
+  std::vector<Entry>& entries() noexcept { return mEntries; }
+  const std::vector<Entry>& entries() const noexcept { return mEntries; }
+
+  const o2::header::DataHeader getDataHeader() const
+  {
+    auto lHdr = o2::header::DataHeader(
+      sDataDescFileStfDirectory,
+      o2::header::gDataOriginAny,
+      0, // subspecification: not used
+      mEntries.size() * sizeof(Entry));
+
+    lHdr.payloadSerializationMethod = o2::header::gSerializationMethodNone;
+
+    return lHdr;
+  }
+
+  friend std::ostream& operator<<(std::ostream& pStream, const SubTimeFrameFileDirectory& pDir);
+
+ private:
+  std::vector<Entry> mEntries;
+};
+
+std::ostream& operator<<(std::ostream& pStream, const SubTimeFrameFileDirectory& pDir);
+
+struct SubTimeFrameFileFooter {
+  static constexpr const char sMagic[8] = { 'S', 'T', 'F', 'F', 'O', 'O', 'T', 'R' };
+  static constexpr std::uint32_t sVersion = 1;
+
+  /// Offset of the directory (DataHeader) in the file. Stf data ends here.
+  std::uint64_t mDirectoryOffset = 0;
+  std::uint64_t mNumStfs = 0;
+  std::uint32_t mVersion = sVersion;
+  std::uint32_t mEntrySize = sizeof(SubTimeFrameFileDirectory::Entry);
+  char mMagic[8] = { 'S', 'T', 'F', 'F', 'O', 'O', 'T', 'R' };
+
+  bool valid() const { return std::memcmp(mMagic, sMagic, sizeof(sMagic)) == 0; }
+
+  /// Size of the directory and the footer
+  std::uint64_t getSizeInFile() const
+  {
+    return sizeof(o2::header::DataHeader) + mNumStfs * mEntrySize + sizeof(SubTimeFrameFileFooter);
+  }
+};
+
+static_assert(sizeof(SubTimeFrameFileDirectory::Entry) == 40,
+              "SubTimeFrameFileDirectory::Entry changed -> Binary compatibility is lost!");
+static_assert(sizeof(SubTimeFrameFileFooter) == 32,
+              "SubTimeFrameFileFooter changed -> Binary compatibility is lost!");
+
+////////////////////////////////////////////////////////////////////////////////
+/// SubTimeFrameFileBlockCodec
+////////////////////////////////////////////////////////////////////////////////
+
+enum StfFileCodec : std::uint32_t {
+  eStfFileCodecNone = 0,
+  eStfFileCodecLz4 = 1,
+  eStfFileCodecZstd = 2
+};
+
+///
+/// Header of a compressed data block (file version 2). Follows the DataHeader in the header stack.
+/// The DataHeader::payloadSize of the block in file is the compressed size.
+///
+struct SubTimeFrameFileBlockCodec : public o2::header::BaseHeader {
+  static constexpr o2::header::HeaderType sHeaderType = o2::header::String2<std::uint64_t>("StfCodec");
+  static constexpr std::uint32_t sVersion = 1;
+
+  /// StfFileCodec
+  std::uint32_t mCodec = eStfFileCodecNone;
+  std::uint32_t mReserved = 0;
+  /// Size of the payload after decompression
+  std::uint64_t mUncompressedSize = 0;
+
+  SubTimeFrameFileBlockCodec(const StfFileCodec pCodec, const std::uint64_t pUncompressedSize)
+    : BaseHeader(sizeof(SubTimeFrameFileBlockCodec), sHeaderType, o2::header::gSerializationMethodNone, sVersion),
+      mCodec(pCodec),
+      mUncompressedSize(pUncompressedSize)
+  {
+    static_assert(sizeof(SubTimeFrameFileBlockCodec) == 48,
+                  "SubTimeFrameFileBlockCodec changed -> Binary compatibility is lost!");
+  }
+};
 }
 } /* o2::DataDistribution */
 
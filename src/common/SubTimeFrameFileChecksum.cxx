@@ -0,0 +1,146 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SubTimeFrameFileChecksum.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace o2::DataDistribution
+{
+
+std::string to_string(const StfFileChecksum pChecksum)
+{
+  switch (pChecksum)
+  {
+    case eStfFileChecksumNone:
+      return "none";
+    case eStfFileChecksumCrc32c:
+      return "crc32c";
+    default:
+      return "invalid";
+  }
+}
+
+namespace {
+
+// slicing-by-8 tables of the reflected Castagnoli polynomial
+using Crc32cTables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+static const Crc32cTables sCrc32cTables = []() {
+  Crc32cTables lTables{};
+
+  for (std::uint32_t i = 0; i < 256; i++) {
+    std::uint32_t lCrc = i;
+    for (int j = 0; j < 8; j++) {
+      lCrc = (lCrc >> 1) ^ ((lCrc & 1) ? 0x82F63B78u : 0u);
+    }
+    lTables[0][i] = lCrc;
+  }
+
+  for (std::uint32_t i = 0; i < 256; i++) {
+    for (std::size_t t = 1; t < 8; t++) {
+      lTables[t][i] = (lTables[t - 1][i] >> 8) ^ lTables[0][lTables[t - 1][i] & 0xFF];
+    }
+  }
+
+  return lTables;
+}();
+
+static std::uint32_t crc32cSoftware(std::uint32_t pCrc, const unsigned char *pData, std::size_t pSize)
+{
+  const auto &T = sCrc32cTables;
+
+  while (pSize >= 8) {
+    std::uint64_t lWord;
+    std::memcpy(&lWord, pData, sizeof(lWord));
+    lWord ^= pCrc;
+
+    pCrc = T[7][lWord & 0xFF] ^ T[6][(lWord >> 8) & 0xFF] ^ T[5][(lWord >> 16) & 0xFF] ^
+           T[4][(lWord >> 24) & 0xFF] ^ T[3][(lWord >> 32) & 0xFF] ^ T[2][(lWord >> 40) & 0xFF] ^
+           T[1][(lWord >> 48) & 0xFF] ^ T[0][(lWord >> 56)];
+
+    pData += 8;
+    pSize -= 8;
+  }
+
+  while (pSize--) {
+    pCrc = (pCrc >> 8) ^ T[0][(pCrc ^ *pData++) & 0xFF];
+  }
+
+  return pCrc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static std::uint32_t crc32cSse42(std::uint32_t pCrc, const unsigned char *pData, std::size_t pSize)
+{
+  std::uint64_t lCrc = pCrc;
+
+  while (pSize >= 8) {
+    std::uint64_t lWord;
+    std::memcpy(&lWord, pData, sizeof(lWord));
+    lCrc = _mm_crc32_u64(lCrc, lWord);
+    pData += 8;
+    pSize -= 8;
+  }
+
+  while (pSize--) {
+    lCrc = _mm_crc32_u8(std::uint32_t(lCrc), *pData++);
+  }
+
+  return std::uint32_t(lCrc);
+}
+
+static const bool sCrc32cSse42 = __builtin_cpu_supports("sse4.2");
+#else
+static const bool sCrc32cSse42 = false;
+#endif
+
+} /* namespace */
+
+bool crc32cHardware()
+{
+  return sCrc32cSse42;
+}
+
+std::uint32_t crc32c(const std::uint32_t pCrc, const void *pData, std::size_t pSize)
+{
+  const auto *lData = reinterpret_cast<const unsigned char*>(pData);
+
+#if defined(__x86_64__)
+  if (sCrc32cSse42) {
+    return ~crc32cSse42(~pCrc, lData, pSize);
+  }
+#endif
+
+  return ~crc32cSoftware(~pCrc, lData, pSize);
+}
+
+bool verifyChecksum(const SubTimeFrameFileDataIndex::DataIndexElem &pElem, const char *pDataStart)
+{
+  switch (StfFileChecksum(pElem.mChecksumType)) {
+    case eStfFileChecksumNone:
+      return true;
+    case eStfFileChecksumCrc32c:
+      return crc32c(0, pDataStart + pElem.mOffset, pElem.mSize) == pElem.mChecksum;
+    default:
+      return false;
+  }
+}
+
+} /* o2::DataDistribution */
@@ -0,0 +1,41 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ALICEO2_SUBTIMEFRAME_FILE_CHECKSUM_H_
+#define ALICEO2_SUBTIMEFRAME_FILE_CHECKSUM_H_
+
+#include "SubTimeFrameFile.h"
+
+#include <cstdint>
+#include <string>
+
+namespace o2::DataDistribution
+{
+
+std::string to_string(const StfFileChecksum pChecksum);
+
+///
+/// CRC32C (Castagnoli). Uses the SSE4.2 crc32 instruction when the CPU supports it.
+/// Checksums can be extended: crc32c(crc32c(0, a), b) == crc32c(0, a|b)
+///
+std::uint32_t crc32c(const std::uint32_t pCrc, const void *pData, std::size_t pSize);
+
+/// Is the CRC32C computed in hardware
+bool crc32cHardware();
+
+/// Verify the checksum of the index element. pDataStart points to the first data block of the Stf.
+bool verifyChecksum(const SubTimeFrameFileDataIndex::DataIndexElem &pElem, const char *pDataStart);
+
+} /* o2::DataDistribution */
+
+#endif /* ALICEO2_SUBTIMEFRAME_FILE_CHECKSUM_H_ */
@@ -0,0 +1,308 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SubTimeFrameFileCodec.h"
+#include "DataDistLogger.h"
+
+#include <boost/algorithm/string.hpp>
+
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(DATADIST_WITH_LZ4)
+#include <lz4.h>
+#endif
+
+#if defined(DATADIST_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace o2::DataDistribution
+{
+
+std::istream& operator>>(std::istream& in, StfFileCodec& pRetVal)
+{
+  std::string token;
+  in >> token;
+
+  if (token == "none") {
+    pRetVal = eStfFileCodecNone;
+  } else if (token == "lz4") {
+    pRetVal = eStfFileCodecLz4;
+  } else if (token == "zstd") {
+    pRetVal = eStfFileCodecZstd;
+  } else {
+    in.setstate(std::ios_base::failbit);
+  }
+  return in;
+}
+
+std::string to_string(const StfFileCodec pCodec)
+{
+  switch (pCodec)
+  {
+    case eStfFileCodecNone:
+      return "none";
+    case eStfFileCodecLz4:
+      return "lz4";
+    case eStfFileCodecZstd:
+      return "zstd";
+    default:
+      return "invalid";
+  }
+}
+
+bool codecAvailable(const StfFileCodec pCodec)
+{
+  switch (pCodec)
+  {
+    case eStfFileCodecNone:
+      return true;
+    case eStfFileCodecLz4:
+#if defined(DATADIST_WITH_LZ4)
+      return true;
+#else
+      return false;
+#endif
+    case eStfFileCodecZstd:
+#if defined(DATADIST_WITH_ZSTD)
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return false;
+  }
+}
+
+bool decompressBlock(const StfFileCodec pCodec, const char *pSrc, const std::size_t pSrcSize,
+                     char *pDst, const std::size_t pDstSize)
+{
+  switch (pCodec)
+  {
+    case eStfFileCodecNone:
+    {
+      if (pSrcSize != pDstSize) {
+        return false;
+      }
+      std::memcpy(pDst, pSrc, pSrcSize);
+      return true;
+    }
+#if defined(DATADIST_WITH_LZ4)
+    case eStfFileCodecLz4:
+    {
+      if (pSrcSize > std::size_t(std::numeric_limits<int>::max()) || pDstSize > std::size_t(LZ4_MAX_INPUT_SIZE)) {
+        return false;
+      }
+      const int lRet = LZ4_decompress_safe(pSrc, pDst, int(pSrcSize), int(pDstSize));
+      return (lRet >= 0) && (std::size_t(lRet) == pDstSize);
+    }
+#endif
+#if defined(DATADIST_WITH_ZSTD)
+    case eStfFileCodecZstd:
+    {
+      thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> tDCtx(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+
+      const std::size_t lRet = ZSTD_decompressDCtx(tDCtx.get(), pDst, pDstSize, pSrc, pSrcSize);
+      return !ZSTD_isError(lRet) && (lRet == pDstSize);
+    }
+#endif
+    default:
+      EDDLOG_RL(1000, "FileReader: data block codec is not supported by this build. codec={}", to_string(pCodec));
+      return false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// StfFileCodecConfig
+////////////////////////////////////////////////////////////////////////////////
+
+StfFileCodecConfig StfFileCodecConfig::parse(const std::string &pCodecs, const int pLevel)
+{
+  StfFileCodecConfig lConfig;
+
+  if (pLevel < sMinLevel || pLevel > sMaxLevel) {
+    throw std::out_of_range("Compression level must be in [" + std::to_string(sMinLevel) + ", " +
+      std::to_string(sMaxLevel) + "]: " + std::to_string(pLevel));
+  }
+  lConfig.mLevel = pLevel;
+
+  std::vector<std::string> lTokens;
+  boost::split(lTokens, pCodecs, boost::is_any_of(","));
+
+  for (auto &lToken : lTokens) {
+    boost::trim(lToken);
+    if (lToken.empty()) {
+      continue;
+    }
+
+    const auto lSepPos = lToken.find(':');
+    if (lSepPos == std::string::npos) {
+      throw std::invalid_argument("Expected <origin>:<codec> pair: " + lToken);
+    }
+
+    const auto lOriginStr = boost::to_upper_copy(boost::trim_copy(lToken.substr(0, lSepPos)));
+    StfFileCodec lCodec;
+    std::istringstream lCodecStream(boost::trim_copy(lToken.substr(lSepPos + 1)));
+    if (!(lCodecStream >> lCodec)) {
+      throw std::invalid_argument("Unknown codec (none, lz4, zstd): " + lToken);
+    }
+
+    if (lOriginStr == "*") {
+      lConfig.mDefaultCodec = lCodec;
+      continue;
+    }
+
+    if (lOriginStr.empty() || lOriginStr.size() > 3) {
+      throw std::invalid_argument("Invalid data origin: " + lToken);
+    }
+
+    o2::header::DataOrigin lOrigin;
+    lOrigin.runtimeInit(lOriginStr.c_str());
+    lConfig.mOriginCodecs[lOrigin] = lCodec;
+  }
+
+  return lConfig;
+}
+
+std::string StfFileCodecConfig::to_string() const
+{
+  std::string lRet = "*:" + o2::DataDistribution::to_string(mDefaultCodec);
+  for (const auto &lOriginCodec : mOriginCodecs) {
+    lRet += "," + lOriginCodec.first.as<std::string>() + ":" + o2::DataDistribution::to_string(lOriginCodec.second);
+  }
+  return lRet;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// SubTimeFrameFileCompressor
+////////////////////////////////////////////////////////////////////////////////
+
+SubTimeFrameFileCompressor::SubTimeFrameFileCompressor(const StfFileCodecConfig &pConfig, const unsigned pNumThreads)
+  : mConfig(pConfig)
+{
+  for (unsigned i = 0; i < pNumThreads; i++) {
+    std::string lThreadName = "stf_compress_" + std::to_string(i);
+
+    mThreads.emplace_back(create_thread_member(lThreadName.c_str(), &SubTimeFrameFileCompressor::CompressThread, this, i));
+  }
+
+  DDDLOG("SubTimeFrameFileCompressor started. codecs={} threads={}", mConfig.to_string(), pNumThreads);
+}
+
+SubTimeFrameFileCompressor::~SubTimeFrameFileCompressor()
+{
+  mJobs.stop();
+
+  for (auto &lThread : mThreads) {
+    if (lThread.joinable()) {
+      lThread.join();
+    }
+  }
+}
+
+void SubTimeFrameFileCompressor::compress(const std::vector<Block*> &pBlocks)
+{
+  if (mThreads.empty() || pBlocks.size() == 1) {
+    for (auto lBlock : pBlocks) {
+      compressBlock(*lBlock);
+    }
+    return;
+  }
+
+  Batch lBatch;
+  lBatch.mPending = pBlocks.size();
+
+  for (auto lBlock : pBlocks) {
+    if (!mJobs.push(Job{ lBlock, &lBatch })) {
+      // the pool is stopped
+      compressBlock(*lBlock);
+
+      std::scoped_lock lLock(lBatch.mLock);
+      lBatch.mPending--;
+    }
+  }
+
+  std::unique_lock lLock(lBatch.mLock);
+  lBatch.mDoneCond.wait(lLock, [&lBatch]() { return lBatch.mPending == 0; });
+}
+
+void SubTimeFrameFileCompressor::compressBlock(Block &pBlock) const
+{
+  pBlock.mCompressed.reset();
+  pBlock.mCompressedSize = 0;
+
+  if (pBlock.mSize == 0) {
+    return;
+  }
+
+  switch (pBlock.mCodec)
+  {
+#if defined(DATADIST_WITH_LZ4)
+    case eStfFileCodecLz4:
+    {
+      if (pBlock.mSize > std::size_t(LZ4_MAX_INPUT_SIZE)) {
+        break;
+      }
+      const int lBound = LZ4_compressBound(int(pBlock.mSize));
+      pBlock.mCompressed.reset(new char[lBound]); // not initialized
+
+      const int lRet = LZ4_compress_default(pBlock.mData, pBlock.mCompressed.get(), int(pBlock.mSize), lBound);
+      pBlock.mCompressedSize = (lRet > 0) ? std::size_t(lRet) : 0;
+      break;
+    }
+#endif
+#if defined(DATADIST_WITH_ZSTD)
+    case eStfFileCodecZstd:
+    {
+      thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> tCCtx(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+
+      const std::size_t lBound = ZSTD_compressBound(pBlock.mSize);
+      pBlock.mCompressed.reset(new char[lBound]); // not initialized
+
+      const std::size_t lRet = ZSTD_compressCCtx(tCCtx.get(), pBlock.mCompressed.get(), lBound,
+        pBlock.mData, pBlock.mSize, mConfig.mLevel);
+      pBlock.mCompressedSize = ZSTD_isError(lRet) ? 0 : lRet;
+      break;
+    }
+#endif
+    default:
+      break;
+  }
+
+  // store the block raw if there is no gain
+  if (pBlock.mCompressedSize == 0 || pBlock.mCompressedSize >= pBlock.mSize) {
+    pBlock.mCompressed.reset();
+    pBlock.mCompressedSize = 0;
+  }
+}
+
+void SubTimeFrameFileCompressor::CompressThread(const unsigned pIdx)
+{
+  Job lJob;
+
+  while (mJobs.pop(lJob)) {
+    compressBlock(*lJob.mBlock);
+
+    std::scoped_lock lLock(lJob.mBatch->mLock);
+    if (--lJob.mBatch->mPending == 0) {
+      lJob.mBatch->mDoneCond.notify_one();
+    }
+  }
+
+  DDDLOG("Exiting file compression thread [{}]", pIdx);
+}
+
+} /* o2::DataDistribution */
@@ -0,0 +1,148 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ALICEO2_SUBTIMEFRAME_FILE_CODEC_H_
+#define ALICEO2_SUBTIMEFRAME_FILE_CODEC_H_
+
+#include "SubTimeFrameFile.h"
+#include "ConcurrentQueue.h"
+
+#include <Headers/DataHeader.h>
+
+#include <condition_variable>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace o2::DataDistribution
+{
+
+std::istream& operator>>(std::istream& in, StfFileCodec& pRetVal);
+std::string to_string(const StfFileCodec pCodec);
+
+/// Is the codec compiled in
+bool codecAvailable(const StfFileCodec pCodec);
+
+/// Decompress the block into a buffer of the exact uncompressed size
+bool decompressBlock(const StfFileCodec pCodec, const char *pSrc, const std::size_t pSrcSize,
+                     char *pDst, const std::size_t pDstSize);
+
+////////////////////////////////////////////////////////////////////////////////
+/// StfFileCodecConfig
+////////////////////////////////////////////////////////////////////////////////
+
+struct StfFileCodecConfig {
+  StfFileCodec mDefaultCodec = eStfFileCodecNone;
+  std::unordered_map<o2::header::DataOrigin, StfFileCodec> mOriginCodecs;
+  int mLevel = 1;
+
+  static constexpr int sMinLevel = 1;
+  static constexpr int sMaxLevel = 22;
+
+  /// parse comma separated list of <origin>:<codec> pairs. Origin '*' sets the default codec.
+  /// The zstd level must be in [sMinLevel, sMaxLevel].
+  static StfFileCodecConfig parse(const std::string &pCodecs, const int pLevel = 1); // throws
+
+  StfFileCodec codecFor(const o2::header::DataOrigin &pOrigin) const
+  {
+    const auto lIt = mOriginCodecs.find(pOrigin);
+    return (lIt != mOriginCodecs.end()) ? lIt->second : mDefaultCodec;
+  }
+
+  bool enabled() const
+  {
+    if (mDefaultCodec != eStfFileCodecNone) {
+      return true;
+    }
+    for (const auto &lOriginCodec : mOriginCodecs) {
+      if (lOriginCodec.second != eStfFileCodecNone) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// all selected codecs are compiled in
+  bool available() const
+  {
+    if (!codecAvailable(mDefaultCodec)) {
+      return false;
+    }
+    for (const auto &lOriginCodec : mOriginCodecs) {
+      if (!codecAvailable(lOriginCodec.second)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::string to_string() const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// SubTimeFrameFileCompressor
+////////////////////////////////////////////////////////////////////////////////
+
+/// Pool of threads compressing data blocks of (Sub)TimeFrames before they are written
+class SubTimeFrameFileCompressor
+{
+ public:
+  struct Block {
+    StfFileCodec mCodec = eStfFileCodecNone;
+    const char *mData = nullptr;
+    std::size_t mSize = 0;
+
+    /// compressed payload. Not set if the block is stored raw (no gain, or error)
+    std::unique_ptr<char[]> mCompressed;
+    std::size_t mCompressedSize = 0;
+
+    bool compressed() const { return mCompressedSize > 0; }
+  };
+
+  SubTimeFrameFileCompressor() = delete;
+  SubTimeFrameFileCompressor(const StfFileCodecConfig &pConfig, const unsigned pNumThreads);
+  ~SubTimeFrameFileCompressor();
+
+  const StfFileCodecConfig& config() const { return mConfig; }
+
+  /// Compress the blocks in parallel. Returns when all blocks are done.
+  void compress(const std::vector<Block*> &pBlocks);
+
+ private:
+  struct Batch {
+    std::mutex mLock;
+    std::condition_variable mDoneCond;
+    std::size_t mPending = 0;
+  };
+
+  struct Job {
+    Block *mBlock = nullptr;
+    Batch *mBatch = nullptr;
+  };
+
+  void compressBlock(Block &pBlock) const;
+  void CompressThread(const unsigned pIdx);
+
+  const StfFileCodecConfig mConfig;
+
+  ConcurrentFifo<Job> mJobs;
+  std::vector<std::thread> mThreads;
+};
+
+} /* o2::DataDistribution */
+
+#endif /* ALICEO2_SUBTIMEFRAME_FILE_CODEC_H_ */
@@ -12,11 +12,17 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "SubTimeFrameFile.h"
+#include "SubTimeFrameFileChecksum.h"
+#include "SubTimeFrameFileCodec.h"
 #include "SubTimeFrameFileReader.h"
 #include "SubTimeFrameBuilder.h"
 
 #include "DataDistLogger.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
 #if __linux__
 #include <sys/mman.h>
 #endif
@@ -45,6 +51,292 @@ SubTimeFrameFileReader::SubTimeFrameFileReader(boost::filesystem::path& pFileNam
 #if __linux__
   madvise((void*)mFileMap.data(), mFileMap.size(), MADV_HUGEPAGE | MADV_SEQUENTIAL | MADV_DONTDUMP);
 #endif
+
+  // TF data ends at the directory, if present
+  mHasFooter = readFooter();
+}
+
+bool SubTimeFrameFileReader::readFooter()
+{
+  using Entry = SubTimeFrameFileDirectory::Entry;
+
+  if (mFileSize < (sizeof(DataHeader) + sizeof(SubTimeFrameFileFooter))) {
+    return false;
+  }
+
+  SubTimeFrameFileFooter lFooter;
+  std::memcpy(&lFooter, mFileMap.data() + mFileSize - sizeof(SubTimeFrameFileFooter), sizeof(SubTimeFrameFileFooter));
+
+  if (!lFooter.valid()) {
+    return false; // legacy file
+  }
+
+  if (lFooter.mEntrySize != sizeof(Entry) || (lFooter.mDirectoryOffset + lFooter.getSizeInFile()) != mFileSize) {
+    WDDLOG("FileReader: invalid TF directory footer. file={} dir_offset={} num_tfs={} entry_size={} file_size={}",
+      mFileName, lFooter.mDirectoryOffset, lFooter.mNumStfs, lFooter.mEntrySize, mFileSize);
+    return false;
+  }
+
+  DataHeader lDirHdr;
+  std::memcpy(&lDirHdr, mFileMap.data() + lFooter.mDirectoryOffset, sizeof(DataHeader));
+  if (!(lDirHdr.dataDescription == SubTimeFrameFileDirectory::sDataDescFileStfDirectory) ||
+      lDirHdr.payloadSize != (lFooter.mNumStfs * sizeof(Entry))) {
+    WDDLOG("FileReader: invalid TF directory header. file={}", mFileName);
+    return false;
+  }
+
+  auto &lEntries = mDirectory.entries();
+  lEntries.resize(lFooter.mNumStfs);
+  std::memcpy(lEntries.data(), mFileMap.data() + lFooter.mDirectoryOffset + sizeof(DataHeader), lDirHdr.payloadSize);
+
+  mFileSize = lFooter.mDirectoryOffset;
+  mDirectoryValid = true;
+  return true;
+}
+
+void SubTimeFrameFileReader::scanDirectory()
+{
+  using DataIndexElem = SubTimeFrameFileDataIndex::DataIndexElem;
+
+  // walk TF meta and index headers only
+  mDirectory.clear();
+  mOrdinalIds = false;
+  std::uint64_t lPos = 0;
+  std::uint64_t lStfCnt = 0;
+
+  const auto lSavedPos = position();
+
+  while (mFileMap.is_open() && (lPos + sizeof(DataHeader)) <= mFileSize) {
+    DataHeader lMetaHdr;
+    std::memcpy(&lMetaHdr, mFileMap.data() + lPos, sizeof(DataHeader));
+    if (!(lMetaHdr.dataDescription == SubTimeFrameFileMeta::sDataDescFileSubTimeFrame)) {
+      WDDLOG("FileReader: invalid TF meta header while scanning the file. file={} offset={}", mFileName, lPos);
+      break;
+    }
+
+    // the meta header stack contains the SubTimeFrameFileStfOrder header since version 3
+    set_position(lPos);
+    const std::uint64_t lMetaHdrStackSize = getHeaderStackSize();
+    if (lMetaHdrStackSize < sizeof(DataHeader) ||
+        (lPos + lMetaHdrStackSize + lMetaHdr.payloadSize + sizeof(DataHeader)) > mFileSize) {
+      WDDLOG("FileReader: invalid TF meta header while scanning the file. file={} offset={}", mFileName, lPos);
+      break;
+    }
+
+    SubTimeFrameFileMeta lMeta;
+    std::memcpy(&lMeta, mFileMap.data() + lPos + lMetaHdrStackSize,
+      std::min(lMetaHdr.payloadSize, std::uint64_t(sizeof(SubTimeFrameFileMeta))));
+    if (lMeta.mStfSizeInFile == 0 || (lPos + lMeta.mStfSizeInFile) > mFileSize) {
+      WDDLOG("FileReader: truncated TF while scanning the file. file={} offset={}", mFileName, lPos);
+      break;
+    }
+
+    SubTimeFrameFileDirectory::Entry lEntry;
+    // TF ids are recorded since version 3. Older files: TF counter of the first data block, or the ordinal
+    lEntry.mStfId = lStfCnt;
+    const auto lOrder = getStfOrder(reinterpret_cast<const std::byte*>(mFileMap.data() + lPos), lMetaHdrStackSize);
+    bool lHasId = lOrder.mValid;
+    if (lHasId) {
+      lEntry.mStfId = lOrder.mStfId;
+    }
+    lEntry.mOffset = lPos;
+    lEntry.mSize = lMeta.mStfSizeInFile;
+    lEntry.mFirstOrbit = std::numeric_limits<std::uint32_t>::max(); // not known without reading the data
+
+    // origins from the index
+    const std::uint64_t lIndexPos = lPos + lMetaHdrStackSize + lMetaHdr.payloadSize;
+    DataHeader lIndexHdr;
+    std::memcpy(&lIndexHdr, mFileMap.data() + lIndexPos, sizeof(DataHeader));
+
+    if (lIndexHdr.dataDescription == SubTimeFrameFileDataIndex::sDataDescFileStfDataIndex &&
+        (lIndexPos + lIndexHdr.headerSize + lIndexHdr.payloadSize) <= (lPos + lMeta.mStfSizeInFile)) {
+      // index element size depends on the version (first fields are the same)
+      const std::uint64_t lElemSize = (lMeta.mStfFileVersion >= 4) ? sizeof(DataIndexElem) :
+        (lMeta.mStfFileVersion >= 2) ? 56 : 48;
+
+      for (std::uint64_t lOff = 0; (lOff + lElemSize) <= lIndexHdr.payloadSize; lOff += lElemSize) {
+        o2::header::DataOrigin lOrigin;
+        std::memcpy(&lOrigin, mFileMap.data() + lIndexPos + lIndexHdr.headerSize + lOff +
+          offsetof(DataIndexElem, mDataOrigin), sizeof(o2::header::DataOrigin));
+        lEntry.mOriginMask |= SubTimeFrameFileDirectory::originBit(lOrigin);
+      }
+
+      const std::uint64_t lDataPos = lIndexPos + lIndexHdr.headerSize + lIndexHdr.payloadSize;
+      if (!lHasId && (lDataPos + sizeof(DataHeader)) <= (lPos + lMeta.mStfSizeInFile)) {
+        DataHeader lDataHdr;
+        std::memcpy(&lDataHdr, mFileMap.data() + lDataPos, sizeof(DataHeader));
+        if (DataHeader::Get(&lDataHdr) && lDataHdr.tfCounter != 0) {
+          lEntry.mStfId = lDataHdr.tfCounter;
+          lHasId = true;
+        }
+      }
+    }
+
+    mOrdinalIds = mOrdinalIds || !lHasId;
+    mDirectory.addStf(lEntry);
+    lPos += lMeta.mStfSizeInFile;
+    lStfCnt++;
+  }
+
+  set_position(lSavedPos);
+  mDirectoryValid = true;
+}
+
+const std::vector<SubTimeFrameFileDirectory::Entry>& SubTimeFrameFileReader::directory()
+{
+  if (!mDirectoryValid) {
+    scanDirectory();
+  }
+  return mDirectory.entries();
+}
+
+bool SubTimeFrameFileReader::seekStf(const std::uint64_t pStfId)
+{
+  const auto &lEntries = directory();
+  const auto lIt = std::find_if(lEntries.cbegin(), lEntries.cend(),
+    [pStfId](const SubTimeFrameFileDirectory::Entry &pEntry) { return pEntry.mStfId == pStfId; });
+
+  if (lIt == lEntries.cend() || (lIt->mOffset + lIt->mSize) > mFileSize) {
+    return false;
+  }
+
+  set_position(lIt->mOffset);
+  return true;
+}
+
+bool SubTimeFrameFileReader::readHeaders(StfHeaders &pStfHdrs)
+{
+  // continue with the next TF when a TF fails the checksum verification
+  for (;;) {
+    bool lSkipped = false;
+    const bool lRet = readStfHeaders(pStfHdrs, lSkipped);
+    if (lRet || !lSkipped) {
+      return lRet;
+    }
+  }
+}
+
+bool SubTimeFrameFileReader::readStfHeaders(StfHeaders &pStfHdrs, bool &pSkipped)
+{
+  pStfHdrs.mBlocks.clear();
+
+  if (!mFileMap.is_open() || eof()) {
+    return false;
+  }
+
+#if __linux__
+  if (!mHeaderAccess) {
+    // sequential readahead would read all payloads from the disk
+    madvise((void*)mFileMap.data(), mFileMap.size(), MADV_RANDOM);
+    mHeaderAccess = true;
+  }
+#endif
+
+  pStfHdrs.mOffset = position();
+
+  // DataHeader + SubTimeFrameFileMeta
+  const std::size_t lMetaHdrStackSize = getHeaderStackSize();
+  if (lMetaHdrStackSize < sizeof(BaseHeader)) {
+    EDDLOG("Failed to read the TF file header. The file might be corrupted. file={}", mFileName);
+    mFileMap.close();
+    return false;
+  }
+
+  DataHeader lMetaHdr;
+  std::memcpy(&lMetaHdr, peek(), std::min(lMetaHdrStackSize, sizeof(DataHeader)));
+  if (!(lMetaHdr.dataDescription == SubTimeFrameFileMeta::sDataDescFileSubTimeFrame)) {
+    WDDLOG("Reading bad data: SubTimeFrame META header. file={} offset={}", mFileName, pStfHdrs.mOffset);
+    mFileMap.close();
+    return false;
+  }
+
+  const std::uint64_t lMetaToRead = std::min(lMetaHdr.payloadSize, std::uint64_t(sizeof(SubTimeFrameFileMeta)));
+  pStfHdrs.mMeta = SubTimeFrameFileMeta();
+  pStfHdrs.mOrder = getStfOrder(reinterpret_cast<const std::byte*>(peek()), lMetaHdrStackSize);
+  if (!ignore_nbytes(lMetaHdrStackSize) || !read_advance(&pStfHdrs.mMeta, lMetaToRead) ||
+      !ignore_nbytes(lMetaHdr.payloadSize - lMetaToRead)) {
+    return false;
+  }
+
+  const std::uint64_t lStfSizeInFile = pStfHdrs.mMeta.mStfSizeInFile;
+  if ((pStfHdrs.mOffset + lStfSizeInFile) > size() || lStfSizeInFile < (position() - pStfHdrs.mOffset)) {
+    WDDLOG_RL(200, "Not enough data in file for this TF. Required: {}, available: {}",
+      lStfSizeInFile, (size() - pStfHdrs.mOffset));
+    mFileMap.close();
+    return false;
+  }
+
+  // DataHeader + SubTimeFrameFileDataIndex: skipped
+  const std::size_t lIndexHdrStackSize = getHeaderStackSize();
+  if (lIndexHdrStackSize < sizeof(BaseHeader)) {
+    mFileMap.close();
+    return false;
+  }
+
+  DataHeader lIndexHdr;
+  std::memcpy(&lIndexHdr, peek(), std::min(lIndexHdrStackSize, sizeof(DataHeader)));
+  const std::uint64_t lStfEnd = pStfHdrs.mOffset + lStfSizeInFile;
+  if (!(lIndexHdr.dataDescription == SubTimeFrameFileDataIndex::sDataDescFileStfDataIndex) ||
+      (position() + lIndexHdrStackSize + lIndexHdr.payloadSize) > lStfEnd || !ignore_nbytes(lIndexHdrStackSize)) {
+    EDDLOG("Failed to read the TF index structure. The file might be corrupted. file={}", mFileName);
+    mFileMap.close();
+    return false;
+  }
+
+  // checksums are recorded in the index since version 4. Reads the payloads.
+  if (mVerifyChecksums && pStfHdrs.mMeta.mStfFileVersion >= 4) {
+    if (!verifyChecksums(lIndexHdr, lStfEnd - position() - lIndexHdr.payloadSize)) {
+      mChecksumErrors++;
+      EDDLOG("Skipping the TF with invalid checksum. The file might be corrupted. file={} tf_id={}",
+        mFileName, pStfHdrs.mOrder.mStfId);
+      set_position(lStfEnd);
+      pSkipped = true;
+      return false;
+    }
+  }
+
+  if (!ignore_nbytes(lIndexHdr.payloadSize)) {
+    mFileMap.close();
+    return false;
+  }
+
+  // data blocks: headers only
+
+  while (position() < lStfEnd) {
+    auto &lBlock = pStfHdrs.mBlocks.emplace_back();
+
+    lBlock.mHdrOffset = position();
+    lBlock.mHdrStackSize = getHeaderStackSize();
+    if (lBlock.mHdrStackSize < sizeof(BaseHeader)) {
+      mFileMap.close();
+      return false;
+    }
+
+    lBlock.mHdrStack = reinterpret_cast<const std::byte*>(peek());
+    std::memcpy(&lBlock.mDataHeader, lBlock.mHdrStack,
+      std::min(std::uint64_t(lBlock.mHdrStackSize), std::uint64_t(sizeof(DataHeader))));
+    lBlock.mUncompressedSize = lBlock.mDataHeader.payloadSize;
+
+    // compressed block (version 2): the codec header follows the DataHeader
+    if (lBlock.mDataHeader.flagsNextHeader) {
+      const auto *lCodecHdr = o2::header::get<SubTimeFrameFileBlockCodec*>(lBlock.mHdrStack, lBlock.mHdrStackSize);
+      if (lCodecHdr) {
+        lBlock.mCodec = lCodecHdr->mCodec;
+        lBlock.mUncompressedSize = lCodecHdr->mUncompressedSize;
+      }
+    }
+
+    if ((lBlock.dataOffset() + lBlock.dataSize()) > lStfEnd) {
+      EDDLOG("FileReader: data block beyond the TF end. file={} offset={} size={} tf_end={}",
+        mFileName, lBlock.dataOffset(), lBlock.dataSize(), lStfEnd);
+      mFileMap.close();
+      return false;
+    }
+
+    set_position(lBlock.dataOffset() + lBlock.dataSize());
+  }
+
+  return true;
 }
 
 SubTimeFrameFileReader::~SubTimeFrameFileReader()
@@ -77,6 +369,20 @@ void SubTimeFrameFileReader::visit(SubTimeFrame& pStf, void*)
   }
 }
 
+SubTimeFrameFileReader::StfOrderInfo SubTimeFrameFileReader::getStfOrder(const std::byte *pMetaHdrStack,
+  const std::size_t pMetaHdrStackSize)
+{
+  StfOrderInfo lInfo;
+
+  const auto *lOrderHdr = o2::header::get<SubTimeFrameFileStfOrder*>(pMetaHdrStack, pMetaHdrStackSize);
+  if (lOrderHdr) {
+    lInfo.mValid = true;
+    lInfo.mStfId = lOrderHdr->mStfId;
+    lInfo.mOrder = lOrderHdr->mOrder;
+  }
+  return lInfo;
+}
+
 std::size_t SubTimeFrameFileReader::getHeaderStackSize() // throws ios_base::failure
 {
   // Expect valid Stack in the file.
@@ -182,7 +488,48 @@ Stack SubTimeFrameFileReader::getHeaderStack(std::size_t &pOrigsize)
 
 std::uint64_t SubTimeFrameFileReader::sStfId = 0;
 
+bool SubTimeFrameFileReader::verifyChecksums(const DataHeader &pIndexHdr, const std::uint64_t pStfDataSize)
+{
+  using DataIndexElem = SubTimeFrameFileDataIndex::DataIndexElem;
+
+  // positioned at the index payload
+  const auto *lIndex = reinterpret_cast<const DataIndexElem*>(peek());
+  const std::size_t lNumElems = pIndexHdr.payloadSize / sizeof(DataIndexElem);
+  const char *lDataStart = reinterpret_cast<const char*>(peek()) + pIndexHdr.payloadSize;
+
+  for (std::size_t i = 0; i < lNumElems; i++) {
+    const auto &lElem = lIndex[i];
+
+    if ((lElem.mOffset + lElem.mSize) > pStfDataSize) {
+      EDDLOG("FileReader: index element beyond the TF data. offset={} size={} tf_data_size={}",
+        lElem.mOffset, lElem.mSize, pStfDataSize);
+      return false;
+    }
+
+    if (!verifyChecksum(lElem, lDataStart)) {
+      EDDLOG("FileReader: checksum mismatch. file={} origin={} subspec={} offset={} size={} checksum_type={}",
+        mFileName, lElem.mDataOrigin.as<std::string>(), lElem.mSubSpecification, lElem.mOffset, lElem.mSize,
+        to_string(StfFileChecksum(lElem.mChecksumType)));
+      return false;
+    }
+  }
+
+  return true;
+}
+
 std::unique_ptr<SubTimeFrame> SubTimeFrameFileReader::read(SubTimeFrameFileBuilder &pFileBuilder)
+{
+  // continue with the next TF when a TF fails the checksum verification
+  for (;;) {
+    bool lSkipped = false;
+    auto lStf = readStf(pFileBuilder, lSkipped);
+    if (lStf || !lSkipped) {
+      return lStf;
+    }
+  }
+}
+
+std::unique_ptr<SubTimeFrame> SubTimeFrameFileReader::readStf(SubTimeFrameFileBuilder &pFileBuilder, bool &pSkipped)
 {
   // make sure headers and chunk pointers don't linger
   mStfData.clear();
@@ -216,22 +563,35 @@ std::unique_ptr<SubTimeFrame> SubTimeFrameFileReader::read(SubTimeFrameFileBuild
 
   lStfMetaDataHdr = o2::header::DataHeader::Get(lMetaHdrStack.first());
 
-  if (!read_advance(&lStfFileMeta, sizeof(SubTimeFrameFileMeta))) {
+  // verify we're actually reading the correct data in
+  if (!lStfMetaDataHdr || !(SubTimeFrameFileMeta::getDataHeader().dataDescription == lStfMetaDataHdr->dataDescription)) {
+    WDDLOG("Reading bad data: SubTimeFrame META header");
+    mFileMap.close();
+    return nullptr;
+  }
+
+  // size of the meta depends on the file version: fields not present in the file keep default values
+  const std::uint64_t lMetaSizeInFile = lStfMetaDataHdr->payloadSize;
+  const std::uint64_t lMetaToRead = std::min(lMetaSizeInFile, std::uint64_t(sizeof(SubTimeFrameFileMeta)));
+
+  if (!read_advance(&lStfFileMeta, lMetaToRead) || !ignore_nbytes(lMetaSizeInFile - lMetaToRead)) {
     return nullptr;
   }
   // use the stored timestamp for creation time
   lStf->updateCreationTimeMs(lStfFileMeta.mWriteTimeMs);
 
-  // verify we're actually reading the correct data in
-  if (!(SubTimeFrameFileMeta::getDataHeader().dataDescription == lStfMetaDataHdr->dataDescription)) {
-    WDDLOG("Reading bad data: SubTimeFrame META header");
+  if (lStfFileMeta.mStfFileVersion > SubTimeFrameFileMeta::sStfFileVersion) {
+    EDDLOG("Reading a TF file of unsupported version. file_version={} supported_version={}",
+      lStfFileMeta.mStfFileVersion, SubTimeFrameFileMeta::sStfFileVersion);
     mFileMap.close();
     return nullptr;
   }
 
+  mLastStfOrder = getStfOrder(lMetaHdrStack.data(), lMetaHdrStackSize);
+
   // prepare to read the TF data
   const auto lStfSizeInFile = lStfFileMeta.mStfSizeInFile;
-  if (lStfSizeInFile == (sizeof(DataHeader) + sizeof(SubTimeFrameFileMeta))) {
+  if (lStfSizeInFile == (lMetaHdrStackSize + lMetaSizeInFile)) {
     WDDLOG("Reading an empty TF from file. Only meta information present");
     mFileMap.close();
     return nullptr;
@@ -261,15 +621,27 @@ std::unique_ptr<SubTimeFrame> SubTimeFrameFileReader::read(SubTimeFrameFileBuild
     return nullptr;
   }
 
-  if (!ignore_nbytes(lStfIndexHdr->payloadSize)) {
-    return nullptr;
-  }
-
   // Remaining data size of the TF:
   // total size in file - meta (hdr+struct) - index (hdr + payload)
-  const auto lStfDataSize = lStfSizeInFile - (lMetaHdrStackSize + sizeof(SubTimeFrameFileMeta))
+  const auto lStfDataSize = lStfSizeInFile - (lMetaHdrStackSize + lMetaSizeInFile)
     - (lStfIndexHdrStackSize + lStfIndexHdr->payloadSize);
 
+  // checksums are recorded in the index since version 4
+  if (mVerifyChecksums && lStfFileMeta.mStfFileVersion >= 4) {
+    if (!verifyChecksums(*lStfIndexHdr, lStfDataSize)) {
+      mChecksumErrors++;
+      EDDLOG("Skipping the TF with invalid checksum. The file might be corrupted. file={} tf_id={}",
+        mFileName, mLastStfOrder.mStfId);
+      set_position(lTfStartPosition + lStfSizeInFile);
+      pSkipped = true;
+      return nullptr;
+    }
+  }
+
+  if (!ignore_nbytes(lStfIndexHdr->payloadSize)) {
+    return nullptr;
+  }
+
   // read all data blocks and headers
   assert(mStfData.empty());
 
@@ -295,13 +667,48 @@ std::unique_ptr<SubTimeFrame> SubTimeFrameFileReader::read(SubTimeFrameFileBuild
     // read the data
     const std::uint64_t lDataSize = lDataHeader->payloadSize;
 
-    auto lDataMsg = pFileBuilder.newDataMessage(lDataSize);
+    // compressed block (version 2): the codec header follows the DataHeader
+    const auto *lCodecHdr = (lDataHeader->flagsNextHeader) ?
+      o2::header::get<SubTimeFrameFileBlockCodec*>(lDataHeaderStack.data()) : nullptr;
+    const std::uint64_t lMsgSize = lCodecHdr ? lCodecHdr->mUncompressedSize : lDataSize;
+
+    auto lDataMsg = pFileBuilder.newDataMessage(lMsgSize);
     if (!lDataMsg) {
       IDDLOG("Data memory resource stopped. Exiting.");
       mFileMap.close();
       return nullptr;
     }
-    if (!read_advance(lDataMsg->GetData(), lDataSize) ) {
+
+    if (lCodecHdr) {
+      // decompress directly from the file into the message
+      if (lDataSize > (mFileSize - mFileMapOffset)) {
+        EDDLOG("FileReader: compressed data block beyond the file end. pos={} size={} len={}",
+          mFileMapOffset, mFileSize, lDataSize);
+        mFileMap.close();
+        return nullptr;
+      }
+
+      const auto lCodec = StfFileCodec(lCodecHdr->mCodec);
+      if (!decompressBlock(lCodec, reinterpret_cast<const char*>(peek()), lDataSize,
+          reinterpret_cast<char*>(lDataMsg->GetData()), lMsgSize)) {
+        EDDLOG("FileReader: failed to decompress data block. codec={} size={} uncompressed_size={}. "
+          "The file might be corrupted.", to_string(lCodec), lDataSize, lMsgSize);
+        mFileMap.close();
+        return nullptr;
+      }
+
+      if (!ignore_nbytes(lDataSize)) {
+        return nullptr;
+      }
+
+      // downstream gets the DataHeader of the uncompressed block only
+      DataHeader lUncompressedDh = *lDataHeader;
+      lUncompressedDh.flagsNextHeader = 0;
+      lUncompressedDh.payloadSize = lMsgSize;
+      lDataHeaderStack = Stack(lUncompressedDh);
+      lDataHeader = o2::header::DataHeader::Get(lDataHeaderStack.first());
+
+    } else if (!read_advance(lDataMsg->GetData(), lDataSize) ) {
       return nullptr;
     }
 
@@ -312,6 +719,8 @@ std::unique_ptr<SubTimeFrame> SubTimeFrameFileReader::read(SubTimeFrameFileBuild
       if (lHdr && lHdr->firstTForbit == 0 && lHdr->dataDescription == o2::header::gDataDescriptionRawData) {
         const auto R = RDHReader(lDataMsg);
         lStf->updateFirstOrbit(R.getOrbit());
+      } else if (lHdr && lHdr->firstTForbit != 0) {
+        lStf->updateFirstOrbit(lHdr->firstTForbit);
       }
     } catch (...) {
       EDDLOG("Error getting RDHReader instance. Not setting firstOrbit for file data");
@@ -15,6 +15,7 @@
 #define ALICEO2_SUBTIMEFRAME_FILE_READER_H_
 
 #include "SubTimeFrameDataModel.h"
+#include "SubTimeFrameFile.h"
 #include <Headers/DataHeader.h>
 #include <Headers/Stack.h>
 
@@ -74,14 +75,104 @@ class SubTimeFrameFileReader : public ISubTimeFrameVisitor
   inline
   std::uint64_t size() const { return mFileSize; }
 
+  ///
+  /// Id and order of a TF in the sink (file version 3). Not valid for TFs of older files.
+  ///
+  struct StfOrderInfo {
+    bool mValid = false;
+    std::uint64_t mStfId = 0;
+    SubTimeFrameFileMeta::StfOrder mOrder;
+  };
+
+  ///
+  /// Id and order of the last TF read
+  ///
+  const StfOrderInfo& lastStfOrder() const { return mLastStfOrder; }
+
+  ///
+  /// Directory of all TFs in the file: read from the file footer, or built by scanning TF headers
+  /// for files without the footer.
+  ///
+  const std::vector<SubTimeFrameFileDirectory::Entry>& directory();
+  bool hasFooter() const { return mHasFooter; }
+
+  ///
+  /// Files before version 3 do not record TF ids: the TF counter of the data is used. TFs without the
+  /// counter get the ordinal in the file, which does not identify the TF across files.
+  ///
+  bool hasOrdinalIds() { directory(); return mOrdinalIds; }
+
+  ///
+  /// Position the reader at the TF. The next read() returns the TF.
+  ///
+  bool seekStf(const std::uint64_t pStfId);
+
+  ///
+  /// Headers of a TF, collected without reading payloads or allocating data messages
+  ///
+  struct StfHeaders {
+    struct Block {
+      o2::header::DataHeader mDataHeader;     // copy of the DataHeader (payloadSize is the size in file)
+      const std::byte *mHdrStack = nullptr;   // header stack in the mapped file
+      std::uint64_t mHdrOffset = 0;           // offset of the header stack in the file
+      std::uint64_t mHdrStackSize = 0;        // payload follows the header stack
+      std::uint32_t mCodec = eStfFileCodecNone;
+      std::uint64_t mUncompressedSize = 0;
+
+      std::uint64_t dataOffset() const { return mHdrOffset + mHdrStackSize; }
+      std::uint64_t dataSize() const { return mDataHeader.payloadSize; }
+    };
+
+    SubTimeFrameFileMeta mMeta;
+    StfOrderInfo mOrder;
+    std::uint64_t mOffset = 0;               // offset of the TF in the file
+    std::vector<Block> mBlocks;
+  };
+
+  ///
+  /// Read headers of the next TF from the file. Payload bytes are skipped, so only pages with headers
+  /// are read from the disk. Can be mixed with seekStf() and set_position().
+  /// With checksum verification, payloads are read and TFs that fail are skipped.
+  ///
+  bool readHeaders(StfHeaders &pStfHdrs);
+
+  ///
+  /// Verify checksums of data blocks before reading a TF, or its headers (file version 4).
+  /// TFs that fail are skipped and counted.
+  ///
+  void setVerifyChecksums(const bool pVerify) { mVerifyChecksums = pVerify; }
+  std::uint64_t checksumErrors() const { return mChecksumErrors; }
+
  private:
   void visit(SubTimeFrame& pStf, void*) override;
 
+  /// Read the next TF. pSkipped is set when the TF failed the checksum verification and was skipped.
+  std::unique_ptr<SubTimeFrame> readStf(SubTimeFrameFileBuilder &pFileBuilder, bool &pSkipped);
+  bool readStfHeaders(StfHeaders &pStfHdrs, bool &pSkipped);
+
   std::string mFileName;
   boost::iostreams::mapped_file_source mFileMap;
   std::uint64_t mFileMapOffset = 0;
   std::uint64_t mFileSize = 0;
 
+  StfOrderInfo mLastStfOrder;
+  static StfOrderInfo getStfOrder(const std::byte *pMetaHdrStack, const std::size_t pMetaHdrStackSize);
+
+  // TF directory: mFileSize is set to the directory offset when the footer is present
+  bool mHasFooter = false;
+  bool mDirectoryValid = false;
+  bool mOrdinalIds = false;
+  SubTimeFrameFileDirectory mDirectory;
+  bool readFooter();
+  void scanDirectory();
+
+  // readHeaders(): no readahead of payload pages
+  bool mHeaderAccess = false;
+
+  bool mVerifyChecksums = false;
+  std::uint64_t mChecksumErrors = 0;
+  bool verifyChecksums(const o2::header::DataHeader &pIndexHdr, const std::uint64_t pStfDataSize);
+
   // helper to make sure written chunks are buffered, only allow pointers
   template <typename pointer,
             typename = std::enable_if_t<std::is_pointer<pointer>::value>>
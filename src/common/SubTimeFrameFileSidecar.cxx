@@ -0,0 +1,69 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SubTimeFrameFileSidecar.h"
+
+#include "DataDistLogger.h"
+
+#include <algorithm>
+
+namespace o2::DataDistribution
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// SubTimeFrameFileSidecarReader
+////////////////////////////////////////////////////////////////////////////////
+
+SubTimeFrameFileSidecarReader::SubTimeFrameFileSidecarReader(const boost::filesystem::path &pFileName)
+{
+  try {
+    mFileMap.open(pFileName.string());
+  } catch (std::exception &e) {
+    EDDLOG("Failed to open the sidecar file. file={} error={}", pFileName.string(), e.what());
+    return;
+  }
+
+  if (!mFileMap.is_open() || mFileMap.size() < sizeof(SubTimeFrameFileSidecarHeader)) {
+    EDDLOG("Failed to open the sidecar file. file={}", pFileName.string());
+    return;
+  }
+
+  SubTimeFrameFileSidecarHeader lHeader;
+  std::memcpy(&lHeader, mFileMap.data(), sizeof(SubTimeFrameFileSidecarHeader));
+
+  if (!lHeader.valid() || lHeader.mVersion != SubTimeFrameFileSidecarHeader::sVersion ||
+    lHeader.mRecordSize != sizeof(SubTimeFrameFileSidecarRecord)) {
+    EDDLOG("Sidecar file format is not supported. file={} version={} record_size={}",
+      pFileName.string(), lHeader.mVersion, lHeader.mRecordSize);
+    return;
+  }
+
+  const std::size_t lRecordsSize = mFileMap.size() - sizeof(SubTimeFrameFileSidecarHeader);
+  if (lRecordsSize % sizeof(SubTimeFrameFileSidecarRecord)) {
+    WDDLOG("Sidecar file is truncated. Ignoring the last record. file={}", pFileName.string());
+  }
+
+  mNumRecords = lRecordsSize / sizeof(SubTimeFrameFileSidecarRecord);
+  mRecords = reinterpret_cast<const Record*>(mFileMap.data() + sizeof(SubTimeFrameFileSidecarHeader));
+  mValid = true;
+}
+
+std::pair<const SubTimeFrameFileSidecarRecord*, const SubTimeFrameFileSidecarRecord*>
+SubTimeFrameFileSidecarReader::findStf(const std::uint64_t pStfId) const
+{
+  const auto lFirst = std::find_if(begin(), end(), [pStfId](const Record &pRec) { return pRec.mStfId == pStfId; });
+  const auto lLast = std::find_if(lFirst, end(), [pStfId](const Record &pRec) { return pRec.mStfId != pStfId; });
+  return { lFirst, lLast };
+}
+
+} /* o2::DataDistribution */
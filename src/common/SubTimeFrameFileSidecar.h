@@ -0,0 +1,127 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ALICEO2_SUBTIMEFRAME_FILE_SIDECAR_H_
+#define ALICEO2_SUBTIMEFRAME_FILE_SIDECAR_H_
+
+#include <Headers/DataHeader.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace o2::DataDistribution
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// SubTimeFrameFileSidecar
+////////////////////////////////////////////////////////////////////////////////
+
+///
+/// Binary sidecar of a (Sub)TimeFrame file: a header followed by fixed-size records,
+/// one for each data block written in the data file, in the file order.
+///
+struct SubTimeFrameFileSidecarHeader {
+  static constexpr const char sMagic[8] = { 'S', 'T', 'F', 'S', 'I', 'D', 'E', 'C' };
+  static constexpr std::uint32_t sVersion = 1;
+
+  char mMagic[8] = { 'S', 'T', 'F', 'S', 'I', 'D', 'E', 'C' };
+  std::uint32_t mVersion = sVersion;
+  std::uint32_t mRecordSize = 0;
+
+  bool valid() const { return std::memcmp(mMagic, sMagic, sizeof(sMagic)) == 0; }
+};
+
+struct SubTimeFrameFileSidecarRecord {
+  enum Flags : std::uint16_t {
+    eRdhValid = 1 << 0, // fields of the first RDH are set (RAWDATA blocks)
+  };
+
+  /// (Sub)TimeFrame
+  std::uint64_t mStfId = 0;
+  std::uint64_t mStfOffset = 0;       // offset of the STF in the data file
+  std::uint64_t mStfSize = 0;         // size of the STF in the data file
+
+  /// Data block
+  std::uint64_t mHdrOffset = 0;       // offset of the header stack in the data file
+  std::uint64_t mDataSize = 0;        // size of the payload in the data file
+  std::uint64_t mUncompressedSize = 0;
+
+  o2::header::DataDescription mDataDescription;
+  o2::header::DataOrigin mDataOrigin;
+  std::uint32_t mHdrSize = 0;         // payload follows the header stack
+  o2::header::DataHeader::SubSpecificationType mSubSpecification = 0;
+  std::uint32_t mSplitPayloadIndex = 0;
+
+  /// TF fields of the DataHeader
+  std::uint32_t mTfFirstOrbit = 0;    // DataHeader::firstTForbit, or the first orbit of the STF
+  std::uint32_t mRunNumber = 0;
+  std::uint32_t mSplitPayloadParts = 0;
+
+  /// First RDH of the block. The RDHs of the block are not walked.
+  std::uint32_t mFirstOrbit = 0;
+  std::uint32_t mTriggerType = 0;
+  std::uint16_t mFeeId = 0;
+  std::uint16_t mBc = 0;
+  std::uint8_t mCodec = 0;            // StfFileCodec of the payload
+  std::uint8_t mReserved0 = 0;
+  std::uint16_t mFlags = 0;
+  std::uint32_t mReserved = 0;
+
+  std::uint64_t dataOffset() const { return mHdrOffset + mHdrSize; }
+  bool rdhValid() const { return mFlags & eRdhValid; }
+};
+
+static_assert(sizeof(SubTimeFrameFileSidecarRecord) == 112,
+              "SubTimeFrameFileSidecarRecord changed -> Binary compatibility is lost!");
+static_assert(std::is_standard_layout_v<SubTimeFrameFileSidecarRecord>,
+              "SubTimeFrameFileSidecarRecord must be a std layout type.");
+static_assert(std::is_trivially_copyable_v<SubTimeFrameFileSidecarRecord>,
+              "SubTimeFrameFileSidecarRecord must be trivially copyable.");
+
+////////////////////////////////////////////////////////////////////////////////
+/// SubTimeFrameFileSidecarReader
+////////////////////////////////////////////////////////////////////////////////
+
+class SubTimeFrameFileSidecarReader
+{
+ public:
+  using Record = SubTimeFrameFileSidecarRecord;
+
+  SubTimeFrameFileSidecarReader() = delete;
+  SubTimeFrameFileSidecarReader(const boost::filesystem::path &pFileName);
+
+  bool good() const { return mValid; }
+
+  std::size_t size() const { return mNumRecords; }
+  const Record* begin() const { return mRecords; }
+  const Record* end() const { return mRecords + mNumRecords; }
+  const Record& operator[](const std::size_t pIdx) const { return mRecords[pIdx]; }
+
+  /// Records of the STF, contiguous in the file order. Empty range if not found.
+  std::pair<const Record*, const Record*> findStf(const std::uint64_t pStfId) const;
+
+ private:
+  boost::iostreams::mapped_file_source mFileMap;
+  bool mValid = false;
+  const Record *mRecords = nullptr;
+  std::size_t mNumRecords = 0;
+};
+
+} /* o2::DataDistribution */
+
+#endif /* ALICEO2_SUBTIMEFRAME_FILE_SIDECAR_H_ */
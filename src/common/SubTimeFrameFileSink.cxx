@@ -12,6 +12,7 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "SubTimeFrameFileSink.h"
+#include "SubTimeFrameFileChecksum.h"
 #include "FilePathUtils.h"
 #include "FmqUtilities.h"
 #include "DataDistLogger.h"
@@ -19,10 +20,11 @@
 #include <fairmq/ProgOptions.h>
 
 #include <boost/asio/ip/host_name.hpp>
-#include <boost/algorithm/string/replace.hpp>
+#include <boost/algorithm/string.hpp>
 #include <boost/program_options/options_description.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <iostream>
@@ -44,6 +46,26 @@ void SubTimeFrameFileSink::start()
     const auto lHostname = boost::asio::ip::host_name();
     mHostname = lHostname.substr(0, lHostname.find('.'));
     mRunning = true;
+    if (mCodecConfig.enabled()) {
+      mCompressor = std::make_unique<SubTimeFrameFileCompressor>(mCodecConfig, mCompressionThreads);
+    }
+
+    mStreams.clear();
+    for (unsigned i = 0; i < mNumStreams; i++) {
+      mStreams.emplace_back(std::make_unique<SinkStream>());
+      mStreams.back()->mIdx = i;
+    }
+
+    if (mNumStreams > 1) {
+      mForwardQueue.start();
+      for (auto &lStream : mStreams) {
+        std::string lThreadName = "stf_sink_" + std::to_string(lStream->mIdx);
+        lStream->mThread = create_thread_member(lThreadName.c_str(), &SubTimeFrameFileSink::StreamWriterThread,
+          this, lStream->mIdx);
+      }
+      mForwardThread = create_thread_member("stf_sink_fwd", &SubTimeFrameFileSink::StfForwardThread, this, 0);
+    }
+
     mSinkThread = create_thread_member("stf_sink", &SubTimeFrameFileSink::DataHandlerThread, this, 0);
   }
   DDDLOG("SubTimeFrameFileSink started");
@@ -53,9 +75,23 @@ void SubTimeFrameFileSink::stop()
 {
   mRunning = false;
 
+  // the dispatcher stops the stream and forwarding queues on exit
   if (mSinkThread.joinable()) {
     mSinkThread.join();
   }
+
+  for (auto &lStream : mStreams) {
+    if (lStream->mThread.joinable()) {
+      lStream->mThread.join();
+    }
+  }
+
+  if (mForwardThread.joinable()) {
+    mForwardThread.join();
+  }
+
+  mStreams.clear();
+  mCompressor.reset();
 }
 
 bpo::options_description SubTimeFrameFileSink::getProgramOptions()
@@ -69,10 +105,12 @@ bpo::options_description SubTimeFrameFileSink::getProgramOptions()
     OptionKeyStfSinkDir,
     bpo::value<std::string>()->default_value(""),
     "Specifies a destination directory where (Sub)TimeFrames are to be written. "
+    "Multiple comma separated directories can be used by multiple writer streams (e.g. on different drives). "
     "Note: A new directory will be created here for all output files.")(
     OptionKeyStfSinkFileName,
     bpo::value<std::string>()->default_value("o2_rawtf_run%r_tf%i_%h.tf"),
-    "Specifies file name pattern: %n - file index, %r - run number, %i - (S)TF id, %D - date, %T - time, %h - hostname.")(
+    "Specifies file name pattern: %n - file index, %r - run number, %i - (S)TF id, %D - date, %T - time, %h - hostname, "
+    "%s - writer stream index (added as a prefix when multiple streams are used).")(
     OptionKeyStfSinkStfsPerFile,
     bpo::value<std::uint64_t>()->default_value(1),
     "Specifies number of (Sub)TimeFrames per file. Default: 1")(
@@ -84,10 +122,30 @@ bpo::options_description SubTimeFrameFileSink::getProgramOptions()
     "Specifies target size for (Sub)TimeFrame files in MiB.")(
     OptionKeyStfSinkSidecar,
     bpo::bool_switch()->default_value(false),
-    "Write a sidecar file for each (Sub)TimeFrame file containing information about data blocks "
-    "written in the data file. "
-    "Note: Useful for debugging. "
-    "Warning: sidecar file format is not stable.");
+    "Write a binary sidecar file for each (Sub)TimeFrame file, with a fixed-size record for each data block "
+    "written in the data file (offsets, sizes, TF orbit, and fields of the first RDH). "
+    "Note: Use StfSidecarDump to print the sidecar file.")(
+    OptionKeyStfSinkCompression,
+    bpo::value<std::string>()->default_value(""),
+    "Compress data blocks with a codec selected by the data origin: comma separated list of <origin>:<codec> pairs, "
+    "where codec is one of none, lz4, zstd. Origin '*' selects the default codec. E.g.: 'TPC:zstd,ITS:lz4,*:none'")(
+    OptionKeyStfSinkCompressionLevel,
+    bpo::value<int>()->default_value(1),
+    "Specifies zstd compression level (1 - 22).")(
+    OptionKeyStfSinkCompressionThreads,
+    bpo::value<unsigned>()->default_value(4),
+    "Specifies number of compression threads.")(
+    OptionKeyStfSinkStreams,
+    bpo::value<unsigned>()->default_value(1),
+    "Specifies number of parallel writer streams. Each stream writes to its own files, and uses the sink "
+    "directories in round-robin. (Sub)TimeFrames are distributed to streams in round-robin.")(
+    OptionKeyStfSinkChecksum,
+    bpo::bool_switch()->default_value(false),
+    "Record CRC32C checksums of data blocks in the (Sub)TimeFrame file index.")(
+    OptionKeyStfSinkDirectory,
+    bpo::bool_switch()->default_value(false),
+    "Append a directory of all (Sub)TimeFrames when a file is closed, to seek without scanning the file. "
+    "Note: Readers of older DataDistribution versions fail at the end of files with the directory.");
 
   return lSinkDesc;
 }
@@ -105,12 +163,21 @@ bool SubTimeFrameFileSink::loadVerifyConfig(const FairMQProgOptions& pFMQProgOpt
   // set enabled to false until all tests pass
   mEnabled = false;
 
-  mRootDir = pFMQProgOpt.GetValue<std::string>(OptionKeyStfSinkDir);
-  if (mRootDir.length() == 0) {
+  const auto lRootDirs = pFMQProgOpt.GetValue<std::string>(OptionKeyStfSinkDir);
+  mRootDirs.clear();
+  boost::split(mRootDirs, lRootDirs, boost::is_any_of(","));
+  for (auto &lDir : mRootDirs) {
+    boost::trim(lDir);
+  }
+  mRootDirs.erase(std::remove(mRootDirs.begin(), mRootDirs.end(), std::string()), mRootDirs.end());
+
+  if (mRootDirs.empty()) {
     EDDLOG("(Sub)TimeFrame file sink directory must be specified");
     return false;
   }
 
+  mNumStreams = std::max(1U, pFMQProgOpt.GetValue<unsigned>(OptionKeyStfSinkStreams));
+
   mFileNamePattern = pFMQProgOpt.GetValue<std::string>(OptionKeyStfSinkFileName);
   mStfsPerFile = pFMQProgOpt.GetValue<std::uint64_t>(OptionKeyStfSinkStfsPerFile);
   mFileSize = std::max(std::uint64_t(1), pFMQProgOpt.GetValue<std::uint64_t>(OptionKeyStfSinkFileSize));
@@ -118,24 +185,51 @@ bool SubTimeFrameFileSink::loadVerifyConfig(const FairMQProgOptions& pFMQProgOpt
   mFileSize <<= 20; /* in MiB */
   mSidecar = pFMQProgOpt.GetValue<bool>(OptionKeyStfSinkSidecar);
 
+  try {
+    mCodecConfig = StfFileCodecConfig::parse(pFMQProgOpt.GetValue<std::string>(OptionKeyStfSinkCompression),
+      pFMQProgOpt.GetValue<int>(OptionKeyStfSinkCompressionLevel));
+  } catch (std::exception &e) {
+    EDDLOG("(Sub)TimeFrame file sink compression option is not valid. error={}", e.what());
+    return false;
+  }
+  mCompressionThreads = pFMQProgOpt.GetValue<unsigned>(OptionKeyStfSinkCompressionThreads);
+  mChecksum = pFMQProgOpt.GetValue<bool>(OptionKeyStfSinkChecksum) ? eStfFileChecksumCrc32c : eStfFileChecksumNone;
+  mWriteDirectory = pFMQProgOpt.GetValue<bool>(OptionKeyStfSinkDirectory);
+
+  if (!mCodecConfig.available()) {
+    EDDLOG("(Sub)TimeFrame file sink compression codec is not supported by this build. codecs={}",
+      mCodecConfig.to_string());
+    return false;
+  }
+
   // make sure directory exists and it is writable
   namespace bfs = boost::filesystem;
-  bfs::path lDirPath(mRootDir);
-  if (!bfs::is_directory(lDirPath)) {
-    EDDLOG("(Sub)TimeFrame file sink directory does not exist");
-    return false;
+  for (const auto &lDir : mRootDirs) {
+    if (!bfs::is_directory(bfs::path(lDir))) {
+      EDDLOG("(Sub)TimeFrame file sink directory does not exist. dir={}", lDir);
+      return false;
+    }
   }
 
   mEnabled = true;
 
   // print options
   IDDLOG("(Sub)TimeFrame Sink :: enabled         = {}", (mEnabled ? "yes" : "no"));
-  IDDLOG("(Sub)TimeFrame Sink :: root dir        = {}", mRootDir);
+  IDDLOG("(Sub)TimeFrame Sink :: root dir        = {}", boost::algorithm::join(mRootDirs, ","));
+  IDDLOG("(Sub)TimeFrame Sink :: writer streams  = {}", mNumStreams);
   IDDLOG("(Sub)TimeFrame Sink :: file pattern    = {}", mFileNamePattern);
   IDDLOG("(Sub)TimeFrame Sink :: stfs per file   = {}", (mStfsPerFile > 0 ? std::to_string(mStfsPerFile) : "unlimited" ));
   IDDLOG("(Sub)TimeFrame Sink :: stfs percentage = {}", (mPercentage));
   IDDLOG("(Sub)TimeFrame Sink :: max file size   = {}", mFileSize);
   IDDLOG("(Sub)TimeFrame Sink :: sidecar files   = {}", (mSidecar ? "yes" : "no"));
+  IDDLOG("(Sub)TimeFrame Sink :: compression     = {}", (mCodecConfig.enabled() ? mCodecConfig.to_string() : "no"));
+  if (mCodecConfig.enabled()) {
+    IDDLOG("(Sub)TimeFrame Sink :: compr. level    = {}", mCodecConfig.mLevel);
+    IDDLOG("(Sub)TimeFrame Sink :: compr. threads  = {}", mCompressionThreads);
+  }
+  IDDLOG("(Sub)TimeFrame Sink :: checksum        = {}{}", to_string(mChecksum),
+    ((mChecksum != eStfFileChecksumNone && !crc32cHardware()) ? " (software)" : ""));
+  IDDLOG("(Sub)TimeFrame Sink :: directory       = {}", (mWriteDirectory ? "yes" : "no"));
   return mEnabled;
 }
 
@@ -147,30 +241,37 @@ bool SubTimeFrameFileSink::makeDirectory()
     return true;
   }
 
-  try {
-    fmt::memory_buffer lDir;
-    fmt::format_to(fmt::appender(lDir), "run0{}_{}", DataDistLogger::sRunNumberStr, FilePathUtils::getDataDirName(mRootDir));
-    mCurrentDir = (bfs::path(mRootDir) / bfs::path(lDir.begin(), lDir.end())).string();
-
-    // make the run directory
-    if (!bfs::create_directory(mCurrentDir)) {
-      EDDLOG("Directory for (Sub)TimeFrame file sink cannot be created. Disabling file sink. path={}", mCurrentDir);
-      mEnabled = false;
+  std::vector<std::string> lCurrentDirs;
+
+  for (const auto &lRootDir : mRootDirs) {
+    std::string lCurrentDir;
+    try {
+      fmt::memory_buffer lDir;
+      fmt::format_to(fmt::appender(lDir), "run0{}_{}", DataDistLogger::sRunNumberStr, FilePathUtils::getDataDirName(lRootDir));
+      lCurrentDir = (bfs::path(lRootDir) / bfs::path(lDir.begin(), lDir.end())).string();
+
+      // make the run directory
+      if (!bfs::create_directory(lCurrentDir)) {
+        EDDLOG("Directory for (Sub)TimeFrame file sink cannot be created. Disabling file sink. path={}", lCurrentDir);
+        mEnabled = false;
+        return false;
+      }
+    } catch (...) {
+      EDDLOG("(Sub)TimeFrame Sink :: write directory creation failed. File sink will be disables. dir={}", lCurrentDir);
+      mReady = false;
       return false;
     }
-  } catch (...) {
-    EDDLOG("(Sub)TimeFrame Sink :: write directory creation failed. File sink will be disables. dir={}", mCurrentDir);
-    mReady = false;
-    return false;
-  }
 
-  IDDLOG("(Sub)TimeFrame Sink :: write dir={:s}", mCurrentDir);
+    IDDLOG("(Sub)TimeFrame Sink :: write dir={:s}", lCurrentDir);
+    lCurrentDirs.push_back(std::move(lCurrentDir));
+  }
 
+  mCurrentDirs = std::move(lCurrentDirs);
   mReady = true;
   return true;
 }
 
-std::string SubTimeFrameFileSink::newStfFileName(const std::uint64_t pStfId) const
+std::string SubTimeFrameFileSink::newStfFileName(const SinkStream &pStream, const std::uint64_t pStfId) const
 {
   time_t lNow;
   time(&lNow);
@@ -178,9 +279,17 @@ std::string SubTimeFrameFileSink::newStfFileName(const std::uint64_t pStfId) con
 
   std::string lFileName = mFileNamePattern;
 
+  // stream index: make sure files of different streams have unique names
+  if (mNumStreams > 1 && lFileName.find("%s") == std::string::npos) {
+    lFileName = "s%s_" + lFileName;
+  }
+  std::stringstream lStreamString;
+  lStreamString << std::dec << std::setw(2) << std::setfill('0') << pStream.mIdx;
+  boost::replace_all(lFileName, "%s", lStreamString.str());
+
   // file index
   std::stringstream lIdxString;
-  lIdxString << std::dec << std::setw(8) << std::setfill('0') << mCurrentFileIdx;
+  lIdxString << std::dec << std::setw(8) << std::setfill('0') << pStream.mCurrentFileIdx;
   boost::replace_all(lFileName, "%n", lIdxString.str());
 
   // run id
@@ -208,7 +317,53 @@ std::string SubTimeFrameFileSink::newStfFileName(const std::uint64_t pStfId) con
   return lFileName;
 }
 
-/// File writing thread
+void SubTimeFrameFileSink::writeStf(SinkStream &pStream, const SubTimeFrame &pStf, const std::uint64_t pSequence)
+{
+  do {
+    // check if we need a writer
+    if (!pStream.mStfWriter) {
+      const auto lStfId = pStf.id();
+      pStream.mCurrentFileName = newStfFileName(pStream, lStfId);
+      pStream.mCurrentDir = mCurrentDirs[pStream.mIdx % mCurrentDirs.size()];
+      namespace bfs = boost::filesystem;
+
+      try {
+        pStream.mStfWriter = std::make_unique<SubTimeFrameFileWriter>(
+          bfs::path(pStream.mCurrentDir) / bfs::path(pStream.mCurrentFileName), mSidecar, mCompressor.get(),
+          mChecksum, mWriteDirectory);
+      } catch (...) {
+        pStream.mStfWriter.reset();
+        break;
+      }
+      pStream.mCurrentFileIdx++;
+    }
+
+    // write
+    if (pStream.mStfWriter->write(pStf, SubTimeFrameFileMeta::StfOrder{ pSequence, pStream.mIdx, mNumStreams })) {
+      pStream.mCurrentFileStfs++;
+      pStream.mCurrentFileSize = pStream.mStfWriter->size();
+    } else {
+      pStream.mStfWriter->close();
+      pStream.mStfWriter->remove();
+      pStream.mStfWriter.reset();
+      break;
+    }
+
+    // check if we should rotate the file
+    if (((mStfsPerFile > 0) && (pStream.mCurrentFileStfs >= mStfsPerFile)) || (pStream.mCurrentFileSize >= mFileSize)) {
+      pStream.mCurrentFileStfs = 0;
+      pStream.mCurrentFileSize = 0;
+      pStream.mStfWriter.reset();
+    }
+  } while(0);
+
+  if (!mEnabled) {
+    EDDLOG("(Sub)TimeFrame file sink: error while writing to file {}", pStream.mCurrentFileName);
+    EDDLOG("(Sub)TimeFrame file sink: disabling file sink");
+  }
+}
+
+/// File writing thread (dispatching in multi-stream mode)
 void SubTimeFrameFileSink::DataHandlerThread(const unsigned pIdx)
 {
   std::default_random_engine lGen;
@@ -216,10 +371,8 @@ void SubTimeFrameFileSink::DataHandlerThread(const unsigned pIdx)
   std::uint64_t lAcceptedStfs = 0;
   std::uint64_t lTotalStfs = 0;
 
-  std::uint64_t lCurrentFileSize = 0;
-  std::uint64_t lCurrentFileStfs = 0;
-
-  std::string lCurrentFileName;
+  const bool lMultiStream = (mNumStreams > 1);
+  unsigned lNextStream = 0;
 
   while (mRunning) {
     // Get the next STF
@@ -238,59 +391,103 @@ void SubTimeFrameFileSink::DataHandlerThread(const unsigned pIdx)
     bool lStfAccepted = (lUniformDist(lGen) < mPercentage) ? true : false;
 
     if (mEnabled && mReady && lStfAccepted) {
-      do {
-        lAcceptedStfs += 1;
-        // make sure Stf is updated before writing
-        lStf->updateStf();
-
-        // check if we need a writer
-        if (!mStfWriter) {
-          const auto lStfId = lStf->id();
-          lCurrentFileName = newStfFileName(lStfId);
-          namespace bfs = boost::filesystem;
-
-          try {
-            mStfWriter = std::make_unique<SubTimeFrameFileWriter>(
-              bfs::path(mCurrentDir) / bfs::path(lCurrentFileName), mSidecar);
-          } catch (...) {
-            mStfWriter.reset();
-            break;
+      const std::uint64_t lSequence = lAcceptedStfs;
+      lAcceptedStfs += 1;
+      // make sure Stf is updated before writing
+      lStf->updateStf();
+
+      if (lMultiStream) {
+        // round-robin: the forwarding thread takes the STF back from the same stream
+        auto &lStream = *mStreams[lNextStream];
+        lNextStream = (lNextStream + 1) % mNumStreams;
+
+        // backpressure: wait for the stream to write out the queued STFs
+        {
+          std::unique_lock<std::mutex> lLock(lStream.mQueuedLock);
+          if (lStream.mQueued >= sStreamQueueSize) {
+            WDDLOG_RL(1000, "(Sub)TimeFrame file sink: writer stream is too slow, waiting. stream={} queued_stfs={}",
+              lStream.mIdx, lStream.mQueued);
+          }
+          while (mRunning && lStream.mQueued >= sStreamQueueSize) {
+            lStream.mQueuedCond.wait_for(lLock, std::chrono::milliseconds(100));
           }
-            mCurrentFileIdx++;
+          lStream.mQueued++;
         }
 
-        // write
-        if (mStfWriter->write(*lStf)) {
-          lCurrentFileStfs++;
-          lCurrentFileSize = mStfWriter->size();
-        } else {
-          mStfWriter->close();
-          mStfWriter->remove();
-          mStfWriter.reset();
-          break;
-        }
+        mForwardQueue.push(ForwardEntry{ lStream.mIdx, nullptr });
+        lStream.mInQueue.push(WriteEntry{ lSequence, std::move(lStf) });
+        continue;
+      }
 
-        // check if we should rotate the file
-        if (((mStfsPerFile > 0) && (lCurrentFileStfs >= mStfsPerFile)) || (lCurrentFileSize >= mFileSize)) {
-          lCurrentFileStfs = 0;
-          lCurrentFileSize = 0;
-          mStfWriter.reset();
-        }
-      } while(0);
+      writeStf(*mStreams[0], *lStf, lSequence);
+    }
 
-      if (!mEnabled) {
-        EDDLOG("(Sub)TimeFrame file sink: error while writing to file {}", lCurrentFileName);
-        EDDLOG("(Sub)TimeFrame file sink: disabling file sink");
-      }
+    if (lMultiStream) {
+      mForwardQueue.push(ForwardEntry{ 0, std::move(lStf) });
+      continue;
     }
 
+    lStf->traceStamp(eStfTraceFileSink);
+
     if (! mPipelineI.queue(mPipelineStageOut, std::move(lStf)) ) {
       // the pipeline is stopped: exiting
       break;
     }
   }
+
+  // let the stream writers and the forwarding thread drain their queues
+  for (auto &lStream : mStreams) {
+    lStream->mInQueue.stop();
+  }
+  mForwardQueue.stop();
+
   IDDLOG("(Sub)TimeFrame file sink: saved={} total={}", lAcceptedStfs, lTotalStfs);
   DDDLOG("Exiting file sink thread [{}]", pIdx);
 }
 
+/// Writer thread of a stream (multi-stream mode)
+void SubTimeFrameFileSink::StreamWriterThread(const unsigned pIdx)
+{
+  auto &lStream = *mStreams[pIdx];
+  WriteEntry lEntry;
+
+  while (lStream.mInQueue.pop(lEntry)) {
+    writeStf(lStream, *lEntry.mStf, lEntry.mSequence);
+    lStream.mDoneQueue.push(std::move(lEntry.mStf));
+  }
+
+  lStream.mDoneQueue.stop();
+  DDDLOG("Exiting file sink stream thread [{}]", pIdx);
+}
+
+/// Forwards STFs to the next pipeline stage in the input order (multi-stream mode)
+void SubTimeFrameFileSink::StfForwardThread(const unsigned pIdx)
+{
+  ForwardEntry lEntry;
+
+  while (mForwardQueue.pop(lEntry)) {
+    std::unique_ptr<SubTimeFrame> lStf = std::move(lEntry.mStf);
+
+    if (!lStf) {
+      auto &lStream = *mStreams[lEntry.mStreamIdx];
+      if (!lStream.mDoneQueue.pop(lStf)) {
+        break;
+      }
+
+      std::unique_lock<std::mutex> lLock(lStream.mQueuedLock);
+      lStream.mQueued--;
+      lStream.mQueuedCond.notify_one();
+    }
+
+    lStf->traceStamp(eStfTraceFileSink);
+
+    if (! mPipelineI.queue(mPipelineStageOut, std::move(lStf)) ) {
+      // the pipeline is stopped: exiting
+      break;
+    }
+  }
+
+  DDDLOG("Exiting file sink forwarding thread [{}]", pIdx);
+}
+
 } /* o2::DataDistribution */
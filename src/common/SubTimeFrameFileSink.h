@@ -25,7 +25,9 @@
 
 #include <boost/program_options/options_description.hpp>
 #include <boost/filesystem.hpp>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
 #include <vector>
 
 namespace o2::DataDistribution
@@ -51,6 +53,12 @@ class SubTimeFrameFileSink
   static constexpr const char* OptionKeyStfSinkStfPercent = "data-sink-stf-percentage";
   static constexpr const char* OptionKeyStfSinkFileSize = "data-sink-max-file-size";
   static constexpr const char* OptionKeyStfSinkSidecar = "data-sink-sidecar";
+  static constexpr const char* OptionKeyStfSinkCompression = "data-sink-compression";
+  static constexpr const char* OptionKeyStfSinkCompressionLevel = "data-sink-compression-level";
+  static constexpr const char* OptionKeyStfSinkCompressionThreads = "data-sink-compression-threads";
+  static constexpr const char* OptionKeyStfSinkStreams = "data-sink-streams";
+  static constexpr const char* OptionKeyStfSinkChecksum = "data-sink-checksum";
+  static constexpr const char* OptionKeyStfSinkDirectory = "data-sink-directory";
   static bpo::options_description getProgramOptions();
 
   SubTimeFrameFileSink() = delete;
@@ -66,9 +74,7 @@ class SubTimeFrameFileSink
 
   ~SubTimeFrameFileSink()
   {
-    if (mSinkThread.joinable()) {
-      mSinkThread.join();
-    }
+    stop();
     DDDLOG("(Sub)TimeFrame Sink terminated.");
   }
 
@@ -81,35 +87,83 @@ class SubTimeFrameFileSink
   void stop();
 
   void DataHandlerThread(const unsigned pIdx);
-
-  std::string newStfFileName(const std::uint64_t pStfId) const;
+  void StreamWriterThread(const unsigned pIdx);
+  void StfForwardThread(const unsigned pIdx);
 
  private:
+  struct WriteEntry {
+    std::uint64_t mSequence = 0; // order of accepted STFs
+    std::unique_ptr<SubTimeFrame> mStf = nullptr;
+  };
+
+  /// Writer stream: owns a writer and the target directory. Streams write in parallel.
+  struct SinkStream {
+    unsigned mIdx = 0;
+    std::string mCurrentDir;
+
+    std::unique_ptr<SubTimeFrameFileWriter> mStfWriter = nullptr;
+    std::string mCurrentFileName;
+    unsigned mCurrentFileIdx = 0;
+    std::uint64_t mCurrentFileSize = 0;
+    std::uint64_t mCurrentFileStfs = 0;
+
+    // multi-stream mode only
+    ConcurrentFifo<WriteEntry> mInQueue;
+    ConcurrentFifo<std::unique_ptr<SubTimeFrame>> mDoneQueue;
+    std::thread mThread;
+
+    // STFs in the input and done queues: bounded by sStreamQueueSize
+    std::mutex mQueuedLock;
+    std::condition_variable mQueuedCond;
+    std::size_t mQueued = 0;
+  };
+
+  /// Max number of STFs queued to a writer stream. The dispatcher waits for a slow stream.
+  static constexpr std::size_t sStreamQueueSize = 8;
+
+  /// STFs are forwarded in the input order: written STFs are taken from the done queue of the stream
+  struct ForwardEntry {
+    unsigned mStreamIdx = 0;
+    std::unique_ptr<SubTimeFrame> mStf = nullptr; // not written: forward directly
+  };
+
+  std::string newStfFileName(const SinkStream &pStream, const std::uint64_t pStfId) const;
+
+  /// write the STF to the file of the stream (rotates the file if needed)
+  void writeStf(SinkStream &pStream, const SubTimeFrame &pStf, const std::uint64_t pSequence);
+
   const DataDistDevice& mDeviceI;
   stf_pipeline& mPipelineI;
 
-  std::unique_ptr<SubTimeFrameFileWriter> mStfWriter = nullptr;
+  std::vector<std::unique_ptr<SinkStream>> mStreams;
+  std::unique_ptr<SubTimeFrameFileCompressor> mCompressor = nullptr;
 
   /// Configuration
   bool mEnabled = false;
   bool mRunning = false;
   bool mReady = false;
-  std::string mRootDir;
-  std::string mCurrentDir;
+  std::vector<std::string> mRootDirs;
+  std::vector<std::string> mCurrentDirs;
   std::string mFileNamePattern;
   std::uint64_t mStfsPerFile;
   unsigned mPercentage = 100;
   std::uint64_t mFileSize;
   bool mSidecar = false;
+  StfFileCodecConfig mCodecConfig;
+  unsigned mCompressionThreads = 4;
+  StfFileChecksum mChecksum = eStfFileChecksumNone;
+  bool mWriteDirectory = false;
+  unsigned mNumStreams = 1;
   std::string mHostname;
 
-  /// Thread for file writing
+  /// Thread for file writing (dispatching in multi-stream mode)
   std::thread mSinkThread;
   unsigned mPipelineStageIn;
   unsigned mPipelineStageOut;
 
-  /// variables
-  unsigned mCurrentFileIdx = 0;
+  /// multi-stream mode: forwarding in the input order
+  ConcurrentFifo<ForwardEntry> mForwardQueue;
+  std::thread mForwardThread;
 };
 
 } /* o2::DataDistribution */
@@ -16,17 +16,25 @@
 #include "FilePathUtils.h"
 #include "DataDistLogger.h"
 
+#include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/program_options/options_description.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/process.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <set>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace o2::DataDistribution
 {
@@ -57,9 +65,21 @@ void SubTimeFrameFileSource::start(SyncMemoryResources &pMemRes)
 
     mRunning = true;
 
-    mFetchThread = create_thread_member("stf_file_fetch", &SubTimeFrameFileSource::DataFetcherThread, this);
-    mSourceThread = create_thread_member("stf_file_read", &SubTimeFrameFileSource::DataHandlerThread, this);
-    mInjectThread = create_thread_member("stf_file_inject", &SubTimeFrameFileSource::DataInjectThread, this);
+    if (merging()) {
+      mMergeThread = create_thread_member("stf_file_merge", &SubTimeFrameFileSource::DataMergeThread, this);
+    } else if (streamOrdered()) {
+      mMergeThread = create_thread_member("stf_file_streams", &SubTimeFrameFileSource::DataStreamMergeThread, this);
+    } else {
+      mFetchThread = create_thread_member("stf_file_fetch", &SubTimeFrameFileSource::DataFetcherThread, this);
+      for (unsigned i = 0; i < mPrefetchThreads; i++) {
+        std::string lThreadName = "stf_prefetch_" + std::to_string(i);
+        mPrefetchThreadPool.emplace_back(
+          create_thread_member(lThreadName.c_str(), &SubTimeFrameFileSource::PrefetchThread, this, i));
+      }
+      mSourceThread = create_thread_member("stf_file_read", &SubTimeFrameFileSource::DataHandlerThread, this);
+    }
+    mInjectThread = create_thread_member("stf_file_inject", (mReplayTiming == eReplayRate) ?
+      &SubTimeFrameFileSource::DataInjectThread : &SubTimeFrameFileSource::DataReplayThread, this);
   }
 }
 
@@ -72,6 +92,8 @@ void SubTimeFrameFileSource::stop()
   }
 
   mInputFileQueue.stop();
+  mPrefetchQueue.stop();
+  mPrefetchCond.notify_all();
 
   mReadStfQueue.stop();
   mReadStfQueue.flush();
@@ -80,10 +102,21 @@ void SubTimeFrameFileSource::stop()
     mFetchThread.join();
   }
 
+  for (auto &lThread : mPrefetchThreadPool) {
+    if (lThread.joinable()) {
+      lThread.join();
+    }
+  }
+  mPrefetchThreadPool.clear();
+
   if (mSourceThread.joinable()) {
     mSourceThread.join();
   }
 
+  if (mMergeThread.joinable()) {
+    mMergeThread.join();
+  }
+
   if (mInjectThread.joinable()) {
     mInjectThread.join();
   }
@@ -141,15 +174,47 @@ bpo::options_description SubTimeFrameFileSource::getProgramOptions()
     bpo::value<std::string>()->default_value(""),
     "Copy command to be used to fetch remote files. NOTE: Placeholders for source and destination file name "
     "(?src and ?dst) must be specified. E.g. \"scp user@my-server:?src ?dst\". Source placeholder will be "
-    "substituted with files provided in the file-list option.");
+    "substituted with files provided in the file-list option.")(
+    OptionKeyStfPrefetchFiles,
+    bpo::value<std::uint64_t>()->default_value(2),
+    "Number of upcoming (Sub)TimeFrame files fetched and read into the page cache while replaying the current file.")(
+    OptionKeyStfPrefetchSize,
+    bpo::value<std::uint64_t>()->default_value(4096),
+    "Limit the total size of prefetched (Sub)TimeFrame files in MiB. "
+    "Note: the limit is checked before starting to fetch the next file.")(
+    OptionKeyStfPrefetchThreads,
+    bpo::value<std::uint32_t>()->default_value(2),
+    "Number of threads fetching (copy command) and prefetching (Sub)TimeFrame files in parallel.")(
+    OptionKeyStfVerifyChecksums,
+    bpo::bool_switch()->default_value(false),
+    "Verify checksums of data blocks, if recorded in the file. (Sub)TimeFrames with invalid checksums are skipped.")(
+    OptionKeyStfReplayTiming,
+    bpo::value<std::string>()->default_value("rate"),
+    "Timing of injected (Sub)TimeFrames: 'rate' - fixed rate given by the data-source-rate option, "
+    "'write-time' - recorded write time of (Sub)TimeFrames, 'orbit' - first orbit of (Sub)TimeFrames.")(
+    OptionKeyStfReplaySpeedup,
+    bpo::value<double>()->default_value(1.0),
+    "Speed-up factor of the recorded timing (write-time and orbit replay).")(
+    OptionKeyStfReplayMaxGap,
+    bpo::value<std::uint64_t>()->default_value(1000),
+    "Recorded gaps between (Sub)TimeFrames longer than this (ms), or negative, are replaced by the data-source-rate "
+    "interval (e.g. between files, or when repeating).")(
+    OptionKeyStfMergeDirs,
+    bpo::value<std::string>()->default_value(""),
+    "Merged replay: comma separated list of directories, each containing (Sub)TimeFrame files of one FLP. "
+    "SubTimeFrames with the same id are merged into full TimeFrames.")(
+    OptionKeyStfMergeIncomplete,
+    bpo::bool_switch()->default_value(false),
+    "Merged replay: inject TimeFrames with SubTimeFrames missing from some of the FLP directories. "
+    "By default, incomplete TimeFrames are dropped.");
 
   return lSinkDesc;
 }
 
-std::vector<std::string> SubTimeFrameFileSource::getDataFileList() const
+std::vector<std::string> SubTimeFrameFileSource::getDataFileList(const std::string &pDir) const
 {
   // Load the sorted list of StfFiles
-  auto lFilesVector = FilePathUtils::getAllFiles(mDir);
+  auto lFilesVector = FilePathUtils::getAllFiles(pDir);
   // Remove side-car files
   auto lRemIt = std::remove_if(lFilesVector.begin(), lFilesVector.end(),
     [](const std::string &lElem) {
@@ -202,11 +267,67 @@ bool SubTimeFrameFileSource::loadVerifyConfig(const FairMQProgOptions& pFMQProgO
     mTfHdrRegionId = std::nullopt;
   }
 
+  mPrefetchFiles = pFMQProgOpt.GetValue<std::uint64_t>(OptionKeyStfPrefetchFiles);
+  mPrefetchSizeMB = pFMQProgOpt.GetValue<std::uint64_t>(OptionKeyStfPrefetchSize);
+  mPrefetchThreads = pFMQProgOpt.GetValue<std::uint32_t>(OptionKeyStfPrefetchThreads);
+  mVerifyChecksums = pFMQProgOpt.GetValue<bool>(OptionKeyStfVerifyChecksums);
+
+  const auto lReplayTiming = pFMQProgOpt.GetValue<std::string>(OptionKeyStfReplayTiming);
+  if (lReplayTiming == "rate") {
+    mReplayTiming = eReplayRate;
+  } else if (lReplayTiming == "write-time") {
+    mReplayTiming = eReplayWriteTime;
+  } else if (lReplayTiming == "orbit") {
+    mReplayTiming = eReplayOrbit;
+  } else {
+    EDDLOG("(Sub)TimeFrame file source: unknown replay timing. {}={}", OptionKeyStfReplayTiming, lReplayTiming);
+    return false;
+  }
+  mReplaySpeedup = pFMQProgOpt.GetValue<double>(OptionKeyStfReplaySpeedup);
+  mReplayMaxGap = std::chrono::milliseconds(pFMQProgOpt.GetValue<std::uint64_t>(OptionKeyStfReplayMaxGap));
+  if (mReplaySpeedup <= 0.) {
+    EDDLOG("(Sub)TimeFrame file source: replay speed-up must be greater than 0. {}={}",
+      OptionKeyStfReplaySpeedup, mReplaySpeedup);
+    return false;
+  }
+
   mCopyFileList = pFMQProgOpt.GetValue<std::string>(OptionKeyStfFileList);
   mCopyCmd = pFMQProgOpt.GetValue<std::string>(OptionKeyStfCopyCmd);
 
-  // initialize file fetcher
-  if (!mCopyFileList.empty() && !mCopyCmd.empty()) {
+  const auto lMergeDirs = pFMQProgOpt.GetValue<std::string>(OptionKeyStfMergeDirs);
+  mMergeIncomplete = pFMQProgOpt.GetValue<bool>(OptionKeyStfMergeIncomplete);
+
+  if (!lMergeDirs.empty()) {
+    // Merged replay of local FLP recordings
+    if (!mDir.empty() || !mCopyFileList.empty()) {
+      EDDLOG("(Sub)TimeFrame file source: merged replay cannot be used with the directory or the file copy options.");
+      return false;
+    }
+
+    std::vector<std::string> lDirs;
+    boost::split(lDirs, lMergeDirs, boost::is_any_of(","));
+    mMergeInputs.clear();
+
+    for (auto &lDir : lDirs) {
+      boost::trim(lDir);
+      if (lDir.empty()) {
+        continue;
+      }
+
+      if (!bfs::is_directory(bfs::path(lDir))) {
+        EDDLOG("(Sub)TimeFrame file source: merge directory does not exist. dir={}", lDir);
+        return false;
+      }
+
+      auto &lInput = mMergeInputs.emplace_back();
+      lInput.mDir = lDir;
+      lInput.mFiles = getDataFileList(lDir);
+      if (lInput.mFiles.empty()) {
+        EDDLOG("(Sub)TimeFrame file source: merge directory contains no data files. dir={}", lDir);
+        return false;
+      }
+    }
+  } else if (!mCopyFileList.empty() && !mCopyCmd.empty()) {
 
     if (!mDir.empty()) {
       EDDLOG("(Sub)TimeFrame file source: specifying both the directory, and the file copy options is not supported.");
@@ -270,6 +391,9 @@ bool SubTimeFrameFileSource::loadVerifyConfig(const FairMQProgOptions& pFMQProgO
       EDDLOG("(Sub)TimeFrame directory contains no data files.");
       return false;
     }
+
+    // files of parallel writer streams are replayed in the recorded order
+    buildStreamInputs();
   } else {
     EDDLOG("(Sub)TimeFrame file source: TF location not specified.");
     return false;
@@ -285,6 +409,11 @@ bool SubTimeFrameFileSource::loadVerifyConfig(const FairMQProgOptions& pFMQProgO
     return false;
   }
 
+  if (mPrefetchFiles == 0 || mPrefetchThreads == 0) {
+    EDDLOG("(Sub)TimeFrame file source: number of prefetched files and prefetch threads must be >= 1.");
+    return false;
+  }
+
   {
     const auto lTfFilesVar = getenv("DATADIST_FILE_READ_COUNT");
     if (lTfFilesVar) {
@@ -308,9 +437,13 @@ bool SubTimeFrameFileSource::loadVerifyConfig(const FairMQProgOptions& pFMQProgO
 
   // print options
   IDDLOG("(Sub)TimeFrame source :: enabled                 = {}", (mEnabled ? "yes" : "no"));
-  IDDLOG("(Sub)TimeFrame source :: file location           = {}", (mLocalFiles ? "local" : "remote"));
-  if (mLocalFiles) {
+  IDDLOG("(Sub)TimeFrame source :: file location           = {}", (merging() ? "merged" : mLocalFiles ? "local" : "remote"));
+  if (merging()) {
+    IDDLOG("(Sub)TimeFrame source :: merge directories       = {}", lMergeDirs);
+    IDDLOG("(Sub)TimeFrame source :: merge incomplete TFs    = {}", mMergeIncomplete);
+  } else if (mLocalFiles) {
     IDDLOG("(Sub)TimeFrame source :: directory               = {}", mDir);
+    IDDLOG("(Sub)TimeFrame source :: writer streams          = {}", (streamOrdered() ? mStreamInputs.size() : 1));
   } else {
     IDDLOG("(Sub)TimeFrame source :: file list               = {}", mCopyFileList);
     IDDLOG("(Sub)TimeFrame source :: copy command            = {}", mCopyCmd);
@@ -318,6 +451,15 @@ bool SubTimeFrameFileSource::loadVerifyConfig(const FairMQProgOptions& pFMQProgO
   IDDLOG("(Sub)TimeFrame source :: (s)tf load rate         = {}", mLoadRate);
   IDDLOG("(Sub)TimeFrame source :: (s)tf pre reads         = {}", mPreReadStfs);
   IDDLOG("(Sub)TimeFrame source :: repeat data             = {}", mRepeat);
+  IDDLOG("(Sub)TimeFrame source :: prefetch files          = {}", mPrefetchFiles);
+  IDDLOG("(Sub)TimeFrame source :: prefetch size(MiB)      = {}", mPrefetchSizeMB);
+  IDDLOG("(Sub)TimeFrame source :: prefetch threads        = {}", mPrefetchThreads);
+  IDDLOG("(Sub)TimeFrame source :: verify checksums        = {}", mVerifyChecksums);
+  IDDLOG("(Sub)TimeFrame source :: replay timing           = {}", lReplayTiming);
+  if (mReplayTiming != eReplayRate) {
+    IDDLOG("(Sub)TimeFrame source :: replay speed-up         = {}", mReplaySpeedup);
+    IDDLOG("(Sub)TimeFrame source :: replay max gap (ms)     = {}", mReplayMaxGap.count());
+  }
   IDDLOG("(Sub)TimeFrame source :: num files in dataset    = {}", mFilesVector.size());
   IDDLOG("(Sub)TimeFrame source :: data region id          = {}", mTfDataRegionId.has_value() ? std::to_string(mTfDataRegionId.value()) : "");
   IDDLOG("(Sub)TimeFrame source :: data region size(MiB)   = {}", mRegionSizeMB);
@@ -327,18 +469,21 @@ bool SubTimeFrameFileSource::loadVerifyConfig(const FairMQProgOptions& pFMQProgO
   return true;
 }
 
-// Fetch copy files if needed
+// Schedule upcoming files for prefetching, in the replay order
 void SubTimeFrameFileSource::DataFetcherThread()
 {
   std::size_t lFileIndex = std::size_t(-1);
-  std::uint64_t lFileErrors = 0;
   std::uint64_t lTotalFiles = 0;
-  std::uint64_t lTotalSuccessfulFiles = 0;
-
-  while (mRunning && lFileErrors < 10) {
-    if (mInputFileQueue.size() > 4) {
-      std::this_thread::sleep_for(5ms);
-      continue;
+  const std::uint64_t lPrefetchBytes = std::uint64_t(mPrefetchSizeMB) << 20;
+
+  while (mRunning && mFetchErrors < 10) {
+    // keep at most K upcoming files, within the byte budget
+    {
+      std::unique_lock lLock(mPrefetchLock);
+      if (mPrefetchPending >= mPrefetchFiles || mPrefetchBytes >= lPrefetchBytes) {
+        mPrefetchCond.wait_for(lLock, 100ms);
+        continue;
+      }
     }
 
     // get the next list
@@ -351,63 +496,182 @@ void SubTimeFrameFileSource::DataFetcherThread()
     lFileIndex = (lFileIndex + 1) % mFilesVector.size();
     lTotalFiles++;
 
+    std::shared_ptr<StfFileMeta> lFile;
+    bool lNewFile = true;
+
     if (mLocalFiles) {
-      // simply forward
-      mInputFileQueue.push(std::make_shared<StfFileMeta>(lFileIndex, mFilesVector[lFileIndex]));
+      lFile = std::make_shared<StfFileMeta>(lFileIndex, mFilesVector[lFileIndex]);
     } else {
-      // check if the file already exists in the cache
+      // check if the file already exists in the cache (or it is being fetched)
       auto lExisting = StfFileMeta::getExistingInstance(lFileIndex);
       if (lExisting) {
-        mInputFileQueue.push(lExisting.value());
+        lFile = std::move(lExisting.value());
+        lNewFile = false;
       } else {
-        // run the copy command
         const auto lDstFileName = mCopyDstPath /
           ("cache-" + std::to_string(lFileIndex) + "-" + bfs::path(mFilesVector[lFileIndex]).filename().native());
 
-        auto lRealCmd = boost::replace_all_copy(mCopyCmd, "?src", mFilesVector[lFileIndex]);
-        boost::replace_all(lRealCmd, "?dst", lDstFileName.native());
-
-        std::vector<std::string> lCopyParams { "-c", lRealCmd };
-        bp::child lCopyChild(bp::search_path("sh"), lCopyParams, bp::std_err > mCopyCmdLogFile,
-          bp::std_out > mCopyCmdLogFile);
-
-        while (!lCopyChild.wait_for(5s)) {
-          IDDLOG("(Sub)TimeFrame source: waiting for copy command. cmd='{}'", lRealCmd);
-        }
-
-        const auto lSysRet = lCopyChild.exit_code();
-        if (lSysRet != 0) {
-          WDDLOG_RL(1000, "(Sub)TimeFrame source: copy command returned non-zero exit code. cmd='{}' exit_code={}",
-            lRealCmd, lSysRet);
-        }
-
-        if (!bfs::is_regular_file(lDstFileName) || bfs::is_empty(lDstFileName)) {
-          EDDLOG("(Sub)TimeFrame source: copy command failed to fetch the file. stc_file={} dst_file={}.",
-            mFilesVector[lFileIndex], lDstFileName.native());
-          lFileErrors++;
-          continue;
-        }
-
-        auto lNewFile = std::make_shared<StfFileMeta>(lFileIndex, lDstFileName.native(), true /* delete after done */);
-        StfFileMeta::insertExistingInstance(lFileIndex, lNewFile);
-        mInputFileQueue.push(lNewFile);
+        lFile = std::make_shared<StfFileMeta>(lFileIndex, lDstFileName.native(),
+          true /* delete after done */, false /* needs fetching */);
+        StfFileMeta::insertExistingInstance(lFileIndex, lFile);
       }
     }
+    DDDLOG_RL(5000, "(Sub)TimeFrame source: scheduling file for prefetch. file={} cached={}", lFile->mFilePath, !lNewFile);
 
-    lTotalSuccessfulFiles++;
+    auto lEntry = std::make_shared<StfFilePrefetch>(std::move(lFile));
+    {
+      std::scoped_lock lLock(mPrefetchLock);
+      mPrefetchPending++;
+    }
+    mPrefetchQueue.push(lEntry);
+    mInputFileQueue.push(std::move(lEntry));
 
     // check if we are done because of DATADIST_FILE_READ_COUNT
-    if (mNumFiles > 0 && lTotalSuccessfulFiles == mNumFiles) {
+    if (mNumFiles > 0 && lTotalFiles == mNumFiles) {
       IDDLOG("(Sub)TimeFrame source: finished loading all files. DATADIST_FILE_READ_COUNT={}", mNumFiles);
       break;
     }
   }
 
-  // close the file queue to signal the next thread to exit
+  // close the file queues to signal the next threads to exit
+  mPrefetchQueue.stop();
   mInputFileQueue.stop();
   DDDLOG("Exiting file provider thread...");
 }
 
+// Run the copy command for remote files
+bool SubTimeFrameFileSource::fetchRemoteFile(StfFileMeta &pFile)
+{
+  const auto &lSrcFileName = mFilesVector[pFile.mIdx];
+  const auto &lDstFileName = pFile.mFilePath;
+
+  auto lRealCmd = boost::replace_all_copy(mCopyCmd, "?src", lSrcFileName);
+  boost::replace_all(lRealCmd, "?dst", lDstFileName);
+
+  std::vector<std::string> lCopyParams { "-c", lRealCmd };
+  bp::child lCopyChild(bp::search_path("sh"), lCopyParams, bp::std_err > mCopyCmdLogFile,
+    bp::std_out > mCopyCmdLogFile);
+
+  while (!lCopyChild.wait_for(5s)) {
+    IDDLOG("(Sub)TimeFrame source: waiting for copy command. cmd='{}'", lRealCmd);
+  }
+
+  const auto lSysRet = lCopyChild.exit_code();
+  if (lSysRet != 0) {
+    WDDLOG_RL(1000, "(Sub)TimeFrame source: copy command returned non-zero exit code. cmd='{}' exit_code={}",
+      lRealCmd, lSysRet);
+  }
+
+  if (!bfs::is_regular_file(lDstFileName) || bfs::is_empty(lDstFileName)) {
+    EDDLOG("(Sub)TimeFrame source: copy command failed to fetch the file. stc_file={} dst_file={}.",
+      lSrcFileName, lDstFileName);
+    return false;
+  }
+
+  return true;
+}
+
+// Read the file into the page cache, ahead of mapping it for reading
+bool SubTimeFrameFileSource::warmFile(StfFilePrefetch &pEntry)
+{
+  const int lFd = ::open(pEntry.mFile->mFilePath.c_str(), O_RDONLY);
+  if (lFd < 0) {
+    EDDLOG("(Sub)TimeFrame source: cannot open the file for prefetching. file={} errno={}",
+      pEntry.mFile->mFilePath, errno);
+    return false;
+  }
+
+  const auto lSize = ::lseek(lFd, 0, SEEK_END);
+  if (lSize > 0) {
+    pEntry.mSize = lSize;
+#if __linux__
+    // readahead() blocks until the whole range is submitted
+    if (::readahead(lFd, 0, pEntry.mSize) != 0) {
+      ::posix_fadvise(lFd, 0, pEntry.mSize, POSIX_FADV_WILLNEED);
+    }
+#else
+    ::posix_fadvise(lFd, 0, pEntry.mSize, POSIX_FADV_WILLNEED);
+#endif
+  }
+
+  ::close(lFd);
+  return lSize > 0;
+}
+
+/// File prefetching threads
+void SubTimeFrameFileSource::PrefetchThread(const unsigned pIdx)
+{
+  DDDLOG("Starting file prefetch thread {}...", pIdx);
+
+  std::shared_ptr<StfFilePrefetch> lEntry;
+  while (mPrefetchQueue.pop(lEntry)) {
+    auto &lFile = *lEntry->mFile;
+    bool lValid = mRunning.load();
+
+    // fetch remote files only once, other threads wait for the copy to complete
+    if (lValid) {
+      std::scoped_lock lFetchLock(lFile.mFetchLock);
+      if (!lFile.mFetched) {
+        lFile.mFetchFailed = !fetchRemoteFile(lFile);
+        lFile.mFetched = true;
+        if (lFile.mFetchFailed) {
+          mFetchErrors++;
+        }
+      }
+      lValid = !lFile.mFetchFailed;
+    }
+
+    lValid = lValid && warmFile(*lEntry);
+
+    {
+      std::scoped_lock lLock(mPrefetchLock);
+      lEntry->mValid = lValid;
+      lEntry->mReady = true;
+      mPrefetchBytes += lEntry->mSize;
+    }
+    mPrefetchCond.notify_all();
+
+    DDDLOG_RL(5000, "(Sub)TimeFrame source: prefetched file={} size={} valid={}",
+      lFile.mFilePath, lEntry->mSize, lValid);
+    lEntry.reset();
+  }
+
+  DDDLOG("Exiting file prefetch thread {}...", pIdx);
+}
+
+bool SubTimeFrameFileSource::waitFileReady(StfFilePrefetch &pEntry)
+{
+  std::unique_lock lLock(mPrefetchLock);
+  mPrefetchPending--;
+  mPrefetchCond.notify_all();
+
+  if (pEntry.mReady) {
+    mPrefetchHits++;
+  } else {
+    mPrefetchMisses++;
+
+    const auto lStallStart = std::chrono::steady_clock::now();
+    while (mRunning && !pEntry.mReady) {
+      mPrefetchCond.wait_for(lLock, 100ms);
+    }
+    mPrefetchStallTime += std::chrono::steady_clock::now() - lStallStart;
+  }
+
+  DDDLOG_RL(5000, "(Sub)TimeFrame source: prefetch hits={} misses={} stall_time_ms={:.3f} prefetched_mb={:.3f}",
+    mPrefetchHits, mPrefetchMisses, mPrefetchStallTime.count() * 1000., double(mPrefetchBytes) / double(1 << 20));
+
+  return pEntry.mReady && pEntry.mValid;
+}
+
+void SubTimeFrameFileSource::releaseFile(const StfFilePrefetch &pEntry)
+{
+  {
+    std::scoped_lock lLock(mPrefetchLock);
+    mPrefetchBytes -= std::min(mPrefetchBytes, pEntry.mSize);
+  }
+  mPrefetchCond.notify_all();
+}
+
 /// File reading thread
 void SubTimeFrameFileSource::DataHandlerThread()
 {
@@ -416,16 +680,26 @@ void SubTimeFrameFileSource::DataHandlerThread()
 
   while (mRunning) {
 
-    std::shared_ptr<StfFileMeta> lMyFile;
-    if (!mRunning || !mInputFileQueue.pop(lMyFile)) {
+    std::shared_ptr<StfFilePrefetch> lMyEntry;
+    if (!mRunning || !mInputFileQueue.pop(lMyEntry)) {
       IDDLOG("(Sub)TimeFrame Source: Finished reading all input files. Exiting...");
       break;
     }
-    assert(lMyFile);
+    assert(lMyEntry);
+
+    if (!waitFileReady(*lMyEntry)) {
+      releaseFile(*lMyEntry);
+      const auto lIdx = lMyEntry->mFile->mIdx;
+      lMyEntry.reset();
+      StfFileMeta::putExistingInstance(lIdx);
+      continue;
+    }
 
+    auto lMyFile = lMyEntry->mFile;
     DDDLOG_RL(5000, "(Sub)TimeFrame Source: reading new file={}", lMyFile->mFilePath);
     auto lFileNameAbs = bfs::path(lMyFile->mFilePath);
     SubTimeFrameFileReader lStfReader(lFileNameAbs);
+    lStfReader.setVerifyChecksums(mVerifyChecksums);
 
     try {
       // load multiple TF per file
@@ -455,12 +729,18 @@ void SubTimeFrameFileSource::DataHandlerThread()
         lMyFile->mFilePath, lMyFile->mIdx);
     }
 
+    releaseFile(*lMyEntry);
+
     // make sure we release the file first befor put call
     const auto lIdx = lMyFile->mIdx;
     lMyFile.reset();
+    lMyEntry.reset();
     StfFileMeta::putExistingInstance(lIdx);
   }
 
+  IDDLOG("(Sub)TimeFrame Source: file prefetch hits={} misses={} stall_time_ms={:.3f}",
+    mPrefetchHits, mPrefetchMisses, mPrefetchStallTime.count() * 1000.);
+
   // notify the injection thread to stop
   mReadStfQueue.stop();
 
@@ -468,6 +748,305 @@ void SubTimeFrameFileSource::DataHandlerThread()
 }
 
 
+bool SubTimeFrameFileSource::buildMergeIndex(MergeInput &pInput)
+{
+  pInput.mStfFiles.clear();
+
+  for (std::size_t lFileIdx = 0; lFileIdx < pInput.mFiles.size(); lFileIdx++) {
+    auto lFileName = bfs::path(pInput.mFiles[lFileIdx]);
+    SubTimeFrameFileReader lReader(lFileName);
+
+    // STFs of different FLPs are aligned by id
+    if (lReader.hasOrdinalIds()) {
+      EDDLOG("(Sub)TimeFrame Source: merged replay requires STF ids. The file does not record STF ids, "
+        "and its data has no TF counter (file version < 3). dir={} file={}", pInput.mDir, pInput.mFiles[lFileIdx]);
+      return false;
+    }
+
+    // STF directory from the file footer, or scanned for older files
+    for (const auto &lEntry : lReader.directory()) {
+      if (!pInput.mStfFiles.emplace(lEntry.mStfId, lFileIdx).second) {
+        WDDLOG_RL(1000, "(Sub)TimeFrame Source: duplicate STF id in the merge directory. dir={} stf_id={} file={}",
+          pInput.mDir, lEntry.mStfId, pInput.mFiles[lFileIdx]);
+      }
+    }
+  }
+
+  IDDLOG("(Sub)TimeFrame Source: merge directory indexed. dir={} files={} stfs={}",
+    pInput.mDir, pInput.mFiles.size(), pInput.mStfFiles.size());
+  return true;
+}
+
+std::unique_ptr<SubTimeFrame> SubTimeFrameFileSource::readMergeStf(MergeInput &pInput, const std::uint64_t pStfId)
+{
+  const auto lFileIt = pInput.mStfFiles.find(pStfId);
+  if (lFileIt == pInput.mStfFiles.end()) {
+    return nullptr;
+  }
+
+  // keep the current file open: STFs are merged in the id order
+  if (pInput.mCurrentFileIdx != lFileIt->second || !pInput.mReader) {
+    auto lFileName = bfs::path(pInput.mFiles[lFileIt->second]);
+    pInput.mReader = std::make_unique<SubTimeFrameFileReader>(lFileName);
+    pInput.mReader->setVerifyChecksums(mVerifyChecksums);
+    pInput.mCurrentFileIdx = lFileIt->second;
+  }
+
+  if (!pInput.mReader->seekStf(pStfId)) {
+    return nullptr;
+  }
+
+  auto lStf = pInput.mReader->read(*mFileBuilder);
+  if (lStf) {
+    lStf->updateId(pStfId);
+  }
+  return lStf;
+}
+
+/// Merged replay: read STFs of all FLP recordings, and merge them into full TFs
+void SubTimeFrameFileSource::DataMergeThread()
+{
+  const std::chrono::microseconds lIntervalUs(mLoadRate > 0. ? unsigned(1000000. / mLoadRate) : 0);
+
+  // align STFs by id
+  std::set<std::uint64_t> lStfIds;
+  for (auto &lInput : mMergeInputs) {
+    if (!buildMergeIndex(lInput)) {
+      EDDLOG("(Sub)TimeFrame Source: merged replay stopped.");
+      mReadStfQueue.stop();
+      return;
+    }
+    for (const auto &lStfFile : lInput.mStfFiles) {
+      lStfIds.insert(lStfFile.first);
+    }
+  }
+
+  std::uint64_t lNumTfs = 0;
+  std::uint64_t lNumIncomplete = 0;
+  std::uint64_t lNumDropped = 0;
+
+  // TF ids keep increasing when repeating
+  const std::uint64_t lIdRange = lStfIds.empty() ? 0 : (*lStfIds.rbegin() - *lStfIds.begin() + 1);
+  std::uint64_t lIdOffset = 0;
+
+  do {
+    for (const auto lStfId : lStfIds) {
+      if (!mRunning) {
+        break;
+      }
+
+      std::unique_ptr<SubTimeFrame> lTf;
+      std::size_t lNumStfs = 0;
+
+      for (auto &lInput : mMergeInputs) {
+        std::unique_ptr<SubTimeFrame> lStf;
+        try {
+          lStf = readMergeStf(lInput, lStfId);
+        } catch (...) {
+          EDDLOG_RL(1000, "(Sub)TimeFrame Source: error while reading the STF. dir={} stf_id={}", lInput.mDir, lStfId);
+        }
+
+        if (!lStf) {
+          continue;
+        }
+
+        lNumStfs++;
+        if (!lTf) {
+          lTf = std::move(lStf);
+        } else {
+          lTf->mergeStf(std::move(lStf), lInput.mDir);
+        }
+      }
+
+      if (!mRunning || !lTf) {
+        continue;
+      }
+
+      if (lNumStfs < mMergeInputs.size()) {
+        lNumIncomplete++;
+        DDDLOG_RL(5000, "(Sub)TimeFrame Source: incomplete TF. tf_id={} stfs={} flps={}",
+          lStfId, lNumStfs, mMergeInputs.size());
+
+        if (!mMergeIncomplete) {
+          lNumDropped++;
+          continue;
+        }
+      }
+
+      // adapt Stf headers for different output channels, native or DPL
+      lTf->updateId(lStfId + lIdOffset);
+      mFileBuilder->adaptHeaders(lTf.get());
+      if (!mReadStfQueue.push(std::move(lTf))) {
+        break;
+      }
+      lNumTfs++;
+
+      DDDLOG_RL(5000, "(Sub)TimeFrame Source: merged TFs={} incomplete={} dropped={}",
+        lNumTfs, lNumIncomplete, lNumDropped);
+
+      // Limit read-ahead
+      while (mRunning && (mReadStfQueue.size() >= mPreReadStfs)) {
+        std::this_thread::sleep_for(mPaused ? lIntervalUs : (lIntervalUs / 10));
+      }
+    }
+    lIdOffset += lIdRange;
+  } while (mRunning && mRepeat && !lStfIds.empty());
+
+  IDDLOG("(Sub)TimeFrame Source: finished merging. tfs={} incomplete={} dropped={}",
+    lNumTfs, lNumIncomplete, lNumDropped);
+
+  // release all files
+  for (auto &lInput : mMergeInputs) {
+    lInput.mReader.reset();
+  }
+
+  // notify the injection thread to stop
+  mReadStfQueue.stop();
+
+  DDDLOG("Exiting file source merge thread...");
+}
+
+void SubTimeFrameFileSource::buildStreamInputs()
+{
+  mStreamInputs.clear();
+
+  // stream index -> (first sequence, file)
+  std::map<std::uint32_t, std::vector<std::pair<std::uint64_t, std::string>>> lStreamFiles;
+  bool lMultiStream = false;
+
+  for (const auto &lFile : mFilesVector) {
+    SubTimeFrameFileReader lReader(bfs::path(lFile));
+    SubTimeFrameFileReader::StfHeaders lHdrs;
+
+    if (!lReader.readHeaders(lHdrs)) {
+      WDDLOG("(Sub)TimeFrame source: cannot read the first STF of the file. file={}", lFile);
+      continue;
+    }
+
+    // the order is recorded from version 3
+    const auto &lOrder = lHdrs.mOrder;
+    if (!lOrder.mValid || lOrder.mOrder.mNumStreams <= 1) {
+      if (lMultiStream) {
+        WDDLOG("(Sub)TimeFrame source: directory mixes single and multi-stream files. Replaying in the file order.");
+      }
+      return;
+    }
+
+    lMultiStream = true;
+    lStreamFiles[lOrder.mOrder.mStreamIdx].emplace_back(lOrder.mOrder.mSequence, lFile);
+  }
+
+  if (!lMultiStream) {
+    return;
+  }
+
+  for (auto &lStream : lStreamFiles) {
+    std::sort(lStream.second.begin(), lStream.second.end());
+
+    auto &lInput = mStreamInputs.emplace_back();
+    for (auto &lFile : lStream.second) {
+      lInput.mFiles.push_back(std::move(lFile.second));
+    }
+  }
+
+  IDDLOG("(Sub)TimeFrame source: multi-stream recording. STFs are replayed in the recorded order. streams={} files={}",
+    mStreamInputs.size(), mFilesVector.size());
+}
+
+bool SubTimeFrameFileSource::readStreamStf(StreamInput &pInput)
+{
+  pInput.mNextStf.reset();
+
+  while (mRunning) {
+    if (!pInput.mReader) {
+      if (pInput.mNextFileIdx >= pInput.mFiles.size()) {
+        return false; // end of the stream
+      }
+
+      auto lFileName = bfs::path(pInput.mFiles[pInput.mNextFileIdx++]);
+      pInput.mReader = std::make_unique<SubTimeFrameFileReader>(lFileName);
+      pInput.mReader->setVerifyChecksums(mVerifyChecksums);
+    }
+
+    std::unique_ptr<SubTimeFrame> lStf;
+    try {
+      lStf = pInput.mReader->read(*mFileBuilder);
+    } catch (...) {
+      EDDLOG("(Sub)TimeFrame Source: error while reading (S)TFs from file. file={}",
+        pInput.mFiles[pInput.mNextFileIdx - 1]);
+    }
+
+    if (lStf) {
+      pInput.mNextSequence = pInput.mReader->lastStfOrder().mOrder.mSequence;
+      pInput.mNextStf = std::move(lStf);
+      return true;
+    }
+
+    // EOF or a bad file: continue with the next file of the stream
+    pInput.mReader.reset();
+  }
+  return false;
+}
+
+/// Multi-stream replay: merge STFs of the writer streams by the recorded sequence number
+void SubTimeFrameFileSource::DataStreamMergeThread()
+{
+  const std::chrono::microseconds lIntervalUs(mLoadRate > 0. ? unsigned(1000000. / mLoadRate) : 0);
+
+  std::uint64_t lNumStfs = 0;
+
+  do {
+    // start all streams from the first file
+    for (auto &lInput : mStreamInputs) {
+      lInput.mNextFileIdx = 0;
+      lInput.mReader.reset();
+      readStreamStf(lInput);
+    }
+
+    while (mRunning) {
+      // next STF in the recorded order: the lowest sequence of all streams
+      StreamInput *lNext = nullptr;
+      for (auto &lInput : mStreamInputs) {
+        if (lInput.mNextStf && (!lNext || lInput.mNextSequence < lNext->mNextSequence)) {
+          lNext = &lInput;
+        }
+      }
+
+      if (!lNext) {
+        break; // all streams are done
+      }
+
+      auto lStf = std::move(lNext->mNextStf);
+      readStreamStf(*lNext);
+
+      // adapt Stf headers for different output channels, native or DPL
+      mFileBuilder->adaptHeaders(lStf.get());
+      if (!mReadStfQueue.push(std::move(lStf))) {
+        break;
+      }
+      lNumStfs++;
+
+      // Limit read-ahead
+      while (mRunning && (mReadStfQueue.size() >= mPreReadStfs)) {
+        std::this_thread::sleep_for(mPaused ? lIntervalUs : (lIntervalUs / 10));
+      }
+    }
+  } while (mRunning && mRepeat);
+
+  IDDLOG("(Sub)TimeFrame Source: finished reading the writer streams. stfs={}", lNumStfs);
+
+  // release all files
+  for (auto &lInput : mStreamInputs) {
+    lInput.mNextStf.reset();
+    lInput.mReader.reset();
+  }
+
+  // notify the injection thread to stop
+  mReadStfQueue.stop();
+
+  DDDLOG("Exiting file source stream merge thread...");
+}
+
 /// STF injecting thread
 void SubTimeFrameFileSource::DataInjectThread()
 {
@@ -526,4 +1105,135 @@ void SubTimeFrameFileSource::DataInjectThread()
   DDDLOG("Exiting file source inject thread...");
 }
 
+std::optional<std::int64_t> SubTimeFrameFileSource::recordedTimeNs(const SubTimeFrame &pStf) const
+{
+  // LHC orbit: 3564 bunch crossings of 24.95 ns
+  static constexpr double sOrbitPeriodNs = 88924.;
+
+  switch (mReplayTiming) {
+    case eReplayWriteTime:
+      if (pStf.header().mCreationTimeMs != SubTimeFrame::Header::sInvalidTimeMs) {
+        return std::int64_t(pStf.header().mCreationTimeMs) * 1000000;
+      }
+      break;
+    case eReplayOrbit:
+      if (pStf.header().mFirstOrbit != std::numeric_limits<std::uint32_t>::max()) {
+        return std::int64_t(double(pStf.header().mFirstOrbit) * sOrbitPeriodNs);
+      }
+      break;
+    default:
+      break;
+  }
+
+  return std::nullopt;
+}
+
+/// STF injecting thread: recorded timing
+void SubTimeFrameFileSource::DataReplayThread()
+{
+  using clock = std::chrono::steady_clock;
+
+  // used when the recorded timing is not available, or the gap is not valid
+  const auto lNominalInterval = std::chrono::nanoseconds(mLoadRate > 0. ? std::int64_t(1e9 / mLoadRate) : 0);
+  const auto lMaxGapNs = std::chrono::duration_cast<std::chrono::nanoseconds>(mReplayMaxGap).count();
+
+  IDDLOG("(Sub)TimeFrame Source: Injecting STFs with recorded timing. speed-up={}", mReplaySpeedup);
+
+  std::optional<std::int64_t> lPrevRecordedNs;
+  clock::time_point lStart;
+  clock::time_point lDeadline;
+  std::chrono::nanoseconds lRequestedTime(0); // sum of all (scaled) gaps
+
+  // timing error stats
+  std::uint64_t lNumInjected = 0;
+  std::uint64_t lNumInvalidGaps = 0;
+  double lLatenessSumUs = 0.;
+  double lLatenessMaxUs = 0.;
+
+  auto lReportFn = [&](const bool pFinal) {
+    const double lAchievedS = std::chrono::duration<double>(clock::now() - lStart).count();
+    const double lRequestedS = std::chrono::duration<double>(lRequestedTime).count();
+    const double lMeanUs = lNumInjected > 0 ? (lLatenessSumUs / lNumInjected) : 0.;
+
+    if (pFinal) {
+      IDDLOG("(Sub)TimeFrame Source: replay injected={} invalid_gaps={} requested_s={:.3f} achieved_s={:.3f} "
+        "mean_lateness_us={:.1f} max_lateness_us={:.1f}", lNumInjected, lNumInvalidGaps, lRequestedS, lAchievedS,
+        lMeanUs, lLatenessMaxUs);
+    } else {
+      DDDLOG_RL(5000, "(Sub)TimeFrame Source: replay injected={} invalid_gaps={} requested_s={:.3f} achieved_s={:.3f} "
+        "mean_lateness_us={:.1f} max_lateness_us={:.1f} prepared_tfs={}", lNumInjected, lNumInvalidGaps, lRequestedS,
+        lAchievedS, lMeanUs, lLatenessMaxUs, mReadStfQueue.size());
+    }
+  };
+
+  while (mRunning) {
+
+    // Get the next STF
+    std::unique_ptr<SubTimeFrame> lStf;
+    if (!mReadStfQueue.pop(lStf)) {
+      break;
+    }
+
+    // deadline of the STF: recorded gap to the previous STF, scaled
+    const auto lRecordedNs = recordedTimeNs(*lStf);
+
+    if (lNumInjected == 0) {
+      lStart = clock::now();
+      lDeadline = lStart;
+    } else {
+      std::chrono::nanoseconds lGap = lNominalInterval;
+      if (lRecordedNs && lPrevRecordedNs && (*lRecordedNs >= *lPrevRecordedNs) &&
+        ((*lRecordedNs - *lPrevRecordedNs) <= lMaxGapNs)) {
+        lGap = std::chrono::nanoseconds(std::int64_t(double(*lRecordedNs - *lPrevRecordedNs) / mReplaySpeedup));
+      } else {
+        lNumInvalidGaps++;
+      }
+
+      lDeadline += lGap;
+      lRequestedTime += lGap;
+    }
+    lPrevRecordedNs = lRecordedNs;
+
+    // wait for the deadline. Limit sleep time to 0.5s in order to be able to check for exit signal.
+    while (mRunning) {
+      if (mPaused) {
+        // do not count the paused time
+        const auto lPauseStart = clock::now();
+        while (mRunning && mPaused) {
+          std::this_thread::sleep_for(200ms);
+        }
+        const auto lPaused = clock::now() - lPauseStart;
+        lDeadline += lPaused;
+        lStart += lPaused;
+        continue;
+      }
+
+      const auto lNow = clock::now();
+      if (lNow >= lDeadline) {
+        break;
+      }
+      std::this_thread::sleep_until(std::min(lDeadline, lNow + std::chrono::milliseconds(500)));
+    }
+
+    if (!mRunning) {
+      break;
+    }
+
+    const double lLatenessUs = std::chrono::duration<double, std::micro>(clock::now() - lDeadline).count();
+    mPipelineI.queue(mPipelineStageOut, std::move(lStf));
+
+    lNumInjected++;
+    lLatenessSumUs += lLatenessUs;
+    lLatenessMaxUs = std::max(lLatenessMaxUs, lLatenessUs);
+
+    lReportFn(false);
+  }
+
+  lReportFn(true);
+
+  mPipelineI.close(mPipelineStageOut);
+
+  DDDLOG("Exiting file source replay thread...");
+}
+
 } /* o2::DataDistribution */
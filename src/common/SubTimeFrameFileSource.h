@@ -16,13 +16,19 @@
 
 #include "ConcurrentQueue.h"
 #include "SubTimeFrameBuilder.h"
+#include "SubTimeFrameFileReader.h"
 
 #include "DataDistLogger.h"
 
 #include <boost/program_options/options_description.hpp>
 #include <boost/filesystem.hpp>
 
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <vector>
 
 namespace o2::DataDistribution
@@ -33,7 +39,6 @@ namespace bpo = boost::program_options;
 ////////////////////////////////////////////////////////////////////////////////
 /// SubTimeFrameFileSource
 ////////////////////////////////////////////////////////////////////////////////
-class SubTimeFrameFileReader;
 class SubTimeFrame;
 
 class SubTimeFrameFileSource
@@ -73,8 +78,8 @@ class SubTimeFrameFileSource
     }
 
     StfFileMeta() = delete;
-    StfFileMeta(const std::size_t pIdx, const std::string &pPath, bool pDelete = false)
-    : mFilePath(pPath), mIdx(pIdx), mDeleteMe(pDelete) { }
+    StfFileMeta(const std::size_t pIdx, const std::string &pPath, bool pDelete = false, bool pFetched = true)
+    : mFilePath(pPath), mIdx(pIdx), mDeleteMe(pDelete), mFetched(pFetched) { }
 
     StfFileMeta(const StfFileMeta &) = delete;
 
@@ -89,6 +94,21 @@ class SubTimeFrameFileSource
     std::string mFilePath;
     std::size_t mIdx;
     bool mDeleteMe;
+
+    /// remote files are fetched once by the first prefetch thread
+    std::mutex mFetchLock;
+    bool mFetched;
+    bool mFetchFailed = false;
+  };
+
+  /// Upcoming file in the replay order, fetched and page-warmed by prefetch threads
+  struct StfFilePrefetch {
+    StfFilePrefetch(std::shared_ptr<StfFileMeta> pFile) : mFile(std::move(pFile)) { }
+
+    std::shared_ptr<StfFileMeta> mFile;
+    std::uint64_t mSize = 0;
+    bool mValid = false;
+    bool mReady = false; // protected by mPrefetchLock
   };
 
  public:
@@ -105,6 +125,23 @@ class SubTimeFrameFileSource
   static constexpr const char* OptionKeyStfFileList = "data-source-file-list";
   static constexpr const char* OptionKeyStfCopyCmd = "data-source-copy-cmd";
 
+  static constexpr const char* OptionKeyStfPrefetchFiles = "data-source-prefetch-files";
+  static constexpr const char* OptionKeyStfPrefetchSize = "data-source-prefetch-size";
+  static constexpr const char* OptionKeyStfPrefetchThreads = "data-source-prefetch-threads";
+  static constexpr const char* OptionKeyStfVerifyChecksums = "data-source-verify-checksums";
+  static constexpr const char* OptionKeyStfReplayTiming = "data-source-replay-timing";
+  static constexpr const char* OptionKeyStfReplaySpeedup = "data-source-replay-speedup";
+  static constexpr const char* OptionKeyStfReplayMaxGap = "data-source-replay-max-gap-ms";
+  static constexpr const char* OptionKeyStfMergeDirs = "data-source-merge-dirs";
+  static constexpr const char* OptionKeyStfMergeIncomplete = "data-source-merge-incomplete";
+
+  /// Source of the inter-STF timing
+  enum ReplayTiming {
+    eReplayRate,      // fixed data-source-rate
+    eReplayWriteTime, // recorded write time of STFs (ms resolution)
+    eReplayOrbit      // first orbit of STFs
+  };
+
 
   static bpo::options_description getProgramOptions();
 
@@ -124,7 +161,8 @@ class SubTimeFrameFileSource
   }
 
   bool loadVerifyConfig(const FairMQProgOptions& pFMQProgOpt);
-  std::vector<std::string> getDataFileList() const;
+  std::vector<std::string> getDataFileList() const { return getDataFileList(mDir); }
+  std::vector<std::string> getDataFileList(const std::string &pDir) const;
 
   bool enabled() const { return mEnabled; }
 
@@ -134,8 +172,12 @@ class SubTimeFrameFileSource
   void stop();
 
   void DataFetcherThread();
+  void PrefetchThread(const unsigned pIdx);
   void DataHandlerThread();
   void DataInjectThread();
+  void DataReplayThread();
+  void DataMergeThread();
+  void DataStreamMergeThread();
 
  private:
   stf_pipeline& mPipelineI;
@@ -143,8 +185,26 @@ class SubTimeFrameFileSource
   unsigned mPipelineStageOut;
   std::unique_ptr<SubTimeFrameFileBuilder> mFileBuilder;
 
-  /// File feed pipe
-  ConcurrentFifo<std::shared_ptr<StfFileMeta>> mInputFileQueue;
+  /// File feed pipe (replay order)
+  ConcurrentFifo<std::shared_ptr<StfFilePrefetch>> mInputFileQueue;
+
+  /// Prefetch: fetch, map, and warm the upcoming files
+  bool fetchRemoteFile(StfFileMeta &pFile);
+  bool warmFile(StfFilePrefetch &pEntry);
+  bool waitFileReady(StfFilePrefetch &pEntry);
+  void releaseFile(const StfFilePrefetch &pEntry);
+
+  ConcurrentFifo<std::shared_ptr<StfFilePrefetch>> mPrefetchQueue;
+  std::mutex mPrefetchLock;
+  std::condition_variable mPrefetchCond;
+  std::size_t mPrefetchPending = 0;     // files queued, not yet opened for reading
+  std::uint64_t mPrefetchBytes = 0;     // warmed bytes not yet consumed
+  std::atomic_uint64_t mFetchErrors = 0;
+
+  /// Prefetch stats
+  std::uint64_t mPrefetchHits = 0;
+  std::uint64_t mPrefetchMisses = 0;
+  std::chrono::duration<double> mPrefetchStallTime{0};
 
   /// Configuration
   bool mEnabled = false;
@@ -165,6 +225,54 @@ class SubTimeFrameFileSource
   std::optional<std::uint16_t> mTfDataRegionId = std::nullopt;
   std::size_t mHdrRegionSizeMB = 256;
   std::optional<std::uint16_t> mTfHdrRegionId = std::nullopt;
+  std::size_t mPrefetchFiles = 2;
+  std::size_t mPrefetchSizeMB = 4096;
+  unsigned mPrefetchThreads = 2;
+  bool mVerifyChecksums = false;
+
+  ReplayTiming mReplayTiming = eReplayRate;
+  double mReplaySpeedup = 1.0;
+  std::chrono::milliseconds mReplayMaxGap{1000};
+
+  /// Merged replay: files of each FLP recording are in a separate directory
+  struct MergeInput {
+    std::string mDir;
+    std::vector<std::string> mFiles;
+    /// STF id -> file index
+    std::map<std::uint64_t, std::size_t> mStfFiles;
+
+    /// reader of the current file
+    std::size_t mCurrentFileIdx = std::size_t(-1);
+    std::unique_ptr<SubTimeFrameFileReader> mReader;
+  };
+
+  std::vector<MergeInput> mMergeInputs;
+  bool mMergeIncomplete = false;
+
+  bool merging() const { return !mMergeInputs.empty(); }
+  bool buildMergeIndex(MergeInput &pInput);
+  std::unique_ptr<SubTimeFrame> readMergeStf(MergeInput &pInput, const std::uint64_t pStfId);
+
+  /// Multi-stream recordings (parallel writer streams of the file sink): files of each stream are ordered
+  /// by their first sequence number, and STFs of all streams are replayed in the recorded sequence order
+  struct StreamInput {
+    std::vector<std::string> mFiles;
+
+    std::size_t mNextFileIdx = 0;
+    std::unique_ptr<SubTimeFrameFileReader> mReader;
+    /// next STF of the stream, and its sequence number
+    std::unique_ptr<SubTimeFrame> mNextStf;
+    std::uint64_t mNextSequence = 0;
+  };
+
+  std::vector<StreamInput> mStreamInputs;
+
+  bool streamOrdered() const { return !mStreamInputs.empty(); }
+  void buildStreamInputs();
+  bool readStreamStf(StreamInput &pInput);
+
+  /// recorded time of the STF in ns, for the timed replay
+  std::optional<std::int64_t> recordedTimeNs(const SubTimeFrame &pStf) const;
 
   /// Thread for file writing
   std::atomic_bool mRunning = false;
@@ -172,6 +280,8 @@ class SubTimeFrameFileSource
   ConcurrentFifo<std::unique_ptr<SubTimeFrame>> mReadStfQueue;
 
   std::thread mFetchThread;
+  std::thread mMergeThread;
+  std::vector<std::thread> mPrefetchThreadPool;
   std::thread mSourceThread;
   std::thread mInjectThread;
 };
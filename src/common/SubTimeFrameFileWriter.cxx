@@ -12,6 +12,8 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "SubTimeFrameFile.h"
+#include "SubTimeFrameFileChecksum.h"
+#include "SubTimeFrameFileSidecar.h"
 #include "SubTimeFrameFileWriter.h"
 
 #include "DataDistLogger.h"
@@ -19,6 +21,11 @@
 #include <iomanip>
 #include <string>
 
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace o2
 {
 namespace DataDistribution
@@ -30,85 +37,20 @@ using namespace std::string_literals;
 ////////////////////////////////////////////////////////////////////////////////
 /// SubTimeFrameFileWriter
 ////////////////////////////////////////////////////////////////////////////////
-namespace impl {
-  struct SidecarInfoData {
-    const char *mHdrFmt;  // not including sep
-    const char *mHdr;
-    const char *mValFmt;
-  };
-
-  enum SidecarInfoDataType {
-    TF_ID = 0,
-    TF_OFFSET,
-    TF_SIZE,
-    ORIGIN,
-    DESC,
-    SUBSPEC,
-    DATA_IDX,
-    HDR_OFF,
-    HDR_SIZE,
-    DATA_OFF,
-    DATA_SIZE,
-    RDH_MEM_SIZE,
-    RDH_STOP_BIT,
-    RDH_FEE_ID,
-    RDH_ORBIT,
-    RDH_BC,
-    RDH_TRG,
-  };
-
-  static const SidecarInfoData sInfoData[] = {
-    { "{:<10}", "TF_ID",        "{:<10d}"   },
-    { "{:<10}", "TF_OFFSET",    "{:<10d}"   },
-    { "{:<9}",  "TF_SIZE",      "{:<9d}"    },
-    { "{:<6}",  "ORIGIN",       "{:<6}"     },
-    { "{:<9}",  "DESC",         "{:<9}"     },
-    { "{:<10}", "SUBSPEC",      "{:<#010x}" },
-    { "{:<8}",  "DATA_IDX",     "{:<8}"     },
-    { "{:<10}", "HDR_OFF",      "{:<10}"    },
-    { "{:<8}",  "HDR_SIZE",     "{:<8}"     },
-    { "{:<10}", "DATA_OFF",     "{:<10}"    },
-    { "{:<9}",  "DATA_SIZE",    "{:<9}"     },
-    { "{:<12}", "RDH_MEM_SIZE", "{:<12}"    },
-    { "{:<12}", "RDH_STOP_BIT", "{:<12}"    },
-    { "{:<10}", "RDH_FEE_ID",   "{:<10}"    },
-    { "{:<12}", "RDH_ORBIT",    "{:<#12d}"  },
-    { "{:<10}", "RDH_BC",       "{:<#10d}"  },
-    { "{:<10}", "RDH_TRG",      "{:<#010x}" },
-  };
-
-  static std::string sInfoToHdrString() {
-    fmt::memory_buffer lHeader;
-    const auto lHdrCnt = sizeof(sInfoData) / sizeof(SidecarInfoData);
-
-    for (std::size_t i = 0; i < lHdrCnt; i++) {
-      fmt::format_to(fmt::appender(lHeader), sInfoData[i].mHdrFmt, sInfoData[i].mHdr);
-      fmt::format_to(fmt::appender(lHeader), "{}", (i < lHdrCnt - 1) ? " " : "");
-    }
-
-    return std::string(std::string(lHeader.begin(), lHeader.end()));
-  }
-
-  template<class T>
-  static void sInfoVal(fmt::memory_buffer &pBuf, const SidecarInfoDataType pType, const T& pVal) {
-    const auto lHdrCnt = sizeof(sInfoData) / sizeof(SidecarInfoData);
-    fmt::format_to(fmt::appender(pBuf), sInfoData[pType].mValFmt, pVal);
-    fmt::format_to(fmt::appender(pBuf), "{}", (pType < lHdrCnt - 1) ? " " : "");
-  }
-}
 
-SubTimeFrameFileWriter::SubTimeFrameFileWriter(const boost::filesystem::path& pFileName, bool pWriteInfo)
+SubTimeFrameFileWriter::SubTimeFrameFileWriter(const boost::filesystem::path& pFileName, bool pWriteInfo,
+                                               SubTimeFrameFileCompressor *pCompressor,
+                                               const StfFileChecksum pChecksum,
+                                               const bool pWriteDirectory)
   : mFileName(pFileName),
-    mWriteInfo(pWriteInfo)
+    mWriteInfo(pWriteInfo),
+    mCompressor(pCompressor),
+    mChecksum(pChecksum),
+    mWriteDirectory(pWriteDirectory)
 {
   using ios = std::ios_base;
 
-  // allocate and set the larger stream buffer
-  mFileBuf = std::make_unique<char[]>(sBuffSize);
-  mFile.rdbuf()->pubsetbuf(mFileBuf.get(), sBuffSize);
-  mFile.clear();
-  mFile.exceptions(std::fstream::failbit | std::fstream::badbit);
-  // allocate and set the larger stream buffer (info file)
+  // allocate and set the larger stream buffer (sidecar file)
   if (mWriteInfo) {
     mInfoFileBuf = std::make_unique<char[]>(sBuffSize);
     mInfoFile.rdbuf()->pubsetbuf(mInfoFileBuf.get(), sBuffSize);
@@ -116,33 +58,128 @@ SubTimeFrameFileWriter::SubTimeFrameFileWriter(const boost::filesystem::path& pF
     mInfoFile.exceptions(std::fstream::failbit | std::fstream::badbit);
   }
 
-  try {
-    mFile.open(pFileName.string() + ".part"s, ios::binary | ios::trunc | ios::out | ios::ate);
+  // data file is written with pwritev()
+  const auto lDataFileName = pFileName.string() + ".part"s;
+  mFd = ::open(lDataFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (mFd < 0) {
+    const auto lErr = std::strerror(errno);
+    EDDLOG("Failed to open/create TF file for writing. file={} error={}", lDataFileName, lErr);
+    throw std::ios_base::failure("Failed to open TF file: "s + lErr);
+  }
 
+  try {
     if (mWriteInfo) {
       auto lInfoFileName = pFileName.string();
-      lInfoFileName += ".info.part"s;
+      lInfoFileName += ".sidecar.part"s;
 
-      mInfoFile.open(lInfoFileName, ios::trunc | ios::out);
-      mInfoFile << impl::sInfoToHdrString() << '\n';
+      mInfoFile.open(lInfoFileName, ios::binary | ios::trunc | ios::out);
+
+      SubTimeFrameFileSidecarHeader lSidecarHdr;
+      lSidecarHdr.mRecordSize = sizeof(SubTimeFrameFileSidecarRecord);
+      mInfoFile.write(reinterpret_cast<const char*>(&lSidecarHdr), sizeof(SubTimeFrameFileSidecarHeader));
     }
   } catch (std::ifstream::failure& eOpenErr) {
     EDDLOG("Failed to open/create TF file for writing. error={}", eOpenErr.what());
+    ::close(mFd);
+    mFd = -1;
     throw eOpenErr;
   }
 }
 
+bool SubTimeFrameFileWriter::writeGather()
+{
+  const auto lStart = std::chrono::steady_clock::now();
+
+  // submit in batches of IOV_MAX buffers, and resume after short writes
+  std::size_t lIovIdx = 0;
+  while (lIovIdx < mIov.size()) {
+    // empty buffers: a zero sized write below means no progress
+    if (mIov[lIovIdx].iov_len == 0) {
+      lIovIdx++;
+      continue;
+    }
+
+    const int lIovCnt = int(std::min(mIov.size() - lIovIdx, std::size_t(IOV_MAX)));
+
+    const ssize_t lWritten = ::pwritev(mFd, &mIov[lIovIdx], lIovCnt, off_t(mFileSize));
+    if (lWritten < 0 && errno == EINTR) {
+      // interrupted before any data was written: retry the same batch
+      continue;
+    }
+
+    if (lWritten <= 0) {
+      EDDLOG("Writing to file failed. file={} error={}", mFileName.string(),
+        (lWritten < 0) ? std::strerror(errno) : "no data written");
+      mFileError = true;
+      break;
+    }
+
+    mFileSize += lWritten;
+    mWriteCalls += 1;
+
+    // advance over fully written buffers, and adjust the partially written one
+    std::size_t lRemaining = std::size_t(lWritten);
+    while (lIovIdx < mIov.size() && lRemaining >= mIov[lIovIdx].iov_len) {
+      lRemaining -= mIov[lIovIdx].iov_len;
+      lIovIdx++;
+    }
+    if (lRemaining > 0) {
+      mIov[lIovIdx].iov_base = reinterpret_cast<char*>(mIov[lIovIdx].iov_base) + lRemaining;
+      mIov[lIovIdx].iov_len -= lRemaining;
+    }
+  }
+
+  mWriteTime += std::chrono::steady_clock::now() - lStart;
+
+  mIov.clear();
+  mStagingUsed = 0;
+
+  return !mFileError;
+}
+
 void SubTimeFrameFileWriter::close()
 {
+  if (mFd >= 0) {
+    // write the Stf directory footer (only once, and not for failed files)
+    // NOTE: readers before the footer was introduced fail on the trailing directory
+    if (mWriteDirectory && !mFileError && !mRemoved && !mStfDirectory.empty()) {
+      const auto &lEntries = mStfDirectory.entries();
+
+      SubTimeFrameFileFooter lFooter;
+      lFooter.mNumStfs = lEntries.size();
+      lFooter.mDirectoryOffset = mFileSize;
+
+      mStaging.resize(std::max(mStaging.size(), sizeof(DataHeader) + sizeof(SubTimeFrameFileFooter)));
+      stage(mStfDirectory.getDataHeader());
+      gather(lEntries.data(), lEntries.size() * sizeof(SubTimeFrameFileDirectory::Entry));
+      stage(lFooter);
+      writeGather();
+
+      mStfDirectory.clear();
+    }
+
+    if (::close(mFd) != 0) {
+      EDDLOG("Closing TimeFrame file failed. error={}", std::strerror(errno));
+    }
+    mFd = -1;
+
+    // achieved write bandwidth of the file
+    if (mWriteCalls > 0 && !mRemoved) {
+      const double lSizeMiB = double(mFileSize) / double(1ULL << 20);
+      const double lTimeS = mWriteTime.count();
+      IDDLOG("TimeFrame file written. file={} size_mb={:.2f} write_calls={} write_time_s={:.3f} bandwidth_mb_s={:.1f}",
+        mFileName.string(), lSizeMiB, mWriteCalls, lTimeS, (lTimeS > 0.0 ? (lSizeMiB / lTimeS) : 0.0));
+    }
+  }
+
   try {
-    mFile.close();
-    if (mWriteInfo) {
+    if (mWriteInfo && mInfoFile.is_open()) {
       mInfoFile.close();
     }
   } catch (std::ifstream::failure& eCloseErr) {
-    EDDLOG("Closing TimeFrame file failed. error={}", eCloseErr.what());
+    EDDLOG("Closing TimeFrame sidecar file failed. error={}", eCloseErr.what());
   } catch (...) {
-    EDDLOG("Closing TimeFrame file failed.");
+    EDDLOG("Closing TimeFrame sidecar file failed.");
   }
 }
 
@@ -151,7 +188,7 @@ void SubTimeFrameFileWriter::remove()
   // final cleanup
   try {
     boost::filesystem::remove(mFileName.string() + ".part"s);
-    boost::filesystem::remove(mFileName.string() + ".info.part"s);
+    boost::filesystem::remove(mFileName.string() + ".sidecar.part"s);
   } catch (...) { }
 
   mRemoved = true;
@@ -166,7 +203,7 @@ SubTimeFrameFileWriter::~SubTimeFrameFileWriter()
     try {
       boost::filesystem::rename(mFileName.string() + ".part"s, mFileName.string());
       if (mWriteInfo) {
-        boost::filesystem::rename(mFileName.string() + ".info.part"s, mFileName.string() + ".info"s);
+        boost::filesystem::rename(mFileName.string() + ".sidecar.part"s, mFileName.string() + ".sidecar"s);
       }
     } catch (...) {
       EDDLOG("Renaming of TimeFrame file failed.");
@@ -179,7 +216,8 @@ SubTimeFrameFileWriter::~SubTimeFrameFileWriter()
 
 void SubTimeFrameFileWriter::visit(const SubTimeFrame& pStf, void*)
 {
-  mStfData.clear();
+  mStfBlocks.clear();
+  mStfEquipBlocks.clear();
   assert(mStfDataIndex.empty());
 
   // Write data in lexicographical order of DataIdentifier + subSpecification
@@ -187,44 +225,98 @@ void SubTimeFrameFileWriter::visit(const SubTimeFrame& pStf, void*)
   std::vector<EquipmentIdentifier> lEquipIds = pStf.getEquipmentIdentifiers();
   std::sort(std::begin(lEquipIds), std::end(lEquipIds));
 
-  //  sizes for different equipment identifiers
-  std::unordered_map<EquipmentIdentifier, std::tuple<std::uint64_t, std::uint32_t>> lDataIdSizeCnt;
-
   for (const auto& lEquip : lEquipIds) {
 
     const auto& lEquipDataVec = pStf.mData.at(lEquip).at(lEquip.mSubSpecification);
+    const auto lCodec = mCompressor ? mCompressor->config().codecFor(lEquip.mDataOrigin) : eStfFileCodecNone;
+    std::uint32_t lCnt = 0;
 
     for (const auto& lDataMsgs : lEquipDataVec) {
 
+      if (!lDataMsgs.mHeader) {
+        EDDLOG("BUG: FileWriter: No header in DataMsg");
+        continue;
+      }
+
       // NOTE: get only pointers to <hdr, data> struct
-      mStfData.push_back(&lDataMsgs);
+      for (std::size_t i = 0; i < lDataMsgs.mDataParts.size(); i++) {
+        const auto &lDataPtr = lDataMsgs.mDataParts[i];
 
-      for (const auto &lDataPtr : lDataMsgs.mDataParts) {
+        SubTimeFrameFileCompressor::Block lData;
+        lData.mCodec = lCodec;
+        lData.mData = reinterpret_cast<const char*>(lDataPtr->GetData());
+        lData.mSize = lDataPtr->GetSize();
 
-        // account the size
-        const auto lHdrDataSize = sizeof(DataHeader) + lDataPtr->GetSize();
+        mStfBlocks.push_back(StfBlock{ &lDataMsgs, std::uint32_t(i), std::move(lData), DataHeader() });
+        lCnt += 1;
+      }
+    }
 
-        // total size
-        mStfSize += lHdrDataSize;
+    if (lCnt > 0) {
+      mStfEquipBlocks.emplace_back(lEquip, lCnt);
+    }
+  }
+}
 
-        // calculate the size for the index
-        auto & [ lSize, lCnt ] = lDataIdSizeCnt[lEquip];
-        lSize += lHdrDataSize;
-        lCnt += 1;
+void SubTimeFrameFileWriter::prepareBlocks()
+{
+  // compress
+  if (mCompressor) {
+    std::vector<SubTimeFrameFileCompressor::Block*> lToCompress;
+    for (auto &lBlock : mStfBlocks) {
+      if (lBlock.mData.mCodec != eStfFileCodecNone) {
+        lToCompress.push_back(&lBlock.mData);
       }
     }
+
+    if (!lToCompress.empty()) {
+      mCompressor->compress(lToCompress);
+    }
   }
 
-  // build the index
-  {
-    std::uint64_t lCurrOff = 0;
-    for (const auto& lId : lEquipIds) {
-      const auto[lIdSize, IdCnt] = lDataIdSizeCnt[lId];
-      assert(lIdSize > sizeof(DataHeader));
-      mStfDataIndex.AddStfElement(lId, IdCnt, lCurrOff, lIdSize);
-      lCurrOff += lIdSize;
+  // build the index: sizes are known after compression
+  std::uint64_t lCurrOff = 0;
+  auto lBlockIt = mStfBlocks.begin();
+
+  for (const auto &[lId, lCnt] : mStfEquipBlocks) {
+    std::uint64_t lIdSize = 0;
+    std::uint64_t lIdUncompressedSize = 0;
+    std::uint32_t lIdChecksum = 0;
+
+    for (std::uint32_t i = 0; i < lCnt; i++, ++lBlockIt) {
+      assert(lBlockIt != mStfBlocks.end());
+      auto &lBlock = *lBlockIt;
+
+      // only write DataHeader (make a local DataHeader copy to set the flagsNextHeader bit)
+      lBlock.mDataHeader = lBlock.mStfMsg->getDataHeaderCopy();
+      lBlock.mDataHeader.payloadSize = lBlock.dataSizeInFile();
+      lBlock.mDataHeader.splitPayloadIndex = lBlock.mPartIdx;
+      // compressed: DataHeader is followed by the codec header
+      lBlock.mDataHeader.flagsNextHeader = lBlock.mData.compressed() ? 1 : 0;
+
+      if (mChecksum == eStfFileChecksumCrc32c) {
+        lIdChecksum = crc32c(lIdChecksum, &lBlock.mDataHeader, sizeof(DataHeader));
+        if (lBlock.mData.compressed()) {
+          const SubTimeFrameFileBlockCodec lCodecHdr(lBlock.mData.mCodec, lBlock.mData.mSize);
+          lIdChecksum = crc32c(lIdChecksum, &lCodecHdr, sizeof(SubTimeFrameFileBlockCodec));
+          lIdChecksum = crc32c(lIdChecksum, lBlock.mData.mCompressed.get(), lBlock.mData.mCompressedSize);
+        } else {
+          lIdChecksum = crc32c(lIdChecksum, lBlock.mData.mData, lBlock.mData.mSize);
+        }
+      }
+
+      lIdSize += lBlock.headerSizeInFile() + lBlock.dataSizeInFile();
+      lIdUncompressedSize += sizeof(DataHeader) + lBlock.mData.mSize;
     }
+
+    mStfDataIndex.AddStfElement(lId, lCnt, lCurrOff, lIdSize, lIdUncompressedSize);
+    mStfDataIndex.elements().back().mChecksumType = mChecksum;
+    mStfDataIndex.elements().back().mChecksum = lIdChecksum;
+    lCurrOff += lIdSize;
   }
+
+  // total size
+  mStfSize = lCurrOff;
 }
 
 std::uint64_t SubTimeFrameFileWriter::getSizeInFile() const
@@ -232,147 +324,141 @@ std::uint64_t SubTimeFrameFileWriter::getSizeInFile() const
   return SubTimeFrameFileMeta::getSizeInFile() + mStfDataIndex.getSizeInFile() + mStfSize;
 }
 
-std::uint64_t SubTimeFrameFileWriter::write(const SubTimeFrame& pStf)
+std::uint64_t SubTimeFrameFileWriter::write(const SubTimeFrame& pStf, const SubTimeFrameFileMeta::StfOrder &pOrder)
 {
-  if (!mFile.good()) {
-    EDDLOG("Error while writing a TF to file. (bad stream state)");
+  if (mFd < 0 || mFileError) {
+    EDDLOG("Error while writing a TF to file. (bad file state)");
     return std::uint64_t(0);
   }
 
-  const auto ret = this->_write(pStf);
+  const auto ret = this->_write(pStf, pOrder);
 
   // cleanup:
   // make sure headers and chunk pointers don't linger
-  mStfData.clear();
+  mStfBlocks.clear();
+  mStfEquipBlocks.clear();
   mStfDataIndex.clear();
   mStfSize = 0;
 
   return ret;
 }
 
-std::uint64_t SubTimeFrameFileWriter::_write(const SubTimeFrame& pStf)
+std::uint64_t SubTimeFrameFileWriter::_write(const SubTimeFrame& pStf, const SubTimeFrameFileMeta::StfOrder &pOrder)
 {
   // collect all stf blocks
   pStf.accept(*this);
+  prepareBlocks();
 
   // get file position
   const std::uint64_t lPrevSize = size();
   const std::uint64_t lStfSizeInFile = getSizeInFile();
-  std::uint64_t lDataOffset = 0;
 
   SubTimeFrameFileMeta lStfFileMeta(lStfSizeInFile);
 
-  try {
-    // Write DataHeader + SubTimeFrameFileMeta
-    mFile << lStfFileMeta;
-
-    // Write DataHeader + SubTimeFrameFileDataIndex
-    mFile << mStfDataIndex;
-
-    lDataOffset = size(); // save for the info file
-
-    for (const auto &lStfMsg : mStfData) {
-
-      if (!lStfMsg->mHeader) {
-        EDDLOG("BUG: FileWriter: No header in DataMsg");
-        continue;
-      }
-
-      // only write DataHeader (make a local DataHeader copy to clear flagsNextHeader bit)
-      DataHeader lDhToWrite = lStfMsg->getDataHeaderCopy();
-      lDhToWrite.flagsNextHeader = 0;
-
-      for (std::size_t i = 0; i < lStfMsg->mDataParts.size(); i++) {
-        const auto &lDataPtr = lStfMsg->mDataParts[i];
-
-        // update payload size and index
-        lDhToWrite.payloadSize = lDataPtr->GetSize();
-        lDhToWrite.splitPayloadIndex = i;
-
-        buffered_write(reinterpret_cast<const char*>(&lDhToWrite), sizeof (DataHeader));
-        buffered_write(lDataPtr->GetData(), lDhToWrite.payloadSize);
-      }
+  // staging arena for all headers of the Stf: grown only, pointers must stay valid until written
+  const std::size_t lStagingSize = SubTimeFrameFileMeta::getSizeInFile() + sizeof(DataHeader) +
+    mStfBlocks.size() * (sizeof(DataHeader) + sizeof(SubTimeFrameFileBlockCodec));
+  if (mStaging.size() < lStagingSize) {
+    mStaging.resize(lStagingSize);
+  }
+  mIov.clear();
+  mStagingUsed = 0;
+
+  // DataHeader + SubTimeFrameFileStfOrder + SubTimeFrameFileMeta
+  auto lMetaHdr = SubTimeFrameFileMeta::getDataHeader();
+  lMetaHdr.flagsNextHeader = 1;
+  stage(lMetaHdr);
+  stage(SubTimeFrameFileStfOrder(pStf.id(), pOrder));
+  stage(lStfFileMeta);
+
+  // DataHeader + SubTimeFrameFileDataIndex
+  stage(mStfDataIndex.getDataHeader());
+  const auto &lIndexElems = mStfDataIndex.elements();
+  gather(lIndexElems.data(), lIndexElems.size() * sizeof(SubTimeFrameFileDataIndex::DataIndexElem));
+
+  // data blocks: payloads are not copied
+  for (const auto &lBlock : mStfBlocks) {
+    stage(lBlock.mDataHeader);
+
+    if (lBlock.mData.compressed()) {
+      stage(SubTimeFrameFileBlockCodec(lBlock.mData.mCodec, lBlock.mData.mSize));
+      gather(lBlock.mData.mCompressed.get(), lBlock.mDataHeader.payloadSize);
+    } else {
+      gather(lBlock.mData.mData, lBlock.mDataHeader.payloadSize);
     }
+  }
 
-    // flush the buffer and check the state
-    mFile.flush();
-
-  } catch (const std::ios_base::failure& eFailExc) {
-    EDDLOG("Writing to file failed. error={}", eFailExc.what());
+  if (!writeGather()) {
     return std::uint64_t(0);
   }
 
+  // save for the sidecar file
+  std::uint64_t lDataOffset = lPrevSize + SubTimeFrameFileMeta::getSizeInFile() + mStfDataIndex.getSizeInFile();
+
   assert((size() - lPrevSize == lStfSizeInFile) && "Calculated and written sizes differ");
 
+  // directory entry
+  if (mWriteDirectory) {
+    SubTimeFrameFileDirectory::Entry lDirEntry;
+    lDirEntry.mStfId = pStf.id();
+    lDirEntry.mOffset = lPrevSize;
+    lDirEntry.mSize = lStfSizeInFile;
+    lDirEntry.mFirstOrbit = pStf.header().mFirstOrbit;
+    for (const auto &lEquip : mStfEquipBlocks) {
+      lDirEntry.mOriginMask |= SubTimeFrameFileDirectory::originBit(lEquip.first.mDataOrigin);
+    }
+    mStfDirectory.addStf(lDirEntry);
+  }
+
   // sidecar
   if (mWriteInfo) {
 
     try {
-
-      const auto l1StfId = pStf.header().mId;
-      const auto l2StfFileOff = lPrevSize;
-      const auto l3StfFileSize = lStfSizeInFile;
-
-      for (const auto& lStfMsg : mStfData) {
-
-        DataHeader lDH = lStfMsg->getDataHeaderCopy();
-
-        for (std::size_t i = 0; i < lStfMsg->mDataParts.size(); i++) {
-          const auto &lDataPtr = lStfMsg->mDataParts[i];
-
-          lDH.splitPayloadIndex = i;
-          lDH.payloadSize = lDataPtr->GetSize();
-
-          fmt::memory_buffer lValRow;
-
-          const auto& l4DataOrigin = lDH.dataOrigin;
-          const auto& l5DataDescription = lDH.dataDescription;
-          const auto l6SubSpec = lDH.subSpecification;
-          const auto l7DataIndex = lDH.splitPayloadIndex;
-
-          const auto l8HdrOff = lDataOffset;
-          lDataOffset += sizeof(DataHeader);
-          const auto l9HdrSize = sizeof(DataHeader);
-          const auto l10DataOff = lDataOffset;
-          lDataOffset += lDH.payloadSize;
-          const auto l11DataSize = lDH.payloadSize;
-
-          impl::sInfoVal(lValRow, impl::TF_ID, l1StfId);
-          impl::sInfoVal(lValRow, impl::TF_OFFSET, l2StfFileOff);
-          impl::sInfoVal(lValRow, impl::TF_SIZE, l3StfFileSize);
-          impl::sInfoVal(lValRow, impl::ORIGIN, l4DataOrigin.as<std::string>());
-          impl::sInfoVal(lValRow, impl::DESC, l5DataDescription.as<std::string>());
-          impl::sInfoVal(lValRow, impl::SUBSPEC, l6SubSpec);
-          impl::sInfoVal(lValRow, impl::DATA_IDX, l7DataIndex);
-          impl::sInfoVal(lValRow, impl::HDR_OFF, l8HdrOff);
-          impl::sInfoVal(lValRow, impl::HDR_SIZE, l9HdrSize);
-          impl::sInfoVal(lValRow, impl::DATA_OFF, l10DataOff);
-          impl::sInfoVal(lValRow, impl::DATA_SIZE, l11DataSize);
-
-          // only if the O2 header is RAWDATA
-          if (lDH.dataDescription == gDataDescriptionRawData) {
-            try {
-              const auto R = RDHReader(lDataPtr);
-              const auto [l12MemSize, l13StopBit] = ReadoutDataUtils::getHBFrameMemorySize(lDataPtr);
-              const auto l14FeeId = R.getFeeID();
-              const auto l15Orbit = R.getOrbit();
-              const auto l16Bc = R.getBC();
-              const auto l17Trig = R.getTriggerType();
-
-              impl::sInfoVal(lValRow, impl::RDH_MEM_SIZE, l12MemSize);
-              impl::sInfoVal(lValRow, impl::RDH_STOP_BIT, l13StopBit ? 1 : 0);
-              impl::sInfoVal(lValRow, impl::RDH_FEE_ID, l14FeeId);
-              impl::sInfoVal(lValRow, impl::RDH_ORBIT, l15Orbit);
-              impl::sInfoVal(lValRow, impl::RDH_BC, l16Bc);
-              impl::sInfoVal(lValRow, impl::RDH_TRG, l17Trig);
-            } catch (RDHReaderException &e) {
-              EDDLOG( e.what());
-            }
+      mSidecarRecords.clear();
+
+      for (const auto& lBlock : mStfBlocks) {
+        const DataHeader lDH = lBlock.mStfMsg->getDataHeaderCopy();
+        const auto &lDataPtr = lBlock.mStfMsg->mDataParts[lBlock.mPartIdx];
+
+        auto &lRec = mSidecarRecords.emplace_back();
+
+        lRec.mStfId = pStf.header().mId;
+        lRec.mStfOffset = lPrevSize;
+        lRec.mStfSize = lStfSizeInFile;
+
+        lRec.mHdrOffset = lDataOffset;
+        lRec.mHdrSize = lBlock.headerSizeInFile();
+        lRec.mDataSize = lBlock.dataSizeInFile();
+        lRec.mUncompressedSize = lBlock.mData.mSize;
+        lRec.mCodec = lBlock.mData.compressed() ? lBlock.mData.mCodec : eStfFileCodecNone;
+        lDataOffset += lRec.mHdrSize + lRec.mDataSize;
+
+        lRec.mDataDescription = lDH.dataDescription;
+        lRec.mDataOrigin = lDH.dataOrigin;
+        lRec.mSubSpecification = lDH.subSpecification;
+        lRec.mSplitPayloadIndex = lBlock.mPartIdx;
+
+        lRec.mTfFirstOrbit = (lDH.firstTForbit != 0) ? lDH.firstTForbit : pStf.header().mFirstOrbit;
+        lRec.mRunNumber = lDH.runNumber;
+        lRec.mSplitPayloadParts = lDH.splitPayloadParts;
+
+        // only if the O2 header is RAWDATA: fields of the first RDH, the block is not walked
+        if (lDH.dataDescription == gDataDescriptionRawData) {
+          try {
+            const auto R = RDHReader(lDataPtr);
+            lRec.mFeeId = R.getFeeID();
+            lRec.mFirstOrbit = R.getOrbit();
+            lRec.mBc = R.getBC();
+            lRec.mTriggerType = R.getTriggerType();
+            lRec.mFlags |= SubTimeFrameFileSidecarRecord::eRdhValid;
+          } catch (RDHReaderException &e) {
+            EDDLOG(e.what());
           }
-
-          mInfoFile << std::string_view(lValRow.begin(), lValRow.size()) << '\n';
         }
       }
+
+      mInfoFile.write(reinterpret_cast<const char*>(mSidecarRecords.data()),
+        mSidecarRecords.size() * sizeof(SubTimeFrameFileSidecarRecord));
       mInfoFile.flush();
     } catch (const std::ios_base::failure& eFailExc) {
       EDDLOG("Writing to file failed. error={}", eFailExc.what());
@@ -16,13 +16,19 @@
 
 #include "SubTimeFrameDataModel.h"
 #include "SubTimeFrameFile.h"
+#include "SubTimeFrameFileCodec.h"
+#include "SubTimeFrameFileSidecar.h"
 #include <Headers/DataHeader.h>
 
 #include <type_traits>
 #include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <vector>
 
+#include <sys/uio.h>
+
 namespace o2
 {
 namespace DataDistribution
@@ -34,23 +40,23 @@ namespace DataDistribution
 
 class SubTimeFrameFileWriter : public ISubTimeFrameConstVisitor
 {
-  static const constexpr char* sSidecarFieldSep = " ";
-  static const constexpr char* sSidecarRecordSep = "\n";
-
  public:
   SubTimeFrameFileWriter() = delete;
-  SubTimeFrameFileWriter(const boost::filesystem::path& pFileName, bool pWriteInfo = false);
+  SubTimeFrameFileWriter(const boost::filesystem::path& pFileName, bool pWriteInfo = false,
+                         SubTimeFrameFileCompressor *pCompressor = nullptr,
+                         const StfFileChecksum pChecksum = eStfFileChecksumNone,
+                         const bool pWriteDirectory = false);
   virtual ~SubTimeFrameFileWriter();
 
   ///
   /// Writes a (Sub)TimeFrame
   ///
-  std::uint64_t write(const SubTimeFrame& pStf);
+  std::uint64_t write(const SubTimeFrame& pStf, const SubTimeFrameFileMeta::StfOrder &pOrder = {});
 
   ///
   /// Tell current size of the file
   ///
-  std::uint64_t size() { return std::uint64_t(mFile.tellp()); }
+  std::uint64_t size() const { return mFileSize; }
 
   ///
   /// Delete the (Sub)TimeFrame file on error
@@ -58,7 +64,7 @@ class SubTimeFrameFileWriter : public ISubTimeFrameConstVisitor
   void remove();
 
   ///
-  /// Close the (Sub)TimeFrame file on error
+  /// Close the (Sub)TimeFrame file. The Stf directory footer is written if enabled and the file is good.
   ///
   void close();
 
@@ -68,61 +74,92 @@ class SubTimeFrameFileWriter : public ISubTimeFrameConstVisitor
   void visit(const SubTimeFrame& pStf, void*) override;
 
   /// Writes a (Sub)TimeFrame
-  std::uint64_t _write(const SubTimeFrame& pStf);
+  std::uint64_t _write(const SubTimeFrame& pStf, const SubTimeFrameFileMeta::StfOrder &pOrder);
+
+  /// Compress the data blocks, prepare the headers, and build the index (with checksums)
+  void prepareBlocks();
+
+  /// Copy a header into the staging arena, and add it to the gather list
+  template <typename T>
+  void stage(const T &pHdr)
+  {
+    static_assert(std::is_standard_layout<T>::value, "Only std layout headers can be staged.");
+    assert((mStagingUsed + sizeof(T) <= mStaging.size()) && "Staging arena is too small");
+
+    char *lPtr = mStaging.data() + mStagingUsed;
+    std::memcpy(lPtr, &pHdr, sizeof(T));
+    mStagingUsed += sizeof(T);
+
+    gather(lPtr, sizeof(T));
+  }
+
+  /// Add a buffer to the gather list (buffer must be valid until writeGather() returns)
+  void gather(const void *pData, const std::size_t pSize)
+  {
+    if (pSize > 0) {
+      mIov.push_back(iovec{ const_cast<void*>(pData), pSize });
+    }
+  }
+
+  /// Write the gather list at the end of the file with pwritev(). Returns false on error.
+  bool writeGather();
 
-  //
-  //  workaround for buffered operation (performance):
-  //   - provide a new, larger, buffer
-  //   - always write less than 1024B at a time (hard limit in libstdc++)
-  //
-  static constexpr std::streamsize sBuffSize = 1ul << 20; // 1 MiB
-  static constexpr std::streamsize sChunkSize = 512;
   boost::filesystem::path mFileName;
-  std::ofstream mFile;
+  int mFd = -1;
+  std::uint64_t mFileSize = 0; // end of data written
+  bool mFileError = false;
   bool mRemoved = false;
 
+  // headers of a Stf are staged here, payloads are referenced directly (shm or compressed)
+  std::vector<char> mStaging;
+  std::size_t mStagingUsed = 0;
+  std::vector<iovec> mIov;
+
+  // write bandwidth of the file
+  std::uint64_t mWriteCalls = 0;
+  std::chrono::duration<double> mWriteTime = std::chrono::duration<double>::zero();
+
+  // binary sidecar file
+  static constexpr std::streamsize sBuffSize = 1ul << 20; // 1 MiB
   bool mWriteInfo;
   std::ofstream mInfoFile;
-
-  std::unique_ptr<char[]> mFileBuf;
   std::unique_ptr<char[]> mInfoFileBuf;
+  std::vector<SubTimeFrameFileSidecarRecord> mSidecarRecords;
 
-  // helper to make sure the written blocks are buffered
-  template <
-    typename pointer,
-    typename std::enable_if<
-      std::is_pointer<pointer>::value &&                      // pointers only
-      (std::is_void<std::remove_pointer_t<pointer>>::value || // void* or standard layout!
-       std::is_standard_layout<std::remove_pointer_t<pointer>>::value)>::type* = nullptr>
-  void buffered_write(const pointer p, std::streamsize pCount)
-  {
-    // make sure we're not doing a short write
-    assert((pCount % sizeof(std::conditional_t<std::is_void<std::remove_pointer_t<pointer>>::value,
-            char, std::remove_pointer_t<pointer>>) == 0) && "Performing short write?");
-
-    const char* lPtr = reinterpret_cast<const char*>(p);
-    // avoid the optimization if the write is large enough
-    if (pCount >= sBuffSize) {
-      mFile.write(lPtr, pCount);
-    } else {
-      // split the write to smaller chunks
-      while (pCount > 0) {
-        const auto lToWrite = std::min(pCount, sChunkSize);
-        assert(lToWrite > 0 && lToWrite <= sChunkSize && lToWrite <= pCount);
-
-        mFile.write(lPtr, lToWrite);
-        lPtr += lToWrite;
-        pCount -= lToWrite;
-      }
+  std::uint64_t getSizeInFile() const;
+
+  // optional, shared between writers
+  SubTimeFrameFileCompressor *mCompressor = nullptr;
+
+  // checksum of data blocks of each equipment
+  StfFileChecksum mChecksum = eStfFileChecksumNone;
+
+  // directory and footer at the end of the file (opt-in)
+  bool mWriteDirectory = false;
+
+  // <header, data> block of a Stf to be written
+  struct StfBlock {
+    const SubTimeFrame::StfMessage *mStfMsg;
+    std::uint32_t mPartIdx;
+    SubTimeFrameFileCompressor::Block mData;
+    o2::header::DataHeader mDataHeader; // as written in the file
+
+    std::uint64_t headerSizeInFile() const
+    {
+      return sizeof(o2::header::DataHeader) + (mData.compressed() ? sizeof(SubTimeFrameFileBlockCodec) : 0);
     }
-  }
 
-  std::uint64_t getSizeInFile() const;
+    std::uint64_t dataSizeInFile() const { return mData.compressed() ? mData.mCompressedSize : mData.mSize; }
+  };
 
-  // vector of <headers, data> elements of a Stf to be written
-  std::vector<const SubTimeFrame::StfMessage*> mStfData;
+  // blocks of a Stf in the file order, and the number of blocks of each equipment
+  std::vector<StfBlock> mStfBlocks;
+  std::vector<std::pair<EquipmentIdentifier, std::uint32_t>> mStfEquipBlocks;
   SubTimeFrameFileDataIndex mStfDataIndex;
   std::uint64_t mStfSize = std::uint64_t(0); // meta + index + data (and all headers)
+
+  // all Stfs written in the file, for the footer
+  SubTimeFrameFileDirectory mStfDirectory;
 };
 }
 } /* o2::DataDistribution */
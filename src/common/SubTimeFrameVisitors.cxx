@@ -63,11 +63,10 @@ void IovSerializer::visit(SubTimeFrame& pStf, void*)
     }
   }
 
-  std::string lHeaderMessage;
-  mIovHeader.SerializeToString(&lHeaderMessage);
-
-  auto lHdrMetaMsg = mChan.NewMessage(lHeaderMessage.size());
-  memcpy(lHdrMetaMsg->GetData(), lHeaderMessage.c_str(), lHeaderMessage.size());
+  // serialize directly into the message. mIovHeader is reused: cleared entries keep their allocations
+  const auto lHeaderSize = mIovHeader.ByteSizeLong();
+  auto lHdrMetaMsg = mChan.NewMessage(lHeaderSize);
+  mIovHeader.SerializeWithCachedSizesToArray(reinterpret_cast<std::uint8_t*>(lHdrMetaMsg->GetData()));
 
   mData.push_back(std::move(lHdrMetaMsg));
 
@@ -98,14 +97,15 @@ void IovSerializer::serialize(std::unique_ptr<SubTimeFrame>&& pStf)
 void IovDeserializer::visit(SubTimeFrame& pStf, void*)
 {
   // stf header
-  const auto lHdrSize = std::min(mIovStfHeader.stf_dd_header().size(), sizeof(SubTimeFrame::Header));
-  memcpy(&pStf.mHeader, mIovStfHeader.stf_dd_header().c_str(), lHdrSize);
+  if (!pStf.mHeader.copyFromRaw(mIovStfHeader->stf_dd_header().data(), mIovStfHeader->stf_dd_header().size())) {
+    EDDLOG_RL(1000, "IovDeserializer: invalid SubTimeFrame::Header size={}", mIovStfHeader->stf_dd_header().size());
+  }
 
   std::size_t iData = 0;
   for (std::size_t iHdr = 0; iHdr < mHdrs.size(); iHdr++) {
 
     auto lHdrMsg = std::move(mHdrs[iHdr]);
-    const auto lLastDataIdx = mIovStfHeader.stf_hdr_iov(iHdr).num_data_parts() + iData;
+    const auto lLastDataIdx = mIovStfHeader->stf_hdr_iov(iHdr).num_data_parts() + iData;
 
     const DataHeader *lHdrPtr = reinterpret_cast<DataHeader*>(lHdrMsg->GetData());
     const auto lSubSpec = lHdrPtr->subSpecification;
@@ -127,13 +127,15 @@ void IovDeserializer::visit(SubTimeFrame& pStf, void*)
 
 std::unique_ptr<SubTimeFrame> IovDeserializer::deserialize(const IovStfHdrMeta &pHdrMeta, std::vector<FairMQMessagePtr>& pDataMsgs)
 {
-  mIovStfHeader.Clear();
-  mIovStfHeader.CopyFrom(pHdrMeta);
+  // the metadata is only used during the call, no copy
+  mIovStfHeader = &pHdrMeta;
 
   mData = std::move(pDataMsgs);
   pDataMsgs.clear();
 
-  return deserialize_impl();
+  auto lStf = deserialize_impl();
+  mIovStfHeader = nullptr;
+  return lStf;
 }
 
 
@@ -141,13 +143,17 @@ std::unique_ptr<SubTimeFrame> IovDeserializer::deserialize_impl()
 {
   std::unique_ptr<SubTimeFrame> lStf = nullptr;
   try {
-    // recreate header messages
-    for (const auto &lHdr : mIovStfHeader.stf_hdr_iov()) {
-      auto lNewHdr = mTfBld.newHeaderMessage(lHdr.hdr_data().c_str(), lHdr.hdr_data().size());
-      mHdrs.push_back(std::move(lNewHdr));
+    // recreate header messages: allocate all headers of the STF at once
+    mHdrSrcs.clear();
+    for (const auto &lHdr : mIovStfHeader->stf_hdr_iov()) {
+      mHdrSrcs.emplace_back(lHdr.hdr_data().data(), lHdr.hdr_data().size());
+    }
+
+    if (!mTfBld.newHeaderMessages(mHdrSrcs, mHdrs)) {
+      throw std::runtime_error("Header message allocation failed");
     }
 
-    lStf = std::make_unique<SubTimeFrame>(mIovStfHeader.stf_id());
+    lStf = std::make_unique<SubTimeFrame>(mIovStfHeader->stf_id());
     lStf->accept(*this);
 
   } catch (std::runtime_error& e) {
@@ -173,18 +179,44 @@ std::unique_ptr<SubTimeFrame> IovDeserializer::deserialize_impl()
 SubTimeFrame::Header IovDeserializer::peek_tf_header(const IovStfHdrMeta &pHdrMeta) const
 {
   SubTimeFrame::Header lStfHdr;
-  auto lSize = std::min(pHdrMeta.stf_dd_header().size(), sizeof(SubTimeFrame::Header));
-  memcpy(&lStfHdr, pHdrMeta.stf_dd_header().data(), lSize);
+  lStfHdr.copyFromRaw(pHdrMeta.stf_dd_header().data(), pHdrMeta.stf_dd_header().size());
 
   return lStfHdr;
 }
 
-// copy all messages into the data region, and update the vector
+// copy messages into the data region, and update the vector
+// Messages received in shared memory (shm transport, co-located StfSender) are kept: only the ownership is transferred
 bool IovDeserializer::copy_to_region(std::vector<FairMQMessagePtr>& pMsgs /* in/out */)
 {
-  mTfBld.newDataMessages(pMsgs, pMsgs);
+  mCopyIdx.clear();
+  for (std::size_t i = 0; i < pMsgs.size(); i++) {
+    if (pMsgs[i]->GetType() != fair::mq::Transport::SHM) {
+      mCopyIdx.push_back(i);
+    }
+  }
+
+  if (mCopyIdx.empty()) {
+    return true;
+  }
+
+  if (mCopyIdx.size() == pMsgs.size()) {
+    return mTfBld.newDataMessages(pMsgs, pMsgs);
+  }
+
+  // copy only the messages outside of shared memory. On failure the vector keeps the original messages
+  mCopyMsgs.clear();
+  for (const auto lIdx : mCopyIdx) {
+    mCopyMsgs.push_back(std::move(pMsgs[lIdx]));
+  }
+
+  const bool lRet = mTfBld.newDataMessages(mCopyMsgs, mCopyMsgs);
+
+  for (std::size_t i = 0; i < mCopyIdx.size(); i++) {
+    pMsgs[mCopyIdx[i]] = std::move(mCopyMsgs[i]);
+  }
+  mCopyMsgs.clear();
 
-  return true;
+  return lRet;
 }
 
 
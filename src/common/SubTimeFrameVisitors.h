@@ -92,12 +92,19 @@ class IovDeserializer : public ISubTimeFrameVisitor
   void visit(SubTimeFrame& pStf, void*) override;
 
  private:
-  // IovStfHeader mIovHeader;
-  IovStfHdrMeta mIovStfHeader;
+  // metadata of the STF being deserialized (not owned)
+  const IovStfHdrMeta *mIovStfHeader = nullptr;
 
   std::vector<FairMQMessagePtr> mHdrs;
   std::vector<FairMQMessagePtr> mData;
 
+  // header sources for batched allocation
+  std::vector<std::pair<const void*, std::size_t>> mHdrSrcs;
+
+  // messages to be copied into the data region
+  std::vector<std::size_t> mCopyIdx;
+  std::vector<FairMQMessagePtr> mCopyMsgs;
+
   TimeFrameBuilder &mTfBld;
 };
 
@@ -298,6 +298,13 @@ using ConcurrentLifo = impl::ConcurrentContainerImpl<T, impl::eLIFO>;
 template <class T>
 using ConcurrentStack = ConcurrentLifo<T>;
 
+///
+///  Hook called when an element is queued into, or dequeued from a pipeline stage.
+///  Overloaded (found by ADL) for the element types that carry a trace, e.g. STFs.
+///
+template <typename T>
+inline void pipeline_trace_hop(const T&, const bool /* pDequeue */) { }
+
 ///
 ///  Pipeline handler with input and output ConcurrentContainer queue/stack
 ///
@@ -339,6 +346,7 @@ class IFifoPipeline
 
     // NOTE: (lNextStage == mPipelineQueues.size()) is the drop queue
     if (lNextStage < mPipelineQueues.size()) {
+      (pipeline_trace_hop(args, false), ...);
       return mPipelineQueues[lNextStage].push(std::forward<Args>(args)...);
     }
     return false;
@@ -373,13 +381,19 @@ class IFifoPipeline
   T dequeue(unsigned pStage)
   {
     T t;
-    mPipelineQueues[pStage].pop(t);
+    if (mPipelineQueues[pStage].pop(t)) {
+      pipeline_trace_hop(t, true);
+    }
     return t;
   }
 
   std::optional<T> dequeue_for(const unsigned pStage, const std::chrono::microseconds &pWaitUs)
   {
-    return mPipelineQueues[pStage].pop_wait_for(pWaitUs);
+    auto lOpt = mPipelineQueues[pStage].pop_wait_for(pWaitUs);
+    if (lOpt) {
+      pipeline_trace_hop(lOpt.value(), true);
+    }
+    return lOpt;
   }
 
   bool try_pop(unsigned pStage)
@@ -0,0 +1,122 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ALICEO2_DATADIST_STF_TRACE_H_
+#define ALICEO2_DATADIST_STF_TRACE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+namespace o2::DataDistribution
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// StfTrace
+////////////////////////////////////////////////////////////////////////////////
+
+/// Points of the STF lifecycle where the trace is stamped
+enum StfTraceStage : std::uint8_t {
+  eStfTraceReadoutRecv = 0,   // StfBuilder: first readout message of the STF received
+  eStfTraceBuilt,             // StfBuilder: STF completed and queued into the pipeline
+  eStfTraceFileSink,          // any FileSink: STF written to file (or skipped)
+  eStfTraceStfBuilderOut,     // StfBuilder: STF sent to StfSender or DPL
+  eStfTraceStfSenderIn,       // StfSender: STF received
+  eStfTraceStfSenderSched,    // StfSender: STF requested by a TfBuilder
+  eStfTraceStfSenderOut,      // StfSender: STF handed to the transport
+  eStfTraceTfBuilderIn,       // TfBuilder: STF received
+  eStfTraceTfBuilderMerged,   // TfBuilder: TF merged
+  eStfTraceTfBuilderOut,      // TfBuilder: TF sent to DPL
+  eStfTracePipeQueue,         // any process: STF queued into the next pipeline stage (IFifoPipeline)
+  eStfTracePipeDequeue,       // any process: STF dequeued by a pipeline stage (IFifoPipeline)
+  eStfTraceStageCount
+};
+
+static constexpr const char* sStfTraceStageNames[eStfTraceStageCount] = {
+  "readout_recv",
+  "stf_built",
+  "file_sink",
+  "stfb_out",
+  "stfs_in",
+  "stfs_sched",
+  "stfs_out",
+  "tfb_in",
+  "tfb_merged",
+  "tfb_out",
+  "pipe_queue",
+  "pipe_dequeue"
+};
+
+static inline const char* to_string(const StfTraceStage pStage)
+{
+  return (pStage < eStfTraceStageCount) ? sStfTraceStageNames[pStage] : "invalid";
+}
+
+/// Timestamps of the pipeline stages an STF passed through. The trace is a part of the STF header
+/// and is carried across the network. Latency of a stage is the time since the previous event.
+/// Timestamps are monotonic within the process and anchored to the wall clock once per process, so
+/// latencies between hosts are only as accurate as the clock synchronization.
+struct StfTrace {
+  static constexpr std::size_t sMaxEvents = 32;
+  // pipeline hops leave room for one event of each stage
+  static constexpr std::size_t sMaxHopEvents = sMaxEvents - eStfTraceStageCount;
+
+  std::uint64_t mTimeNs[sMaxEvents] = { };
+  std::uint8_t mStage[sMaxEvents] = { };
+  std::uint8_t mNumEvents = 0;
+  std::uint8_t mProcessStart = 0; // first event stamped by the current process
+
+  static std::uint64_t toNs(const std::chrono::steady_clock::time_point &pTime)
+  {
+    // offset between the monotonic and the wall clock, taken once
+    static const std::int64_t sOffsetNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch() -
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(pTime.time_since_epoch()).count() + sOffsetNs);
+  }
+
+  static std::uint64_t now() { return toNs(std::chrono::steady_clock::now()); }
+
+  void stamp(const StfTraceStage pStage, const std::uint64_t pTimeNs = now())
+  {
+    if (mNumEvents < sMaxEvents) {
+      mStage[mNumEvents] = pStage;
+      mTimeNs[mNumEvents] = pTimeNs;
+      mNumEvents++;
+    }
+  }
+
+  /// Pipeline queue/dequeue stamp. Dropped when the trace is close to full, to keep the stage events
+  void stampHop(const StfTraceStage pStage, const std::uint64_t pTimeNs = now())
+  {
+    if (mNumEvents < sMaxHopEvents) {
+      stamp(pStage, pTimeNs);
+    }
+  }
+
+  /// First stamp of a new process: events from here on are accounted by this process
+  void stampProcessStart(const StfTraceStage pStage, const std::uint64_t pTimeNs = now())
+  {
+    mProcessStart = mNumEvents;
+    stamp(pStage, pTimeNs);
+  }
+
+  std::uint64_t lastTimeNs() const { return mNumEvents ? mTimeNs[mNumEvents - 1] : 0; }
+};
+
+static_assert(std::is_trivially_copyable_v<StfTrace>, "StfTrace is sent as a part of raw STF header");
+
+} /* namespace o2::DataDistribution */
+
+#endif /* ALICEO2_DATADIST_STF_TRACE_H_ */
@@ -28,6 +28,11 @@ namespace o2::DataDistribution
 static constexpr std::string_view DataDistNetworkTransportKey = "DataDistNetworkTransport";
 static constexpr std::string_view DataDistNetworkTransportDefault = "ucx";
 
+// Use the FairMQ shared memory transport for the "fmq" network transport. STF data is handed over to the TfBuilder
+// without copies. Only for deployments where StfSenders and TfBuilders run on the same node, in the same FairMQ session
+static constexpr std::string_view DataDistFmqShmTransportKey = "DataDistFmqShmTransport";
+static constexpr bool DataDistFmqShmTransportDefault = false;
+
 
 ////////////////////////////////////////////////////////////////////////////////
 /// StfBuilder
@@ -51,6 +56,15 @@ static constexpr std::uint64_t StfBufferSizeMBValue = (32ULL << 10);
 static constexpr std::string_view UcxRdmaGapBKey = "UcxRdmaGapB";
 static constexpr std::uint64_t UcxRdmaGapBDefault = 8192;
 
+// Cost model of RMA get operations, used to decide if a gap is merged into a txg: "<size_bytes>:<time_us>,..."
+// Measured on the link with UcxRmaCalibration. Empty: merge all gaps up to UcxRdmaGapB
+static constexpr std::string_view UcxRmaCostModelKey = "UcxRmaCostModel";
+static constexpr std::string_view UcxRmaCostModelDefault = "";
+
+// Send STF metadata and receive transfer acks as UCX active messages (instead of tagged strings)
+static constexpr std::string_view UcxControlActiveMessagesKey = "UcxControlActiveMessages";
+static constexpr bool UcxControlActiveMessagesDefault = false;
+
 // Size of sender treadpool. Default 0 (number of cpu cores)
 static constexpr std::string_view UcxSenderThreadPoolSizeKey = "UcxStfSenderThreadPoolSize";
 static constexpr std::uint64_t UcxStfSenderThreadPoolSizeDefault = 0;
@@ -64,16 +78,53 @@ static constexpr std::uint64_t UcxStfSenderThreadPoolSizeDefault = 0;
 static constexpr std::string_view MaxNumStfTransfersKey = "MaxNumStfTransfers";
 static constexpr std::uint64_t MaxNumStfTransferDefault = 100;
 
+// Credit based flow control: maximum of STF bytes in flight (MiB), also limited by the free data region. 0: free region only
+static constexpr std::string_view StfTransferCreditMBKey = "StfTransferCreditMB";
+static constexpr std::uint64_t StfTransferCreditMBDefault = 4096;
+
+// Credit based flow control: maximum of STF bytes in flight from one StfSender (MiB). 0: unlimited
+static constexpr std::string_view StfTransferCreditPerStfSenderMBKey = "StfTransferCreditPerStfSenderMB";
+static constexpr std::uint64_t StfTransferCreditPerStfSenderMBDefault = 256;
+
 
 /// UCX transport
 // Size of receiver treadpool. Default 0 (number of cpu cores)
 static constexpr std::string_view UcxTfBuilderThreadPoolSizeKey = "UcxTfBuilderThreadPoolSize";
 static constexpr std::uint64_t UcxTfBuilderThreadPoolSizeDefault = 0;
 
-// Number of rma_get operation in flight, per ucx thread
+// Number of rma_get operation in flight, per ucx thread (upper bound of the adaptive RMA window)
 static constexpr std::string_view UcxNumConcurrentRmaGetOpsKey = "UcxNumConcurrentRmaGetOps";
 static constexpr std::uint64_t UcxNumConcurrentRmaGetOpsDefault = 8;
 
+// Adaptive RMA concurrency: largest window of rma_get bytes in flight per StfSender connection. 0: disabled
+static constexpr std::string_view UcxRmaConnWindowMaxMBKey = "UcxRmaConnWindowMaxMB";
+static constexpr std::uint64_t UcxRmaConnWindowMaxMBDefault = 0;
+
+// Adaptive RMA concurrency: largest window of rma_get bytes in flight of all connections
+static constexpr std::string_view UcxRmaNodeWindowMaxMBKey = "UcxRmaNodeWindowMaxMB";
+static constexpr std::uint64_t UcxRmaNodeWindowMaxMBDefault = 1024;
+
+// Adaptive RMA concurrency: latency increase above the unloaded link (percent), considered as congestion
+static constexpr std::string_view UcxRmaLatencyTolerancePctKey = "UcxRmaLatencyTolerancePct";
+static constexpr std::uint64_t UcxRmaLatencyTolerancePctDefault = 50;
+
+// Number of progress threads shared by all StfSender connections. 0: each receiver thread progresses its connection
+static constexpr std::string_view UcxTfBuilderProgressThreadsKey = "UcxTfBuilderProgressThreads";
+static constexpr std::uint64_t UcxTfBuilderProgressThreadsDefault = 2;
+
+// Busy polling of progress threads after the last progress (us), before sleeping on the workers
+static constexpr std::string_view UcxTfBuilderProgressBusyPollUsKey = "UcxTfBuilderProgressBusyPollUs";
+static constexpr std::uint64_t UcxTfBuilderProgressBusyPollUsDefault = 50;
+
+// Multi-rail: local ips of additional interfaces, "<ip>,<ip>,...". StfSenders connect one endpoint to each rail, and STF
+// data is striped across the rails. Empty: one rail, on the ip of the TfBuilder
+static constexpr std::string_view UcxTfBuilderRailIpsKey = "UcxTfBuilderRailIps";
+static constexpr std::string_view UcxTfBuilderRailIpsDefault = "";
+
+// Multi-rail: largest chunk of a txg transferred on one rail (KiB)
+static constexpr std::string_view UcxRailStripeSizeKBKey = "UcxRailStripeSizeKB";
+static constexpr std::uint64_t UcxRailStripeSizeKBDefault = 1024;
+
 
 ////////////////////////////////////////////////////////////////////////////////
 /// TfScheduler
@@ -0,0 +1,206 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "DataDistLogger.h"
+
+#include "DataDistTracing.h"
+#include "DataDistMonitoring.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <unistd.h>
+
+namespace o2::DataDistribution
+{
+
+namespace bfs = boost::filesystem;
+
+////////////////////////////////////////////////////////////////////////////////
+/// StfTraceHistogram
+////////////////////////////////////////////////////////////////////////////////
+
+void StfTraceHistogram::add(const std::uint64_t pUs)
+{
+  // bucket i holds values in [2^(i-1), 2^i)
+  std::size_t lBucket = 0;
+  for (std::uint64_t lVal = pUs; lVal > 0 && lBucket < (sNumBuckets - 1); lVal >>= 1) {
+    lBucket++;
+  }
+
+  mBuckets[lBucket]++;
+  mCount++;
+  mMaxUs = std::max(mMaxUs, pUs);
+}
+
+std::uint64_t StfTraceHistogram::percentileUs(const double pPercentile) const
+{
+  if (mCount == 0) {
+    return 0;
+  }
+
+  const std::uint64_t lRank = std::max(std::uint64_t(1), std::uint64_t(std::ceil(pPercentile * double(mCount))));
+  std::uint64_t lCount = 0;
+
+  for (std::size_t i = 0; i < sNumBuckets; i++) {
+    lCount += mBuckets[i];
+    if (lCount >= lRank) {
+      return std::min(mMaxUs, (std::uint64_t(1) << i) - 1);
+    }
+  }
+  return mMaxUs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// DataDistTracer
+////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<DataDistTracer> DataDistTracer::sTracer = nullptr;
+
+void DataDistTracer::start(const std::string &pProcName, const std::uint64_t pSampleInterval, const std::string &pDumpDir)
+{
+  sTracer = std::make_unique<DataDistTracer>(pProcName, pSampleInterval, pDumpDir);
+}
+
+void DataDistTracer::stop()
+{
+  sTracer = nullptr;
+}
+
+DataDistTracer::DataDistTracer(const std::string &pProcName, const std::uint64_t pSampleInterval, const std::string &pDumpDir)
+  : mProcName(pProcName),
+    mSampleInterval(pSampleInterval),
+    mPid(getpid())
+{
+  if (mSampleInterval == 0) {
+    return;
+  }
+
+  const auto lFileName = (bfs::path(pDumpDir) / fmt::format("{}_{}.trace.json", mProcName, mPid)).string();
+
+  mTraceFile.open(lFileName, std::ios::out | std::ios::trunc);
+  if (!mTraceFile.good()) {
+    EDDLOG("Cannot open the trace file. Disabling STF trace sampling. file={}", lFileName);
+    mSampleInterval = 0;
+    return;
+  }
+
+  // Chrome JSON array format: the closing bracket is optional
+  mTraceFile << "[\n" << fmt::format(R"({{"name":"process_name","ph":"M","pid":{},"args":{{"name":"{}"}}}})",
+    mPid, mProcName);
+
+  IDDLOG("Writing STF trace events. sample_interval={} file={}", mSampleInterval, lFileName);
+}
+
+DataDistTracer::~DataDistTracer()
+{
+  std::scoped_lock lLock(mLock);
+
+  logHistograms();
+
+  if (mTraceFile.is_open()) {
+    mTraceFile << "\n]\n";
+    mTraceFile.close();
+  }
+}
+
+void DataDistTracer::record_impl(const std::uint64_t pStfId, const StfTrace &pTrace)
+{
+  static const auto sMetricKeys = []() {
+    std::array<std::string, eStfTraceStageCount> lKeys;
+    for (std::size_t i = 0; i < eStfTraceStageCount; i++) {
+      lKeys[i] = fmt::format("{}_us", to_string(StfTraceStage(i)));
+    }
+    return lKeys;
+  }();
+
+  const std::size_t lNumEvents = std::min(std::size_t(pTrace.mNumEvents), StfTrace::sMaxEvents);
+  if (lNumEvents == 0) {
+    return;
+  }
+
+  {
+    std::scoped_lock lLock(mLock);
+
+    // latency of each stage since the previous event (can be in a different process)
+    for (std::size_t i = std::max(std::size_t(pTrace.mProcessStart), std::size_t(1)); i < lNumEvents; i++) {
+      const auto lStage = pTrace.mStage[i];
+      if (lStage >= eStfTraceStageCount) {
+        continue;
+      }
+
+      // do not report negative latencies caused by clock offsets between hosts
+      const std::uint64_t lUs = (pTrace.mTimeNs[i] > pTrace.mTimeNs[i-1]) ? (pTrace.mTimeNs[i] - pTrace.mTimeNs[i-1]) / 1000 : 0;
+
+      mStageHist[lStage].add(lUs);
+      DDMON("stftrace", sMetricKeys[lStage], lUs);
+    }
+
+    // latency since the first event of the trace
+    const std::uint64_t lTotalUs = (pTrace.mTimeNs[lNumEvents-1] - std::min(pTrace.mTimeNs[0], pTrace.mTimeNs[lNumEvents-1])) / 1000;
+    mTotalHist.add(lTotalUs);
+    DDMON("stftrace", "total_us", lTotalUs);
+
+    if (mSampleInterval > 0 && (pStfId % mSampleInterval) == 0) {
+      dump(pStfId, pTrace);
+    }
+
+    const auto lNow = std::chrono::steady_clock::now();
+    if (lNow - mLastLogTime > std::chrono::seconds(30)) {
+      mLastLogTime = lNow;
+      logHistograms();
+    }
+  }
+}
+
+void DataDistTracer::dump(const std::uint64_t pStfId, const StfTrace &pTrace)
+{
+  // "complete" event for each stage stamped by this process. One track per STF.
+  const std::size_t lNumEvents = std::min(std::size_t(pTrace.mNumEvents), StfTrace::sMaxEvents);
+
+  for (std::size_t i = std::max(std::size_t(pTrace.mProcessStart), std::size_t(1)); i < lNumEvents; i++) {
+    const auto lStage = StfTraceStage(pTrace.mStage[i]);
+    const std::uint64_t lDurNs = (pTrace.mTimeNs[i] > pTrace.mTimeNs[i-1]) ? (pTrace.mTimeNs[i] - pTrace.mTimeNs[i-1]) : 0;
+
+    mTraceFile << fmt::format(",\n" R"({{"name":"{}","cat":"stf","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":{},"tid":{},"args":{{"stf_id":{}}}}})",
+      to_string(lStage), double(pTrace.mTimeNs[i] - lDurNs) / 1000.0, double(lDurNs) / 1000.0, mPid, pStfId, pStfId);
+  }
+}
+
+void DataDistTracer::logHistograms()
+{
+  fmt::memory_buffer lLine;
+  fmt::format_to(fmt::appender(lLine), "STF trace latency (p50/p99/max us) process={}", mProcName);
+
+  for (std::size_t i = 0; i < eStfTraceStageCount; i++) {
+    const auto &lHist = mStageHist[i];
+    if (lHist.count() == 0) {
+      continue;
+    }
+    fmt::format_to(fmt::appender(lLine), " {}={}/{}/{}", to_string(StfTraceStage(i)),
+      lHist.percentileUs(0.50), lHist.percentileUs(0.99), lHist.maxUs());
+  }
+
+  if (mTotalHist.count() == 0) {
+    return;
+  }
+
+  fmt::format_to(fmt::appender(lLine), " total={}/{}/{} count={}", mTotalHist.percentileUs(0.50),
+    mTotalHist.percentileUs(0.99), mTotalHist.maxUs(), mTotalHist.count());
+
+  IDDLOG("{}", std::string(lLine.begin(), lLine.end()));
+}
+
+} /* namespace o2::DataDistribution */
@@ -0,0 +1,102 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DATADIST_TRACING_H_
+#define DATADIST_TRACING_H_
+
+#include "StfTrace.h"
+
+#include <boost/program_options.hpp>
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace o2::DataDistribution
+{
+
+/// Log2 histogram of latencies in microseconds
+class StfTraceHistogram {
+public:
+  static constexpr std::size_t sNumBuckets = 32;
+
+  void add(const std::uint64_t pUs);
+  void clear() { mBuckets.fill(0); mCount = 0; mMaxUs = 0; }
+
+  std::uint64_t count() const { return mCount; }
+  std::uint64_t maxUs() const { return mMaxUs; }
+  // upper bound of the bucket containing the percentile
+  std::uint64_t percentileUs(const double pPercentile) const;
+
+private:
+  std::array<std::uint64_t, sNumBuckets> mBuckets = { };
+  std::uint64_t mCount = 0;
+  std::uint64_t mMaxUs = 0;
+};
+
+
+class DataDistTracer {
+public:
+  DataDistTracer() = delete;
+  DataDistTracer(const std::string &pProcName, const std::uint64_t pSampleInterval, const std::string &pDumpDir);
+  ~DataDistTracer();
+
+  static void start(const std::string &pProcName, const std::uint64_t pSampleInterval, const std::string &pDumpDir);
+  static void stop();
+
+  /// Account latencies of stages stamped by this process, and dump the trace if the STF is sampled
+  static void record(const std::uint64_t pStfId, const StfTrace &pTrace) {
+    if (sTracer) {
+      sTracer->record_impl(pStfId, pTrace);
+    }
+  }
+
+  static std::unique_ptr<DataDistTracer> sTracer;
+
+private:
+  void record_impl(const std::uint64_t pStfId, const StfTrace &pTrace);
+  void dump(const std::uint64_t pStfId, const StfTrace &pTrace);
+  void logHistograms();
+
+  std::string mProcName;
+  std::uint64_t mSampleInterval;
+
+  std::mutex mLock;
+  std::array<StfTraceHistogram, eStfTraceStageCount> mStageHist;
+  StfTraceHistogram mTotalHist;
+  std::chrono::steady_clock::time_point mLastLogTime = std::chrono::steady_clock::now();
+
+  std::ofstream mTraceFile;
+  int mPid = 0;
+
+public:
+  // Tracing Options
+  static boost::program_options::options_description getProgramOptions() {
+    namespace bpo = boost::program_options;
+
+    bpo::options_description lTracingOpts("Tracing options", 120);
+    lTracingOpts.add_options()
+      ("trace-sample-interval", bpo::value<std::uint64_t>()->default_value(0),
+        "Write Chrome trace (Perfetto) events of every n-th STF (by id). 0 disables the trace file.")
+      ("trace-dump-dir", bpo::value<std::string>()->default_value("."), "Directory of the trace file.");
+
+    return lTracingOpts;
+  };
+};
+
+} /* namespace o2::DataDistribution */
+
+#endif /* DATADIST_TRACING_H_ */
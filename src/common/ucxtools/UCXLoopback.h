@@ -0,0 +1,104 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DATADIST_UCX_LOOPBACK_H_
+#define DATADIST_UCX_LOOPBACK_H_
+
+// Loopback UCX connection (client and server worker in one process) for the UCX measurement tools.
+// Select the transport with UCX_TLS (e.g. UCX_TLS=tcp, or UCX_TLS=shm,tcp).
+
+#include <UCXUtilities.h>
+#include <UCXSendRecv.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace o2::DataDistribution::ucx {
+
+struct UcxLoopbackConn {
+  ucp_context_h ucp_context = nullptr;
+
+  dd_ucp_worker server_worker;
+  ucp_listener_h ucp_listener = nullptr;
+  ucp_conn_request_h conn_request = nullptr;
+  ucp_ep_h server_ep = nullptr;
+
+  dd_ucp_worker client_worker;
+  ucp_ep_h client_ep = nullptr;
+
+  void progress()
+  {
+    ucp_worker_progress(client_worker.ucp_worker);
+    ucp_worker_progress(server_worker.ucp_worker);
+  }
+
+  bool connect(const std::string &pIp)
+  {
+    if (!util::create_ucp_context(&ucp_context) ||
+        !util::create_ucp_worker(ucp_context, &server_worker, "server") ||
+        !util::create_ucp_worker(ucp_context, &client_worker, "client")) {
+      return false;
+    }
+
+    if (!util::create_ucp_listener(server_worker.ucp_worker, pIp, &ucp_listener, conn_handle_cb, this)) {
+      return false;
+    }
+
+    ucp_listener_attr_t attr;
+    attr.field_mask = UCP_LISTENER_ATTR_FIELD_SOCKADDR;
+    if (ucp_listener_query(ucp_listener, &attr) != UCS_OK) {
+      return false;
+    }
+    const auto lPort = util::sockaddr_to_port(&attr.sockaddr);
+
+    if (!util::create_ucp_client_ep(client_worker.ucp_worker, pIp, lPort, &client_ep, ep_err_cb, nullptr, "client")) {
+      return false;
+    }
+
+    while (!conn_request) {
+      progress();
+    }
+
+    if (!util::create_ucp_ep(server_worker.ucp_worker, conn_request, &server_ep, ep_err_cb, nullptr, "server")) {
+      return false;
+    }
+
+    // make sure the client endpoint is wired up
+    return util::flush_ep_blocking(client_worker.ucp_worker, client_ep);
+  }
+
+  void close()
+  {
+    ucp_listener_destroy(ucp_listener);
+    util::close_connection(client_worker, client_ep);
+    util::close_connection(server_worker, server_ep);
+    ucp_cleanup(ucp_context);
+  }
+
+private:
+  static void conn_handle_cb(ucp_conn_request_h pConnRequest, void *pArg)
+  {
+    reinterpret_cast<UcxLoopbackConn*>(pArg)->conn_request = pConnRequest;
+  }
+
+  static void ep_err_cb(void *, ucp_ep_h, ucs_status_t pStatus)
+  {
+    std::cerr << "UCX endpoint error: " << ucs_status_string(pStatus) << std::endl;
+    std::exit(2);
+  }
+};
+
+} /* o2::DataDistribution::ucx */
+
+#endif // DATADIST_UCX_LOOPBACK_H_
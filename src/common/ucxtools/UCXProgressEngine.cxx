@@ -0,0 +1,231 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "UCXProgressEngine.h"
+
+#include <DataDistLogger.h>
+#include <Utilities.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace o2::DataDistribution::ucx {
+
+////////////////////////////////////////////////////////////////////////////////
+/// UCXProgressEngine
+////////////////////////////////////////////////////////////////////////////////
+
+bool UCXProgressEngine::start(const unsigned pNumThreads, const std::uint64_t pBusyPollUs, const std::string &pName)
+{
+  if (mRunning.load()) {
+    return true;
+  }
+
+  mBusyPollUs = pBusyPollUs;
+  mName = pName;
+
+  for (unsigned i = 0; i < std::max(1U, pNumThreads); i++) {
+    auto lThread = std::make_unique<ProgressThread>();
+
+    lThread->mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    lThread->mEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (lThread->mEpollFd < 0 || lThread->mEventFd < 0) {
+      EDDLOG("UCXProgressEngine: failed to create epoll structures. name={} errno={}", mName, errno);
+      return false;
+    }
+
+    struct epoll_event lEv;
+    lEv.events = EPOLLIN;
+    lEv.data.fd = lThread->mEventFd;
+    if (epoll_ctl(lThread->mEpollFd, EPOLL_CTL_ADD, lThread->mEventFd, &lEv) != 0) {
+      EDDLOG("UCXProgressEngine: failed to add the eventfd. name={} errno={}", mName, errno);
+      return false;
+    }
+
+    mThreads.push_back(std::move(lThread));
+  }
+
+  mRunning = true;
+
+  for (std::size_t i = 0; i < mThreads.size(); i++) {
+    auto &lThread = *mThreads[i];
+    lThread.mThread = create_thread_member((mName + "_prog_" + std::to_string(i)).c_str(),
+      &UCXProgressEngine::ProgressThreadFn, this, &lThread);
+  }
+
+  IDDLOG("UCXProgressEngine: started. name={} threads={} busy_poll_us={}", mName, mThreads.size(), mBusyPollUs);
+  return true;
+}
+
+void UCXProgressEngine::stop()
+{
+  if (!mRunning.exchange(false)) {
+    return;
+  }
+
+  for (auto &lThread : mThreads) {
+    const std::uint64_t lOne = 1;
+    [[maybe_unused]] auto lRet = write(lThread->mEventFd, &lOne, sizeof(lOne));
+  }
+
+  for (auto &lThread : mThreads) {
+    if (lThread->mThread.joinable()) {
+      lThread->mThread.join();
+    }
+
+    IDDLOG("UCXProgressEngine: thread stopped. name={} workers={} progress_calls={} sleeps={}", mName,
+      lThread->mWorkers.size(), lThread->mNumProgress, lThread->mNumSleeps);
+
+    close(lThread->mEventFd);
+    close(lThread->mEpollFd);
+  }
+  mThreads.clear();
+}
+
+bool UCXProgressEngine::add(dd_ucp_worker &pWorker)
+{
+  if (!mRunning.load() || mThreads.empty()) {
+    return false;
+  }
+
+  const unsigned lThreadIdx = mNextThread++ % mThreads.size();
+  auto &lThread = *mThreads[lThreadIdx];
+
+  {
+    std::scoped_lock lLock(lThread.mWorkersLock);
+
+    struct epoll_event lEv;
+    lEv.events = EPOLLIN;
+    lEv.data.fd = pWorker.worker_efd;
+    if (epoll_ctl(lThread.mEpollFd, EPOLL_CTL_ADD, pWorker.worker_efd, &lEv) != 0) {
+      EDDLOG("UCXProgressEngine: failed to add the worker fd. name={} errno={}", mName, errno);
+      return false;
+    }
+
+    lThread.mWorkers.push_back(pWorker.ucp_worker);
+
+    // the thread index is published with the engine
+    pWorker.progress_thread = lThreadIdx;
+    pWorker.progress_engine.store(this);
+  }
+
+  // progress the new worker
+  const std::uint64_t lOne = 1;
+  [[maybe_unused]] auto lRet = write(lThread.mEventFd, &lOne, sizeof(lOne));
+  return true;
+}
+
+void UCXProgressEngine::remove(dd_ucp_worker &pWorker)
+{
+  if (pWorker.progress_engine.load() != this || pWorker.progress_thread >= mThreads.size()) {
+    return;
+  }
+
+  auto &lThread = *mThreads[pWorker.progress_thread];
+  {
+    // the thread does not use the worker after the lock is released
+    std::scoped_lock lLock(lThread.mWorkersLock);
+
+    epoll_ctl(lThread.mEpollFd, EPOLL_CTL_DEL, pWorker.worker_efd, nullptr);
+    lThread.mWorkers.erase(std::remove(lThread.mWorkers.begin(), lThread.mWorkers.end(), pWorker.ucp_worker),
+      lThread.mWorkers.end());
+
+    pWorker.progress_engine.store(nullptr);
+  }
+}
+
+void UCXProgressEngine::ProgressThreadFn(ProgressThread *pThread)
+{
+  auto &lThread = *pThread;
+  using clock = std::chrono::steady_clock;
+
+  const auto lBusyPoll = std::chrono::microseconds(mBusyPollUs);
+  auto lLastProgress = clock::now();
+
+  constexpr int cMaxEvents = 64;
+  struct epoll_event lEvents[cMaxEvents];
+
+  while (mRunning.load()) {
+    bool lArmed = false;
+    {
+      std::scoped_lock lLock(lThread.mWorkersLock);
+
+      // progress all workers until there is no more work
+      unsigned lProgress = 0;
+      for (auto lWorker : lThread.mWorkers) {
+        while (ucp_worker_progress(lWorker)) {
+          lProgress++;
+        }
+      }
+      lThread.mNumProgress += lProgress;
+
+      if (lProgress > 0) {
+        lLastProgress = clock::now();
+        continue;
+      }
+
+      // busy polling budget
+      if ((clock::now() - lLastProgress) < lBusyPoll) {
+        continue;
+      }
+
+      // operations posted before this point are progressed below, later ones kick() the thread
+      lThread.mSleeping = true;
+      for (auto lWorker : lThread.mWorkers) {
+        while (ucp_worker_progress(lWorker)) {
+          lProgress++;
+        }
+      }
+      if (lProgress > 0) {
+        lThread.mSleeping = false;
+        lThread.mNumProgress += lProgress;
+        lLastProgress = clock::now();
+        continue;
+      }
+
+      // arm all workers before sleeping
+      lArmed = std::all_of(lThread.mWorkers.begin(), lThread.mWorkers.end(), [](ucp_worker_h pWorker) {
+        return ucp_worker_arm(pWorker) == UCS_OK;
+      });
+    }
+
+    if (!lArmed) {
+      lThread.mSleeping = false;
+      continue; // events pending, progress again
+    }
+
+    lThread.mNumSleeps++;
+    const int lNumEvents = epoll_wait(lThread.mEpollFd, lEvents, cMaxEvents, 100);
+    lThread.mSleeping = false;
+
+    for (int i = 0; i < lNumEvents; i++) {
+      if (lEvents[i].data.fd == lThread.mEventFd) {
+        std::uint64_t lVal;
+        [[maybe_unused]] auto lRet = read(lThread.mEventFd, &lVal, sizeof(lVal));
+      }
+    }
+
+    if ((lNumEvents < 0) && (errno != EINTR)) {
+      EDDLOG_RL(1000, "UCXProgressEngine: epoll_wait failed. name={} errno={}", mName, errno);
+    }
+    lLastProgress = clock::now();
+  }
+
+  DDDLOG("UCXProgressEngine: exiting the progress thread. name={}", mName);
+}
+
+} /* o2::DataDistribution::ucx */
@@ -0,0 +1,97 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DATADIST_UCX_PROGRESS_ENGINE_H_
+#define DATADIST_UCX_PROGRESS_ENGINE_H_
+
+#include "UCXUtilities.h"
+
+#include <ucp/api/ucp.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace o2::DataDistribution::ucx {
+
+////////////////////////////////////////////////////////////////////////////////
+/// UCXProgressEngine
+////////////////////////////////////////////////////////////////////////////////
+
+///
+/// Progress threads shared by many workers. Each thread progresses its workers until there is no
+/// more work, keeps polling for the busy-poll budget, and then arms the workers and sleeps on one
+/// epoll set. Blocking operations on workers added to the engine do not progress the worker,
+/// they wait for the completion callbacks (see ucx::io::ucp_wait_until()).
+///
+class UCXProgressEngine
+{
+ public:
+  UCXProgressEngine() = default;
+  ~UCXProgressEngine() { stop(); }
+
+  UCXProgressEngine(const UCXProgressEngine&) = delete;
+  UCXProgressEngine& operator=(const UCXProgressEngine&) = delete;
+
+  /// Start the progress threads. Busy polling budget (us) after the last progress of the thread.
+  bool start(const unsigned pNumThreads, const std::uint64_t pBusyPollUs, const std::string &pName);
+  void stop();
+
+  bool running() const { return mRunning.load(); }
+
+  /// Progress the worker with the engine. Call after the connection handshake.
+  bool add(dd_ucp_worker &pWorker);
+  /// Stop progressing the worker. Must be called before the worker is destroyed.
+  void remove(dd_ucp_worker &pWorker);
+
+  /// Wake up the thread of the worker after new operations are posted
+  void kick(const dd_ucp_worker &pWorker)
+  {
+    if (pWorker.progress_thread < mThreads.size() && mThreads[pWorker.progress_thread]->mSleeping.load()) {
+      ucp_worker_signal(pWorker.ucp_worker);
+    }
+  }
+
+ private:
+  struct ProgressThread {
+    int mEpollFd = -1;
+    int mEventFd = -1; // wake up on stop, and changes of the worker set
+    std::atomic_bool mSleeping = false;
+
+    std::mutex mWorkersLock;
+    std::vector<ucp_worker_h> mWorkers;
+
+    // statistics
+    std::uint64_t mNumProgress = 0;
+    std::uint64_t mNumSleeps = 0;
+
+    std::thread mThread;
+  };
+
+  void ProgressThreadFn(ProgressThread *pThread);
+
+  std::atomic_bool mRunning = false;
+  std::uint64_t mBusyPollUs = 0;
+  std::string mName;
+
+  std::vector<std::unique_ptr<ProgressThread>> mThreads;
+  std::atomic_uint64_t mNextThread = 0;
+};
+
+} /* o2::DataDistribution::ucx */
+
+#endif // DATADIST_UCX_PROGRESS_ENGINE_H_
@@ -0,0 +1,77 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "UCXRails.h"
+
+#include <boost/algorithm/string.hpp>
+
+namespace o2::DataDistribution::ucx {
+
+std::vector<std::string> parse_rail_ips(const std::string &pRailIps)
+{
+  std::vector<std::string> lTokens;
+  std::vector<std::string> lRailIps;
+
+  boost::split(lTokens, pRailIps, boost::is_any_of(", "), boost::token_compress_on);
+
+  for (auto &lIp : lTokens) {
+    boost::trim(lIp);
+    if (!lIp.empty() && std::find(lRailIps.cbegin(), lRailIps.cend(), lIp) == lRailIps.cend()) {
+      lRailIps.push_back(lIp);
+    }
+  }
+  return lRailIps;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// UCXRailStats
+////////////////////////////////////////////////////////////////////////////////
+
+void UCXRailStats::configure(const std::vector<std::string> &pRailNames)
+{
+  std::scoped_lock lLock(mReportLock);
+
+  mNumRails = pRailNames.size();
+  mRailNames = pRailNames;
+  mBytes = std::make_unique<std::atomic_uint64_t[]>(mNumRails);
+  for (std::size_t i = 0; i < mNumRails; i++) {
+    mBytes[i] = 0;
+  }
+  mReportedBytes.assign(mNumRails, 0);
+  mLastReport = std::chrono::steady_clock::now();
+}
+
+bool UCXRailStats::report(const std::chrono::milliseconds pPeriod, std::vector<double> &pRatesMiBs)
+{
+  std::unique_lock lLock(mReportLock, std::try_to_lock);
+  if (!lLock.owns_lock()) {
+    return false;
+  }
+
+  const auto lNow = std::chrono::steady_clock::now();
+  const auto lElapsedS = std::chrono::duration<double>(lNow - mLastReport).count();
+  if (lElapsedS < std::chrono::duration<double>(pPeriod).count()) {
+    return false;
+  }
+
+  pRatesMiBs.clear();
+  for (std::size_t i = 0; i < mNumRails; i++) {
+    const auto lBytes = bytes(i);
+    pRatesMiBs.push_back(double(lBytes - mReportedBytes[i]) / double(1ULL << 20) / lElapsedS);
+    mReportedBytes[i] = lBytes;
+  }
+  mLastReport = lNow;
+  return true;
+}
+
+} /* o2::DataDistribution::ucx */
@@ -0,0 +1,147 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DATADIST_UCX_RAILS_H_
+#define DATADIST_UCX_RAILS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace o2::DataDistribution::ucx {
+
+/// Parse the list of rail addresses: "<ip>,<ip>,..."
+std::vector<std::string> parse_rail_ips(const std::string &pRailIps);
+
+////////////////////////////////////////////////////////////////////////////////
+/// UCXRailStriper
+////////////////////////////////////////////////////////////////////////////////
+
+///
+/// Striping of the RMA transfers of one STF across the rails (endpoints) of a connection.
+/// Transfers are split into chunks of at most the stripe size, and each chunk goes to the rail
+/// with the least bytes assigned so far. Small txgs are not split, they only balance the rails.
+///
+class UCXRailStriper
+{
+ public:
+  explicit UCXRailStriper(const std::uint64_t pStripeSize = (1ULL << 20))
+  : mStripeSize(std::max(std::uint64_t(4096), pStripeSize))
+  { }
+
+  /// Start a new STF on the rails
+  void reset(const std::size_t pNumRails)
+  {
+    mRailBytes.assign(std::max(std::size_t(1), pNumRails), 0);
+  }
+
+  /// Call pFn(rail, offset, len) for each chunk of the transfer. Stops when pFn returns false.
+  template <typename Fn>
+  bool stripe(const std::uint64_t pLen, const Fn &pFn)
+  {
+    return stripe(pLen, [](const std::size_t) { return true; }, pFn);
+  }
+
+  /// As above, using only the rails for which pRailOk(rail) is true (e.g. the region is mapped on the rail).
+  /// Rail 0 (the control endpoint) is always used.
+  template <typename RailOk, typename Fn>
+  bool stripe(const std::uint64_t pLen, const RailOk &pRailOk, const Fn &pFn)
+  {
+    if (mRailBytes.size() == 1) {
+      mRailBytes[0] += pLen;
+      return pFn(0, 0, pLen);
+    }
+
+    // keep chunks of the transfer of similar size
+    const std::uint64_t lNumChunks = (pLen + mStripeSize - 1) / mStripeSize;
+    const std::uint64_t lChunkSize = (lNumChunks > 0) ? ((pLen + lNumChunks - 1) / lNumChunks) : pLen;
+
+    std::uint64_t lOff = 0;
+    do {
+      const auto lLen = std::min(lChunkSize, pLen - lOff);
+
+      // least loaded of the usable rails
+      std::size_t lRail = 0;
+      for (std::size_t i = 1; i < mRailBytes.size(); i++) {
+        if (mRailBytes[i] < mRailBytes[lRail] && pRailOk(i)) {
+          lRail = i;
+        }
+      }
+
+      mRailBytes[lRail] += lLen;
+      if (!pFn(lRail, lOff, lLen)) {
+        return false;
+      }
+      lOff += lLen;
+    } while (lOff < pLen);
+
+    return true;
+  }
+
+  /// Bytes assigned to each rail since reset()
+  const std::vector<std::uint64_t>& railBytes() const { return mRailBytes; }
+
+  std::uint64_t stripeSize() const { return mStripeSize; }
+
+ private:
+  std::uint64_t mStripeSize;
+  std::vector<std::uint64_t> mRailBytes = { 0 };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// UCXRailStats
+////////////////////////////////////////////////////////////////////////////////
+
+///
+/// Bytes transferred on each rail (local interface) of the node, and the bandwidth of the rails
+/// over the reporting period.
+///
+class UCXRailStats
+{
+ public:
+  void configure(const std::vector<std::string> &pRailNames);
+
+  std::size_t size() const { return mNumRails; }
+  const std::string& name(const std::size_t pRail) const { return mRailNames[pRail]; }
+
+  void add(const std::size_t pRail, const std::uint64_t pBytes)
+  {
+    if (pRail < mNumRails) {
+      mBytes[pRail].fetch_add(pBytes, std::memory_order_relaxed);
+    }
+  }
+
+  std::uint64_t bytes(const std::size_t pRail) const { return mBytes[pRail].load(std::memory_order_relaxed); }
+
+  /// Bandwidth of the rails (MiB/s) since the last report. Only one caller gets the report of a period,
+  /// others return false.
+  bool report(const std::chrono::milliseconds pPeriod, std::vector<double> &pRatesMiBs);
+
+ private:
+  std::size_t mNumRails = 0;
+  std::vector<std::string> mRailNames;
+  std::unique_ptr<std::atomic_uint64_t[]> mBytes;
+
+  std::mutex mReportLock;
+  std::vector<std::uint64_t> mReportedBytes;
+  std::chrono::steady_clock::time_point mLastReport;
+};
+
+} /* o2::DataDistribution::ucx */
+
+#endif // DATADIST_UCX_RAILS_H_
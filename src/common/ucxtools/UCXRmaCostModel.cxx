@@ -0,0 +1,137 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "UCXRmaCostModel.h"
+
+#include <DataDistLogger.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+
+namespace o2::DataDistribution::ucx {
+
+////////////////////////////////////////////////////////////////////////////////
+/// UCXRmaCostModel
+////////////////////////////////////////////////////////////////////////////////
+
+bool UCXRmaCostModel::parse(const std::string &pModel)
+{
+  std::vector<std::string> lPointStrs;
+  boost::split(lPointStrs, pModel, boost::is_any_of(","), boost::token_compress_on);
+
+  std::vector<Point> lPoints;
+
+  for (auto &lPointStr : lPointStrs) {
+    boost::trim(lPointStr);
+    if (lPointStr.empty()) {
+      continue;
+    }
+
+    const auto lSep = lPointStr.find(':');
+    if (lSep == std::string::npos) {
+      EDDLOG("UCXRmaCostModel: invalid point, expected <size_bytes>:<time_us>. point={}", lPointStr);
+      return false;
+    }
+
+    try {
+      Point lPoint;
+      lPoint.mSize = boost::lexical_cast<std::uint64_t>(boost::trim_copy(lPointStr.substr(0, lSep)));
+      lPoint.mTimeUs = boost::lexical_cast<double>(boost::trim_copy(lPointStr.substr(lSep + 1)));
+      if (lPoint.mTimeUs < 0.0) {
+        EDDLOG("UCXRmaCostModel: negative time. point={}", lPointStr);
+        return false;
+      }
+      lPoints.push_back(lPoint);
+    } catch (boost::bad_lexical_cast &e) {
+      EDDLOG("UCXRmaCostModel: invalid point. point={} what={}", lPointStr, e.what());
+      return false;
+    }
+  }
+
+  std::sort(lPoints.begin(), lPoints.end(), [](const Point &a, const Point &b) { return a.mSize < b.mSize; });
+  lPoints.erase(std::unique(lPoints.begin(), lPoints.end(),
+    [](const Point &a, const Point &b) { return a.mSize == b.mSize; }), lPoints.end());
+
+  if (lPoints.size() < 2) {
+    EDDLOG("UCXRmaCostModel: at least two points with different sizes are required. model={}", pModel);
+    return false;
+  }
+
+  mPoints = std::move(lPoints);
+  return true;
+}
+
+std::string UCXRmaCostModel::to_string() const
+{
+  std::string lStr;
+  for (const auto &lPoint : mPoints) {
+    if (!lStr.empty()) {
+      lStr += ",";
+    }
+    lStr += fmt::format("{}:{:.3f}", lPoint.mSize, lPoint.mTimeUs);
+  }
+  return lStr;
+}
+
+double UCXRmaCostModel::cost(const std::uint64_t pSize) const
+{
+  if (!valid()) {
+    return 0.0;
+  }
+
+  // latency floor
+  if (pSize <= mPoints.front().mSize) {
+    return mPoints.front().mTimeUs;
+  }
+
+  // segment containing the size, or the last one
+  auto lIt = std::lower_bound(mPoints.cbegin(), mPoints.cend(), pSize,
+    [](const Point &a, const std::uint64_t s) { return a.mSize < s; });
+  if (lIt == mPoints.cend()) {
+    lIt = std::prev(mPoints.cend());
+  }
+  const auto &lHi = *lIt;
+  const auto &lLo = *std::prev(lIt);
+
+  const double lSlope = (lHi.mTimeUs - lLo.mTimeUs) / double(lHi.mSize - lLo.mSize);
+  return std::max(0.0, lLo.mTimeUs + lSlope * double(pSize - lLo.mSize));
+}
+
+std::uint64_t UCXRmaCostModel::maxMergeGap(const std::uint64_t pTxgLen, const std::uint64_t pNextLen,
+                                           const std::uint64_t pLimit) const
+{
+  if (!merge(pTxgLen, 0, pNextLen)) {
+    return 0;
+  }
+
+  // binary search: merge() is monotonic in the gap
+  std::uint64_t lLo = 0;
+  std::uint64_t lHi = pLimit;
+  if (merge(pTxgLen, lHi, pNextLen)) {
+    return lHi;
+  }
+
+  while ((lHi - lLo) > 1) {
+    const std::uint64_t lMid = lLo + (lHi - lLo) / 2;
+    if (merge(pTxgLen, lMid, pNextLen)) {
+      lLo = lMid;
+    } else {
+      lHi = lMid;
+    }
+  }
+  return lLo;
+}
+
+} /* o2::DataDistribution::ucx */
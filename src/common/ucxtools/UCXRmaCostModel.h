@@ -0,0 +1,70 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DATADIST_UCX_RMA_COST_MODEL_H_
+#define DATADIST_UCX_RMA_COST_MODEL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace o2::DataDistribution::ucx {
+
+////////////////////////////////////////////////////////////////////////////////
+/// UCXRmaCostModel
+////////////////////////////////////////////////////////////////////////////////
+
+///
+/// Time of a single RMA get operation as a function of its size. The cost is interpolated
+/// (piecewise linear) from calibration points, measured with UcxRmaCalibration on the link.
+/// Above the last point the cost grows with the bandwidth of the last segment.
+///
+/// Text format: "<size_bytes>:<time_us>,<size_bytes>:<time_us>,..."
+///
+class UCXRmaCostModel
+{
+ public:
+  struct Point {
+    std::uint64_t mSize;
+    double mTimeUs;
+  };
+
+  UCXRmaCostModel() = default;
+
+  /// Parse the model from the text format. The model is not changed on error.
+  bool parse(const std::string &pModel);
+  std::string to_string() const;
+
+  bool valid() const { return mPoints.size() >= 2; }
+  const std::vector<Point>& points() const { return mPoints; }
+
+  /// Time of a get operation of the size (us)
+  double cost(const std::uint64_t pSize) const;
+
+  /// Is it cheaper to extend the txg over the gap with the next buffer, than to issue a separate get?
+  bool merge(const std::uint64_t pTxgLen, const std::uint64_t pGap, const std::uint64_t pNextLen) const
+  {
+    return cost(pTxgLen + pGap + pNextLen) <= (cost(pTxgLen) + cost(pNextLen));
+  }
+
+  /// Largest gap for which merge() is true (for reporting)
+  std::uint64_t maxMergeGap(const std::uint64_t pTxgLen, const std::uint64_t pNextLen,
+                            const std::uint64_t pLimit = (16ULL << 20)) const;
+
+ private:
+  std::vector<Point> mPoints; // sorted by size
+};
+
+} /* o2::DataDistribution::ucx */
+
+#endif // DATADIST_UCX_RMA_COST_MODEL_H_
@@ -0,0 +1,90 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "UCXRmaWindow.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace o2::DataDistribution::ucx {
+
+////////////////////////////////////////////////////////////////////////////////
+/// UCXRmaWindow
+////////////////////////////////////////////////////////////////////////////////
+
+void UCXRmaWindow::configure(const Config &pConfig)
+{
+  std::scoped_lock lLock(mLock);
+
+  mConfig = pConfig;
+  mConfig.mMinBytes = std::max(std::uint64_t(1), mConfig.mMinBytes);
+  mConfig.mMaxBytes = std::max(mConfig.mMinBytes, mConfig.mMaxBytes);
+  mConfig.mDecrease = std::clamp(mConfig.mDecrease, 0.1, 0.99);
+  mConfig.mLatencyTolerance = std::max(0.0, mConfig.mLatencyTolerance);
+
+  mWindow = std::clamp(mConfig.mInitBytes, mConfig.mMinBytes, mConfig.mMaxBytes);
+  mBaseHistory.fill(std::numeric_limits<double>::max());
+  mBaseIdx = 0;
+  mBasePeriodStart = std::chrono::steady_clock::now();
+  mBaseLatencyUs = 0;
+  mMaxThroughput = 0;
+}
+
+bool UCXRmaWindow::update(const Sample &pSample)
+{
+  if (pSample.mOps == 0 || pSample.mBytes == 0 || pSample.mElapsedUs <= 0.0) {
+    return false;
+  }
+
+  std::scoped_lock lLock(mLock);
+
+  const auto lNow = std::chrono::steady_clock::now();
+
+  // bottleneck throughput: slowly decaying maximum
+  const double lThroughput = double(pSample.mBytes) / pSample.mElapsedUs;
+  mMaxThroughput = std::max(lThroughput, mMaxThroughput * 0.99);
+
+  // size independent part of the unloaded latency: minimum of the recent periods, to follow changes of the path
+  const double lOpSize = double(pSample.mBytes) / double(pSample.mOps);
+  const double lTransferUs = lOpSize / std::max(mMaxThroughput, 1e-9);
+  const double lBaseUs = std::max(0.0, pSample.mMinLatencyUs - lTransferUs);
+
+  if ((lNow - mBasePeriodStart) > sBasePeriod) {
+    mBaseIdx = (mBaseIdx + 1) % mBaseHistory.size();
+    mBaseHistory[mBaseIdx] = lBaseUs;
+    mBasePeriodStart = lNow;
+  } else {
+    mBaseHistory[mBaseIdx] = std::min(mBaseHistory[mBaseIdx], lBaseUs);
+  }
+  mBaseLatencyUs = *std::min_element(mBaseHistory.cbegin(), mBaseHistory.cend());
+
+  const double lExpectedUs = mBaseLatencyUs + lTransferUs;
+  const bool lCongested = pSample.mMeanLatencyUs > (lExpectedUs * (1.0 + mConfig.mLatencyTolerance));
+
+  auto lWindow = mWindow.load();
+
+  if (lCongested) {
+    // decrease at most once per latency period, all operations in flight see the same congestion
+    if (std::chrono::duration<double, std::micro>(lNow - mLastDecrease).count() > pSample.mMeanLatencyUs) {
+      lWindow = std::uint64_t(double(lWindow) * mConfig.mDecrease);
+      mLastDecrease = lNow;
+    }
+  } else {
+    lWindow += std::max(mConfig.mIncreaseBytes, std::uint64_t(lOpSize));
+  }
+
+  mWindow = std::clamp(lWindow, mConfig.mMinBytes, mConfig.mMaxBytes);
+  return lCongested;
+}
+
+} /* o2::DataDistribution::ucx */
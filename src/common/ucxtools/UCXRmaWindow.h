@@ -0,0 +1,89 @@
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DATADIST_UCX_RMA_WINDOW_H_
+#define DATADIST_UCX_RMA_WINDOW_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace o2::DataDistribution::ucx {
+
+////////////////////////////////////////////////////////////////////////////////
+/// UCXRmaWindow
+////////////////////////////////////////////////////////////////////////////////
+
+///
+/// Adaptive limit of RMA bytes in flight (AIMD). The window grows additively while the latency of
+/// get operations stays close to the latency of an unloaded link, and shrinks multiplicatively when
+/// operations start queuing (latency inflation), e.g. when many StfSenders send to the same node.
+///
+/// Expected latency of an operation of size S: base_latency + S / max_throughput
+/// The base latency is the minimum of the last minute (6 periods of 10 s), so that it is not learned
+/// from a permanently loaded link.
+///
+class UCXRmaWindow
+{
+ public:
+  struct Config {
+    std::uint64_t mMinBytes = (1ULL << 20);
+    std::uint64_t mMaxBytes = (64ULL << 20);
+    std::uint64_t mInitBytes = (4ULL << 20);
+    std::uint64_t mIncreaseBytes = (256ULL << 10); // at least, or the average op size
+    double mDecrease = 0.7;                        // multiplicative decrease factor
+    double mLatencyTolerance = 0.5;                // allowed latency inflation above the expected
+  };
+
+  /// Completed RMA operations of one batch (STF)
+  struct Sample {
+    std::uint64_t mBytes = 0;
+    std::uint64_t mOps = 0;
+    double mElapsedUs = 0;
+    double mMeanLatencyUs = 0;
+    double mMinLatencyUs = 0;
+  };
+
+  UCXRmaWindow() = default;
+  explicit UCXRmaWindow(const Config &pConfig) { configure(pConfig); }
+
+  void configure(const Config &pConfig);
+
+  /// Current limit of bytes in flight
+  std::uint64_t window() const { return mWindow.load(std::memory_order_relaxed); }
+
+  /// Adjust the window. Returns true when the sample shows congestion.
+  bool update(const Sample &pSample);
+
+  double baseLatencyUs() const { return mBaseLatencyUs; }
+  double maxThroughput() const { return mMaxThroughput; } // bytes per us
+
+ private:
+  Config mConfig;
+  std::atomic_uint64_t mWindow = (4ULL << 20);
+
+  std::mutex mLock;
+  static constexpr auto sBasePeriod = std::chrono::seconds(10);
+  std::array<double, 6> mBaseHistory;
+  std::size_t mBaseIdx = 0;
+  std::chrono::steady_clock::time_point mBasePeriodStart;
+  double mBaseLatencyUs = 0;
+  double mMaxThroughput = 0;
+  std::chrono::steady_clock::time_point mLastDecrease;
+};
+
+} /* o2::DataDistribution::ucx */
+
+#endif // DATADIST_UCX_RMA_WINDOW_H_
@@ -15,11 +15,22 @@
 #define DATADIST_UCX_SENDRECV_H_
 
 #include "UCXUtilities.h"
+#include "UCXProgressEngine.h"
 
 #include <ucp/api/ucp.h>
 
 #include <boost/container/small_vector.hpp>
 #include <boost/container/flat_set.hpp>
+#include <boost/container/flat_map.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace o2::DataDistribution {
 
@@ -33,6 +44,9 @@ static constexpr ucp_tag_t STRING_TAG             = 3;
 static constexpr ucp_tag_t STRING_SIZE_TAG        = 4;
 static constexpr ucp_tag_t STF_DONE_TAG           = 1'000'000'000ULL;
 
+// active message id of the control channel
+static constexpr unsigned DD_AM_CONTROL_ID        = 1;
+
 #define make_ucp_req() (reinterpret_cast<char*>(alloca(UCX_REQUEST_SIZE)) + UCX_REQUEST_SIZE)
 
 struct sync_tag_call_cookie {
@@ -45,15 +59,65 @@ struct sync_tag_call_cookie {
 
 namespace ucx::io {
 
+/// Wakes up threads waiting on completions made by the progress engine
+struct dd_ucp_signal {
+  std::mutex mLock;
+  std::condition_variable mCond;
+
+  /// call after the completion state is updated
+  void notify() {
+    std::scoped_lock lLock(mLock);
+    mCond.notify_all();
+  }
+
+  /// wait for the condition, at most pTimeoutMs. Returns the condition
+  template <typename Cond>
+  bool wait_for(const Cond &pCond, const int pTimeoutMs) {
+    std::unique_lock lLock(mLock);
+    return mCond.wait_for(lLock, std::chrono::milliseconds(pTimeoutMs), pCond);
+  }
+};
+
+/// Bytes of RMA operations in flight of all connections (node limit of the adaptive RMA concurrency)
+struct dd_ucp_inflight_budget {
+  std::atomic_uint64_t mBytes = 0;
+  std::atomic_uint64_t mLimit = std::numeric_limits<std::uint64_t>::max();
+  dd_ucp_signal mSignal;
+
+  bool available() const { return mBytes.load() < mLimit.load(); }
+};
+
 struct dd_ucp_multi_req {
   const std::uint64_t mSlotsCount = 1;
   std::atomic_uint64_t mSlotsUsed = 0;
   std::atomic_uint64_t mTotalDone = 0;
 
+  struct req_info {
+    std::uint64_t mBytes;
+    std::chrono::steady_clock::time_point mStart;
+  };
+
   std::mutex mRequestLock;
-    boost::container::small_flat_set<void*, 128> mRequests;
+    boost::container::small_flat_map<void*, req_info, 128> mRequests;
+    // completed by the progress engine before add_request()
+    boost::container::small_flat_set<void*, 8> mCompletedEarly;
 
   bool mFinished = false;
+  // an operation completed with an error (rma_get)
+  std::atomic_bool mFailed = false;
+
+  // limit of bytes in flight (in addition to slots), and the node limit
+  std::atomic_uint64_t mBytesInFlight = 0;
+  std::uint64_t mBytesLimit = std::numeric_limits<std::uint64_t>::max();
+  dd_ucp_inflight_budget *mBudget = nullptr;
+
+  // completion statistics (use with mRequestLock)
+  std::uint64_t mBytesDone = 0;
+  std::uint64_t mLatencyOps = 0;
+  double mLatencySumUs = 0;
+  double mLatencyMinUs = 0;
+
+  dd_ucp_signal mSignal;
 
   dd_ucp_multi_req() = delete;
   explicit dd_ucp_multi_req(const std::uint64_t pSlotsCount) : mSlotsCount(pSlotsCount)  { }
@@ -64,18 +128,33 @@ struct dd_ucp_multi_req {
     assert (mTotalDone.load() >= mRequests.size());
 
     std::scoped_lock lLock(mRequestLock);
-    for (const auto req_ptr : mRequests) {
-      if (req_ptr && UCS_PTR_IS_PTR(req_ptr)) {
-        ucp_request_free(req_ptr);
+    for (const auto &req : mRequests) {
+      if (req.first && UCS_PTR_IS_PTR(req.first)) {
+        ucp_request_free(req.first);
       }
     }
+    for (const auto req_ptr : mCompletedEarly) {
+      ucp_request_free(req_ptr);
+    }
+  }
+
+  /// Limit bytes in flight. At least one operation is always allowed.
+  void set_window(const std::uint64_t pBytesLimit, dd_ucp_inflight_budget *pBudget) {
+    mBytesLimit = std::max(std::uint64_t(1), pBytesLimit);
+    mBudget = pBudget;
   }
 
   inline
   bool done() const {
     if (!mFinished) {
-      // let rma progress as long as there are free slots
-      return (mSlotsUsed.load() < mSlotsCount);
+      // let rma progress as long as there are free slots and the bytes in flight are within the limits
+      const auto lSlotsUsed = mSlotsUsed.load();
+      if (lSlotsUsed >= mSlotsCount) {
+        return false;
+      } else if (lSlotsUsed == 0) {
+        return true;
+      }
+      return (mBytesInFlight.load() < mBytesLimit) && (!mBudget || mBudget->available());
     } else {
       // done when slots used is zero
       return (mSlotsUsed.load() == 0);
@@ -86,16 +165,28 @@ struct dd_ucp_multi_req {
   std::uint64_t total_done() const  { return mTotalDone.load(); }
 
   inline
-  bool add_request(void *req) {
+  bool add_request(void *req, const std::uint64_t bytes = 0) {
     if (UCS_PTR_IS_ERR(req)) {
       EDDLOG("Failed run ucp_get_nbx ucx_err={}", ucs_status_string(UCS_PTR_STATUS(req)));
+      mFailed = true;
       return false;
     }
     // operation returned request
     if (req && UCS_PTR_IS_PTR(req)) {
       std::scoped_lock lLock(mRequestLock);
-      mRequests.insert(req);
+      if (mCompletedEarly.erase(req) > 0) {
+        ucp_request_free(req);
+        mTotalDone += 1;
+        mBytesDone += bytes;
+        return true;
+      }
+
+      mRequests.emplace(req, req_info{ bytes, std::chrono::steady_clock::now() });
       mSlotsUsed += 1;
+      mBytesInFlight += bytes;
+      if (mBudget) {
+        mBudget->mBytes += bytes;
+      }
     }
     return true;
   }
@@ -104,26 +195,65 @@ struct dd_ucp_multi_req {
   bool remove_request(void *req) {
     // operation returned request
     if (req && UCS_PTR_IS_PTR(req)) {
-      ucp_request_free(req);
       std::scoped_lock lLock(mRequestLock);
-      mRequests.erase(req);
+      auto lReqIt = mRequests.find(req);
+      if (lReqIt == mRequests.end()) {
+        mCompletedEarly.insert(req); // freed in add_request()
+        return true;
+      }
+
+      const auto lInfo = lReqIt->second;
+      mRequests.erase(lReqIt);
+      ucp_request_free(req);
 
+      const double lLatencyUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - lInfo.mStart).count();
+      mLatencyMinUs = (mLatencyOps == 0) ? lLatencyUs : std::min(mLatencyMinUs, lLatencyUs);
+      mLatencySumUs += lLatencyUs;
+      mLatencyOps += 1;
+      mBytesDone += lInfo.mBytes;
+
+      mBytesInFlight -= lInfo.mBytes;
       mTotalDone += 1;
       mSlotsUsed -= 1;
+      mSignal.notify();
+
+      if (mBudget) {
+        mBudget->mBytes -= lInfo.mBytes;
+        mBudget->mSignal.notify();
+      }
     }
     return true;
   }
 
   void mark_finished() { mFinished = true; }
+  bool failed() const { return mFailed.load(); }
 };
 
 
+/// Wait until the condition is met. Workers of a progress engine are progressed by the engine thread,
+/// which signals the completions. Otherwise progress the worker, and block on the worker fd when idle.
+/// pTimeoutMs is the interval of rechecking the condition (and of waking up the engine thread).
+template <typename Cond>
 static inline
-bool ucp_wait(dd_ucp_worker &pDDCtx, dd_ucp_multi_req &pReq)
+bool ucp_wait_until(dd_ucp_worker &pDDCtx, dd_ucp_signal &pSignal, const Cond &pCond, const int pTimeoutMs = 100)
 {
+  if (pDDCtx.progress_engine.load()) {
+    while (!pCond()) {
+      // the engine was stopped, or the worker removed: completions will not be signaled
+      const auto lEngine = pDDCtx.progress_engine.load();
+      if (!lEngine || !lEngine->running()) {
+        return pCond();
+      }
+
+      lEngine->kick(pDDCtx);
+      pSignal.wait_for(pCond, pTimeoutMs);
+    }
+    return true;
+  }
+
   for (;;) {
-    // check if request is done
-    if (pReq.done()) {
+    // check the condition
+    if (pCond()) {
       return true;
     } else if (ucp_worker_progress(pDDCtx.ucp_worker)) {
       continue;
@@ -135,19 +265,29 @@ bool ucp_wait(dd_ucp_worker &pDDCtx, dd_ucp_multi_req &pReq)
     if (UCS_OK == status) {
       int epoll_ret;
       do {
-        epoll_ret = epoll_wait(pDDCtx.epoll_fd, &pDDCtx.ev, 1, 100);
+        epoll_ret = epoll_wait(pDDCtx.epoll_fd, &pDDCtx.ev, 1, pTimeoutMs);
       } while ((epoll_ret == -1) && (errno == EINTR || errno == EAGAIN));
 
       if (epoll_ret == -1) {
         EDDLOG("Failed ucp_advance epoll. errno={}", errno);
-        return pReq.done();
+        return pCond();
       }
     } else if (UCS_ERR_BUSY == status) {
-      continue; // could not arm, recheck the request
+      continue; // could not arm, recheck the condition
     }
-      // epoll returned or timeout, recheck the request
+      // epoll returned or timeout, recheck the condition
   }
-  return pReq.done();
+  return pCond();
+}
+
+static inline
+bool ucp_wait(dd_ucp_worker &pDDCtx, dd_ucp_multi_req &pReq)
+{
+  // the node limit is released by completions of other connections
+  if (pReq.mBudget) {
+    return ucp_wait_until(pDDCtx, pReq.mBudget->mSignal, [&pReq]() { return pReq.done(); }, 1) && !pReq.failed();
+  }
+  return ucp_wait_until(pDDCtx, pReq.mSignal, [&pReq]() { return pReq.done(); }) && !pReq.failed();
 }
 
 
@@ -163,6 +303,18 @@ void send_multi_cb(void *req, ucs_status_t status, void *user_data)
   }
 }
 
+static
+void get_multi_cb(void *req, ucs_status_t status, void *user_data)
+{
+  dd_ucp_multi_req *dd_req = reinterpret_cast<dd_ucp_multi_req*>(user_data);
+
+  // failed gets complete as well (e.g. endpoint of a failed rail), the waiter checks failed()
+  if (UCS_OK != status) {
+    dd_req->mFailed = true;
+  }
+  dd_req->remove_request(req);
+}
+
 static
 void recv_multi_cb(void *req, ucs_status_t status, const ucp_tag_recv_info_t *, void *user_data)
 {
@@ -249,12 +401,12 @@ bool get(ucp_ep_h ep, void *buffer, const std::size_t size, const std::uint64_t
   param.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK |
                        UCP_OP_ATTR_FIELD_DATATYPE |
                        UCP_OP_ATTR_FIELD_USER_DATA;
-  param.cb.send      = send_multi_cb;
+  param.cb.send      = get_multi_cb;
   param.datatype     = ucp_dt_make_contig(1);
   param.user_data    = dd_req;
 
   void *req = ucp_get_nbx(ep, buffer, size, rptr, rkey, &param);
-  return dd_req->add_request(req);
+  return dd_req->add_request(req, size);
 }
 
 static inline
@@ -289,6 +441,240 @@ std::optional<std::string> ucx_receive_string(dd_ucp_worker &worker)
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+/// Active message control channel
+////////////////////////////////////////////////////////////////////////////////
+
+enum dd_am_type : std::uint16_t {
+  DD_AM_STF_META = 1, // StfSender -> TfBuilder: STF metadata (serialized UCXIovStfHeader) in the payload
+  DD_AM_STF_DONE = 2  // TfBuilder -> StfSender: STF transfer finished (ack), status in the header
+};
+
+/// Fixed binary frame of the control messages, sent as the active message header
+struct dd_am_hdr {
+  static constexpr std::uint32_t sMagic = 0x4D414444; // "DDAM"
+
+  std::uint32_t mMagic = sMagic;
+  std::uint16_t mType = 0;
+  std::uint16_t mStatus = 0;    // DONE: 0 on success
+  std::uint64_t mStfId = 0;
+  std::uint64_t mSize = 0;      // payload size
+};
+static_assert(sizeof(dd_am_hdr) == 24);
+
+struct dd_ucp_am_queue;
+
+/// Received control message. The buffer is kept for the next message of the slot.
+struct dd_am_msg {
+  dd_ucp_am_queue *mQueue = nullptr;
+  dd_am_hdr mHdr;
+  std::vector<char> mData;
+  bool mReady = false;
+
+  const char* data() const { return mData.data(); }
+  std::size_t size() const { return mHdr.mSize; }
+};
+
+/// Receive ring of control messages of one worker. Slots and buffers are allocated upfront.
+/// Messages are received in the progress of the worker (own thread, or the progress engine thread).
+struct dd_ucp_am_queue {
+  ucp_worker_h mWorker = nullptr;
+  std::mutex mLock;
+  dd_ucp_signal mSignal;
+  std::vector<dd_am_msg> mSlots;
+  std::uint64_t mHead = 0;  // next message to consume
+  std::uint64_t mTail = 0;  // next slot to receive into
+  std::uint64_t mDropped = 0;
+
+  explicit dd_ucp_am_queue(const std::size_t pNumSlots = 4, const std::size_t pBufferSize = (256ULL << 10))
+    : mSlots(pNumSlots)
+  {
+    for (auto &lSlot : mSlots) {
+      lSlot.mQueue = this;
+      lSlot.mData.resize(pBufferSize);
+    }
+  }
+  dd_ucp_am_queue(const dd_ucp_am_queue&) = delete;
+  dd_ucp_am_queue& operator=(const dd_ucp_am_queue&) = delete;
+
+  bool full() const { return (mTail - mHead) == mSlots.size(); }
+
+  /// Oldest received message, or nullptr. The message is not modified until pop()
+  dd_am_msg* front() {
+    std::scoped_lock lLock(mLock);
+    if (mHead == mTail) {
+      return nullptr;
+    }
+    auto &lMsg = mSlots[mHead % mSlots.size()];
+    return lMsg.mReady ? &lMsg : nullptr;
+  }
+
+  void pop() {
+    std::scoped_lock lLock(mLock);
+    assert (mHead < mTail);
+    mSlots[mHead % mSlots.size()].mReady = false;
+    mHead++;
+  }
+
+  /// Slot for a new message of the size (called from the receive callback)
+  dd_am_msg* push(const dd_am_hdr &pHdr) {
+    std::scoped_lock lLock(mLock);
+    if (full()) {
+      return nullptr;
+    }
+    auto &lMsg = mSlots[mTail % mSlots.size()];
+    mTail++;
+
+    lMsg.mHdr = pHdr;
+    lMsg.mReady = false;
+    if (lMsg.mData.size() < pHdr.mSize) {
+      lMsg.mData.resize(pHdr.mSize);
+    }
+    return &lMsg;
+  }
+
+  /// Message data is received (called from the receive callback)
+  void set_ready(dd_am_msg &pMsg) {
+    {
+      std::scoped_lock lLock(mLock);
+      pMsg.mReady = true;
+    }
+    mSignal.notify();
+  }
+};
+
+static
+void am_recv_data_cb(void *req, ucs_status_t status, size_t, void *user_data)
+{
+  dd_am_msg *lMsg = reinterpret_cast<dd_am_msg*>(user_data);
+  if (UCS_OK != status) {
+    EDDLOG_GRL(1000, "UCX active message: failed to receive the payload. err={}", ucs_status_string(status));
+    lMsg->mHdr.mStatus = std::uint16_t(-1);
+  }
+  lMsg->mQueue->set_ready(*lMsg);
+  ucp_request_free(req);
+}
+
+static
+ucs_status_t am_recv_cb(void *arg, const void *header, size_t header_length, void *data, size_t length,
+                        const ucp_am_recv_param_t *param)
+{
+  dd_ucp_am_queue *lQueue = reinterpret_cast<dd_ucp_am_queue*>(arg);
+
+  dd_am_hdr lHdr;
+  if (header_length != sizeof(dd_am_hdr)) {
+    EDDLOG_GRL(1000, "UCX active message: invalid header size. size={}", header_length);
+    lQueue->mDropped++;
+    return UCS_OK;
+  }
+  std::memcpy(&lHdr, header, sizeof(dd_am_hdr));
+
+  if (lHdr.mMagic != dd_am_hdr::sMagic || lHdr.mSize != length) {
+    EDDLOG_GRL(1000, "UCX active message: invalid header. magic={:#x} size={} length={}", lHdr.mMagic, lHdr.mSize, length);
+    lQueue->mDropped++;
+    return UCS_OK;
+  }
+
+  dd_am_msg *lMsg = lQueue->push(lHdr);
+  if (!lMsg) {
+    EDDLOG_GRL(1000, "UCX active message: receive queue is full. type={} stf_id={}", lHdr.mType, lHdr.mStfId);
+    lQueue->mDropped++;
+    return UCS_OK;
+  }
+
+  if (length == 0) {
+    lQueue->set_ready(*lMsg);
+  } else if (param->recv_attr & UCP_AM_RECV_ATTR_FLAG_RNDV) {
+    // large payload: fetch it into the slot buffer
+    ucp_request_param_t req_param;
+    req_param.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK |
+                             UCP_OP_ATTR_FIELD_DATATYPE |
+                             UCP_OP_ATTR_FIELD_USER_DATA;
+    req_param.cb.recv_am   = am_recv_data_cb;
+    req_param.datatype     = ucp_dt_make_contig(1);
+    req_param.user_data    = lMsg;
+
+    void *req = ucp_am_recv_data_nbx(lQueue->mWorker, data, lMsg->mData.data(), length, &req_param);
+    if (req == NULL) {
+      lQueue->set_ready(*lMsg);
+    } else if (UCS_PTR_IS_ERR(req)) {
+      EDDLOG_GRL(1000, "UCX active message: failed to receive the payload. err={}", ucs_status_string(UCS_PTR_STATUS(req)));
+      lMsg->mHdr.mStatus = std::uint16_t(-1);
+      lQueue->set_ready(*lMsg);
+    }
+  } else {
+    // eager payload: data is only valid during the callback
+    std::memcpy(lMsg->mData.data(), data, length);
+    lQueue->set_ready(*lMsg);
+  }
+
+  return UCS_OK;
+}
+
+/// Register the control channel receive handler. The queue must outlive the worker.
+static inline
+bool am_register_handler(dd_ucp_worker &worker, dd_ucp_am_queue &queue)
+{
+  queue.mWorker = worker.ucp_worker;
+
+  ucp_am_handler_param_t param;
+  param.field_mask = UCP_AM_HANDLER_PARAM_FIELD_ID |
+                     UCP_AM_HANDLER_PARAM_FIELD_FLAGS |
+                     UCP_AM_HANDLER_PARAM_FIELD_CB |
+                     UCP_AM_HANDLER_PARAM_FIELD_ARG;
+  param.id         = impl::DD_AM_CONTROL_ID;
+  param.flags      = UCP_AM_FLAG_WHOLE_MSG;
+  param.cb         = am_recv_cb;
+  param.arg        = &queue;
+
+  const auto status = ucp_worker_set_am_recv_handler(worker.ucp_worker, &param);
+  if (status != UCS_OK) {
+    EDDLOG("Failed to register the active message handler. err={}", ucs_status_string(status));
+    return false;
+  }
+  return true;
+}
+
+/// Send a control message. Header and payload are not copied, the call blocks until completion.
+static inline
+bool am_send_blocking(dd_ucp_worker &worker, ucp_ep_h ep, dd_am_hdr &hdr, const void *data = nullptr, const std::size_t size = 0)
+{
+  ucp_request_param_t param;
+  dd_ucp_multi_req dd_request(1);
+
+  hdr.mSize = size;
+
+  param.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK |
+                       UCP_OP_ATTR_FIELD_DATATYPE |
+                       UCP_OP_ATTR_FIELD_USER_DATA;
+  param.cb.send      = send_multi_cb;
+  param.datatype     = ucp_dt_make_contig(1);
+  param.user_data    = &dd_request;
+
+  void *ucp_request = ucp_am_send_nbx(ep, impl::DD_AM_CONTROL_ID, &hdr, sizeof(dd_am_hdr), data, size, &param);
+  if (ucp_request == NULL) {
+    return true;
+  }
+
+  if (UCS_PTR_IS_ERR(ucp_request)) {
+    EDDLOG("Failed am_send_blocking. type={} stf_id={} err={}", hdr.mType, hdr.mStfId, ucs_status_string(UCS_PTR_STATUS(ucp_request)));
+    return false;
+  }
+
+  dd_request.add_request(ucp_request);
+  dd_request.mark_finished();
+  return ucp_wait(worker, dd_request);
+}
+
+/// Wait for the next control message. The message is valid until queue.pop()
+static inline
+dd_am_msg* am_receive_blocking(dd_ucp_worker &worker, dd_ucp_am_queue &queue)
+{
+  ucp_wait_until(worker, queue.mSignal, [&queue]() { return queue.front() != nullptr; });
+  return queue.front();
+}
+
+
 } /* ucx::io */
 
 
@@ -23,6 +23,7 @@
 
 #include <sys/epoll.h>
 
+#include <atomic>
 #include <string>
 #include <cstring>
 
@@ -30,6 +31,8 @@ namespace o2::DataDistribution {
 
 namespace ucx {
 
+class UCXProgressEngine;
+
 struct dd_ucp_worker {
   ucp_worker_h ucp_worker;
 
@@ -37,6 +40,11 @@ struct dd_ucp_worker {
 
   int epoll_fd;
   struct epoll_event ev;
+
+  // set when the worker is progressed by a progress engine thread. Cleared by the engine when the worker is
+  // removed, while other threads wait on the worker.
+  std::atomic<UCXProgressEngine*> progress_engine = nullptr;
+  unsigned progress_thread = 0;
 };
 
 }
@@ -229,8 +237,9 @@ bool flush_ep_blocking(ucp_worker_h worker, ucp_ep_h ep)
   return true;
 }
 
+// close the endpoint, keep the worker (e.g. other rails of the connection)
 static inline
-void close_connection(dd_ucp_worker &worker, ucp_ep_h ep)
+void close_ep(dd_ucp_worker &worker, ucp_ep_h ep)
 {
   ucp_request_param_t param;
   param.op_attr_mask = UCP_OP_ATTR_FIELD_FLAGS;
@@ -246,7 +255,12 @@ void close_connection(dd_ucp_worker &worker, ucp_ep_h ep)
 
     ucp_request_free(close_req);
   }
+}
 
+static inline
+void close_connection(dd_ucp_worker &worker, ucp_ep_h ep)
+{
+  close_ep(worker, ep);
   ucp_worker_destroy(worker.ucp_worker);
 }
 
@@ -0,0 +1,135 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "CruRateControl"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "CruRateControl.h"
+
+using namespace o2::DataDistribution;
+using namespace std::chrono_literals;
+
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_CASE(ParseStepFactorsTest)
+{
+  const auto lFactors = CruRateConfig::parseStepFactors("1, 0.5,,2");
+  BOOST_REQUIRE(lFactors.size() == 3);
+  BOOST_CHECK(lFactors[0] == 1.0);
+  BOOST_CHECK(lFactors[1] == 0.5);
+  BOOST_CHECK(lFactors[2] == 2.0);
+
+  BOOST_CHECK_THROW(CruRateConfig::parseStepFactors(""), std::invalid_argument);
+  BOOST_CHECK_THROW(CruRateConfig::parseStepFactors("0,0"), std::invalid_argument);
+  BOOST_CHECK_THROW(CruRateConfig::parseStepFactors("1,-1"), std::out_of_range);
+  BOOST_CHECK_THROW(CruRateConfig::parseStepFactors("1,abc"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(RateProfileTest)
+{
+  for (const auto lProfile : { CruRateConfig::eStable, CruRateConfig::eBursty, CruRateConfig::eStepped }) {
+    std::istringstream lIn(to_string(lProfile));
+    CruRateConfig::RateProfile lParsed;
+    BOOST_REQUIRE(lIn >> lParsed);
+    BOOST_CHECK(lParsed == lProfile);
+  }
+
+  std::istringstream lIn("constant");
+  CruRateConfig::RateProfile lParsed;
+  BOOST_CHECK(!(lIn >> lParsed));
+}
+
+BOOST_AUTO_TEST_CASE(InvalidConfigTest)
+{
+  CruRateConfig lConfig;
+  lConfig.mStfRate = 0.0;
+  BOOST_CHECK_THROW(CruLinkRateControl{lConfig}, std::invalid_argument);
+
+  lConfig = CruRateConfig();
+  lConfig.mProfile = CruRateConfig::eBursty;
+  lConfig.mBurstDuty = 0.0;
+  BOOST_CHECK_THROW(CruLinkRateControl{lConfig}, std::invalid_argument);
+
+  lConfig = CruRateConfig();
+  lConfig.mProfile = CruRateConfig::eStepped;
+  lConfig.mStepFactors = { 0.0 };
+  BOOST_CHECK_THROW(CruLinkRateControl{lConfig}, std::invalid_argument);
+}
+
+// token bucket: a stalled producer gets at most the bucket depth back-to-back, the rest is dropped
+BOOST_AUTO_TEST_CASE(TokenBucketTest)
+{
+  CruRateConfig lConfig;
+  lConfig.mStfRate = 1000.0;
+  lConfig.mBucketDepth = 4.0;
+
+  CruLinkRateControl lRateControl(lConfig);
+  std::this_thread::sleep_for(50ms);
+
+  BOOST_CHECK(lRateControl.waitForStfs() == 4);
+  BOOST_CHECK(lRateControl.numDropped() >= 45);
+  BOOST_CHECK(lRateControl.numIssued() == lRateControl.numDropped() + 4);
+}
+
+// issued STFs follow the integral of the rate, independent of the wakeup lateness
+BOOST_AUTO_TEST_CASE(StableRateTest)
+{
+  CruRateConfig lConfig;
+  lConfig.mStfRate = 2000.0;
+  lConfig.mBucketDepth = 1e6;
+
+  const auto lStart = std::chrono::steady_clock::now();
+  CruLinkRateControl lRateControl(lConfig);
+
+  std::uint64_t lProduced = 0;
+  while (std::chrono::steady_clock::now() - lStart < 200ms) {
+    lProduced += lRateControl.waitForStfs();
+  }
+  const double lElapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStart).count();
+
+  BOOST_CHECK(lRateControl.numDropped() == 0);
+  BOOST_CHECK(lProduced == lRateControl.numIssued());
+  BOOST_CHECK(double(lProduced) <= lConfig.mStfRate * lElapsedS + 1.0);
+  BOOST_CHECK(double(lProduced) >= lConfig.mStfRate * 0.2 - 1.0);
+}
+
+// bursty: the rate of the full period is produced in the first mBurstDuty fraction of the period
+BOOST_AUTO_TEST_CASE(BurstyRateTest)
+{
+  CruRateConfig lConfig;
+  lConfig.mProfile = CruRateConfig::eBursty;
+  lConfig.mStfRate = 1000.0;
+  lConfig.mBucketDepth = 1e6;
+  lConfig.mPeriod = 200ms;
+  lConfig.mBurstDuty = 0.5;
+
+  const auto lStart = std::chrono::steady_clock::now();
+  CruLinkRateControl lRateControl(lConfig);
+  std::this_thread::sleep_for(100ms);
+
+  // all STFs of the period are due at the end of the burst
+  const auto lBurst = lRateControl.waitForStfs();
+  BOOST_CHECK(lBurst >= 199 && lBurst <= 200);
+
+  // nothing is produced in the idle phase: the next STF is due in the next period
+  std::uint64_t lNext = 0;
+  while (lNext == 0) {
+    lNext = lRateControl.waitForStfs();
+  }
+  BOOST_CHECK(std::chrono::steady_clock::now() - lStart >= 199ms);
+  BOOST_CHECK(lRateControl.numDropped() == 0);
+}
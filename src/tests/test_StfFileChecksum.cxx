@@ -0,0 +1,154 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "StfFileChecksum"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "SubTimeFrameFile.h"
+#include "SubTimeFrameFileChecksum.h"
+#include "SubTimeFrameFileReader.h"
+
+using namespace o2::DataDistribution;
+using namespace o2::header;
+namespace bfs = boost::filesystem;
+
+namespace {
+
+template <typename T>
+void append(std::string &pBuf, const T &pVal)
+{
+  pBuf.append(reinterpret_cast<const char*>(&pVal), sizeof(T));
+}
+
+/// TF of version 4 with one data block: <meta, order> <index> <DataHeader, payload>
+std::string makeStf(const std::uint64_t pStfId, const std::string &pPayload)
+{
+  DataHeader lBlockHdr(gDataDescriptionRawData, gDataOriginTPC, 0, pPayload.size());
+  lBlockHdr.payloadSerializationMethod = gSerializationMethodNone;
+  lBlockHdr.tfCounter = pStfId;
+
+  std::string lData;
+  append(lData, lBlockHdr);
+  lData.append(pPayload);
+
+  SubTimeFrameFileDataIndex lIndex;
+  lIndex.AddStfElement(EquipmentIdentifier(gDataDescriptionRawData, gDataOriginTPC, 0), 1, 0, lData.size(), lData.size());
+  lIndex.elements().back().mChecksumType = eStfFileChecksumCrc32c;
+  lIndex.elements().back().mChecksum = crc32c(0, lData.data(), lData.size());
+
+  const std::uint64_t lStfSize = SubTimeFrameFileMeta::getSizeInFile() + lIndex.getSizeInFile() + lData.size();
+
+  std::string lStf;
+  auto lMetaHdr = SubTimeFrameFileMeta::getDataHeader();
+  lMetaHdr.flagsNextHeader = 1;
+  append(lStf, lMetaHdr);
+  append(lStf, SubTimeFrameFileStfOrder(pStfId, {}));
+  append(lStf, SubTimeFrameFileMeta(lStfSize));
+  append(lStf, lIndex.getDataHeader());
+  lStf.append(reinterpret_cast<const char*>(lIndex.elements().data()),
+    lIndex.elements().size() * sizeof(SubTimeFrameFileDataIndex::DataIndexElem));
+  lStf.append(lData);
+
+  BOOST_REQUIRE(lStf.size() == lStfSize);
+  return lStf;
+}
+
+std::vector<std::uint64_t> readStfIds(bfs::path &pFile, const bool pVerify, std::uint64_t &pErrors)
+{
+  SubTimeFrameFileReader lReader(pFile);
+  lReader.setVerifyChecksums(pVerify);
+
+  std::vector<std::uint64_t> lIds;
+  SubTimeFrameFileReader::StfHeaders lHdrs;
+  while (lReader.readHeaders(lHdrs)) {
+    lIds.push_back(lHdrs.mOrder.mStfId);
+  }
+
+  pErrors = lReader.checksumErrors();
+  return lIds;
+}
+
+} /* namespace */
+
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_CASE(Crc32cVectorTest)
+{
+  const std::string lCheck = "123456789";
+  BOOST_CHECK(crc32c(0, lCheck.data(), lCheck.size()) == 0xE3069283);
+  BOOST_CHECK(crc32c(0, lCheck.data(), 0) == 0);
+
+  // 32 bytes of zeros and ones (RFC 3720, B.4)
+  const std::string lZeros(32, '\x00');
+  const std::string lOnes(32, '\xFF');
+  BOOST_CHECK(crc32c(0, lZeros.data(), lZeros.size()) == 0x8A9136AA);
+  BOOST_CHECK(crc32c(0, lOnes.data(), lOnes.size()) == 0x62A8AB43);
+}
+
+BOOST_AUTO_TEST_CASE(Crc32cIncrementalTest)
+{
+  std::string lData;
+  for (unsigned i = 0; i < 1000; i++) {
+    lData.push_back(char(i * 31 + 7));
+  }
+  const std::uint32_t lFull = crc32c(0, lData.data(), lData.size());
+
+  // any split, including unaligned chunks shorter than a word
+  for (std::size_t lSplit : { 0, 1, 3, 8, 13, 500, 999, 1000 }) {
+    const std::uint32_t lFirst = crc32c(0, lData.data(), lSplit);
+    BOOST_CHECK(crc32c(lFirst, lData.data() + lSplit, lData.size() - lSplit) == lFull);
+  }
+
+  std::uint32_t lBytewise = 0;
+  for (const char lByte : lData) {
+    lBytewise = crc32c(lBytewise, &lByte, 1);
+  }
+  BOOST_CHECK(lBytewise == lFull);
+}
+
+BOOST_AUTO_TEST_CASE(CorruptedStfTest)
+{
+  auto lFileName = bfs::temp_directory_path() / bfs::unique_path("test_stf_checksum_%%%%-%%%%.tf");
+
+  const std::string lStf1 = makeStf(1, std::string(256, 'a'));
+  std::string lStf2 = makeStf(2, std::string(256, 'b'));
+  const std::string lStf3 = makeStf(3, std::string(256, 'c'));
+
+  // flip a bit in the payload of the second TF
+  lStf2[lStf2.size() - 100] ^= 0x01;
+
+  {
+    std::ofstream lFile(lFileName.string(), std::ios::binary | std::ios::trunc);
+    lFile << lStf1 << lStf2 << lStf3;
+    BOOST_REQUIRE(lFile.good());
+  }
+
+  std::uint64_t lErrors = 0;
+
+  // without the verification all TFs are read
+  const auto lAllIds = readStfIds(lFileName, false, lErrors);
+  BOOST_CHECK(lAllIds == std::vector<std::uint64_t>({ 1, 2, 3 }));
+  BOOST_CHECK(lErrors == 0);
+
+  // the corrupted TF is skipped and counted
+  const auto lValidIds = readStfIds(lFileName, true, lErrors);
+  BOOST_CHECK(lValidIds == std::vector<std::uint64_t>({ 1, 3 }));
+  BOOST_CHECK(lErrors == 1);
+
+  bfs::remove(lFileName);
+}
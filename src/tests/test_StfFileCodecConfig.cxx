@@ -0,0 +1,74 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "StfFileCodecConfig"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+#include "SubTimeFrameFileCodec.h"
+
+using namespace o2::DataDistribution;
+using o2::header::DataOrigin;
+
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_CASE(EmptySpecTest)
+{
+  const auto lConfig = StfFileCodecConfig::parse("");
+  BOOST_CHECK(lConfig.mDefaultCodec == eStfFileCodecNone);
+  BOOST_CHECK(lConfig.mOriginCodecs.empty());
+  BOOST_CHECK(lConfig.mLevel == 1);
+  BOOST_CHECK(!lConfig.enabled());
+}
+
+BOOST_AUTO_TEST_CASE(ValidSpecTest)
+{
+  const auto lConfig = StfFileCodecConfig::parse(" tpc : zstd, ITS:lz4,,*:none ", 19);
+  BOOST_CHECK(lConfig.mLevel == 19);
+  BOOST_CHECK(lConfig.mDefaultCodec == eStfFileCodecNone);
+  BOOST_REQUIRE(lConfig.mOriginCodecs.size() == 2);
+  BOOST_CHECK(lConfig.codecFor(DataOrigin("TPC")) == eStfFileCodecZstd);
+  BOOST_CHECK(lConfig.codecFor(DataOrigin("ITS")) == eStfFileCodecLz4);
+  BOOST_CHECK(lConfig.codecFor(DataOrigin("TOF")) == eStfFileCodecNone);
+  BOOST_CHECK(lConfig.enabled());
+
+  // the last setting of an origin wins
+  const auto lDefault = StfFileCodecConfig::parse("*:lz4,*:zstd");
+  BOOST_CHECK(lDefault.mDefaultCodec == eStfFileCodecZstd);
+  BOOST_CHECK(lDefault.codecFor(DataOrigin("TPC")) == eStfFileCodecZstd);
+
+  // round trip through the string representation
+  const auto lReparsed = StfFileCodecConfig::parse(lConfig.to_string());
+  BOOST_CHECK(lReparsed.mDefaultCodec == lConfig.mDefaultCodec);
+  BOOST_CHECK(lReparsed.mOriginCodecs == lConfig.mOriginCodecs);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidCodecTest)
+{
+  BOOST_CHECK_THROW(StfFileCodecConfig::parse("TPC"), std::invalid_argument);
+  BOOST_CHECK_THROW(StfFileCodecConfig::parse("TPC:gzip"), std::invalid_argument);
+  BOOST_CHECK_THROW(StfFileCodecConfig::parse("TPC:"), std::invalid_argument);
+  BOOST_CHECK_THROW(StfFileCodecConfig::parse(":zstd"), std::invalid_argument);
+  BOOST_CHECK_THROW(StfFileCodecConfig::parse("TPCX:zstd"), std::invalid_argument);
+  BOOST_CHECK_THROW(StfFileCodecConfig::parse("TPC:zstd,ITS"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(LevelTest)
+{
+  BOOST_CHECK(StfFileCodecConfig::parse("*:zstd", StfFileCodecConfig::sMinLevel).mLevel == StfFileCodecConfig::sMinLevel);
+  BOOST_CHECK(StfFileCodecConfig::parse("*:zstd", StfFileCodecConfig::sMaxLevel).mLevel == StfFileCodecConfig::sMaxLevel);
+
+  BOOST_CHECK_THROW(StfFileCodecConfig::parse("*:zstd", 0), std::out_of_range);
+  BOOST_CHECK_THROW(StfFileCodecConfig::parse("*:zstd", -1), std::out_of_range);
+  BOOST_CHECK_THROW(StfFileCodecConfig::parse("*:zstd", StfFileCodecConfig::sMaxLevel + 1), std::out_of_range);
+}
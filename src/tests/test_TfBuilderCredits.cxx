@@ -0,0 +1,142 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "TfBuilderCredits"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include "TfBuilderCredits.h"
+
+using namespace o2::DataDistribution;
+using namespace std::chrono_literals;
+
+//____________________________________________________________________________//
+
+// credits are granted within the free memory, and returned when the transfer is done
+BOOST_AUTO_TEST_CASE(GrantReturnTest)
+{
+  std::uint64_t lFreeMem = 1000;
+  TfBuilderCredits lCredits([&]() { return lFreeMem; });
+
+  BOOST_CHECK(lCredits.try_acquire("sender0", 1, 600));
+  BOOST_CHECK(lCredits.try_acquire("sender1", 1, 400));
+  BOOST_CHECK(!lCredits.try_acquire("sender2", 1, 1));
+  BOOST_CHECK(lCredits.bytesInFlight() == 1000);
+  BOOST_CHECK(lCredits.transfersInFlight() == 2);
+  BOOST_CHECK(lCredits.numDenied() == 1);
+
+  // granting the same transfer again does not take more credit
+  BOOST_CHECK(lCredits.try_acquire("sender0", 1, 600));
+  BOOST_CHECK(lCredits.bytesInFlight() == 1000);
+
+  const auto lGeneration = lCredits.generation();
+  lCredits.release("sender0", 1);
+  BOOST_CHECK(lCredits.generation() != lGeneration);
+  BOOST_CHECK(lCredits.bytesInFlight() == 400);
+  BOOST_CHECK(lCredits.try_acquire("sender2", 1, 600));
+
+  // unknown transfers are ignored
+  lCredits.release("sender0", 1);
+  lCredits.release("sender3", 1);
+  BOOST_CHECK(lCredits.bytesInFlight() == 1000);
+
+  lCredits.release("sender1", 1);
+  lCredits.release("sender2", 1);
+  BOOST_CHECK(lCredits.bytesInFlight() == 0);
+  BOOST_CHECK(lCredits.transfersInFlight() == 0);
+}
+
+// a transfer is granted when nothing is in flight, even above the limits
+BOOST_AUTO_TEST_CASE(LargeStfTest)
+{
+  TfBuilderCredits lCredits([]() { return std::uint64_t(100); });
+  lCredits.configure({ 50, 10, 100 });
+
+  BOOST_CHECK(lCredits.try_acquire("sender0", 1, 1000));
+  BOOST_CHECK(!lCredits.try_acquire("sender1", 1, 1));
+  lCredits.release("sender0", 1);
+  BOOST_CHECK(lCredits.try_acquire("sender1", 1, 1000));
+}
+
+BOOST_AUTO_TEST_CASE(LimitsTest)
+{
+  TfBuilderCredits lCredits([]() { return std::uint64_t(1000); });
+
+  // node limit below the free memory
+  lCredits.configure({ 500, 0, 100 });
+  BOOST_CHECK(lCredits.try_acquire("sender0", 1, 300));
+  BOOST_CHECK(!lCredits.try_acquire("sender1", 1, 300));
+  BOOST_CHECK(lCredits.try_acquire("sender1", 1, 200));
+  lCredits.reset();
+  BOOST_CHECK(lCredits.bytesInFlight() == 0);
+  BOOST_CHECK(lCredits.numDenied() == 0);
+
+  // per StfSender limit: the first transfer of every StfSender is granted
+  lCredits.configure({ 0, 100, 100 });
+  BOOST_CHECK(lCredits.try_acquire("sender0", 1, 80));
+  BOOST_CHECK(!lCredits.try_acquire("sender0", 2, 80));
+  BOOST_CHECK(lCredits.try_acquire("sender0", 2, 20));
+  BOOST_CHECK(lCredits.try_acquire("sender1", 1, 150));
+  BOOST_CHECK(lCredits.numDenied() == 1);
+  lCredits.reset();
+
+  // number of transfers
+  lCredits.configure({ 0, 0, 2 });
+  BOOST_CHECK(lCredits.try_acquire("sender0", 1, 1));
+  BOOST_CHECK(lCredits.try_acquire("sender0", 2, 1));
+  BOOST_CHECK(!lCredits.try_acquire("sender0", 3, 1));
+  lCredits.release("sender0", 1);
+  BOOST_CHECK(lCredits.try_acquire("sender0", 3, 1));
+}
+
+// the size reported by the StfSender replaces the estimate
+BOOST_AUTO_TEST_CASE(UpdateTest)
+{
+  TfBuilderCredits lCredits([]() { return std::uint64_t(1000); });
+  lCredits.configure({ 0, 500, 100 });
+
+  BOOST_CHECK(lCredits.try_acquire("sender0", 1, 100));
+  lCredits.update("sender0", 1, 450);
+  BOOST_CHECK(lCredits.bytesInFlight() == 450);
+  BOOST_CHECK(!lCredits.try_acquire("sender0", 2, 100));
+  lCredits.update("sender0", 1, 50);
+  BOOST_CHECK(lCredits.try_acquire("sender0", 2, 100));
+  BOOST_CHECK(lCredits.bytesInFlight() == 150);
+
+  lCredits.release("sender0", 1);
+  lCredits.release("sender0", 2);
+  BOOST_CHECK(lCredits.bytesInFlight() == 0);
+}
+
+// waiting threads are woken up by returned credits
+BOOST_AUTO_TEST_CASE(WaitTest)
+{
+  TfBuilderCredits lCredits([]() { return std::uint64_t(100); });
+  BOOST_CHECK(lCredits.try_acquire("sender0", 1, 100));
+
+  const auto lGeneration = lCredits.generation();
+  BOOST_CHECK(!lCredits.try_acquire("sender1", 1, 100));
+
+  std::thread lReleaseThread([&]() {
+    std::this_thread::sleep_for(20ms);
+    lCredits.release("sender0", 1);
+  });
+
+  const auto lStart = std::chrono::steady_clock::now();
+  lCredits.wait_for(lGeneration, 10s);
+  BOOST_CHECK(std::chrono::steady_clock::now() - lStart < 5s);
+  BOOST_CHECK(lCredits.try_acquire("sender1", 1, 100));
+
+  lReleaseThread.join();
+}
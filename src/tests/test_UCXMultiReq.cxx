@@ -0,0 +1,67 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "UCXMultiReq"
+
+#include <boost/test/unit_test.hpp>
+
+#include "UCXSendRecv.h"
+
+using namespace o2::DataDistribution::ucx::io;
+
+//____________________________________________________________________________//
+
+// rma operations are issued while a slot is free
+BOOST_AUTO_TEST_CASE(SlotsTest)
+{
+  dd_ucp_multi_req lReq(4);
+  BOOST_CHECK(lReq.done());
+
+  lReq.mSlotsUsed = 3;
+  BOOST_CHECK(lReq.done());
+  lReq.mSlotsUsed = 4;
+  BOOST_CHECK(!lReq.done());
+
+  // finished: done when all operations completed
+  lReq.mark_finished();
+  lReq.mSlotsUsed = 1;
+  BOOST_CHECK(!lReq.done());
+  lReq.mSlotsUsed = 0;
+  BOOST_CHECK(lReq.done());
+}
+
+// bytes in flight of the connection (window), and of the node (budget)
+BOOST_AUTO_TEST_CASE(WindowTest)
+{
+  dd_ucp_inflight_budget lBudget;
+  dd_ucp_multi_req lReq(16);
+  lReq.set_window(1 << 20, &lBudget);
+
+  lReq.mSlotsUsed = 2;
+  lReq.mBytesInFlight = (1 << 20) - 1;
+  BOOST_CHECK(lReq.done());
+  lReq.mBytesInFlight = (1 << 20);
+  BOOST_CHECK(!lReq.done());
+
+  // at least one operation is always allowed
+  lReq.mSlotsUsed = 0;
+  BOOST_CHECK(lReq.done());
+
+  lReq.mSlotsUsed = 1;
+  lReq.mBytesInFlight = 0;
+  lBudget.mLimit = (4 << 20);
+  lBudget.mBytes = (4 << 20);
+  BOOST_CHECK(!lReq.done());
+  lBudget.mBytes = (4 << 20) - 1;
+  BOOST_CHECK(lReq.done());
+
+  lReq.mSlotsUsed = 0;
+}
@@ -0,0 +1,141 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "UCXRailStriper"
+
+#include <boost/test/unit_test.hpp>
+
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+#include "UCXRails.h"
+
+using namespace o2::DataDistribution::ucx;
+
+using Chunk = std::tuple<std::size_t, std::uint64_t, std::uint64_t>; // rail, offset, len
+
+static constexpr std::uint64_t sKiB = (1ULL << 10);
+
+static std::uint64_t sumBytes(const UCXRailStriper &pStriper)
+{
+  return std::accumulate(pStriper.railBytes().cbegin(), pStriper.railBytes().cend(), std::uint64_t(0));
+}
+
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_CASE(ParseRailIpsTest)
+{
+  const auto lIps = parse_rail_ips(" 10.0.0.1, 10.0.1.1 ,,10.0.0.1 10.0.2.1");
+  BOOST_REQUIRE(lIps.size() == 3);
+  BOOST_CHECK(lIps[0] == "10.0.0.1");
+  BOOST_CHECK(lIps[1] == "10.0.1.1");
+  BOOST_CHECK(lIps[2] == "10.0.2.1");
+
+  BOOST_CHECK(parse_rail_ips("").empty());
+  BOOST_CHECK(parse_rail_ips(" , ").empty());
+}
+
+// one rail: transfers are not split
+BOOST_AUTO_TEST_CASE(SingleRailTest)
+{
+  UCXRailStriper lStriper(64 * sKiB);
+  lStriper.reset(1);
+
+  std::vector<Chunk> lChunks;
+  BOOST_CHECK(lStriper.stripe(1000 * sKiB, [&](auto pRail, auto pOff, auto pLen) { lChunks.emplace_back(pRail, pOff, pLen); return true; }));
+  BOOST_REQUIRE(lChunks.size() == 1);
+  BOOST_CHECK(lChunks[0] == Chunk(0, 0, 1000 * sKiB));
+  BOOST_CHECK(lStriper.railBytes()[0] == 1000 * sKiB);
+}
+
+// chunks of similar size, at most the stripe size, covering the transfer
+BOOST_AUTO_TEST_CASE(SplitTest)
+{
+  UCXRailStriper lStriper(64 * sKiB);
+  BOOST_CHECK(UCXRailStriper(1).stripeSize() == 4096);
+
+  lStriper.reset(2);
+  std::vector<Chunk> lChunks;
+  const auto lCollect = [&](auto pRail, auto pOff, auto pLen) { lChunks.emplace_back(pRail, pOff, pLen); return true; };
+
+  // 3 chunks: 43691 + 43691 + 43690
+  BOOST_CHECK(lStriper.stripe(128 * sKiB + 10, lCollect));
+  BOOST_REQUIRE(lChunks.size() == 3);
+
+  std::uint64_t lOff = 0;
+  for (const auto &[lRail, lChunkOff, lLen] : lChunks) {
+    BOOST_CHECK(lChunkOff == lOff);
+    BOOST_CHECK(lLen <= 64 * sKiB);
+    BOOST_CHECK(lLen >= 43690);
+    lOff += lLen;
+  }
+  BOOST_CHECK(lOff == 128 * sKiB + 10);
+  BOOST_CHECK(std::get<0>(lChunks[0]) == 0);
+  BOOST_CHECK(std::get<0>(lChunks[1]) == 1);
+  BOOST_CHECK(std::get<0>(lChunks[2]) == 0);
+
+  // small transfers are not split, they go to the least loaded rail
+  lChunks.clear();
+  BOOST_CHECK(lStriper.stripe(1000, lCollect));
+  BOOST_REQUIRE(lChunks.size() == 1);
+  BOOST_CHECK(lChunks[0] == Chunk(1, 0, 1000));
+  BOOST_CHECK(sumBytes(lStriper) == 128 * sKiB + 1010);
+
+  // stops on the first failed chunk
+  lChunks.clear();
+  BOOST_CHECK(!lStriper.stripe(256 * sKiB, [&](auto pRail, auto pOff, auto pLen) { lChunks.emplace_back(pRail, pOff, pLen); return false; }));
+  BOOST_CHECK(lChunks.size() == 1);
+}
+
+// the rails are balanced over many transfers
+BOOST_AUTO_TEST_CASE(BalanceTest)
+{
+  UCXRailStriper lStriper(64 * sKiB);
+  lStriper.reset(4);
+
+  for (std::uint64_t i = 1; i <= 1000; i++) {
+    lStriper.stripe((i * 7919) % (256 * sKiB) + 1, [](auto, auto, auto) { return true; });
+  }
+
+  const auto &lBytes = lStriper.railBytes();
+  const auto [lMin, lMax] = std::minmax_element(lBytes.cbegin(), lBytes.cend());
+  BOOST_CHECK((*lMax - *lMin) <= 64 * sKiB);
+}
+
+// chunks of rails that cannot be used (e.g. without the region) go to the usable rails, and are accounted there
+BOOST_AUTO_TEST_CASE(FailedRailTest)
+{
+  UCXRailStriper lStriper(64 * sKiB);
+  lStriper.reset(3);
+
+  std::vector<std::uint64_t> lRailBytes(3, 0);
+  const auto lCount = [&](auto pRail, auto, auto pLen) { lRailBytes[pRail] += pLen; return true; };
+
+  // rail 1 failed
+  BOOST_CHECK(lStriper.stripe(1024 * sKiB, [](const std::size_t pRail) { return pRail != 1; }, lCount));
+  BOOST_CHECK(lRailBytes[0] == 512 * sKiB);
+  BOOST_CHECK(lRailBytes[1] == 0);
+  BOOST_CHECK(lRailBytes[2] == 512 * sKiB);
+  BOOST_CHECK(lStriper.railBytes() == lRailBytes);
+
+  // no usable rail: everything on rail 0
+  BOOST_CHECK(lStriper.stripe(1024 * sKiB, [](const std::size_t) { return false; }, lCount));
+  BOOST_CHECK(lRailBytes[0] == 1536 * sKiB);
+  BOOST_CHECK(lRailBytes[2] == 512 * sKiB);
+  BOOST_CHECK(lStriper.railBytes() == lRailBytes);
+
+  // the least loaded rails get the next transfer
+  BOOST_CHECK(lStriper.stripe(2048 * sKiB, lCount));
+  BOOST_CHECK(lRailBytes[0] == 1536 * sKiB);
+  BOOST_CHECK(lStriper.railBytes() == lRailBytes);
+  BOOST_CHECK(sumBytes(lStriper) == 4096 * sKiB);
+}
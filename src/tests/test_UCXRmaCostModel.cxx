@@ -0,0 +1,104 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "UCXRmaCostModel"
+
+#include <boost/test/unit_test.hpp>
+
+#include "UCXRmaCostModel.h"
+
+using namespace o2::DataDistribution::ucx;
+
+// latency floor of 10us up to 4KiB, then 1us per KiB (exact in binary floating point)
+static const char *sModel = "4096:10, 1052672:1034";
+
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_CASE(ParseTest)
+{
+  UCXRmaCostModel lModel;
+  BOOST_CHECK(!lModel.valid());
+
+  // points are sorted, duplicate sizes are removed
+  BOOST_REQUIRE(lModel.parse("65536:70,4096:10,,65536:80, 1052672:1034"));
+  BOOST_REQUIRE(lModel.valid());
+  BOOST_REQUIRE(lModel.points().size() == 3);
+  BOOST_CHECK(lModel.points()[0].mSize == 4096);
+  BOOST_CHECK(lModel.points()[1].mSize == 65536);
+  BOOST_CHECK(lModel.points()[2].mSize == 1052672);
+
+  // round trip through the text format
+  UCXRmaCostModel lCopy;
+  BOOST_REQUIRE(lCopy.parse(lModel.to_string()));
+  BOOST_REQUIRE(lCopy.points().size() == lModel.points().size());
+  for (std::size_t i = 0; i < lCopy.points().size(); i++) {
+    BOOST_CHECK(lCopy.points()[i].mSize == lModel.points()[i].mSize);
+    BOOST_CHECK(lCopy.points()[i].mTimeUs == lModel.points()[i].mTimeUs);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(InvalidParseTest)
+{
+  UCXRmaCostModel lModel;
+  BOOST_REQUIRE(lModel.parse(sModel));
+
+  for (const auto lInvalid : { "", "4096:10", "4096:10,4096:20", "4096", "4096:10,abc:20",
+                               "4096:10,8192:x", "4096:10,8192:-1" }) {
+    BOOST_CHECK_MESSAGE(!lModel.parse(lInvalid), lInvalid);
+  }
+
+  // the model is not changed on error
+  BOOST_REQUIRE(lModel.points().size() == 2);
+  BOOST_CHECK(lModel.points()[0].mSize == 4096);
+  BOOST_CHECK(lModel.points()[1].mSize == 1052672);
+}
+
+BOOST_AUTO_TEST_CASE(CostTest)
+{
+  UCXRmaCostModel lModel;
+  BOOST_CHECK(lModel.cost(4096) == 0.0);
+
+  BOOST_REQUIRE(lModel.parse(sModel));
+
+  // latency floor
+  BOOST_CHECK(lModel.cost(0) == 10.0);
+  BOOST_CHECK(lModel.cost(4096) == 10.0);
+
+  // interpolation and extrapolation with the bandwidth of the last segment
+  BOOST_CHECK(lModel.cost(4096 + 1024) == 11.0);
+  BOOST_CHECK(lModel.cost(1052672) == 1034.0);
+  BOOST_CHECK(lModel.cost(1052672 + 2048) == 1036.0);
+}
+
+BOOST_AUTO_TEST_CASE(MergeThresholdTest)
+{
+  UCXRmaCostModel lModel;
+  BOOST_REQUIRE(lModel.parse(sModel));
+
+  // large buffers: cost is 6us + 1us/KiB, merging saves the 6us per get, i.e. a gap of 6 KiB
+  const std::uint64_t lLen = 1 << 20;
+  BOOST_CHECK(lModel.merge(lLen, 0, lLen));
+  BOOST_CHECK(lModel.merge(lLen, 6144, lLen));
+  BOOST_CHECK(!lModel.merge(lLen, 6145, lLen));
+  BOOST_CHECK(lModel.maxMergeGap(lLen, lLen) == 6144);
+
+  // small buffers: both gets cost the 10us floor, the merged get costs 20us at 14 KiB
+  BOOST_CHECK(lModel.maxMergeGap(100, 100) == (14336 - 200));
+
+  // flat cost: merging is always cheaper, the gap is limited
+  BOOST_REQUIRE(lModel.parse("4096:10,1048576:10"));
+  BOOST_CHECK(lModel.maxMergeGap(lLen, lLen, 1 << 16) == (1 << 16));
+
+  // superlinear cost: never merge
+  BOOST_REQUIRE(lModel.parse("4096:1,8192:100"));
+  BOOST_CHECK(!lModel.merge(4096, 0, 4096));
+  BOOST_CHECK(lModel.maxMergeGap(4096, 4096) == 0);
+}
@@ -0,0 +1,126 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "UCXRmaWindow"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include "UCXRmaWindow.h"
+
+using namespace o2::DataDistribution::ucx;
+using namespace std::chrono_literals;
+
+static constexpr std::uint64_t sMiB = (1ULL << 20);
+static constexpr std::uint64_t sKiB = (1ULL << 10);
+
+static UCXRmaWindow::Config testConfig()
+{
+  UCXRmaWindow::Config lConfig;
+  lConfig.mMinBytes = 1 * sMiB;
+  lConfig.mMaxBytes = 8 * sMiB;
+  lConfig.mInitBytes = 4 * sMiB;
+  lConfig.mIncreaseBytes = 256 * sKiB;
+  lConfig.mDecrease = 0.5;
+  lConfig.mLatencyTolerance = 0.5;
+  return lConfig;
+}
+
+// 16 ops of 64 KiB in 100us: the transfer of one op takes 6.25us, the base latency is 10us
+static UCXRmaWindow::Sample testSample(const double pMeanLatencyUs)
+{
+  UCXRmaWindow::Sample lSample;
+  lSample.mBytes = 1 * sMiB;
+  lSample.mOps = 16;
+  lSample.mElapsedUs = 100.0;
+  lSample.mMinLatencyUs = 16.25;
+  lSample.mMeanLatencyUs = pMeanLatencyUs;
+  return lSample;
+}
+
+//____________________________________________________________________________//
+
+BOOST_AUTO_TEST_CASE(ConfigureTest)
+{
+  auto lConfig = testConfig();
+  lConfig.mInitBytes = 64 * sMiB;
+  UCXRmaWindow lWindow(lConfig);
+  BOOST_CHECK(lWindow.window() == 8 * sMiB);
+
+  lConfig.mInitBytes = 0;
+  lWindow.configure(lConfig);
+  BOOST_CHECK(lWindow.window() == 1 * sMiB);
+
+  // the maximum is never below the minimum
+  lConfig.mMaxBytes = 0;
+  lWindow.configure(lConfig);
+  BOOST_CHECK(lWindow.window() == 1 * sMiB);
+
+  // empty samples are ignored
+  lWindow.configure(testConfig());
+  BOOST_CHECK(!lWindow.update(UCXRmaWindow::Sample{}));
+  BOOST_CHECK(lWindow.window() == 4 * sMiB);
+}
+
+// additive increase while the latency is as expected, up to the maximum
+BOOST_AUTO_TEST_CASE(IncreaseTest)
+{
+  UCXRmaWindow lWindow(testConfig());
+
+  BOOST_CHECK(!lWindow.update(testSample(16.25)));
+  BOOST_CHECK(lWindow.window() == 4 * sMiB + 256 * sKiB);
+  BOOST_CHECK_CLOSE(lWindow.baseLatencyUs(), 10.0, 1e-6);
+  BOOST_CHECK_CLOSE(lWindow.maxThroughput(), double(sMiB) / 100.0, 1e-6);
+
+  // within the latency tolerance
+  BOOST_CHECK(!lWindow.update(testSample(24.0)));
+  BOOST_CHECK(lWindow.window() == 4 * sMiB + 512 * sKiB);
+
+  // the increase is at least the average op size
+  auto lSample = testSample(16.25);
+  lSample.mOps = 2;
+  lSample.mMinLatencyUs = 60.0;
+  lSample.mMeanLatencyUs = 60.0;
+  BOOST_CHECK(!lWindow.update(lSample));
+  BOOST_CHECK(lWindow.window() == 5 * sMiB);
+
+  for (int i = 0; i < 100; i++) {
+    lWindow.update(testSample(16.25));
+  }
+  BOOST_CHECK(lWindow.window() == 8 * sMiB);
+}
+
+// multiplicative decrease on latency inflation, at most once per mean latency, down to the minimum
+BOOST_AUTO_TEST_CASE(DecreaseTest)
+{
+  UCXRmaWindow lWindow(testConfig());
+
+  BOOST_CHECK(lWindow.update(testSample(25000.0)));
+  BOOST_CHECK(lWindow.window() == 2 * sMiB);
+
+  // the operations in flight of the same latency period see the same congestion
+  BOOST_CHECK(lWindow.update(testSample(25000.0)));
+  BOOST_CHECK(lWindow.window() == 2 * sMiB);
+
+  std::this_thread::sleep_for(30ms);
+  BOOST_CHECK(lWindow.update(testSample(25000.0)));
+  BOOST_CHECK(lWindow.window() == 1 * sMiB);
+
+  std::this_thread::sleep_for(30ms);
+  BOOST_CHECK(lWindow.update(testSample(25000.0)));
+  BOOST_CHECK(lWindow.window() == 1 * sMiB);
+
+  // grows again when the congestion is gone
+  BOOST_CHECK(!lWindow.update(testSample(16.25)));
+  BOOST_CHECK(lWindow.window() == 1 * sMiB + 256 * sKiB);
+}